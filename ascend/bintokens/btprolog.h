@@ -79,6 +79,12 @@
 typedef void (*BinTokenFPtr)(double *, double *);
 /**  Gradient evaluation function pointer.  G(vars,grad,resid); */
 typedef void (*BinTokenGPtr)(double *, double *, double *);
+/**
+ * Batch evaluation function pointer.  B(n,vars,resid,grad);
+ * Evaluates n instances of one relation. Variable j of instance i is
+ * vars[j*n+i], and its gradient element grad[j*n+i]. grad may be NULL.
+ */
+typedef void (*BinTokenBPtr)(int, double *, double *, double *);
 #ifdef BINTOKEN_WITH_F77
 /**
  * F77 style interface code (if and big goto required inside).
@@ -91,6 +97,8 @@ typedef void (*BinTokenSPtr)(double *, double *, double *, int *, int *, int *);
 typedef void (*BinTokenFPtr)();
 /**  Gradient evaluation function pointer.  G(vars,grad,resid); */
 typedef void (*BinTokenGPtr)();
+/**  Batch evaluation function pointer.  B(n,vars,resid,grad); */
+typedef void (*BinTokenBPtr)();
 
 #ifdef BINTOKEN_WITH_F77
 /**
@@ -101,9 +109,17 @@ typedef void (*BinTokenSPtr)();
 #endif
 #endif /* __STDC__ */
 
+/**
+	Version of the interface between generated code and libascend: the
+	tables and function pointer types below. Increase it whenever they
+	change, so that cached bintoken libraries are rebuilt.
+*/
+#define ASC_BTPROLOG_ABI 2
+
 struct TableC {
   BinTokenFPtr F;
   BinTokenGPtr G;
+  BinTokenBPtr B;
 };
 
 #ifdef BINTOKEN_WITH_F77
@@ -135,6 +135,21 @@ double RealAtomValue(CONST struct Instance *i){
   }
 }
 
+CONST double *RealAtomValuePtr(CONST struct Instance *i){
+  assert(i!=NULL);
+  AssertMemory(i);
+  switch(i->t) {
+  case REAL_INST:
+    return &(R_INST(i)->value);
+  case REAL_CONSTANT_INST:
+    return &(RC_INST(i)->value);
+  case REAL_ATOM_INST:
+    return &(RA_INST(i)->value);
+  default:
+    ASC_PANIC("called with non-real instance");
+  }
+}
+
 void SetRealAtomValue(struct Instance *i, double d, unsigned int depth){
   assert(i!=NULL);
   AssertMemory(i);
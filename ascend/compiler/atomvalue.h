@@ -82,6 +82,15 @@ ASC_DLLSPEC double RealAtomValue(CONST struct Instance *i);
  *  REAL_INST or REAL_ATOM_INST or REAL_CONSTANT_INSTANCE.
  */
 
+ASC_DLLSPEC CONST double *RealAtomValuePtr(CONST struct Instance *i);
+/**<
+ *  Return the address of the real value of instance i, for clients
+ *  (such as compiled relation programs) that read values repeatedly.
+ *  This works only on REAL_INST or REAL_ATOM_INST or
+ *  REAL_CONSTANT_INSTANCE.  The address is valid only as long as the
+ *  instance is not moved or destroyed (eg by refinement or merging).
+ */
+
 ASC_DLLSPEC void SetRealAtomValue(struct Instance *i, double d, unsigned depth);
 /**<
  *  Assign the value d(in system units) to instance i.  This works only on
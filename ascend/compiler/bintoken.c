@@ -31,7 +31,13 @@ TIMESTAMP = -DTIMESTAMP="\"by `whoami`@`hostname`\""
 #include <ascend/utilities/config.h>
 #include "bintoken.h"
 
+#include <errno.h>
+#include <math.h>
 #include <unistd.h> /* for getpid() */
+#ifndef WIN32
+# include <sys/types.h>
+# include <sys/wait.h>
+#endif
 
 #include <ascend/general/platform.h>
 #include <ascend/general/ascMalloc.h>
@@ -46,6 +52,7 @@ TIMESTAMP = -DTIMESTAMP="\"by `whoami`@`hostname`\""
 #include <ascend/utilities/ascEnvVar.h>
 
 #include "functype.h"
+#include "func.h"
 #include "expr_types.h"
 #include "stattypes.h"
 #include "statio.h"
@@ -75,6 +82,9 @@ TIMESTAMP = -DTIMESTAMP="\"by `whoami`@`hostname`\""
 
 #define CMDMAX (3*PATH_MAX)
 
+/* BinTokenArch_ plus 16 hex digits of hash */
+#define REGNAMEMAX 32
+
 enum bintoken_error {
   BTE_ok,
   BTE_badrel,
@@ -91,6 +101,7 @@ struct bt_table {
   int btable; /* check id */
   int refcount; /* total number of relation shares with btable = our number */
   int size; /* may be larger than refcount. */
+  int cached; /* library is in the cache directory: don't delete it */
 };
 
 /*
@@ -104,7 +115,7 @@ struct bt_data {
   /* loading hooks */
   union TableUnion *newtable;
   int newtablesize;
-  char regname[256];
+  unsigned long nextunit; /* uniquifies file names of generated units */
   /* ui set build options */
   char *srcname;
   char *objname;
@@ -114,7 +125,7 @@ struct bt_data {
   unsigned long maxrels; /* no more than this many C relations per file */
   int verbose; /* comments in generated code */
   int housekeep; /* if !=0, generated src files are deleted sometimes. */
-} g_bt_data = {NULL,0,0,NULL,0,"ERRARCHIVE",NULL,NULL,NULL,NULL,NULL,1,0,0};
+} g_bt_data = {NULL,0,0,NULL,0,0,NULL,NULL,NULL,NULL,NULL,1,0,0};
 
 /**
  *  In the C++ interface, the arguments of BinTokenSetOptions need to be
@@ -275,6 +286,28 @@ void BinTokenClearTables(void)
   BinTokenSetOptions(NULL,NULL,NULL,NULL,NULL,1,0,0);
 }
 
+/*
+ * deletes a generated file with the unlink command.
+ */
+static
+void BinTokenUnlink(CONST char *filename)
+{
+  char *cbuf;
+  int rc;
+  if (filename == NULL || !strlen(filename) || g_bt_data.unlinkcommand == NULL) {
+    return;
+  }
+  cbuf = ASC_NEW_ARRAY(char,strlen(g_bt_data.unlinkcommand)+1+strlen(filename)+1);
+  assert(cbuf!=NULL);
+  sprintf(cbuf,"%s %s",g_bt_data.unlinkcommand,filename);
+  MSG("Deleting: %s",cbuf);
+  rc = system(cbuf); /* we don't care if the delete fails */
+  if(rc){
+    MSG("delete failed: %d",rc);
+  }
+  ASC_FREE(cbuf);
+}
+
 /*
  * when all the references expire, unload the library.
  * note there is no AddReference since all the references
@@ -295,22 +328,10 @@ void BinTokenDeleteReference(int btable)
     MSG("Unloading btable=%d: %s",btable,g_bt_data.tables[btable].name);
     Asc_DynamicUnLoad(g_bt_data.tables[btable].name);
 
-    if(g_bt_data.housekeep){
-      if(g_bt_data.libname && strlen(g_bt_data.libname)){
-          char *cbuf;
-          cbuf = ASC_NEW_ARRAY(char,strlen(g_bt_data.unlinkcommand)+1+strlen(g_bt_data.libname)+1);
-          assert(cbuf!=NULL);
-          sprintf(cbuf,"%s %s",g_bt_data.unlinkcommand,g_bt_data.libname);
-          MSG("Deleting bintok shared library: %s",cbuf);
-          int rc = system(cbuf); /* we don't care if the delete fails */
-	  if(rc){
-            MSG("delete failed: %d",rc);
-	  }
-          ASC_FREE(cbuf);
-      }
+    if(g_bt_data.housekeep && !g_bt_data.tables[btable].cached){
+      BinTokenUnlink(g_bt_data.tables[btable].name);
     }
 
-
 #else
     ERROR_REPORTER_NOLINE(ASC_PROG_ERR,"Dynamic Unloading not available in this build");
 #endif /* havedlunload */
@@ -565,28 +586,492 @@ enum bintoken_error WriteResidualCode(FILE *fp, struct Instance *i,
   return BTE_ok;
 }
 
+/*
+ * Straight-line code for the gradient and batch functions.
+ * The postfix terms of a relation are translated into a list of
+ * instructions, each computing one register v_k from earlier ones.
+ * Identical instructions are merged (so each variable and each common
+ * subexpression is computed once) and literal subexpressions are
+ * folded. The gradient is then written as a reverse sweep over the
+ * registers that depend on variables.
+ */
+struct bt_instr {
+  enum Expr_enum op; /* e_real for constants, e_var, or the operator */
+  int left, right;   /* operand registers, -1 if none */
+  int hasvar;        /* nonzero if the register depends on a variable */
+  double c;          /* e_real */
+  unsigned long slot; /* e_var, base 0 */
+  CONST struct Func *f; /* e_func */
+};
+
+struct bt_code {
+  struct bt_instr *ins;
+  int n, cap;
+  int *hash; /* open addressing table of register numbers, -1 if empty */
+  int hcap;
+  unsigned long nvars;
+  int root; /* register holding the residual */
+};
+
+static
+unsigned long BinTokenInstrHash(CONST struct bt_instr *in)
+{
+  unsigned long h;
+  CONST unsigned char *b;
+  size_t k;
+  h = (unsigned long)in->op * 2654435761UL;
+  h ^= (unsigned long)(in->left + 1) * 40503UL + (unsigned long)(in->right + 1);
+  h ^= in->slot * 97UL;
+  h ^= (unsigned long)(size_t)in->f;
+  b = (CONST unsigned char *)&(in->c);
+  for (k = 0; k < sizeof(double); k++) {
+    h = h * 31UL + b[k];
+  }
+  return h;
+}
+
+static
+int BinTokenInstrEqual(CONST struct bt_instr *a, CONST struct bt_instr *b)
+{
+  return a->op == b->op && a->left == b->left && a->right == b->right
+    && a->slot == b->slot && a->f == b->f
+    && memcmp(&(a->c),&(b->c),sizeof(double)) == 0;
+}
+
+/*
+ * returns the register computing in, adding it to the code if no
+ * identical instruction is there already.
+ */
+static
+int BinTokenAddInstr(struct bt_code *code, struct bt_instr *in)
+{
+  unsigned long h;
+  int k;
+  h = BinTokenInstrHash(in) % (unsigned long)code->hcap;
+  while ((k = code->hash[h]) >= 0) {
+    if (BinTokenInstrEqual(&(code->ins[k]),in)) {
+      return k;
+    }
+    h = (h + 1) % (unsigned long)code->hcap;
+  }
+  assert(code->n < code->cap);
+  k = code->n++;
+  code->ins[k] = *in;
+  code->hash[h] = k;
+  return k;
+}
+
+/* value of a constant operation, as computed by the generated code */
+static
+double BinTokenFold(CONST struct bt_instr *in, double x, double y)
+{
+  switch (in->op) {
+  case e_plus: return x + y;
+  case e_minus: return x - y;
+  case e_times: return x * y;
+  case e_divide: return x / y;
+  case e_power: return pow(x,y);
+  case e_ipower: return asc_ipow(x,(int)y);
+  case e_uminus: return -x;
+  case e_func: return FuncEval(in->f,x);
+  default:
+    return 0.0;
+  }
+}
+
+/*
+ * appends the postfix terms of one side of r to code.
+ * returns the register holding the side, or -1 for unsupported terms.
+ */
+static
+int BinTokenCodeSide(struct bt_code *code, CONST struct relation *r,
+                     int lhs, int *stack)
+{
+  unsigned long t, len;
+  int s = -1, arity;
+  CONST struct relation_term *term;
+  struct bt_instr in;
+  double v;
+
+  len = RelationLength(r,lhs);
+  for (t = 0; t < len; t++) {
+    term = NewRelationTerm(r,t,lhs);
+    memset(&in,0,sizeof(in));
+    in.left = in.right = -1;
+    arity = 0;
+    in.op = RelationTermType(term);
+    switch (in.op) {
+    case e_zero:
+      in.op = e_real;
+      break;
+    case e_real:
+      in.c = TermReal(term);
+      break;
+    case e_int:
+      in.op = e_real;
+      in.c = (double)TermInteger(term);
+      break;
+    case e_var:
+      in.slot = TermVarNumber(term) - 1;
+      in.hasvar = 1;
+      break;
+    case e_plus: case e_minus: case e_times: case e_divide:
+    case e_power: case e_ipower:
+      arity = 2;
+      break;
+    case e_uminus:
+      arity = 1;
+      break;
+    case e_func:
+      in.f = TermFunc(term);
+      if (FuncCName(in.f) == NULL || FuncDeriv1CName(in.f) == NULL) {
+        return -1;
+      }
+      arity = 1;
+      break;
+    default:
+      return -1;
+    }
+    if (arity == 2) {
+      in.right = stack[s--];
+      in.left = stack[s--];
+      in.hasvar = code->ins[in.left].hasvar || code->ins[in.right].hasvar;
+    } else if (arity == 1) {
+      in.left = stack[s--];
+      in.hasvar = code->ins[in.left].hasvar;
+    }
+    if (arity && code->ins[in.left].op == e_real
+        && (arity == 1 || code->ins[in.right].op == e_real)) {
+      v = BinTokenFold(&in,code->ins[in.left].c,
+                       (arity == 2) ? code->ins[in.right].c : 0.0);
+      if (asc_finite(v)) {
+        memset(&in,0,sizeof(in));
+        in.op = e_real;
+        in.left = in.right = -1;
+        in.c = v;
+      }
+    }
+    stack[++s] = BinTokenAddInstr(code,&in);
+  }
+  return (s == 0) ? stack[0] : -1;
+}
+
+static
+void BinTokenCodeDestroy(struct bt_code *code)
+{
+  if (code->ins != NULL) {
+    ASC_FREE(code->ins);
+  }
+  if (code->hash != NULL) {
+    ASC_FREE(code->hash);
+  }
+  code->ins = NULL;
+  code->hash = NULL;
+}
+
+/*
+ * translates relation instance i into code.
+ * returns nonzero if it contains terms we cannot write.
+ */
+static
+int BinTokenCodeCreate(struct bt_code *code, struct Instance *i)
+{
+  CONST struct relation *r;
+  unsigned long llen, rlen;
+  int *stack, lroot = -1, rroot = -1, k;
+  struct bt_instr in;
+
+  memset(code,0,sizeof(struct bt_code));
+  r = GetInstanceRelationOnly(i);
+  if (r == NULL) {
+    return 1;
+  }
+  llen = RelationLength(r,1);
+  rlen = RelationLength(r,0);
+  if (llen + rlen == 0) {
+    return 1;
+  }
+  code->nvars = NumberVariables(r);
+  code->cap = (int)(llen + rlen + 1);
+  code->ins = ASC_NEW_ARRAY(struct bt_instr,code->cap);
+  code->hcap = 2*code->cap + 1;
+  code->hash = ASC_NEW_ARRAY(int,code->hcap);
+  for (k = 0; k < code->hcap; k++) {
+    code->hash[k] = -1;
+  }
+  stack = ASC_NEW_ARRAY(int,MAX(llen,rlen) + 1);
+  if (llen) {
+    lroot = BinTokenCodeSide(code,r,1,stack);
+  }
+  if (rlen && (!llen || lroot >= 0)) {
+    rroot = BinTokenCodeSide(code,r,0,stack);
+  }
+  ASC_FREE(stack);
+  if ((llen && lroot < 0) || (rlen && rroot < 0)) {
+    BinTokenCodeDestroy(code);
+    return 1;
+  }
+  /* residual = LHS - RHS */
+  if (!rlen) {
+    code->root = lroot;
+    return 0;
+  }
+  memset(&in,0,sizeof(in));
+  in.right = -1;
+  if (llen) {
+    in.op = e_minus;
+    in.left = lroot;
+    in.right = rroot;
+    in.hasvar = code->ins[lroot].hasvar || code->ins[rroot].hasvar;
+  } else {
+    in.op = e_uminus;
+    in.left = rroot;
+    in.hasvar = code->ins[rroot].hasvar;
+  }
+  code->root = BinTokenAddInstr(code,&in);
+  return 0;
+}
+
+/* writes register k as an operand: constants are written in place. */
+static
+void BinTokenWriteOperand(FILE *fp, struct bt_code *code, int k)
+{
+  char buf[40];
+  if (code->ins[k].op != e_real) {
+    FPRINTF(fp,"v%d",k);
+    return;
+  }
+  sprintf(buf,"%.17g",code->ins[k].c);
+  if (strpbrk(buf,".eEin") == NULL) {
+    strcat(buf,".0");
+  }
+  if (buf[0] == '-') {
+    FPRINTF(fp,"(%s)",buf);
+  } else {
+    FPRINTF(fp,"%s",buf);
+  }
+}
+
+/*
+ * writes the body computing *residual and the gradient g from x.
+ * If batch, the variables, residual and gradient of instance i of n
+ * are x[j*n+i], residual[i] and g[j*n+i]; else x[j], *residual, g[j].
+ * If nograd, only the residual is computed.
+ */
+static
+void BinTokenWriteBody(FILE *fp, struct bt_code *code, int batch,
+                       int nograd, CONST char *indent)
+{
+  struct bt_instr *in;
+  int k, *varreg;
+  unsigned long j;
+  CONST char *opstr;
+
+#define OPND(K) BinTokenWriteOperand(fp,code,(K))
+  /* forward sweep */
+  for (k = 0; k < code->n; k++) {
+    in = &(code->ins[k]);
+    if (in->op == e_real) {
+      continue;
+    }
+    FPRINTF(fp,"%sconst double v%d = ",indent,k);
+    opstr = NULL;
+    switch (in->op) {
+    case e_var:
+      if (batch) {
+        FPRINTF(fp,"x[%lu*n+i]",in->slot);
+      } else {
+        FPRINTF(fp,"x[%lu]",in->slot);
+      }
+      break;
+    case e_plus: opstr = " + "; break;
+    case e_minus: opstr = " - "; break;
+    case e_times: opstr = " * "; break;
+    case e_divide: opstr = " / "; break;
+    case e_power:
+      FPRINTF(fp,"pow("); OPND(in->left); FPRINTF(fp,","); OPND(in->right);
+      FPRINTF(fp,")");
+      break;
+    case e_ipower:
+      FPRINTF(fp,"asc_ipow("); OPND(in->left); FPRINTF(fp,",(int)");
+      OPND(in->right); FPRINTF(fp,")");
+      break;
+    case e_uminus:
+      FPRINTF(fp,"-"); OPND(in->left);
+      break;
+    case e_func:
+      FPRINTF(fp,"%s(",FuncCName(in->f)); OPND(in->left); FPRINTF(fp,")");
+      break;
+    default:
+      break;
+    }
+    if (opstr != NULL) {
+      OPND(in->left); FPRINTF(fp,"%s",opstr); OPND(in->right);
+    }
+    CLINE(";");
+  }
+  if (nograd) {
+    FPRINTF(fp,"%s%s = ",indent,batch ? "residual[i]" : "*residual");
+    OPND(code->root);
+    CLINE(";");
+    return;
+  }
+
+  /* reverse sweep: a_k is the derivative of the residual wrt v_k */
+  varreg = ASC_NEW_ARRAY(int,code->nvars + 1);
+  for (j = 0; j < code->nvars; j++) {
+    varreg[j] = -1;
+  }
+  for (k = 0; k < code->n; k++) {
+    in = &(code->ins[k]);
+    if (in->hasvar && k != code->root) {
+      FPRINTF(fp,"%sdouble a%d = 0.0;\n",indent,k);
+    }
+    if (in->op == e_var) {
+      varreg[in->slot] = k;
+    }
+  }
+  if (code->ins[code->root].hasvar) {
+    FPRINTF(fp,"%sconst double a%d = 1.0;\n",indent,code->root);
+  }
+  /* statements after all declarations, so the code is C89 */
+  FPRINTF(fp,"%s%s = ",indent,batch ? "residual[i]" : "*residual");
+  OPND(code->root);
+  CLINE(";");
+#define HV(K) (code->ins[(K)].hasvar)
+#define ADJ(K,OP) FPRINTF(fp,"%sa%d %s a%d",indent,(K),(OP),k)
+  for (k = code->n - 1; k >= 0; k--) {
+    in = &(code->ins[k]);
+    if (!in->hasvar) {
+      continue;
+    }
+    switch (in->op) {
+    case e_plus:
+      if (HV(in->left)) { ADJ(in->left,"+="); CLINE(";"); }
+      if (HV(in->right)) { ADJ(in->right,"+="); CLINE(";"); }
+      break;
+    case e_minus:
+      if (HV(in->left)) { ADJ(in->left,"+="); CLINE(";"); }
+      if (HV(in->right)) { ADJ(in->right,"-="); CLINE(";"); }
+      break;
+    case e_times:
+      if (HV(in->left)) {
+        ADJ(in->left,"+="); FPRINTF(fp," * "); OPND(in->right); CLINE(";");
+      }
+      if (HV(in->right)) {
+        ADJ(in->right,"+="); FPRINTF(fp," * "); OPND(in->left); CLINE(";");
+      }
+      break;
+    case e_divide:
+      if (HV(in->left)) {
+        ADJ(in->left,"+="); FPRINTF(fp," / "); OPND(in->right); CLINE(";");
+      }
+      if (HV(in->right)) {
+        ADJ(in->right,"-="); FPRINTF(fp," * v%d / ",k); OPND(in->right);
+        CLINE(";");
+      }
+      break;
+    case e_power:
+      if (HV(in->left)) {
+        ADJ(in->left,"+="); FPRINTF(fp," * "); OPND(in->right);
+        FPRINTF(fp," * pow("); OPND(in->left); FPRINTF(fp,","); OPND(in->right);
+        CLINE(" - 1.0);");
+      }
+      if (HV(in->right)) {
+        ADJ(in->right,"+="); FPRINTF(fp," * log("); OPND(in->left);
+        FPRINTF(fp,") * v%d;\n",k);
+      }
+      break;
+    case e_ipower:
+      if (HV(in->left)) {
+        ADJ(in->left,"+="); FPRINTF(fp," * asc_d1ipow("); OPND(in->left);
+        FPRINTF(fp,",(int)"); OPND(in->right); CLINE(");");
+      }
+      if (HV(in->right)) {
+        ADJ(in->right,"+="); FPRINTF(fp," * log("); OPND(in->left);
+        FPRINTF(fp,") * v%d;\n",k);
+      }
+      break;
+    case e_uminus:
+      ADJ(in->left,"-="); CLINE(";");
+      break;
+    case e_func:
+      ADJ(in->left,"+="); FPRINTF(fp," * %s(",FuncDeriv1CName(in->f));
+      OPND(in->left); CLINE(");");
+      break;
+    default:
+      break;
+    }
+  }
+#undef ADJ
+#undef HV
+#undef OPND
+  for (j = 0; j < code->nvars; j++) {
+    if (batch) {
+      FPRINTF(fp,"%sg[%lu*n+i] = ",indent,j);
+    } else {
+      FPRINTF(fp,"%sg[%lu] = ",indent,j);
+    }
+    if (varreg[j] >= 0) {
+      FPRINTF(fp,"a%d;\n",varreg[j]);
+    } else {
+      CLINE("0.0;");
+    }
+  }
+  ASC_FREE(varreg);
+}
+
+/*
+ * writes g_nrel(x,g,residual), computing the residual and gradient of
+ * relation i by reverse differentiation, and b_nrel(n,x,residual,g),
+ * doing the same for n instances of the relation at once, with their
+ * values interleaved so that the loop over instances can be vectorized.
+ * b_nrel computes only residuals if g is NULL.
+ * Returns BTE_badrel, and writes nothing, if the relation contains
+ * terms we cannot differentiate.
+ */
 static
 enum bintoken_error WriteGradientCode(FILE *fp, struct Instance *i,
     int nrel, int verbose, char *streqn, int timesused
 ){
+  struct bt_code code;
+
+  (void)streqn;
+  if (BinTokenCodeCreate(&code,i)) {
+    return BTE_badrel;
+  }
   if (verbose) {
-    MSG("Writing gradient code for rel %p (NOT IMPLEMENTED)",i);
+    MSG("Writing gradient code for rel %p",i);
 
     /* put in a little header */
     CLINE("\n/*");
-    FPRINTF(fp,"\tGradients for\n",timesused);
+    FPRINTF(fp,"\tGradients for relation used %d times, from:\n",timesused);
     FPRINTF(fp,"\t");
     /* Use fastest path to a root */
     WriteAnyInstanceName(fp,i);
     CLINE("\n*/");
   }
-  FPRINTF(fp,"void g_%d(double *x, double *resid, double *grad){\n",nrel);
-  FPRINTF(fp,"\t*resid =");
-  print_long_string(fp,streqn,C_WIDTH,C_INDENT); /* human readable, sort of */
-  FPRINTF(fp,";\n");
-  fprintf(fp,"\t/* gradient code missing */\n");
-  FPRINTF(fp,"}\n\n");
-  return BTE_write;
+  CLINE("static");
+  FPRINTF(fp,"void g_%d(double *x, double *g, double *residual){\n",nrel);
+  BinTokenWriteBody(fp,&code,0,0,"\t");
+  CLINE("}\n");
+
+  CLINE("static");
+  FPRINTF(fp,"void b_%d(int n, double *x, double *residual, double *g){\n",nrel);
+  CLINE("\tint i;");
+  CLINE("\tif(g == NULL){");
+  CLINE("\t\tfor(i = 0; i < n; i++){");
+  BinTokenWriteBody(fp,&code,1,1,"\t\t\t");
+  CLINE("\t\t}");
+  CLINE("\t\treturn;");
+  CLINE("\t}");
+  CLINE("\tfor(i = 0; i < n; i++){");
+  BinTokenWriteBody(fp,&code,1,0,"\t\t");
+  CLINE("\t}");
+  CLINE("}");
+
+  BinTokenCodeDestroy(&code);
+  return BTE_ok;
 }
 
 
@@ -661,17 +1146,65 @@ void ResizeIndices(struct Instance *rel, struct reusable_rxnd *r)
   r->cap = newlen;
 }
 
+/*
+ * hash of generated code, for naming the archive load function and
+ * cached libraries: 32-bit FNV-1a (h1) and shift-add-xor (h2).
+ */
+struct bt_hash {
+  unsigned long h1, h2;
+};
+
+static
+void BinTokenHashInit(struct bt_hash *h)
+{
+  h->h1 = 2166136261UL;
+  h->h2 = 5381UL;
+}
+
+static
+void BinTokenHashBytes(struct bt_hash *h, CONST unsigned char *buf, size_t n)
+{
+  size_t i;
+  for (i = 0; i < n; i++) {
+    h->h1 = ((h->h1 ^ buf[i]) * 16777619UL) & 0xffffffffUL;
+    h->h2 = (h->h2 ^ ((h->h2 << 5) + (h->h2 >> 2) + buf[i])) & 0xffffffffUL;
+  }
+}
+
+/* hashes what has been written to fp, leaving fp at its end. */
+static
+int BinTokenHashFile(struct bt_hash *h, FILE *fp)
+{
+  unsigned char buf[8192];
+  size_t n;
+  fflush(fp);
+  rewind(fp);
+  while ((n = fread(buf,1,sizeof(buf),fp)) > 0) {
+    BinTokenHashBytes(h,buf,n);
+  }
+  if (ferror(fp)) {
+    return 1;
+  }
+  return fseek(fp,0L,SEEK_END);
+}
+
 /*
  * generate code for a table of function pointers and the function
  * pointers also in an archive load function.
  * The table is always 1 pair larger than rellist since by convention
  * index 0 has the NULL functions.
+ * The archive load function is named from a hash of the rest of the
+ * file and of buildkey, and its name is returned in regname, which
+ * must have room for REGNAMEMAX characters. Identical code built the
+ * same way thus always gets the same name.
  */
 static
 enum bintoken_error BinTokenSharesToC(struct Instance *root,
                                       struct gl_list_t *rellist,
                                       char *srcname,
-                                      int verbose)
+                                      int verbose,
+                                      CONST char *buildkey,
+                                      char *regname)
 {
   int *error;
   FILE *fp;
@@ -680,9 +1213,10 @@ enum bintoken_error BinTokenSharesToC(struct Instance *root,
   int slen;
   struct bintoken_unique_eqn *eqn;
   struct bintoken_eqlist eql;
+  struct bt_hash hash;
   unsigned long c, len;
-  int pid;
-  int eqns_done;
+  int eqns_done, u;
+  char *gradok; /* indexed by indexU: nonzero if g_ and b_ were written */
   struct reusable_rxnd rrd = {{"x[",NULL,"]"},0};
 
   if (root == NULL ||  rellist == NULL) {
@@ -734,47 +1268,53 @@ enum bintoken_error BinTokenSharesToC(struct Instance *root,
     DestroyEQData(&eql);
     return BTE_badrel;
   }
+  gradok = ASC_NEW_ARRAY_CLEAR(char,eql.nextnew + 1);
   for (c = gl_length(eql.ue); c > 0; c--) {
     eqn = (struct bintoken_unique_eqn *)gl_fetch(eql.ue,c);
     i = gl_fetch(rellist,eqn->firstrel);
     WriteResidualCode(fp,i,eqn->indexU,verbose,eqn->str,eqn->refcount);
-    WriteGradientCode(fp,i,eqn->indexU,verbose,eqn->str,eqn->refcount);
+    gradok[eqn->indexU] = (char)(WriteGradientCode(fp,i,eqn->indexU,
+                                   verbose,eqn->str,eqn->refcount) == BTE_ok);
   }
-  /* write the registered function name */
-  pid = getpid();
-  /** @TODO FIXME win32 has getpid but it is bogus as uniquifier. */
-  /* so long as makefile deletes previous dll, windows is ok though */
-  sprintf(g_bt_data.regname,"BinTokenArch_%d_%d",++(g_bt_data.nextid),(int)pid);
-  FPRINTF(fp,"\n\nint ASC_EXPORT %s(){\n",g_bt_data.regname);
-  CLINE("\tint status;");
-  FPRINTF(fp,"\tstatic struct TableC g_ctable[%lu] =\n",len+1);
-  CLINE("\t\t{ {NULL, NULL},");
-  len--; /* to fudge the final comma */
+  FPRINTF(fp,"\n\nstatic struct TableC g_ctable[%lu] =\n",len+1);
+  CLINE("\t\t{ {NULL, NULL, NULL},");
   for (c=1; c <= len; c++) {
-    if (error[c-1] == BTE_ok) {
-      FPRINTF(fp,"\t\t\t{r_%u, NULL},\n",eql.rel2U[c]);
+    u = eql.rel2U[c];
+    if (error[c-1] != BTE_ok) {
+      FPRINTF(fp,"\t\t\t{NULL, NULL, NULL}");
+    } else if (gradok[u]) {
+      FPRINTF(fp,"\t\t\t{r_%d, g_%d, b_%d}",u,u,u);
     } else {
-      FPRINTF(fp,"\t\t\t{NULL, NULL},\n");
+      FPRINTF(fp,"\t\t\t{r_%d, NULL, NULL}",u);
     }
-  }
-  len++;
-  if (error[len-1] == BTE_ok) {
-    FPRINTF(fp,"\t\t\t{r_%u, NULL}\n",eql.rel2U[c]);
-  } else {
-    FPRINTF(fp,"\t\t\t{NULL, NULL}\n");
+    CLINE((c < len) ? "," : "");
   }
   CLINE("\t\t};");
-  FPRINTF(fp,"\tstatus = ExportBinTokenCTable(g_ctable,%lu);\n",len+1);
-  CLINE("\treturn status;");
   if (verbose) {
-    FPRINTF(fp,"\t/* %lu unique equations */\n",gl_length(eql.ue));
+    FPRINTF(fp,"/* %lu unique equations */\n",gl_length(eql.ue));
     MSG("Prepared %lu external C functions.\n",gl_length(eql.ue));
   }
-  CLINE("}");
-
   ASC_FREE(error);
+  ASC_FREE(gradok);
   DestroyEQData(&eql);
-  fclose(fp);
+
+  /* write the registered function name */
+  BinTokenHashInit(&hash);
+  if (BinTokenHashFile(&hash,fp)) {
+    fclose(fp);
+    return BTE_write;
+  }
+  if (buildkey != NULL) {
+    BinTokenHashBytes(&hash,(CONST unsigned char *)buildkey,strlen(buildkey));
+  }
+  sprintf(regname,"BinTokenArch_%08lx%08lx",hash.h1,hash.h2);
+  FPRINTF(fp,"\nint ASC_EXPORT %s(){\n",regname);
+  FPRINTF(fp,"\treturn ExportBinTokenCTable(g_ctable,%lu);\n",len+1);
+  CLINE("}");
+
+  if (fclose(fp)) {
+    return BTE_write;
+  }
   return BTE_ok;
 }
 
@@ -815,10 +1355,12 @@ void BinTokenHookToTable(int entry, enum bintoken_kind type)
 static
 enum bintoken_error BinTokenLoadC(struct gl_list_t *rellist,
                                   char *libname,
-                                  char *regname)
+                                  char *regname,
+                                  int cached)
 {
   int status;
   unsigned long c,len;
+  ++(g_bt_data.nextid);
   BinTokenCheckCapacity();
   status = Asc_DynamicLoad(libname,regname);
   if (status != 0) {
@@ -841,6 +1383,7 @@ enum bintoken_error BinTokenLoadC(struct gl_list_t *rellist,
   }
   g_bt_data.tables[g_bt_data.nextid].refcount = (int)len;
   g_bt_data.tables[g_bt_data.nextid].name = ASC_STRDUP(libname);
+  g_bt_data.tables[g_bt_data.nextid].cached = cached;
   return BTE_ok;
 }
 
@@ -884,20 +1427,209 @@ void BinTokenErrorMessage(enum bintoken_error err,
   ERROR_REPORTER_HERE(ASC_PROG_ERR,"%s: %s",filename, mess);
 }
 
+/*
+ * a generated source file and the library built from it. Large models
+ * are split into several units, built concurrently.
+ */
+struct bt_unit {
+  struct gl_list_t *rellist; /* relations coded in this unit */
+  char *srcname;
+  char *objname;
+  char *libname; /* library to load */
+  char *outname; /* library written by command, renamed to libname */
+  char *command; /* build command, NULL if nothing to build */
+  char regname[REGNAMEMAX];
+  enum bintoken_error status;
+  int cached; /* libname is in the cache directory */
+};
+
+/*
+ * returns a copy of str in which each occurrence of from[k] is
+ * replaced by to[k], trying the longest match first. Empty or
+ * NULL from[k] are ignored.
+ */
+static
+char *BinTokenSubst(CONST char *str, int n, CONST char **from, CONST char **to)
+{
+  Asc_DString ds;
+  CONST char *p;
+  char *result;
+  int k, best;
+  size_t blen, flen;
+
+  Asc_DStringInit(&ds);
+  p = str;
+  while (*p != '\0') {
+    best = -1;
+    blen = 0;
+    for (k = 0; k < n; k++) {
+      if (from[k] == NULL || (flen = strlen(from[k])) == 0 || flen <= blen) {
+        continue;
+      }
+      if (strncmp(p,from[k],flen) == 0) {
+        best = k;
+        blen = flen;
+      }
+    }
+    if (best < 0) {
+      Asc_DStringAppend(&ds,p,1);
+      p++;
+    } else {
+      Asc_DStringAppend(&ds,(to[best] != NULL ? to[best] : ""),-1);
+      p += blen;
+    }
+  }
+  result = ASC_STRDUP(Asc_DStringValue(&ds));
+  Asc_DStringFree(&ds);
+  return result;
+}
+
+/* returns the position of the extension of filename, or of its end */
+static
+CONST char *BinTokenExtension(CONST char *filename)
+{
+  CONST char *dot, *p;
+  dot = NULL;
+  for (p = filename; *p != '\0'; p++) {
+    if (*p == '.') {
+      dot = p;
+    } else if (*p == '/' || *p == '\\') {
+      dot = NULL;
+    }
+  }
+  return (dot != NULL) ? dot : p;
+}
+
+/* returns filename with "-tag" inserted before its extension */
+static
+char *BinTokenUnitName(CONST char *filename, unsigned long tag)
+{
+  CONST char *ext;
+  char *name;
+  ext = BinTokenExtension(filename);
+  name = ASC_NEW_ARRAY(char,strlen(filename)+24);
+  sprintf(name,"%.*s-%lu%s",(int)(ext-filename),filename,tag,ext);
+  return name;
+}
+
+/* returns dir/regname, with the extension of libname */
+static
+char *BinTokenCacheName(CONST char *dir, CONST char *regname,
+                        CONST char *libname)
+{
+  CONST char *ext;
+  char *name;
+  ext = BinTokenExtension(libname);
+  name = ASC_NEW_ARRAY(char,strlen(dir)+1+strlen(regname)+strlen(ext)+1);
+  sprintf(name,"%s/%s%s",dir,regname,ext);
+  return name;
+}
+
+static
+int BinTokenFileExists(CONST char *filename)
+{
+  FILE *fp;
+  fp = fopen(filename,"rb");
+  if (fp == NULL) {
+    return 0;
+  }
+  fclose(fp);
+  return 1;
+}
+
+/* number of build commands to run at once */
+static
+int BinTokenJobs(void)
+{
+  CONST char *e;
+  int jobs = 0;
+  e = getenv(ASC_ENV_BTJOBS);
+  if (e != NULL) {
+    jobs = atoi(e);
+  }
+#if !defined(WIN32) && defined(_SC_NPROCESSORS_ONLN)
+  if (jobs < 1) {
+    jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  }
+#endif
+  return (jobs < 1) ? 1 : jobs;
+}
+
+/*
+ * runs the build commands of the units, up to jobs at a time,
+ * setting the status of those that fail to BTE_build.
+ */
+static
+void BinTokenRunCommands(struct bt_unit *units, int nunits, int jobs)
+{
+#ifndef WIN32
+  pid_t pid, *pids;
+  int *run;
+  int u, nrun, head, st;
+
+  pids = ASC_NEW_ARRAY(pid_t,nunits);
+  run = ASC_NEW_ARRAY(int,nunits);
+  nrun = head = 0;
+  for (u = 0; u <= nunits; u++) {
+    if (u < nunits && units[u].command == NULL) {
+      continue;
+    }
+    /* wait for the oldest running build until there is a free slot */
+    while (head < nrun && (nrun - head >= jobs || u == nunits)) {
+      while ((pid = waitpid(pids[head],&st,0)) < 0 && errno == EINTR);
+      if (pid != pids[head] || !WIFEXITED(st) || WEXITSTATUS(st) != 0) {
+        MSG("buildcommand: %s",units[run[head]].command);
+        MSG("...returned status %d",st);
+        units[run[head]].status = BTE_build;
+      }
+      head++;
+    }
+    if (u == nunits) {
+      break;
+    }
+    pid = fork();
+    if (pid == 0) {
+      execl("/bin/sh","sh","-c",units[u].command,(char *)NULL);
+      _exit(127);
+    }
+    if (pid < 0) {
+      units[u].status = BinTokenCompileC(units[u].command);
+      continue;
+    }
+    pids[nrun] = pid;
+    run[nrun++] = u;
+  }
+  ASC_FREE(pids);
+  ASC_FREE(run);
+#else
+  int u;
+  (void)jobs;
+  for (u = 0; u < nunits; u++) {
+    if (units[u].command != NULL) {
+      units[u].status = BinTokenCompileC(units[u].command);
+    }
+  }
+#endif
+}
+
 void BinTokensCreate(struct Instance *root, enum bintoken_kind method){
   struct gl_list_t *rellist;
-  char *cbuf;
-  enum bintoken_error status;
+  struct bt_unit *units, *un;
   char *srcname = g_bt_data.srcname;
   char *objname = g_bt_data.objname;
   char *libname = g_bt_data.libname;
   char *buildcommand = g_bt_data.buildcommand;
   char *unlinkcommand = g_bt_data.unlinkcommand;
   int verbose = g_bt_data.verbose;
+  unsigned long maxrels = g_bt_data.maxrels;
+  CONST char *from[3], *to[3];
+  char *cachedir, *cmdkey, *buildkey;
+  unsigned long c, len, tag;
+  int split, nunits, u, k, nbuilt, nfound, nloaded;
 
   MSG("...");
 
-  if (g_bt_data.maxrels == 0) {
+  if (maxrels == 0) {
 #ifdef BINTOKEN_DEBUG
     ERROR_REPORTER_HERE(ASC_PROG_NOTE,"BinTokensCreate disabled (maxrels=0)\n");
 #endif
@@ -909,71 +1641,184 @@ void BinTokensCreate(struct Instance *root, enum bintoken_kind method){
 #endif
     return;
   }
+  if (method != BT_C) {
+    ERROR_REPORTER_HERE(ASC_PROG_ERR,"BinaryTokensCreate called with unavailable method '%d'",(int)method);
+    return;
+  }
+
+  /*
+   * units need file names of their own, so we can only split the model
+   * and cache libraries if we can see where the build command puts them.
+   */
+  split = (libname != NULL && strlen(libname) && strlen(srcname)
+    && strstr(buildcommand,srcname) != NULL
+    && strstr(buildcommand,libname) != NULL
+  );
+  cachedir = split ? getenv(ASC_ENV_BTCACHE) : NULL;
+  if (cachedir != NULL && !strlen(cachedir)) {
+    cachedir = NULL;
+  }
 
   rellist =
-    CollectTokenRelationsWithUniqueBINlessShares(root,g_bt_data.maxrels);
+    CollectTokenRelationsWithUniqueBINlessShares(root,split ? 0 : maxrels);
   if(rellist==NULL){
     ERROR_REPORTER_HERE(ASC_PROG_WARNING
         ,"BinaryTokensCreate found 0 or too many unique relations."
     );
     return;
   }
+  len = gl_length(rellist);
+  if (len == 0) {
+    gl_destroy(rellist);
+    return;
+  }
 
   MSG("Creating bintokens");
-  //MSG("buildcommand = %s",buildcommand);
-
-  switch(method){
-  case BT_C:
-    /* generate code */
-    status = BinTokenSharesToC(root,rellist,srcname,verbose);
-    if(status != BTE_ok){
-      BinTokenErrorMessage(status,root,srcname,buildcommand);
-      break; /* leave source file there if partial */
+
+  /* the build command, independent of the unit file names, is hashed too */
+  from[0] = srcname;
+  from[1] = libname;
+  from[2] = objname;
+  to[0] = "$SRC";
+  to[1] = "$LIB";
+  to[2] = "$OBJ";
+  cmdkey = BinTokenSubst(buildcommand,3,from,to);
+  buildkey = ASC_NEW_ARRAY(char,strlen(cmdkey)+32);
+  sprintf(buildkey,"%s\nABI %d",cmdkey,ASC_BTPROLOG_ABI);
+  ASC_FREE(cmdkey);
+
+  nunits = split ? (int)((len + maxrels - 1)/maxrels) : 1;
+  units = ASC_NEW_ARRAY_CLEAR(struct bt_unit,nunits);
+  nfound = 0;
+
+  /* generate code, and find which units must be built */
+  for (u = 0; u < nunits; u++) {
+    un = &units[u];
+    if (nunits == 1) {
+      un->rellist = rellist;
+    } else {
+      un->rellist = gl_create(maxrels);
+      for (c = u*maxrels + 1; c <= len && c <= (u+1)*maxrels; c++) {
+        gl_append_ptr(un->rellist,gl_fetch(rellist,c));
+      }
     }
-    status = BinTokenCompileC(buildcommand);
-    if(status != BTE_ok){
-      MSG("Writing error msg");
-      BinTokenErrorMessage(status,root,srcname,buildcommand);
-      break; /* leave source file there to debug */
-    }else{
-      MSG("BinTokenCompileC completed OK");
-      if(g_bt_data.housekeep){
-        /* trash src */
-        cbuf = ASC_NEW_ARRAY(char,strlen(unlinkcommand)+1+strlen(srcname)+1);
-        assert(cbuf!=NULL);
-        sprintf(cbuf,"%s %s",unlinkcommand,srcname);
-        int rc = system(cbuf); /* we don't care if the delete fails */
-	if(rc){
-          MSG("delete failed: %d",rc);
-	}
-        ASC_FREE(cbuf);
-        /* trash obj */
-        if(objname && strlen(objname)){
-          cbuf = ASC_NEW_ARRAY(char,strlen(unlinkcommand)+1+strlen(objname)+1);
-          assert(cbuf!=NULL);
-          sprintf(cbuf,"%s %s",unlinkcommand,objname);
-          int rc = system(cbuf); /* we don't care if the delete fails */
-  	  if(rc){
-           MSG("delete failed: %d",rc);
-	  }
-          ASC_FREE(cbuf);
-        }
+    if (split) {
+      tag = g_bt_data.nextunit++;
+      un->srcname = BinTokenUnitName(srcname,tag);
+      if (objname != NULL && strlen(objname)) {
+        un->objname = BinTokenUnitName(objname,tag);
+      }
+      un->libname = BinTokenUnitName(libname,tag);
+    } else {
+      un->srcname = ASC_STRDUP(srcname);
+      if (objname != NULL && strlen(objname)) {
+        un->objname = ASC_STRDUP(objname);
       }
+      if (libname != NULL) {
+        un->libname = ASC_STRDUP(libname);
+      }
+    }
 
-      status = BinTokenLoadC(rellist,libname,g_bt_data.regname);
-      if(status != BTE_ok){
-        BinTokenErrorMessage(status,root,libname,buildcommand);
-        /* leave source,binary files there to debug */
-      }else{
-        MSG("BinTokenLoadC completed OK");
-        ERROR_REPORTER_HERE(ASC_PROG_NOTE,"Binary tokens compiled and loaded.\n");
+    un->status = BinTokenSharesToC(root,un->rellist,un->srcname,verbose,
+                                   buildkey,un->regname);
+    if (un->status != BTE_ok) {
+      BinTokenErrorMessage(un->status,root,un->srcname,buildcommand);
+      continue; /* leave source file there if partial */
+    }
+
+    if (cachedir != NULL) {
+      ASC_FREE(un->libname);
+      un->libname = BinTokenCacheName(cachedir,un->regname,libname);
+      un->cached = 1;
+      if (BinTokenFileExists(un->libname)) {
+        MSG("Found cached library %s",un->libname);
+        nfound++;
+        continue;
       }
+      for (k = 0; k < u; k++) {
+        if (units[k].command != NULL && !strcmp(units[k].regname,un->regname)) {
+          break;
+        }
+      }
+      if (k < u) {
+        continue; /* identical to unit k, which builds it */
+      }
+      /* build under a private name, so others never see a partial file */
+      un->outname = BinTokenUnitName(un->libname,(unsigned long)getpid());
     }
-    break;
-  default:
-    ERROR_REPORTER_HERE(ASC_PROG_ERR,"BinaryTokensCreate called with unavailable method '%d'",(int)method);
-    break;
+    if (split) {
+      to[0] = un->srcname;
+      to[1] = (un->outname != NULL) ? un->outname : un->libname;
+      to[2] = un->objname;
+      un->command = BinTokenSubst(buildcommand,3,from,to);
+    } else {
+      un->command = ASC_STRDUP(buildcommand);
+    }
+  }
+  ASC_FREE(buildkey);
+
+  BinTokenRunCommands(units,nunits,BinTokenJobs());
+
+  /* load in order, so that btable numbers follow the relation list */
+  nbuilt = nloaded = 0;
+  for (u = 0; u < nunits; u++) {
+    un = &units[u];
+    if (un->status == BTE_ok && un->command != NULL) {
+      MSG("Built %s",un->libname);
+      nbuilt++;
+      if (un->outname != NULL && rename(un->outname,un->libname)) {
+        /* another process may have put the same library in place */
+        remove(un->outname);
+        if (!BinTokenFileExists(un->libname)) {
+          un->status = BTE_write;
+          BinTokenErrorMessage(un->status,root,un->libname,buildcommand);
+          continue;
+        }
+      }
+    }else if (un->status != BTE_ok) {
+      if (un->status == BTE_build) {
+        BinTokenErrorMessage(un->status,root,un->srcname,buildcommand);
+      }
+      continue; /* leave source file there to debug */
+    }
+    if (g_bt_data.housekeep) {
+      /* trash src, obj */
+      BinTokenUnlink(un->srcname);
+      BinTokenUnlink(un->objname);
+    }
+    un->status = BinTokenLoadC(un->rellist,un->libname,un->regname,un->cached);
+    if (un->status != BTE_ok) {
+      BinTokenErrorMessage(un->status,root,un->libname,buildcommand);
+      /* leave source,binary files there to debug */
+    } else {
+      MSG("BinTokenLoadC completed OK");
+      nloaded++;
+    }
+  }
+
+  if (nloaded) {
+    if (nunits == 1 && cachedir == NULL) {
+      ERROR_REPORTER_HERE(ASC_PROG_NOTE,"Binary tokens compiled and loaded.\n");
+    } else {
+      ERROR_REPORTER_HERE(ASC_PROG_NOTE,"Binary tokens loaded from %d of %d"
+          " libraries (%d compiled, %d from cache).\n"
+          ,nloaded,nunits,nbuilt,nfound
+      );
+    }
+  }
+
+  for (u = 0; u < nunits; u++) {
+    un = &units[u];
+    if (un->rellist != rellist) {
+      gl_destroy(un->rellist);
+    }
+    if (un->srcname != NULL) ASC_FREE(un->srcname);
+    if (un->objname != NULL) ASC_FREE(un->objname);
+    if (un->libname != NULL) ASC_FREE(un->libname);
+    if (un->outname != NULL) ASC_FREE(un->outname);
+    if (un->command != NULL) ASC_FREE(un->command);
   }
+  ASC_FREE(units);
   gl_destroy(rellist);
   return;
 }
@@ -986,7 +1831,8 @@ void BinTokensCreate(struct Instance *root, enum bintoken_kind method){
 int BinTokenCalcResidual(int btable, int bindex
     , double *vars, double *residual
 ){
-  if(btable < 1 || bindex < 1){
+  /* relations of a unit which failed to load are left with btable INT_MAX */
+  if(btable < 1 || bindex < 1 || btable > g_bt_data.nextid){
     return 1;
   }
   switch (g_bt_data.tables[btable].type) {
@@ -1055,6 +1901,44 @@ int BinTokenCalcResidual(int btable, int bindex
   }
 }
 
+/*
+ * returns the C table row of btable, bindex or NULL.
+ */
+static
+struct TableC *BinTokenCRow(int btable, int bindex)
+{
+  if (btable < 1 || bindex < 1 || btable > g_bt_data.nextid
+      || g_bt_data.tables[btable].type != BT_C
+      || bindex > g_bt_data.tables[btable].size) {
+    return NULL;
+  }
+  return (struct TableC *)g_bt_data.tables[btable].tu + bindex;
+}
+
+void *BinTokenBatchKey(int btable, int bindex)
+{
+  struct TableC *row;
+  row = BinTokenCRow(btable,bindex);
+  if (row == NULL || row->B == NULL) {
+    return NULL;
+  }
+  return (void *)row->B;
+}
+
+int BinTokenCalcBatch(int btable, int bindex, int n,
+                      double *vars, double *residuals, double *gradients)
+{
+  struct TableC *row;
+  row = BinTokenCRow(btable,bindex);
+  if (row == NULL || row->B == NULL) {
+    return 1;
+  }
+  if (n > 0) {
+    (*(row->B))(n,vars,residuals,gradients);
+  }
+  return 0;
+}
+
 /*
  * Returns nonzero if can't evaluate gradient.
  * Vars is assumed already filled with values.
@@ -1063,8 +1947,8 @@ int BinTokenCalcGradient(int btable, int bindex
     ,double *vars,double *residual, double *gradient
 ){
   MSG("Calculating gradient...");
-  if(btable == 0){
-    MSG("btable is 0");
+  if(btable < 1 || btable > g_bt_data.nextid){
+    MSG("btable %d is not a loaded table",btable);
     return 1;
   }
   switch (g_bt_data.tables[btable].type) {
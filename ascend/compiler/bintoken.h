@@ -66,7 +66,10 @@ enum bintoken_kind {
 	@param unlinkcommand  command for deleting bintoken files once no longer 
 	                      required
 	@param maxreln        is the largest number of relations to be allowed in a 
-	                      single generated C file.
+	                      single generated C file. Larger models are split
+	                      into several files, built concurrently, if
+	                      buildcommand names srcname and libname (see
+	                      BinTokensCreate).
 	@param verbose        if nonzero, causes human-edible comments in generated 
 	                      code.
 	@param housekeep      if given, will cause limited OS housekeeping 
@@ -115,6 +118,15 @@ extern void BinTokenDeleteReference(int btable);
  * compiles them to source, then object, then dynamically loaded
  * library. Then associates the compiled code to the equations.
  * The language and compiler tools are determined from method.
+ *
+ * If the build command contains the srcname and libname given to
+ * BinTokenSetOptions, the equations are split into units of at most
+ * maxreln, each built into its own library by the build command with
+ * those names replaced, and up to $ASCENDBTJOBS builds run at once.
+ * If in addition $ASCENDBTCACHE names a directory, each library is
+ * kept there under a name derived from a hash of its source, the build
+ * command and ASC_BTPROLOG_ABI, and is loaded from there without
+ * building when the same unit is generated again.
  */
 ASC_DLLSPEC void BinTokensCreate(struct Instance *root, enum bintoken_kind method);
 
@@ -140,6 +152,25 @@ ASC_DLLSPEC int BinTokenCalcResidual(int btable, int bindex, double *vars, doubl
 extern int BinTokenCalcGradient(int btable, int bindex, double *vars,
                                 double *residual, double *gradient);
 
+/**
+ * Returns an identifier of the batch function of the relation indicated
+ * by btable and bindex, or NULL if there is none. Relations with the same
+ * key may be evaluated together by one call to BinTokenCalcBatch.
+ */
+ASC_DLLSPEC void *BinTokenBatchKey(int btable, int bindex);
+
+/**
+ * Calculates residuals, and gradients if gradients is not NULL, of n
+ * relations sharing the batch function of the relation indicated by
+ * btable and bindex. The values of variable j of relation i are in
+ * vars[j*n+i], its residual goes in residuals[i] and the gradient
+ * element in gradients[j*n+i].
+ * Returns nonzero if there is no batch function or it failed.
+ */
+ASC_DLLSPEC int BinTokenCalcBatch(int btable, int bindex, int n,
+                                  double *vars, double *residuals,
+                                  double *gradients);
+
 /* @} */
 
 #endif  /* ASC_BINTOKEN_H */
@@ -150,6 +150,18 @@ ASC_DLLSPEC int g_use_copyanon;
  * headered for export in compiler.h.
  */
 
+ASC_DLLSPEC int g_use_modelcache;
+/**<
+ * Turn on/off reuse of compiled simulation trees.
+ *
+ * If TRUE, a copy of each complete model built by NewInstantiate is
+ * kept (see AddModelPrototype) and copied, instead of compiled, the
+ * next time a simulation of the same type is requested. The copies are
+ * dropped when any type is replaced or the library is destroyed.
+ * This variable is defined in instantiate.c and headered for export
+ * in compiler.h.
+ */
+
 /* Simple types eligible to be ATOM children. */
 #define BASE_REAL_NAME          "real"
 #define BASE_INTEGER_NAME       "integer"
@@ -66,6 +66,7 @@
 #include "relation_util.h"
 #include "logrel_util.h"
 #include "rel_common.h"
+#include "sets.h"
 #include "case.h"
 #include "when_util.h"
 #include "universal.h"
@@ -351,10 +352,7 @@ struct Instance *CopyRelationInst(CONST struct Instance *i)
   result->logrels = NULL;
   result->anon_flags = 0x0;
   CopyTypeDesc(result->desc);
-  if(result->ptr){
-    CONSOLE_DEBUG("Clearing rel ptr %p",result->ptr);
-  }
-  result->ptr = NULL;
+  result->ptr = NULL; /* set again by CopyRelationStructures */
 
   RedoChildPointers(ChildListLen(GetChildList(result->desc)),
 		    INST(result),REL_CHILD(result,0),
@@ -381,10 +379,7 @@ struct Instance *CopyLogRelInst(CONST struct Instance *i)
   result->logrels = NULL;
   result->anon_flags = 0x0;
   CopyTypeDesc(result->desc);
-  if(result->ptr!=NULL){
-    CONSOLE_DEBUG("Clearing rel ptr %p",result->ptr);
-  }
-  result->ptr = NULL;
+  result->ptr = NULL; /* set again by CopyLogRelStructures */
   RedoChildPointers(ChildListLen(GetChildList(result->desc)),
 		    INST(result),LREL_CHILD(result,0),
 		    i,LREL_CHILD(i,0));
@@ -445,6 +440,7 @@ struct Instance *CopyModel(CONST struct Instance *i)
   result->tmp_num = 0;
   result->anon_flags = 0x0;
   result->executed = CopyBList(mod->executed);
+  result->link_table = gl_create(AVG_LINKS);
   ZeroNewChildrenEntries(MOD_CHILD(result,0),num_children);
   AssertMemory(result);
   return INST(result);
@@ -616,7 +612,7 @@ struct gl_list_t *BuildWhenCasesRefList(struct Instance *dest,
 
   lref = gl_length(srcref_list);
   destref_list = gl_create(lref);
-  for (ref=1;ref<=lref;lref++) {
+  for (ref=1;ref<=lref;ref++) {
     i = (struct Instance *)gl_fetch(srcref_list,ref);
     copynum = GetTmpNum(i);
     ptr = (struct Instance *)gl_fetch(dest_list,copynum);
@@ -647,7 +643,8 @@ static void BuildWhenCasesList(CONST struct Instance *src,
 
   for (c=1;c<=len;c++) {
     src_case = (struct Case *)gl_fetch(src_caselist,c);
-    dest_case = CreateCase(GetCaseValues(src_case),NULL);
+    /* the value set is shared; each case releases its own reference */
+    dest_case = CreateCase(CopySetByReference(GetCaseValues(src_case)),NULL);
     srcref_list = GetCaseReferences(src_case);
     destref_list = BuildWhenCasesRefList(dest,srcref_list,dest_list);
     SetCaseReferences(dest_case,destref_list);
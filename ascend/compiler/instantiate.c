@@ -59,6 +59,7 @@
 #include "rel_blackbox.h"
 #include "logrel_util.h"
 #include "instance_types.h"
+#include "instmacro.h"
 #include "cmpfunc.h"
 #include "instance_io.h"
 #include "when.h"
@@ -88,6 +89,7 @@
 #include "parpend.h"
 #include "bintoken.h"
 #include "relerr.h"
+#include "prototype.h"
 
 #include <stdarg.h>
 #include <errno.h>
@@ -165,6 +167,13 @@ int g_use_copyanon = 1;
 	copying. if 0, no copying by that method is done.
 */
 
+int g_use_modelcache = 0;
+/**
+	the user switch for reuse of completed simulation trees.
+	if nonzero, NewInstantiate keeps a copy of each complete model it
+	builds and copies that on the next request for the same type.
+*/
+
 #if TIMECOMPILER
 static
 int g_ExecuteREL_CreateTokenRelation_calls = 0;
@@ -12924,6 +12933,57 @@ struct Instance *NewRealInstantiate(struct TypeDescription *def,
   }
 }
 
+static int g_model_cacheable;
+
+static
+void CheckCacheable(struct Instance *i)
+{
+  struct BitList *blist;
+  if (i==NULL || !g_model_cacheable) {
+    return;
+  }
+  switch (InstanceKind(i)) {
+  case MODEL_INST:
+    blist = InstanceBitList(i);
+    if ((blist != NULL && !BitListEmpty(blist)) ||
+        gl_length(MOD_INST(i)->link_table) != 0) {
+      g_model_cacheable = 0;
+    }
+    /* fall through */
+  case ARRAY_INT_INST:
+  case ARRAY_ENUM_INST:
+    if (IncompleteArray(i)) {
+      g_model_cacheable = 0;
+    }
+    break;
+  case REL_INST:
+    /* black and glass box relations share per-call caches, not copyable */
+    if (GetInstanceRelationType(i) != e_token) {
+      g_model_cacheable = 0;
+    }
+    break;
+  case DUMMY_INST:
+    /* the shared unSELECTed part is not handled by CopyInstance */
+    g_model_cacheable = 0;
+    break;
+  default:
+    break;
+  }
+}
+
+/**
+	A tree can be kept for reuse by NewInstantiate only if it is complete
+	(nothing pending, no unexpanded arrays) and everything in it can be
+	duplicated by CopyInstance.
+*/
+static
+int ModelCacheable(struct Instance *root)
+{
+  g_model_cacheable = 1;
+  SilentVisitInstanceTree(root,CheckCacheable,0,0);
+  return g_model_cacheable;
+}
+
 static
 void ExecDefMethod(struct Instance *root,symchar *simname, symchar *defmethod)
 {
@@ -12957,7 +13017,17 @@ struct Instance *NewInstantiate(symchar *type, symchar *name, int intset,
 
   ClearIteration();
   result = CreateSimulationInstance(def,name);
-  root = NewRealInstantiate(def,intset);
+  root = NULL;
+  if (g_use_modelcache && (root = LookupModelPrototype(def,intset)) != NULL) {
+    root = CopyInstance(root);
+  } else {
+    root = NewRealInstantiate(def,intset);
+    if (g_use_modelcache && root != NULL && g_ExtVariablesTable == NULL &&
+        ModelCacheable(root)) {
+      /* copy before linking: CopyInstance wants a parentless tree. */
+      AddModelPrototype(def,intset,CopyInstance(root));
+    }
+  }
   LinkToParentByPos(result,root,1);
   if (g_ExtVariablesTable!=NULL) {
     SetSimulationExtVars(result,g_ExtVariablesTable);
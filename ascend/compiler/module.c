@@ -354,6 +354,7 @@ struct module_t *OpenModuleInternal(CONST char *name,
    */
   if (keep_string == NULL) {
     Asc_ScannerAssignFile(new_module->f,1);
+    Asc_ScannerOpenTokenCache(new_module->f,SCP(new_module->filename));
   } else {
     asc_assert(new_module->scanbuffer != NULL);
     Asc_ScannerAssignString(new_module->scanbuffer,1,1);
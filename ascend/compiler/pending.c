@@ -49,6 +49,20 @@
  * once FAST_PENDINGS has been fully qualified by user testing.
  */
 
+#define PENDING_CHECK 0
+/* if PENDING_CHECK, every addition to the list and every call to
+ * NumberPending walks the whole list to check it for duplicates and
+ * recount it. That makes each instantiation pass quadratic in the number
+ * of pending instances (minutes for arrays of 10^4 models), so it is only
+ * for debugging this file. With FAST_PENDINGS a duplicate addition is
+ * caught in constant time via the instance's back-pointer anyway.
+ */
+#if PENDING_CHECK
+# define ASSERT_NOT_DUPLICATED(pl,i) assert(NotDuplicated((pl),(i)))
+#else
+# define ASSERT_NOT_DUPLICATED(pl,i) ((void)0)
+#endif
+
 unsigned long g_unresolved_count=0;
 static unsigned long g_pending_count=0;
 static struct pending_t *g_pending_list = NULL;
@@ -123,7 +137,7 @@ void ReportPendingPool(FILE *f)
   pool_print_store(f,g_pending_pool,0);
 }
 
-#ifndef NDEBUG
+#if PENDING_CHECK
 static
 int NotDuplicated(struct pending_t *pl, struct Instance *inst)
 {
@@ -187,7 +201,9 @@ void ClearList(void)
 
 unsigned long NumberPending(void)
 {
+#if PENDING_CHECK
   assert(g_pending_count == CalcNumberPending());
+#endif
   return g_pending_count;
 }
 
@@ -195,7 +211,7 @@ void AddBelow(struct pending_t *pt,
 	      struct Instance *i)
 {
   struct pending_t *new;
-  assert(NotDuplicated(g_pending_list,i));
+  ASSERT_NOT_DUPLICATED(g_pending_list,i);
 #if FAST_PENDINGS
 #ifndef NDEBUG
   if (InstanceKind(i) != MODEL_INST &&
@@ -248,7 +264,7 @@ void AddBelow(struct pending_t *pt,
 void AddToEnd(struct Instance *i)
 {
   struct pending_t *ptr;
-  assert(NotDuplicated(g_pending_list,i));
+  ASSERT_NOT_DUPLICATED(g_pending_list,i);
 #if FAST_PENDINGS
 #ifndef NDEBUG
   if (InstanceKind(i) != MODEL_INST &&
@@ -320,7 +336,7 @@ void PendingInstanceRealloced(struct Instance *old, struct Instance *new)
       AssertContainedMemory(ptr,sizeof(struct pending_t));
       if (ptr->inst==old){
 	ptr->inst = new;
-	assert(NotDuplicated(ptr,old));
+	ASSERT_NOT_DUPLICATED(ptr,old);
 	return;
       }
       ptr = ptr->next;
@@ -363,7 +379,7 @@ void RemoveInstance(struct Instance *i)
   while(ptr){
     if (ptr->inst == i){
       RemoveFromList(ptr);
-      assert(NotDuplicated(g_pending_list,i));
+      ASSERT_NOT_DUPLICATED(g_pending_list,i);
       break;
     }
     ptr = ptr->next;
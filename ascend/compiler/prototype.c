@@ -51,11 +51,25 @@ struct ProtoRec {
 struct ProtoRec *g_proto_ht[PROTOTYPEHASHSIZE];
 unsigned long g_proto_count=0;
 
+/*
+ *  Completed model snapshots, see AddModelPrototype. There are only ever
+ *  a handful of these (one per simulation type compiled), so a list will do.
+ */
+struct ModelProtoRec {
+  struct ModelProtoRec *next;
+  CONST struct TypeDescription *def;
+  int intset;
+  struct Instance *i;
+};
+
+static struct ModelProtoRec *g_model_proto_list = NULL;
+
 void InitializePrototype(void)
 {
   unsigned c;
   for(c=0;c<PROTOTYPEHASHSIZE;g_proto_ht[c++]=NULL);
   g_proto_count = 0;
+  g_model_proto_list = NULL;
 }
 
 struct Instance *LookupPrototype(symchar *t)
@@ -125,6 +139,9 @@ void DeletePrototype(symchar *t)
   unsigned long bucket;
   assert(AscFindSymbol(t)!=NULL);
 
+  /* any model snapshot may contain a part of type t */
+  DestroyModelPrototypes();
+
   p = g_proto_ht[bucket = PROTOHASH(t)];
   prev = &g_proto_ht[bucket];
   while (p!=NULL) {
@@ -149,6 +166,7 @@ void DestroyPrototype(void)
 {
   unsigned c;
   struct ProtoRec *p,*next;
+  DestroyModelPrototypes();
   for(c=0;c<PROTOTYPEHASHSIZE;c++){
     if ((p=g_proto_ht[c])!=NULL) {
       g_proto_ht[c]=NULL;
@@ -165,3 +183,47 @@ void DestroyPrototype(void)
   }
   g_proto_count =0;
 }
+
+struct Instance *LookupModelPrototype(CONST struct TypeDescription *def,
+                                      int intset)
+{
+  struct ModelProtoRec *p;
+  for (p = g_model_proto_list; p != NULL; p = p->next) {
+    if (p->def == def && p->intset == intset) {
+      return p->i;
+    }
+  }
+  return NULL;
+}
+
+void AddModelPrototype(CONST struct TypeDescription *def, int intset,
+                       struct Instance *i)
+{
+  struct ModelProtoRec *p;
+  for (p = g_model_proto_list; p != NULL; p = p->next) {
+    if (p->def == def && p->intset == intset) {
+      DestroyInstance(p->i,NULL);
+      p->i = i;
+      return;
+    }
+  }
+  p = ASC_NEW(struct ModelProtoRec);
+  p->def = def;
+  p->intset = intset;
+  p->i = i;
+  p->next = g_model_proto_list;
+  g_model_proto_list = p;
+}
+
+void DestroyModelPrototypes(void)
+{
+  struct ModelProtoRec *p,*next;
+  p = g_model_proto_list;
+  g_model_proto_list = NULL;
+  while (p != NULL) {
+    next = p->next;
+    DestroyInstance(p->i,NULL);
+    ascfree(p);
+    p = next;
+  }
+}
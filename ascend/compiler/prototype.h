@@ -16,7 +16,8 @@
 	along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *//**
 	@file
-	This module stores a copy of atom instances.
+	This module stores a copy of atom instances, and snapshots of
+	completed models for reuse by NewInstantiate.
 
 	Given the amount of time we spend looking for prototypes, we need
 	to be running distinct prototype libraries for models, atoms, and
@@ -36,6 +37,8 @@
 #include "compiler.h"
 #include "instance_enum.h"
 
+struct TypeDescription;
+
 /**	@addtogroup compiler_inst Compiler Instance Hierarchy
 	@{
 */
@@ -69,6 +72,31 @@ ASC_DLLSPEC void DestroyPrototype(void);
  *  be done before the program exits.
  */
 
+extern struct Instance *LookupModelPrototype(CONST struct TypeDescription *def,
+                                             int intset);
+/**<
+ *  Return the completed model snapshot stored for def by AddModelPrototype,
+ *  or NULL if there is none. The snapshot belongs to the library; use
+ *  CopyInstance to get a tree of your own.
+ *
+ *  Model snapshots are kept apart from the atom prototypes above, which
+ *  are looked up by type name during instantiation of every part.
+ */
+
+extern void AddModelPrototype(CONST struct TypeDescription *def, int intset,
+                              struct Instance *i);
+/**<
+ *  Store i, a fully instantiated and unattached model of type def, so that
+ *  later instantiations of def can copy it instead of compiling again.
+ *  Any snapshot previously stored for def is destroyed.
+ */
+
+extern void DestroyModelPrototypes(void);
+/**<
+ *  Destroy all model snapshots. This is done by DeletePrototype and
+ *  DestroyPrototype, as a snapshot may contain parts of any type.
+ */
+
 /* @} */
 
 #endif /* ASC_PROTOTYPE_H */
@@ -105,6 +105,15 @@ struct ds_soln_list {
    double *soln;
 };
 
+/**
+	Caller-owned scratch space for the reentrant evaluation routines.
+	Grows as needed; never shared between callers.
+*/
+struct RelationEvalContext{
+  double *buf;
+  unsigned long cap;    /**< length of buf, in doubles */
+};
+
 /*
 	Define the following if you want ASCEND to panic when it hits a
 	relation error in this file. This will help with debugging (GDB).
@@ -118,6 +127,7 @@ struct ds_soln_list {
 */
 
 static struct fraction real_to_frac(double real);
+static double *RelationEvalScratch(struct RelationEvalContext *ctx, unsigned long n);
 int ArgsForRealToken(enum Expr_enum type);
 static int IsZero(struct dimnode *node);
 
@@ -1006,13 +1016,14 @@ RelationEvaluateResidualPostfix(CONST struct relation *r)
 	Computes the gradients by maintaining n stacks, where
 		n = (number-of-variables-in-r + 1)
 	The +1 is for the residual.  The stacks come from a single array which
-	this function gets by calling tmpalloc_array.  Two macros are defined
-	to make referencing this array easier.
+	this function gets from ctx, or by calling tmpalloc_array if ctx is
+	NULL.  Two macros are defined to make referencing this array easier.
 */
 static int
 RelationEvaluateResidualGradient(CONST struct relation *r,
                                  double *residual,
-                                 double *gradient)
+                                 double *gradient,
+                                 struct RelationEvalContext *ctx)
 {
   unsigned long t;       /* the current term in the relation r */
   unsigned long num_var; /* the number of variables in the relation r */
@@ -1040,7 +1051,7 @@ RelationEvaluateResidualGradient(CONST struct relation *r,
   }
 
   /* create the stacks */
-  stacks = tmpalloc_array(((num_var+1)*stack_height),double);
+  stacks = RelationEvalScratch(ctx,(num_var+1)*stack_height);
   if( stacks == NULL ) return 1;
 
 #define res_stack(s)    stacks[(s)]
@@ -1209,7 +1220,8 @@ static int
 RelationEvaluateResidualGradientSafe(CONST struct relation *r,
                                      double *residual,
                                      double *gradient,
-                                     enum safe_err *serr)
+                                     enum safe_err *serr,
+                                     struct RelationEvalContext *ctx)
 {
   unsigned long t;       /* the current term in the relation r */
   unsigned long num_var; /* the number of variables in the relation r */
@@ -1236,7 +1248,7 @@ RelationEvaluateResidualGradientSafe(CONST struct relation *r,
   }
 
   /* create the stacks */
-  stacks = tmpalloc_array(((num_var+1)*stack_height),double);
+  stacks = RelationEvalScratch(ctx,(num_var+1)*stack_height);
   if( stacks == NULL ) return 1;
 
 #define res_stack(s)    stacks[(s)]
@@ -2261,19 +2273,22 @@ int RelationCalcGradientBinary(CONST struct relation *r, double *resid,double *g
   return ret;
 }
 
-enum safe_err
-RelationCalcResidualPostfixSafe(struct Instance *i, double *res){
+/**
+	Body of RelationCalcResidualPostfixSafe. If report is zero nothing is
+	reported, so that it may be called from worker threads; the caller
+	then reports the returned code itself.
+*/
+static enum safe_err
+RelationCalcResidualPostfixSafeRep(struct Instance *i, double *res, int report){
   struct relation *r;
   enum Expr_enum reltype;
   enum safe_err status = safe_ok;
   unsigned long length_lhs, length_rhs;
 
-  CHECK_INST_RES(i,res,1);
-
   r = (struct relation *)GetInstanceRelation(i, &reltype);
 
   if( r == NULL ) {
-    ERROR_REPORTER_HERE(ASC_PROG_ERR,"null relation");
+    if(report)ERROR_REPORTER_HERE(ASC_PROG_ERR,"null relation");
     return safe_problem;
   }
 
@@ -2294,13 +2309,15 @@ RelationCalcResidualPostfixSafe(struct Instance *i, double *res){
         *res -= RelationEvaluatePostfixBranchSafe(r, &length_rhs, 0,&status);
       }
 
-      safe_error_to_stderr(&status);
+      if(report)safe_error_to_stderr(&status);
       break;
     case e_blackbox:
       if(RelationCalcResidualPostfix(i,res) != 0) {
-        CONSOLE_DEBUG("Problem evaluating Blackbox residual");
         status = safe_problem;
-        safe_error_to_stderr(&status);
+        if(report){
+          CONSOLE_DEBUG("Problem evaluating Blackbox residual");
+          safe_error_to_stderr(&status);
+        }
       }
       break;
 #if 0
@@ -2323,6 +2340,12 @@ RelationCalcResidualPostfixSafe(struct Instance *i, double *res){
   return status;
 }
 
+enum safe_err
+RelationCalcResidualPostfixSafe(struct Instance *i, double *res){
+  CHECK_INST_RES(i,res,1);
+  return RelationCalcResidualPostfixSafeRep(i,res,1);
+}
+
 /* return 0 on success */
 int
 RelationCalcResidualPostfix(struct Instance *i, double *res){
@@ -2537,7 +2560,7 @@ int RelationCalcResidGrad(struct Instance *i, double *residual, double *gradient
   }
 
   if(reltype == e_token ){
-    return RelationEvaluateResidualGradient(r, residual, gradient);
+    return RelationEvaluateResidualGradient(r, residual, gradient, NULL);
   }
 
   if(reltype == e_blackbox){
@@ -2590,7 +2613,7 @@ enum safe_err RelationCalcResidGradSafe(struct Instance *i
     if(BinTokenCalcGradient(int btable, int bindex, double *vars,
                                 double *residual, double *gradient);
 #endif
-    RelationEvaluateResidualGradientSafe(r, residual, gradient, &not_safe);
+    RelationEvaluateResidualGradientSafe(r, residual, gradient, &not_safe, NULL);
     MSG("Relation Type: e_token");
     return not_safe;
   }
@@ -2931,6 +2954,133 @@ enum safe_err RelationCalcHessianMtxSafe(struct Instance *i, ltmatrix *hess_mtx,
 
 /**------------------------------------------------------------------------------------------ */
 
+/*------------------------------------------------------------------------------
+  REENTRANT EVALUATION
+
+  These mirror the routines above but take their scratch space from a
+  caller-owned RelationEvalContext instead of tmpalloc, and touch no file
+  statics, so distinct contexts may be used concurrently.
+*/
+
+struct RelationEvalContext *RelationEvalContextCreate(void){
+  struct RelationEvalContext *ctx;
+  ctx = ASC_NEW(struct RelationEvalContext);
+  ctx->buf = NULL;
+  ctx->cap = 0;
+  return ctx;
+}
+
+void RelationEvalContextDestroy(struct RelationEvalContext *ctx){
+  if(ctx == NULL) return;
+  if(ctx->buf != NULL) ASC_FREE(ctx->buf);
+  ASC_FREE(ctx);
+}
+
+/**
+	Return at least n doubles of scratch space, from ctx if given, else
+	from the shared (non-reentrant) tmpalloc buffer.
+*/
+static double *RelationEvalScratch(struct RelationEvalContext *ctx, unsigned long n){
+  if(ctx == NULL) return tmpalloc_array(n,double);
+  if(n > ctx->cap){
+    if(ctx->buf != NULL) ASC_FREE(ctx->buf);
+    ctx->buf = ASC_NEW_ARRAY(double,n);
+    ctx->cap = (ctx->buf != NULL) ? n : 0;
+  }
+  return ctx->buf;
+}
+
+int RelationCalcResidualCtx(struct RelationEvalContext *ctx
+    , struct Instance *i, double *res
+){
+  (void)ctx; /* the recursive postfix evaluator needs no scratch space */
+  return RelationCalcResidualPostfix(i,res);
+}
+
+enum safe_err RelationCalcResidualSafeCtx(struct RelationEvalContext *ctx
+    , struct Instance *i, double *res
+){
+  (void)ctx;
+  CHECK_INST_RES(i,res,safe_problem);
+  return RelationCalcResidualPostfixSafeRep(i,res,0);
+}
+
+int RelationCalcResidGradCtx(struct RelationEvalContext *ctx
+    , struct Instance *i, double *residual, double *gradient
+){
+  struct relation *r;
+  enum Expr_enum reltype;
+
+  asc_assert(ctx != NULL);
+  CHECK_INST_RES(i,residual,1);
+
+  r = (struct relation *)GetInstanceRelation(i, &reltype);
+  if( r == NULL ) {
+    ERROR_REPORTER_HERE(ASC_PROG_ERR,"null relation");
+    return 1;
+  }
+  if(reltype == e_token){
+    return RelationEvaluateResidualGradient(r, residual, gradient, ctx);
+  }
+  if(reltype == e_blackbox){
+    return BlackBoxCalcResidGrad(i, residual, gradient, r);
+  }
+  ERROR_REPORTER_HERE(ASC_PROG_ERR,"reltype %d not implemented",reltype);
+  return 1;
+}
+
+enum safe_err RelationCalcResidGradSafeCtx(struct RelationEvalContext *ctx
+    , struct Instance *i, double *residual, double *gradient
+){
+  struct relation *r;
+  enum Expr_enum reltype;
+  enum safe_err not_safe = safe_ok;
+
+  asc_assert(ctx != NULL);
+  r = (struct relation *)GetInstanceRelation(i, &reltype);
+  if( r == NULL ) {
+    return safe_problem;
+  }
+  if(reltype == e_token){
+    RelationEvaluateResidualGradientSafe(r, residual, gradient, &not_safe, ctx);
+    return not_safe;
+  }
+  if(reltype == e_blackbox){
+    if(BlackBoxCalcResidGrad(i, residual, gradient, r)){
+      not_safe = safe_problem;
+    }
+    return not_safe;
+  }
+  return safe_problem;
+}
+
+int RelationCalcResidGradRevCtx(struct RelationEvalContext *ctx
+    , struct Instance *i, double *residual, double *gradient
+){
+  (void)ctx; /* the reverse AD tape is allocated per call */
+  return RelationCalcResidGradRev(i,residual,gradient);
+}
+
+enum safe_err RelationCalcResidGradRevSafeCtx(struct RelationEvalContext *ctx
+    , struct Instance *i, double *residual, double *gradient
+){
+  (void)ctx;
+  return RelationCalcResidGradRevSafe(i,residual,gradient);
+}
+
+int RelationCalcHessianMtxCtx(struct RelationEvalContext *ctx
+    , struct Instance *i, ltmatrix *hess_mtx, unsigned long dimension
+){
+  (void)ctx;
+  return RelationCalcHessianMtx(i,hess_mtx,dimension);
+}
+
+enum safe_err RelationCalcHessianMtxSafeCtx(struct RelationEvalContext *ctx
+    , struct Instance *i, ltmatrix *hess_mtx, unsigned long dimension
+){
+  (void)ctx;
+  return RelationCalcHessianMtxSafe(i,hess_mtx,dimension);
+}
 
 /*
 	calculate the derivative with respect to a single variable
@@ -4420,7 +4570,7 @@ void CollectShares(struct Instance *i,struct ctrwubs *data){
    * Previously built shared have a btable > 0 and < INT_MAX.
    * Collected relations have btable = INT_MAX.
    */
-  if(gl_length(data->list) <= data->maxlen) {
+  if(data->maxlen == 0 || gl_length(data->list) <= data->maxlen) {
     if(i!=NULL &&
         InstanceKind(i) == REL_INST &&
         GetInstanceRelationType(i) == e_token &&
@@ -4443,7 +4593,7 @@ CollectTokenRelationsWithUniqueBINlessShares(struct Instance *i,
   struct Instance *rel;
   struct relation *r;
   unsigned long c;
-  data.list = gl_create(maxlen);
+  data.list = gl_create(maxlen ? maxlen : 100L);
   data.overflowed = 0;
   data.maxlen = maxlen;
   if(data.list == NULL) {
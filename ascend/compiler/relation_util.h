@@ -697,6 +697,69 @@ ASC_DLLSPEC enum safe_err RelationCalcHessianMtxSafe(struct Instance *i, ltmatri
 	Safe Version
  */
 
+/*------------------------------------------------------------------------------
+	REENTRANT EVALUATION
+*/
+
+struct RelationEvalContext;
+/**<
+	Opaque, caller-owned scratch space for relation evaluation.
+
+	The routines above that take no context share a static buffer (tmpalloc)
+	and so must not be called from more than one thread at a time. The
+	...Ctx variants below take all their scratch space from the context
+	and use no file statics, so they may be called concurrently provided
+	each thread uses its own context and the relations' variable values are
+	not being modified meanwhile. Blackbox relations are passed through to
+	the external code, which must itself be reentrant for this to hold.
+*/
+
+ASC_DLLSPEC struct RelationEvalContext *RelationEvalContextCreate(void);
+/**< Create an empty evaluation context. Its buffers grow on demand. */
+
+ASC_DLLSPEC void RelationEvalContextDestroy(struct RelationEvalContext *ctx);
+/**< Free a context created by RelationEvalContextCreate. NULL is ignored. */
+
+ASC_DLLSPEC int RelationCalcResidualCtx(struct RelationEvalContext *ctx
+		, struct Instance *i, double *res);
+/**< Reentrant equivalent of RelationCalcResidual. */
+
+ASC_DLLSPEC enum safe_err RelationCalcResidualSafeCtx(
+		struct RelationEvalContext *ctx, struct Instance *i, double *res);
+/**<
+	Reentrant equivalent of RelationCalcResidualSafe. Evaluation errors are
+	not reported, only returned, so that the caller can report them (with
+	safe_error_to_stderr) from a single thread in a deterministic order.
+*/
+
+ASC_DLLSPEC int RelationCalcResidGradCtx(struct RelationEvalContext *ctx
+		, struct Instance *i, double *residual, double *gradient);
+/**< Reentrant equivalent of RelationCalcResidGrad. */
+
+ASC_DLLSPEC enum safe_err RelationCalcResidGradSafeCtx(
+		struct RelationEvalContext *ctx, struct Instance *i
+		, double *residual, double *gradient);
+/**< Reentrant equivalent of RelationCalcResidGradSafe. Errors are only
+	returned, as for RelationCalcResidualSafeCtx. */
+
+ASC_DLLSPEC int RelationCalcResidGradRevCtx(struct RelationEvalContext *ctx
+		, struct Instance *i, double *residual, double *gradient);
+/**< Reentrant equivalent of RelationCalcResidGradRev. */
+
+ASC_DLLSPEC enum safe_err RelationCalcResidGradRevSafeCtx(
+		struct RelationEvalContext *ctx, struct Instance *i
+		, double *residual, double *gradient);
+/**< Reentrant equivalent of RelationCalcResidGradRevSafe. */
+
+ASC_DLLSPEC int RelationCalcHessianMtxCtx(struct RelationEvalContext *ctx
+		, struct Instance *i, ltmatrix *hess_mtx, unsigned long dimension);
+/**< Reentrant equivalent of RelationCalcHessianMtx. */
+
+ASC_DLLSPEC enum safe_err RelationCalcHessianMtxSafeCtx(
+		struct RelationEvalContext *ctx, struct Instance *i
+		, ltmatrix *hess_mtx, unsigned long dimension);
+/**< Reentrant equivalent of RelationCalcHessianMtxSafe. */
+
 /*------------------------------------------------------------------------------
 	ROOT FINDING FUNCTIONS (deprecated?)
 */
@@ -750,7 +813,8 @@ struct gl_list_t *CollectTokenRelationsWithUniqueBINlessShares(
 	(or at least attempted so) to binary form yet.
 	If more than maxlen are found, returns NULL instead. Presumably there
 	is some upper limit beyond which you don't want to know the answer to
-	this question. If none are found, returns a 0 length list.
+	this question. If maxlen is 0, there is no limit.
+	If none are found, returns a 0 length list.
 	Actually, it is not a share that is collected, but instead any
 	one of the relation instances which use the share is collected.
 	The list returned should be destroyed by the user (not its content,though).
@@ -59,6 +59,16 @@ extern void Asc_ScannerAssignFile(FILE *f, unsigned long linenum);
  *  Change the input to file f and reset the line count to linenum.
  */
 
+extern void Asc_ScannerOpenTokenCache(FILE *f, CONST char *filename);
+/**<
+ *  Set up the token cache (see tokencache.h) for the module file f just
+ *  given to Asc_ScannerAssignFile, whose name is filename.  If the cache
+ *  holds the tokens of a file with the same contents, they are replayed
+ *  instead of scanning f; otherwise the tokens scanned from f are
+ *  recorded and written to the cache at end of file.  Does nothing
+ *  unless token caching is enabled.
+ */
+
 extern void Asc_ScannerAssignString(void *yybs, unsigned long linenum, int first);
 /**<
  *  Change the input to string buffer yybs and reset the line count to linenum.
@@ -1337,6 +1337,7 @@ char *yytext_ptr;
 #include "../compiler/scanner.h"
 #include "../compiler/symtab.h"
 #include "../compiler/parser.h"
+#include "../compiler/tokencache.h"
 
 #define YY_BREAK
 /*  Defining yybreak as above means that all of our matches must end
@@ -1351,6 +1352,18 @@ char *yytext_ptr;
  *  This to must be 0 or negative according to yacc
  */
 
+#define RESUMETOK (-1)
+/*  Return value of Asc_ScannerScan when it has popped back to a file
+ *  whose tokens are being replayed from the token cache.  Never seen
+ *  by the parser; yylex carries on with the replay instead.
+ */
+
+#define YY_DECL static int Asc_ScannerScan(void)
+/*  The scanner generated by Flex.  The parser calls yylex (at the end
+ *  of this file), which replays or records tokens in the token cache
+ *  (see tokencache.h) around calls to Asc_ScannerScan.
+ */
+
 #define MAX_REQUIRE_DEPTH 10
 /*  The maximum number of REQUIREd file nesting we will accept.
  *  See RequireStack below.
@@ -1394,6 +1407,12 @@ static YY_BUFFER_STATE RequireStack[MAX_REQUIRE_DEPTH];
 /* The Flex buffers used for the REQUIREd files
  */
 
+static struct TokenCache *TokenStack[MAX_REQUIRE_DEPTH+1];
+/*  The token cache streams of the files being scanned, indexed by
+ *  RequireIndex: TokenStack[RequireIndex] belongs to the current file.
+ *  NULL where a file is neither replayed nor recorded.
+ */
+
 static char *g_workbuf = NULL;
 /*  We need a place to keep doubly-quoted-text and braced-text for passing
  *  it back to the parser.  yytext will not work since the parser may ask
@@ -2497,8 +2516,11 @@ case YY_STATE_EOF(Comment):
 				   */
 				  ErrMsg_CommentEOF();
 				  CommentNestLevel = 0;
-				  if ( Asc_ScannerPopBuffer() == 1 ) {
+				  switch ( Asc_ScannerPopBuffer() ) {
+				  case 1:
 				    return ENDTOK;
+				  case 2:
+				    return RESUMETOK;
 				  }
 				  break;
 				}
@@ -2568,8 +2590,11 @@ case YY_STATE_EOF(Symbol):
 				   *  pop fails due to no more input.
 				   */
 				  ErrMsg_SymbolEOF();
-				  if ( Asc_ScannerPopBuffer() == 1 ) {
+				  switch ( Asc_ScannerPopBuffer() ) {
+				  case 1:
 				    return ENDTOK;
+				  case 2:
+				    return RESUMETOK;
 				  }
 				  break;
 				}
@@ -2688,8 +2713,11 @@ case YY_STATE_EOF(DoubleQuote):
 				   */
 				  ErrMsg_DoubleQuoteEOF();
 				  MatchedBackslash = 0;
-				  if ( Asc_ScannerPopBuffer() == 1 ) {
+				  switch ( Asc_ScannerPopBuffer() ) {
+				  case 1:
 				    return ENDTOK;
+				  case 2:
+				    return RESUMETOK;
 				  }
 				  break;
 				}
@@ -2863,8 +2891,11 @@ case YY_STATE_EOF(BracedText):
 				  ErrMsg_BracesEOF();
 				  BracesNestLevel = 0;
 				  MatchedBackslash = 0;
-				  if ( Asc_ScannerPopBuffer() == 1 ) {
+				  switch ( Asc_ScannerPopBuffer() ) {
+				  case 1:
 				    return ENDTOK;
+				  case 2:
+				    return RESUMETOK;
 				  }
 				  break;
 				}
@@ -2958,8 +2989,11 @@ case YY_STATE_EOF(INITIAL):
 				   *  ENDTOK if no more input.
 				   */
 				  Asc_ErrMsgTypeDefnEOF();
-				  if ( Asc_ScannerPopBuffer() == 1 ) {
+				  switch ( Asc_ScannerPopBuffer() ) {
+				  case 1:
 				    return ENDTOK;
+				  case 2:
+				    return RESUMETOK;
 				  }
 				  break;
 				}
@@ -3983,6 +4017,118 @@ LineNum(void)
 }
 
 
+/*
+ *  int yylex(void);
+ *
+ *  The scanner called by the parser.  If the tokens of the current file
+ *  are being replayed from the token cache, return the next one (setting
+ *  zz_lval and yy_line as Asc_ScannerScan would have done) and pop back
+ *  to the REQUIRing file at the end of the stream.  Otherwise call
+ *  Asc_ScannerScan, recording the token if the current file's stream
+ *  is recording.
+ */
+int
+yylex(void)
+{
+  struct TokenCache *tc;
+  struct TokenCacheToken t;
+  int tok;
+
+  for (;;) {
+    tc = TokenStack[RequireIndex];
+    if ( tc != NULL && TokenCacheReplaying(tc) ) {
+      if ( TokenCacheNext(tc, &t) ) {
+        yy_line = t.line;
+        switch (t.tok) {
+        case REAL_TOK:
+          zz_lval.real_value = t.v.real_value;
+          break;
+        case INTEGER_TOK:
+          zz_lval.int_value = t.v.int_value;
+          break;
+        case IDENTIFIER_TOK:
+          zz_lval.id_ptr = t.v.sym_ptr;
+          break;
+        case SYMBOL_TOK:
+          zz_lval.sym_ptr = t.v.sym_ptr;
+          break;
+        case DQUOTE_TOK:
+          zz_lval.dquote_ptr = CopyIntoWorkBuffer(t.v.text, strlen(t.v.text));
+          break;
+        case BRACEDTEXT_TOK:
+          zz_lval.braced_ptr = CopyIntoWorkBuffer(t.v.text, strlen(t.v.text));
+          break;
+        default:
+          break;
+        }
+        return t.tok;
+      }
+      /*  End of the replayed file: as for <INITIAL><<EOF>> below.
+       */
+      yy_line = TokenCacheLastLine(tc);
+      Asc_ErrMsgTypeDefnEOF();
+      if ( Asc_ScannerPopBuffer() == 1 ) {
+        return ENDTOK;
+      }
+      continue;
+    }
+
+    tok = Asc_ScannerScan();
+    if ( tok == RESUMETOK ) {
+      continue;
+    }
+    tc = TokenStack[RequireIndex];
+    if ( tc != NULL && tok != ENDTOK ) {
+      switch (tok) {
+      case REAL_TOK:
+        TokenCacheAddReal(tc, tok, yy_line, zz_lval.real_value);
+        break;
+      case INTEGER_TOK:
+        TokenCacheAddInteger(tc, tok, yy_line, zz_lval.int_value);
+        break;
+      case IDENTIFIER_TOK:
+        TokenCacheAddSymbol(tc, tok, yy_line, zz_lval.id_ptr);
+        break;
+      case SYMBOL_TOK:
+        TokenCacheAddSymbol(tc, tok, yy_line, zz_lval.sym_ptr);
+        break;
+      case DQUOTE_TOK:
+        TokenCacheAddText(tc, tok, yy_line, zz_lval.dquote_ptr);
+        break;
+      case BRACEDTEXT_TOK:
+        TokenCacheAddText(tc, tok, yy_line, zz_lval.braced_ptr);
+        break;
+      default:
+        TokenCacheAdd(tc, tok, yy_line);
+        break;
+      }
+    }
+    return tok;
+  }
+}
+
+
+/*
+ *  See the header file scanner.h for a description of this function.
+ *  The cache file signature combines token numbers from across the
+ *  grammar, so that caches written by a differently numbered parser
+ *  are not replayed.
+ */
+void
+Asc_ScannerOpenTokenCache(FILE *f, CONST char *filename)
+{
+  unsigned long grammar;
+
+  grammar = ((unsigned long)ADD_TOK << 20)
+            ^ ((unsigned long)MODEL_TOK << 10)
+            ^ ((unsigned long)WITH_VALUE_T << 5)
+            ^ ((unsigned long)DQUOTE_TOK << 15)
+            ^ (unsigned long)UPLUS_TOK;
+  TokenCacheClose(TokenStack[RequireIndex], FALSE, 0);
+  TokenStack[RequireIndex] = TokenCacheOpen(f, filename, grammar);
+}
+
+
 /*
  *  See the header file scanner.h for a description of this function.
  */
@@ -4084,12 +4230,17 @@ Asc_ScannerPushBuffer(CONST char *filename)
  *
  *  When we reach an End Of File (EOF) in the scanner, we call this
  *  function to pop us to the file which REQUIREd the file we just
- *  reached the end of and return 0.  If there are no more files on the
- *  RequireStack, return 1.
+ *  reached the end of and return 0, or 2 if the tokens of that file
+ *  are being replayed from the token cache.  If there are no more files
+ *  on the RequireStack, return 1.
+ *  The token cache stream of the file just finished is written out if
+ *  it was recording.
  */
 static int
 Asc_ScannerPopBuffer(void)
 {
+  TokenCacheClose(TokenStack[RequireIndex], TRUE, yy_line);
+  TokenStack[RequireIndex] = NULL;
   Asc_CloseCurrentModule(); /* the current module may be NULL. */
   if ( RequireIndex == 0 ) {
     return 1;
@@ -4098,6 +4249,10 @@ Asc_ScannerPopBuffer(void)
   yy_delete_buffer(YY_CURRENT_BUFFER);
   yy_switch_to_buffer( RequireStack[--RequireIndex] );
   BEGIN(INITIAL);
+  if ( TokenStack[RequireIndex] != NULL
+       && TokenCacheReplaying(TokenStack[RequireIndex]) ) {
+    return 2;
+  }
   return 0;
 }
 
@@ -4114,6 +4269,9 @@ void *Asc_ScannerCreateStringBuffer(CONST char *string, int len)
   YY_BUFFER_STATE yybs;
   /* push current, don't care its name or type. */
   RequireStack[RequireIndex++] = YY_CURRENT_BUFFER;
+  /* strings are never cached */
+  TokenCacheClose(TokenStack[RequireIndex], FALSE, 0);
+  TokenStack[RequireIndex] = NULL;
   yybs = yy_scan_bytes(string, len);
   assert(yybs);
   return (void *)yybs;
@@ -4170,6 +4328,11 @@ Asc_DestroyScannerWorkBuffer(void)
 
 void Asc_DestroyScannerInputBuffer(void)
 {
+  int i;
+  for (i = 0; i <= MAX_REQUIRE_DEPTH; i++) {
+    TokenCacheClose(TokenStack[i], FALSE, 0);
+    TokenStack[i] = NULL;
+  }
   if (YY_CURRENT_BUFFER != NULL) {
     yy_delete_buffer(YY_CURRENT_BUFFER);
   }
@@ -4289,6 +4452,7 @@ Process_Backslashes(void)
  */
 static void
 ErrMsg_BracesEOF(void){
+	TokenCacheInvalidate(TokenStack[RequireIndex]);
 	error_reporter(ASC_USER_ERROR, Asc_ModuleBestName(Asc_CurrentModule()), start_line, NULL
 		,"End of file reached within a unit, data table or explanation. No closing brace "
 		"found for open brace."
@@ -4299,6 +4463,7 @@ ErrMsg_BracesEOF(void){
 static void
 ErrMsg_CommentEOF(void)
 {
+  TokenCacheInvalidate(TokenStack[RequireIndex]);
   FPRINTF(ASCERR,
           "Error:\tEnd of file reached within a comment.\n"
 	  "\tNo close-comment found for comment starting on line %s:%lu\n",
@@ -4309,6 +4474,7 @@ ErrMsg_CommentEOF(void)
 static void
 ErrMsg_LongID(void)
 {
+  TokenCacheInvalidate(TokenStack[RequireIndex]);
   FPRINTF(ASCERR,
 	  "Error:\tIdentifier too long on line %s:%lu.\n"
 	  "\tIdentifier \"%s\" exceeds the maximum identifier size of %d\n",
@@ -4322,6 +4488,7 @@ ErrMsg_LongID(void)
 static void
 ErrMsg_LongSymbol(void)
 {
+  TokenCacheInvalidate(TokenStack[RequireIndex]);
   FPRINTF(ASCERR,
 	  "Error:\tSymbol too long on line %s:%lu.\n"
 	  "\tSymbol %s exceeds the maximum symbol size of %d\n",
@@ -4335,6 +4502,7 @@ ErrMsg_LongSymbol(void)
 static void
 ErrMsg_DoubleQuoteEOF(void)
 {
+  TokenCacheInvalidate(TokenStack[RequireIndex]);
   FPRINTF(ASCERR,
           "Error:\tEnd of file reached with a double quoted string.\n"
 	  "\tNo close quote found for the open quote on line %s:%lu\n",
@@ -4345,6 +4513,7 @@ ErrMsg_DoubleQuoteEOF(void)
 static void
 ErrMsg_SymbolEOF(void)
 {
+  TokenCacheInvalidate(TokenStack[RequireIndex]);
   FPRINTF(ASCERR,
           "Error:\tEnd of file reached within a symbol.\n"
 	  "\tNo close quote found for symbol on line %s:%lu\n",
@@ -4355,6 +4524,7 @@ ErrMsg_SymbolEOF(void)
 static void
 ErrMsg_SymbolEOL(void)
 {
+  TokenCacheInvalidate(TokenStack[RequireIndex]);
   FPRINTF(ASCERR,
           "Error:\tEnd of line reached within a symbol.\n"
 	  "\tNo close quote found for symbol on line %s:%lu\n",
@@ -4364,6 +4534,7 @@ ErrMsg_SymbolEOL(void)
 #define ERRCOUNT_UNEXPCHAR 5
 static void ErrMsg_UnexpectedChar(){
 	static int errcount=0;
+	TokenCacheInvalidate(TokenStack[RequireIndex]);
 	if(errcount<ERRCOUNT_UNEXPCHAR){
 		error_reporter(ASC_USER_ERROR
 			,Asc_ModuleBestName(Asc_CurrentModule()), yy_line, NULL
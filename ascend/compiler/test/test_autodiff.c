@@ -642,13 +642,124 @@ static void AutomateDiffTest(struct Instance *inst, VOIDPTR ptr){
 	RETURN;
 #undef RETURN
 }
+/*------------------------------------------------------------------------------
+	Reentrant evaluation: the ...Ctx routines must give exactly the results
+	of the usual ones, and the safe ones must only return their errors.
+*/
+
+static struct gl_list_t *g_ctxrels;
+
+static void collect_ctxrels(struct Instance *i){
+	if(i != NULL && InstanceKind(i) == REL_INST){
+		gl_append_ptr(g_ctxrels,(VOIDPTR)i);
+	}
+}
+
+static void check_evalctx(struct RelationEvalContext *ctx, struct Instance *i){
+	double r, rc, g[3], gc[3];
+	unsigned long j, n;
+	enum safe_err s, sc;
+
+	n = NumberVariables(GetInstanceRelationOnly(i));
+	CU_ASSERT_FATAL(n <= 3);
+
+	CU_ASSERT(0 == RelationCalcResidual(i,&r));
+	CU_ASSERT(0 == RelationCalcResidualCtx(ctx,i,&rc));
+	CU_ASSERT(r == rc);
+
+	s = RelationCalcResidualSafe(i,&r);
+	sc = RelationCalcResidualSafeCtx(ctx,i,&rc);
+	CU_ASSERT(s == safe_ok && sc == safe_ok);
+	CU_ASSERT(r == rc);
+
+	CU_ASSERT(0 == RelationCalcResidGrad(i,&r,g));
+	CU_ASSERT(0 == RelationCalcResidGradCtx(ctx,i,&rc,gc));
+	CU_ASSERT(r == rc);
+	for(j = 0; j < n; ++j)CU_ASSERT(g[j] == gc[j]);
+
+	s = RelationCalcResidGradSafe(i,&r,g);
+	sc = RelationCalcResidGradSafeCtx(ctx,i,&rc,gc);
+	CU_ASSERT(s == safe_ok && sc == safe_ok);
+	CU_ASSERT(r == rc);
+	for(j = 0; j < n; ++j)CU_ASSERT(g[j] == gc[j]);
+
+	CU_ASSERT(0 == RelationCalcResidGradRev(i,&r,g));
+	CU_ASSERT(0 == RelationCalcResidGradRevCtx(ctx,i,&rc,gc));
+	CU_ASSERT(r == rc);
+	for(j = 0; j < n; ++j)CU_ASSERT(g[j] == gc[j]);
+}
+
+static void test_evalctx(void){
+	struct Instance *sim, *root, *x, *e1;
+	struct RelationEvalContext *ctx;
+	struct Name *name;
+	enum Proc_enum pe;
+	enum safe_err s, sc;
+	double r, rc, g[3];
+	unsigned long c;
+	int status;
+
+	Asc_CompilerInit(1);
+	Asc_PutEnv(ASC_ENV_LIBRARY "=models");
+
+#define TESTFILE "evalctx"
+	Asc_OpenModule("test/compiler/" TESTFILE ".a4c",&status);
+	CU_ASSERT_FATAL(status == 0);
+	CU_ASSERT_FATAL(0 == zz_parse());
+	CU_ASSERT_FATAL(FindType(AddSymbol(TESTFILE))!=NULL);
+	sim = SimsCreateInstance(AddSymbol(TESTFILE), AddSymbol("sim1"), e_normal, NULL);
+	CU_ASSERT_FATAL(sim!=NULL);
+	root = GetSimulationRoot(sim);
+	name = CreateIdName(AddSymbol("on_load"));
+	pe = Initialize(root,name,"sim1",ASCERR,WP_STOPONERR,NULL,NULL);
+	DestroyName(name);
+	CU_ASSERT_FATAL(pe == Proc_all_ok);
+
+	g_ctxrels = gl_create(10L);
+	VisitInstanceTree(root,collect_ctxrels,0,0);
+	CU_ASSERT(gl_length(g_ctxrels) == 3);
+
+	ctx = RelationEvalContextCreate();
+	CU_ASSERT_FATAL(ctx != NULL);
+	for(c = 1; c <= gl_length(g_ctxrels); ++c){
+		check_evalctx(ctx,(struct Instance *)gl_fetch(g_ctxrels,c));
+	}
+
+	/* a safe failure gives the same code as the usual routine, unreported */
+	x = ChildByChar(root,AddSymbol("x"));
+	e1 = ChildByChar(root,AddSymbol("e1"));
+	CU_ASSERT_FATAL(x != NULL && e1 != NULL);
+	SetRealAtomValue(x,0.0,0);
+	s = RelationCalcResidualSafe(e1,&r);
+	error_reporter_tree_start();
+	sc = RelationCalcResidualSafeCtx(ctx,e1,&rc);
+	CU_ASSERT(0 == error_reporter_tree_has_error());
+	error_reporter_tree_end();
+	CU_ASSERT(s != safe_ok);
+	CU_ASSERT(sc == s);
+	error_reporter_tree_start();
+	sc = RelationCalcResidGradSafeCtx(ctx,e1,&rc,g);
+	CU_ASSERT(0 == error_reporter_tree_has_error());
+	error_reporter_tree_end();
+	CU_ASSERT(sc != safe_ok);
+
+	RelationEvalContextDestroy(ctx);
+	RelationEvalContextDestroy(NULL);
+	gl_destroy(g_ctxrels);
+	g_ctxrels = NULL;
+	sim_destroy(sim);
+	Asc_CompilerDestroy();
+#undef TESTFILE
+}
+
 /*===========================================================================*/
 /* Registration information */
 
 /* the list of tests */
 
 #define TESTS(T) \
-  T(autodiff)
+  T(autodiff) \
+  T(evalctx)
 
 REGISTER_TESTS_SIMPLE(compiler_autodiff, TESTS)
 
@@ -18,6 +18,8 @@
 	Unit test functions for compiler. Nothing here yet.
 */
 #include <string.h>
+#include <dirent.h>
+#include <unistd.h>
 
 #include <ascend/general/env.h>
 #include <ascend/general/platform.h>
@@ -36,6 +38,7 @@
 #include <ascend/compiler/childio.h>
 
 #include <ascend/compiler/initialize.h>
+#include <ascend/compiler/tokencache.h>
 
 #include <test/common.h>
 #include <test/assertimpl.h>
@@ -246,6 +249,72 @@ static void test_parse_file(void){
 	Asc_CompilerDestroy();
 }
 
+/*
+	Parse system.a4l twice with the token cache enabled: the first parse
+	records the tokens of system.a4l and basemodel.a4l, the second replays
+	them, and should load exactly the same types.
+*/
+static void test_tokencache(void){
+
+	struct module_t *m;
+	struct gl_list_t *l;
+	unsigned long ntypes[2], nreplay[2];
+	int status, pass, nfiles = 0;
+	char dir[] = "/tmp/ascend-test-XXXXXX";
+	char fn[PATH_MAX];
+	static char envon[PATH_MAX];
+	static char envoff[] = ASC_ENV_TOKCACHE "=";
+	DIR *d;
+	struct dirent *e;
+
+	CU_TEST_FATAL(mkdtemp(dir) != NULL);
+	snprintf(envon,PATH_MAX,ASC_ENV_TOKCACHE "=%s",dir);
+	CU_TEST_FATAL(0 == putenv(envon));
+
+	for(pass = 0; pass < 2; ++pass){
+		Asc_CompilerInit(1);
+		Asc_PutEnv(ASC_ENV_LIBRARY "=models");
+
+		nreplay[pass] = TokenCacheReplayCount();
+		m = Asc_OpenModule("system.a4l",&status);
+		CU_ASSERT(status==0);
+		CU_ASSERT(0 == zz_parse());
+		nreplay[pass] = TokenCacheReplayCount() - nreplay[pass];
+
+		l = Asc_TypeByModule(m);
+		ntypes[pass] = gl_length(l);
+		gl_destroy(l);
+		MSG("pass %d: %lu library entries loaded",pass,ntypes[pass]);
+
+		CU_ASSERT(FindType(AddSymbol("solver_var"))!=NULL);
+		CU_ASSERT(FindType(AddSymbol("cmumodel"))!=NULL);
+
+		Asc_CompilerDestroy();
+	}
+	CU_ASSERT(ntypes[0]==8);
+	CU_ASSERT(ntypes[1]==ntypes[0]);
+
+	/* nothing to replay on the first pass; both files replayed on the second */
+	CU_ASSERT(nreplay[0]==0);
+	CU_ASSERT(nreplay[1]==2);
+
+	/* one cache file for each of system.a4l and basemodel.a4l */
+	d = opendir(dir);
+	CU_TEST_FATAL(d != NULL);
+	while((e = readdir(d)) != NULL){
+		if(e->d_name[0] == '.')continue;
+		MSG("cache file %s",e->d_name);
+		snprintf(fn,PATH_MAX,"%s/%s",dir,e->d_name);
+		CU_ASSERT(0 == remove(fn));
+		++nfiles;
+	}
+	closedir(d);
+	CU_ASSERT(0 == rmdir(dir));
+	CU_ASSERT(nfiles==2);
+
+	putenv(envoff);
+}
+
 static void test_instantiate_file(void){
 
 	/*struct module_t *m;*/
@@ -509,6 +578,7 @@ static void test_badalias(void){
 	T(instantiate_string) \
 	T(parse_basemodel) \
 	T(parse_file) \
+	T(tokencache) \
 	T(instantiate_file) \
 	T(initialize) \
 	T(stop) \
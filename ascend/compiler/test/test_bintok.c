@@ -1,6 +1,10 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include <ascend/general/env.h>
 #include <ascend/general/ospath.h>
@@ -24,6 +28,7 @@
 #include <ascend/compiler/relation_io.h>
 #include <ascend/compiler/reverse_ad.h>
 #include <ascend/compiler/relation_util.h>
+#include <ascend/compiler/relation.h>
 #include <ascend/compiler/mathinst.h>
 #include <ascend/compiler/watchpt.h>
 #include <ascend/compiler/initialize.h>
@@ -43,6 +48,56 @@
 
 #include <test/common.h>
 
+static struct gl_list_t *g_rels;
+
+static void collect_rels(struct Instance *i){
+	if(i != NULL && InstanceKind(i) == REL_INST){
+		gl_append_ptr(g_rels,(VOIDPTR)i);
+	}
+}
+
+/*
+	Compare the compiled gradient and batch functions of every bintoken
+	relation with the interpreted gradient, at the current values.
+*/
+static void check_bintok_gradients(struct Instance *root){
+	unsigned long c, j, n;
+	double x[16], g[16], gr[16], r, rr;
+	int nbt = 0;
+	CONST struct relation *rel;
+	struct Instance *i;
+
+	g_rels = gl_create(20L);
+	VisitInstanceTree(root,collect_rels,0,0);
+	for(c = 1; c <= gl_length(g_rels); ++c){
+		i = (struct Instance *)gl_fetch(g_rels,c);
+		rel = GetInstanceRelationOnly(i);
+		if(GetInstanceRelationType(i) != e_token || RTOKEN(rel).btable <= 0)continue;
+		n = NumberVariables(rel);
+		CU_ASSERT_FATAL(n <= 16);
+		for(j = 0; j < n; ++j){
+			x[j] = RealAtomValue(RelationVariable(rel,j+1));
+		}
+		CU_ASSERT(0 == RelationCalcResidGrad(i,&rr,gr));
+		CU_ASSERT(0 == BinTokenCalcGradient(RTOKEN(rel).btable,RTOKEN(rel).bindex,x,&r,g));
+		CU_ASSERT_DOUBLE_EQUAL(r,rr,1e-12*(1 + fabs(rr)));
+		for(j = 0; j < n; ++j){
+			CU_ASSERT_DOUBLE_EQUAL(g[j],gr[j],1e-12*(1 + fabs(gr[j])));
+		}
+		/* a batch of one gives the same result */
+		CU_ASSERT(NULL != BinTokenBatchKey(RTOKEN(rel).btable,RTOKEN(rel).bindex));
+		CU_ASSERT(0 == BinTokenCalcBatch(RTOKEN(rel).btable,RTOKEN(rel).bindex,1,x,&rr,gr));
+		CU_ASSERT(r == rr);
+		for(j = 0; j < n; ++j){
+			CU_ASSERT(g[j] == gr[j]);
+		}
+		++nbt;
+	}
+	CU_ASSERT(nbt > 0);
+	gl_destroy(g_rels);
+	g_rels = NULL;
+}
+
 /*
 	Test solving a simple model with 'bintoken' support
 */
@@ -85,6 +140,9 @@ static void test_bintok(char *filenamestem,int usebintok){
 	struct Name *name = CreateIdName(AddSymbol(ONLOAD));
 	enum Proc_enum pe = Initialize(GetSimulationRoot(siminst),name,ONLOAD, ASCERR, WP_STOPONERR, NULL, NULL);
 	CU_ASSERT(pe==Proc_all_ok);
+	if(usebintok){
+		check_bintok_gradients(GetSimulationRoot(siminst));
+	}
 
 	slv_system_t sys = system_build(GetSimulationRoot(siminst));
 	CU_ASSERT_FATAL(sys != NULL);
@@ -136,6 +194,70 @@ static void test_gradient_nobintok(){
 	test_bintok("gradient",0);
 }
 
+static void test_batch(){
+	test_bintok("batch",1);
+}
+
+static void test_batch_nobintok(){
+	test_bintok("batch",0);
+}
+
+/*
+	Find the single library in the bintoken cache directory dir, and stat
+	it. @return 0 if there is exactly one file there, and it is a library.
+*/
+static int cache_library(const char *dir, char *fn, struct stat *st){
+	DIR *d;
+	struct dirent *e;
+	int nfiles = 0, bad = 0;
+
+	d = opendir(dir);
+	if(d == NULL)return 1;
+	while((e = readdir(d)) != NULL){
+		if(e->d_name[0] == '.')continue;
+		++nfiles;
+		snprintf(fn,PATH_MAX,"%s/%s",dir,e->d_name);
+		if(strncmp(e->d_name,"BinTokenArch_",13) || stat(fn,st))bad = 1;
+	}
+	closedir(d);
+	return bad || nfiles != 1;
+}
+
+/*
+	Build the same model twice with a bintoken cache directory: the
+	second build should load the library left there by the first, not
+	compile it again. A compiled library would be written under a private
+	name and renamed into place, so it would be a new file.
+*/
+static void test_cache(){
+	char dir[] = "/tmp/ascend-test-XXXXXX";
+	char fn[PATH_MAX], fn2[PATH_MAX];
+	static char envon[PATH_MAX];
+	static char envoff[] = ASC_ENV_BTCACHE "=";
+	struct stat st, st2;
+
+	CU_TEST_FATAL(mkdtemp(dir) != NULL);
+	snprintf(envon,PATH_MAX,ASC_ENV_BTCACHE "=%s",dir);
+	CU_TEST_FATAL(0 == putenv(envon));
+
+	/* one library, named by the hash of its code */
+	test_bintok("test1",1);
+	CU_ASSERT_FATAL(0 == cache_library(dir,fn,&st));
+
+	/* sleep past the mtime resolution, so that a rebuild would show */
+	sleep(1);
+	test_bintok("test1",1);
+	CU_ASSERT_FATAL(0 == cache_library(dir,fn2,&st2));
+	CU_ASSERT(0 == strcmp(fn,fn2));
+	CU_ASSERT(st.st_ino == st2.st_ino);
+	CU_ASSERT(st.st_mtime == st2.st_mtime);
+
+	CU_ASSERT(0 == remove(fn2));
+	CU_ASSERT(0 == rmdir(dir));
+
+	putenv(envoff);
+}
+
 
 /*===========================================================================*/
 /* Registration information */
@@ -146,7 +268,10 @@ static void test_gradient_nobintok(){
 	T(test1) \
 	T(nobintok) \
 	T(gradient) \
-	T(gradient_nobintok)
+	T(gradient_nobintok) \
+	T(batch) \
+	T(batch_nobintok) \
+	T(cache)
 
 REGISTER_TESTS_SIMPLE(compiler_bintok, TESTS)
 
@@ -0,0 +1,369 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2024 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//**
+	@file
+	Unit tests for the reuse of compiled simulation trees (g_use_modelcache).
+	A simulation copied from the cache must match one compiled from scratch,
+	and the cache must be dropped when types are replaced.
+*/
+#include <string.h>
+
+#include <ascend/general/env.h>
+#include <ascend/general/platform.h>
+#include <ascend/general/list.h>
+#include <ascend/general/ascMalloc.h>
+#include <ascend/utilities/ascEnvVar.h>
+#include <ascend/utilities/error.h>
+
+#include <ascend/compiler/ascCompiler.h>
+#include <ascend/compiler/compiler.h>
+#include <ascend/compiler/module.h>
+#include <ascend/compiler/parser.h>
+#include <ascend/compiler/library.h>
+#include <ascend/compiler/symtab.h>
+#include <ascend/compiler/simlist.h>
+#include <ascend/compiler/instquery.h>
+#include <ascend/compiler/parentchild.h>
+#include <ascend/compiler/atomvalue.h>
+#include <ascend/compiler/mathinst.h>
+#include <ascend/compiler/relation_util.h>
+#include <ascend/compiler/when_util.h>
+#include <ascend/compiler/case.h>
+#include <ascend/compiler/link.h>
+#include <ascend/compiler/prototype.h>
+
+#include <test/common.h>
+#include <test/assertimpl.h>
+
+//#define MODELCACHE_DEBUG
+#ifdef MODELCACHE_DEBUG
+# define MSG CONSOLE_DEBUG
+#else
+# define MSG(ARGS...) ((void)0)
+#endif
+
+static void load_file(const char *file){
+	struct module_t *m;
+	int status;
+
+	m = Asc_OpenModule(file,&status);
+	CU_ASSERT_FATAL(m != NULL);
+	CU_ASSERT(status == 0);
+	CU_ASSERT(0 == zz_parse());
+}
+
+static void load_models(void){
+	load_file("test/compiler/modelcache.a4c");
+}
+
+static struct Instance *create_sim(const char *type, const char *name){
+	struct Instance *sim;
+	sim = SimsCreateInstance(AddSymbol(type),AddSymbol(name),e_normal
+		,AddSymbol("default_self")
+	);
+	CU_ASSERT_FATAL(sim != NULL);
+	return sim;
+}
+
+/*------------------------------------------------------------------------------
+	Comparison of two instance trees. Each instance of the first tree is
+	paired with the one found at the same place in the second, and the
+	pairing must be one-to-one, so merged parts must be merged in both.
+	Relations, WHENs and LINKs must refer to the paired instances, ie to
+	instances of their own tree.
+*/
+
+#define MAXPAIRS 1000
+static struct Instance *g_pair1[MAXPAIRS], *g_pair2[MAXPAIRS];
+static int g_npairs;
+
+/** @return the instance paired with i (from the first tree), or NULL */
+static struct Instance *paired(struct Instance *i){
+	int k;
+	for(k = 0; k < g_npairs; ++k){
+		if(g_pair1[k] == i)return g_pair2[k];
+	}
+	return NULL;
+}
+
+/** @return 1 if i1 and i2 are new, and have been paired */
+static int add_pair(struct Instance *i1, struct Instance *i2){
+	int k;
+	for(k = 0; k < g_npairs; ++k){
+		if(g_pair2[k] == i2)return 0;
+	}
+	CU_ASSERT_FATAL(g_npairs < MAXPAIRS);
+	g_pair1[g_npairs] = i1;
+	g_pair2[g_npairs] = i2;
+	g_npairs++;
+	return 1;
+}
+
+static void compare_relations(struct Instance *i1, struct Instance *i2){
+	CONST struct relation *r1, *r2;
+	unsigned long c, n;
+
+	r1 = GetInstanceRelationOnly(i1);
+	r2 = GetInstanceRelationOnly(i2);
+	CU_ASSERT_FATAL(r1 != NULL && r2 != NULL);
+	n = NumberVariables(r1);
+	CU_ASSERT_FATAL(n == NumberVariables(r2));
+	for(c = 1; c <= n; ++c){
+		CU_ASSERT(paired(RelationVariable(r1,c)) == RelationVariable(r2,c));
+	}
+}
+
+static void compare_whens(struct Instance *i1, struct Instance *i2){
+	struct Case *c1, *c2;
+	unsigned long c, k, n;
+
+	n = NumberWhenVariables(i1);
+	CU_ASSERT_FATAL(n == NumberWhenVariables(i2));
+	for(c = 1; c <= n; ++c){
+		CU_ASSERT(paired(WhenVariable(i1,c)) == WhenVariable(i2,c));
+	}
+	n = NumberWhenCases(i1);
+	CU_ASSERT_FATAL(n == NumberWhenCases(i2));
+	for(c = 1; c <= n; ++c){
+		c1 = WhenCase(i1,c);
+		c2 = WhenCase(i2,c);
+		CU_ASSERT_FATAL(NumberCaseRefs(c1) == NumberCaseRefs(c2));
+		for(k = 1; k <= NumberCaseRefs(c1); ++k){
+			CU_ASSERT(paired(CaseRef(c1,k)) == CaseRef(c2,k));
+		}
+	}
+}
+
+/**
+	Pair up the instances of the two trees and compare their kinds, types
+	and values.
+*/
+static void pair_trees(struct Instance *i1, struct Instance *i2){
+	unsigned long c, n;
+
+	if(i1 == NULL || i2 == NULL){
+		CU_ASSERT(i1 == i2);
+		return;
+	}
+	if(paired(i1) != NULL){
+		CU_ASSERT(paired(i1) == i2);
+		return;
+	}
+	CU_ASSERT_FATAL(add_pair(i1,i2));
+	CU_ASSERT(i1 != i2);
+	CU_ASSERT_FATAL(InstanceKind(i1) == InstanceKind(i2));
+	CU_ASSERT(InstanceTypeDesc(i1) == InstanceTypeDesc(i2));
+	if(InstanceKind(i1) & (IFUND | IATOM | ICONS)){
+		CU_ASSERT(0 == CmpAtomValues(i1,i2));
+	}
+	n = NumberChildren(i1);
+	CU_ASSERT_FATAL(n == NumberChildren(i2));
+	for(c = 1; c <= n; ++c){
+		pair_trees(InstanceChild(i1,c),InstanceChild(i2,c));
+	}
+}
+
+/** Second pass, once all instances have been paired. */
+static void check_references(void){
+	int k;
+	for(k = 0; k < g_npairs; ++k){
+		switch(InstanceKind(g_pair1[k])){
+		case REL_INST:
+			compare_relations(g_pair1[k],g_pair2[k]);
+			break;
+		case WHEN_INST:
+			compare_whens(g_pair1[k],g_pair2[k]);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+static void compare_trees(struct Instance *i1, struct Instance *i2){
+	g_npairs = 0;
+	pair_trees(i1,i2);
+	check_references();
+	MSG("%d instances compared",g_npairs);
+}
+
+/**
+	@return the three instances named by the LINK entry (one each) resolved
+	in the model root.
+*/
+static struct Instance **link_targets(struct Instance *root
+		, struct link_entry_t *link
+){
+	struct gl_list_t *l, *names;
+	struct Instance **v;
+	unsigned long c;
+
+	names = (struct gl_list_t *)getLinkInstances(root,link,0);
+	CU_ASSERT_FATAL(names != NULL);
+	CU_ASSERT_FATAL(gl_length(names) == 3);
+	v = ASC_NEW_ARRAY(struct Instance *,3);
+	for(c = 1; c <= 3; ++c){
+		l = (struct gl_list_t *)gl_fetch(names,c);
+		CU_ASSERT_FATAL(gl_length(l) == 1);
+		v[c-1] = (struct Instance *)gl_fetch(l,1);
+		gl_destroy(l);
+	}
+	gl_destroy(names);
+	return v;
+}
+
+/*----------------------------------------------------------------------------*/
+
+/**
+	A model with a WHEN: the copy must match a fresh compilation, and must
+	not see changes made to the simulation the cache was filled from.
+*/
+static void test_when(void){
+	struct Instance *sim1, *sim2, *sim3, *root1, *root2, *root3, *proto, *x;
+	struct TypeDescription *def;
+
+	Asc_CompilerInit(1);
+	Asc_PutEnv(ASC_ENV_LIBRARY "=models");
+	load_models();
+	def = FindType(AddSymbol("cachewhen"));
+	CU_ASSERT_FATAL(def != NULL);
+
+	g_use_modelcache = 1;
+	sim1 = create_sim("cachewhen","sim1");
+	proto = LookupModelPrototype(def,0);
+	CU_ASSERT_FATAL(proto != NULL);
+	root1 = GetSimulationRoot(sim1);
+	CU_ASSERT(root1 != proto);
+
+	/* a change to sim1 must not reach the copies */
+	x = ChildByChar(ChildByChar(root1,AddSymbol("p")),AddSymbol("x"));
+	CU_ASSERT_FATAL(x != NULL);
+	SetRealAtomValue(x,99.0,0);
+
+	sim2 = create_sim("cachewhen","sim2");
+	CU_ASSERT(LookupModelPrototype(def,0) == proto);
+	root2 = GetSimulationRoot(sim2);
+
+	g_use_modelcache = 0;
+	sim3 = create_sim("cachewhen","sim3");
+	root3 = GetSimulationRoot(sim3);
+
+	compare_trees(root2,root3);
+
+	sim_destroy(sim1);
+	sim_destroy(sim2);
+	sim_destroy(sim3);
+	Asc_CompilerDestroy();
+}
+
+/**
+	A model with merged parts and a declarative LINK: the copy must be
+	merged the same way, and its LINK must refer to its own instances.
+*/
+static void test_same(void){
+	struct Instance *sim2, *sim3, *root2, *root3, *a, *b;
+	struct Instance **v2, **v3;
+	struct gl_list_t *l2, *l3;
+	int c;
+
+	Asc_CompilerInit(1);
+	Asc_PutEnv(ASC_ENV_LIBRARY "=models");
+	load_models();
+
+	g_use_modelcache = 1;
+	sim_destroy(create_sim("cachesame","sim1"));
+	CU_ASSERT_FATAL(LookupModelPrototype(FindType(AddSymbol("cachesame")),0) != NULL);
+	sim2 = create_sim("cachesame","sim2");
+	root2 = GetSimulationRoot(sim2);
+	g_use_modelcache = 0;
+	sim3 = create_sim("cachesame","sim3");
+	root3 = GetSimulationRoot(sim3);
+
+	a = ChildByChar(root2,AddSymbol("a"));
+	b = ChildByChar(root2,AddSymbol("b"));
+	CU_ASSERT_FATAL(a != NULL && b != NULL);
+	CU_ASSERT(ChildByChar(a,AddSymbol("x")) == ChildByChar(b,AddSymbol("x")));
+
+	compare_trees(root2,root3);
+
+	l2 = getLinks(root2,AddSymbol("k1"),0);
+	l3 = getLinks(root3,AddSymbol("k1"),0);
+	CU_ASSERT_FATAL(l2 != NULL && l3 != NULL);
+	CU_ASSERT_FATAL(gl_length(l2) == 1 && gl_length(l3) == 1);
+	v2 = link_targets(root2,(struct link_entry_t *)gl_fetch(l2,1));
+	v3 = link_targets(root3,(struct link_entry_t *)gl_fetch(l3,1));
+	for(c = 0; c < 3; ++c){
+		CU_ASSERT(paired(v2[c]) == v3[c]);
+	}
+	ASC_FREE(v2);
+	ASC_FREE(v3);
+	gl_destroy(l2);
+	gl_destroy(l3);
+
+	sim_destroy(sim2);
+	sim_destroy(sim3);
+	Asc_CompilerDestroy();
+}
+
+/**
+	Replacing any type, directly (DeletePrototype) or by loading a changed
+	definition of it, must drop the cached trees.
+*/
+static void test_invalidate(void){
+	struct Instance *sim;
+
+	Asc_CompilerInit(1);
+	Asc_PutEnv(ASC_ENV_LIBRARY "=models");
+	load_models();
+
+	g_use_modelcache = 1;
+	sim_destroy(create_sim("cachewhen","sim1"));
+	sim_destroy(create_sim("cachesame","sim2"));
+	CU_ASSERT(LookupModelPrototype(FindType(AddSymbol("cachewhen")),0) != NULL);
+	CU_ASSERT(LookupModelPrototype(FindType(AddSymbol("cachesame")),0) != NULL);
+
+	/* cachepart is only a part of the cached models */
+	DeletePrototype(AddSymbol("cachepart"));
+	CU_ASSERT(LookupModelPrototype(FindType(AddSymbol("cachewhen")),0) == NULL);
+	CU_ASSERT(LookupModelPrototype(FindType(AddSymbol("cachesame")),0) == NULL);
+
+	sim_destroy(create_sim("cachesame","sim3"));
+	CU_ASSERT(LookupModelPrototype(FindType(AddSymbol("cachesame")),0) != NULL);
+
+	/* a changed definition of cachepart replaces the type */
+	load_file("test/compiler/modelcache_edit.a4c");
+	CU_ASSERT(LookupModelPrototype(FindType(AddSymbol("cachesame")),0) == NULL);
+
+	/* and models built on the new part are cached as before */
+	sim = create_sim("cachesame","sim4");
+	CU_ASSERT(LookupModelPrototype(FindType(AddSymbol("cachesame")),0) != NULL);
+	sim_destroy(sim);
+
+	g_use_modelcache = 0;
+	Asc_CompilerDestroy();
+}
+
+/*===========================================================================*/
+/* Registration information */
+
+/* the list of tests */
+
+#define TESTS(T) \
+	T(when) \
+	T(same) \
+	T(invalidate)
+
+REGISTER_TESTS_SIMPLE(compiler_modelcache, TESTS)
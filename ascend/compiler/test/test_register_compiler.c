@@ -34,7 +34,8 @@
 	T(qlfdid) \
 	T(func) \
 	T(notes) \
-	T(chkdim)
+	T(chkdim) \
+	T(modelcache)
 
 
 #define PROTO_TEST(NAME) PROTO(compiler,NAME)
@@ -0,0 +1,447 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2024 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//**
+	@file
+	Token stream cache for module files, see tokencache.h.
+
+	Cache file layout (native byte order):
+	TokenCacheHeader, then TokenRec[ntok], then unsigned long symoff[nsym]
+	giving the offset of each distinct symbol in the character pool, then
+	the character pool (nchar chars of NUL-terminated strings).
+	Symbol tokens refer to the symbol index, text tokens to a pool offset.
+	Symbols are entered in the symbol table only once each, when first
+	replayed.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef WIN32
+# include <process.h> /* for getpid() */
+#else
+# include <unistd.h> /* for getpid() */
+#endif
+
+#include <ascend/general/platform.h>
+#include <ascend/general/ascMalloc.h>
+#include <ascend/general/panic.h>
+#include <ascend/general/table.h>
+#include <ascend/utilities/config.h>
+#include <ascend/utilities/error.h>
+
+#include "symtab.h"
+#include "tokencache.h"
+
+/* #define TOKENCACHE_DEBUG */
+#ifdef TOKENCACHE_DEBUG
+# define MSG CONSOLE_DEBUG
+#else
+# define MSG(ARGS...) ((void)0)
+#endif
+
+#define TOKENCACHE_MAGIC "ASCTOK1"
+#define TOKENCACHE_INIT_SIZE 1024
+#define TOKENCACHE_HASH_MASK 0xFFFFFFFFUL
+
+static unsigned long g_tokencache_replays = 0;
+
+enum TokenKind{
+	tk_plain = 0,
+	tk_real,
+	tk_integer,
+	tk_symbol,
+	tk_text
+};
+
+typedef struct TokenRec_struct{
+	int tok;
+	int kind;           /**< enum TokenKind */
+	unsigned long line;
+	union{
+		double r;
+		long i;
+		unsigned long s;  /**< symbol index, or offset of text in the pool */
+	} v;
+} TokenRec;
+
+typedef struct TokenCacheHeader_struct{
+	char magic[8];
+	unsigned long recsize;  /**< sizeof(TokenRec), guards against ABI changes */
+	unsigned long grammar;  /**< token numbering signature from the scanner */
+	unsigned long h1, h2;   /**< hashes of the module file contents */
+	unsigned long srclen;   /**< length of the module file */
+	unsigned long ntok, nsym, nchar;
+	unsigned long lastline; /**< line number at end of file */
+} TokenCacheHeader;
+
+struct TokenCache{
+	TokenCacheHeader h;
+	char *fn;               /**< cache file name */
+	int replay;             /**< TRUE if replaying, FALSE if recording */
+	int valid;              /**< FALSE once a recording has been invalidated */
+	TokenRec *tok;
+	unsigned long *symoff;
+	char *pool;
+	unsigned long cap_tok, cap_sym, cap_char;
+	unsigned long next;     /**< next token to replay */
+	symchar **sym;          /**< replay: symbols entered so far, else NULL */
+	struct Table *symtab;   /**< record: symbol string -> index+1 */
+};
+
+/*------------------------------------------------------------------------------
+  HASHING AND FILE NAMES
+*/
+
+/**
+	Hash the contents of f with 32-bit FNV-1a (h1) and a 32-bit
+	shift-add-xor hash (h2), then rewind f.
+*/
+static void tokencache_hash(FILE *f, TokenCacheHeader *h){
+	unsigned char buf[8192];
+	unsigned long h1 = 2166136261UL, h2 = 5381UL, len = 0;
+	size_t n, i;
+	while((n = fread(buf,1,sizeof(buf),f)) > 0){
+		for(i = 0; i < n; ++i){
+			h1 = ((h1 ^ buf[i]) * 16777619UL) & TOKENCACHE_HASH_MASK;
+			h2 = (h2 ^ ((h2 << 5) + (h2 >> 2) + buf[i])) & TOKENCACHE_HASH_MASK;
+		}
+		len += n;
+	}
+	rewind(f);
+	h->h1 = h1;
+	h->h2 = h2;
+	h->srclen = len;
+}
+
+/** @return cache file name for filename, to be freed with ASC_FREE */
+static char *tokencache_filename(CONST char *dir, CONST char *filename
+		, CONST TokenCacheHeader *h
+){
+	CONST char *base, *p;
+	char *fn;
+	base = filename;
+	for(p = filename; *p != '\0'; ++p){
+		if(*p == '/' || *p == '\\')base = p + 1;
+	}
+	fn = ASC_NEW_ARRAY(char,strlen(dir) + strlen(base) + 32);
+	sprintf(fn,"%s/%s.%08lx%08lx" TOKENCACHE_SUFFIX,dir,base,h->h1,h->h2);
+	return fn;
+}
+
+/*------------------------------------------------------------------------------
+  LOADING
+*/
+
+/**
+	Read and check the cache file tc->fn against the header already filled
+	in from the module file.
+	@return 0 on success, nonzero if there is no usable cache file.
+*/
+static int tokencache_load(struct TokenCache *tc){
+	TokenCacheHeader h;
+	FILE *f;
+	unsigned long k;
+	TokenRec *r;
+
+	f = fopen(tc->fn,"rb");
+	if(f == NULL){
+		MSG("No cache file '%s'",tc->fn);
+		return 1;
+	}
+	if(fread(&h,sizeof(TokenCacheHeader),1,f) != 1
+		|| strncmp(h.magic,tc->h.magic,sizeof(h.magic))
+		|| h.recsize != tc->h.recsize || h.grammar != tc->h.grammar
+		|| h.h1 != tc->h.h1 || h.h2 != tc->h.h2 || h.srclen != tc->h.srclen
+		|| h.ntok > h.srclen + 1 || h.nsym > h.ntok || h.nchar > h.srclen + h.ntok
+	){
+		goto stale;
+	}
+	tc->tok = ASC_NEW_ARRAY(TokenRec,h.ntok + 1);
+	tc->symoff = ASC_NEW_ARRAY(unsigned long,h.nsym + 1);
+	tc->pool = ASC_NEW_ARRAY(char,h.nchar + 1);
+	if(fread(tc->tok,sizeof(TokenRec),h.ntok,f) != h.ntok
+		|| fread(tc->symoff,sizeof(unsigned long),h.nsym,f) != h.nsym
+		|| fread(tc->pool,1,h.nchar,f) != h.nchar
+		|| fgetc(f) != EOF
+		|| (h.nchar > 0 && tc->pool[h.nchar - 1] != '\0')
+	){
+		goto stale;
+	}
+	for(k = 0; k < h.nsym; ++k){
+		if(tc->symoff[k] >= h.nchar)goto stale;
+	}
+	for(k = 0, r = tc->tok; k < h.ntok; ++k, ++r){
+		switch(r->kind){
+		case tk_plain: case tk_real: case tk_integer:
+			break;
+		case tk_symbol:
+			if(r->v.s >= h.nsym)goto stale;
+			break;
+		case tk_text:
+			if(r->v.s >= h.nchar)goto stale;
+			break;
+		default:
+			goto stale;
+		}
+	}
+	fclose(f);
+
+	tc->h = h;
+	tc->sym = ASC_NEW_ARRAY_CLEAR(symchar *,h.nsym + 1);
+	MSG("Replaying %lu tokens from '%s'",h.ntok,tc->fn);
+	return 0;
+
+stale:
+	MSG("Cache file '%s' is stale or invalid",tc->fn);
+	fclose(f);
+	if(tc->tok)ASC_FREE(tc->tok);
+	if(tc->symoff)ASC_FREE(tc->symoff);
+	if(tc->pool)ASC_FREE(tc->pool);
+	tc->tok = NULL;
+	tc->symoff = NULL;
+	tc->pool = NULL;
+	return 1;
+}
+
+struct TokenCache *TokenCacheOpen(FILE *f, CONST char *filename
+		, unsigned long grammar
+){
+	CONST char *dir;
+	struct TokenCache *tc;
+
+	dir = getenv(ASC_ENV_TOKCACHE);
+	if(f == NULL || filename == NULL || dir == NULL || *dir == '\0'){
+		return NULL;
+	}
+
+	tc = ASC_NEW_CLEAR(struct TokenCache);
+	strncpy(tc->h.magic,TOKENCACHE_MAGIC,sizeof(tc->h.magic));
+	tc->h.recsize = sizeof(TokenRec);
+	tc->h.grammar = grammar;
+	tokencache_hash(f,&(tc->h));
+	tc->fn = tokencache_filename(dir,filename,&(tc->h));
+
+	if(tokencache_load(tc) == 0){
+		tc->replay = TRUE;
+		g_tokencache_replays++;
+		return tc;
+	}
+
+	/* record */
+	tc->valid = TRUE;
+	tc->cap_tok = TOKENCACHE_INIT_SIZE;
+	tc->cap_sym = TOKENCACHE_INIT_SIZE;
+	tc->cap_char = 8 * TOKENCACHE_INIT_SIZE;
+	tc->tok = ASC_NEW_ARRAY(TokenRec,tc->cap_tok);
+	tc->symoff = ASC_NEW_ARRAY(unsigned long,tc->cap_sym);
+	tc->pool = ASC_NEW_ARRAY(char,tc->cap_char);
+	tc->symtab = CreateTable(1031);
+	return tc;
+}
+
+unsigned long TokenCacheReplayCount(void){
+	return g_tokencache_replays;
+}
+
+int TokenCacheReplaying(CONST struct TokenCache *tc){
+	return tc->replay;
+}
+
+/*------------------------------------------------------------------------------
+  REPLAY
+*/
+
+int TokenCacheNext(struct TokenCache *tc, struct TokenCacheToken *t){
+	TokenRec *r;
+	asc_assert(tc->replay);
+	if(tc->next >= tc->h.ntok){
+		return 0;
+	}
+	r = &(tc->tok[tc->next++]);
+	t->tok = r->tok;
+	t->line = r->line;
+	switch(r->kind){
+	case tk_real:
+		t->v.real_value = r->v.r;
+		break;
+	case tk_integer:
+		t->v.int_value = r->v.i;
+		break;
+	case tk_symbol:
+		if(tc->sym[r->v.s] == NULL){
+			tc->sym[r->v.s] = AddSymbol(tc->pool + tc->symoff[r->v.s]);
+		}
+		t->v.sym_ptr = tc->sym[r->v.s];
+		break;
+	case tk_text:
+		t->v.text = tc->pool + r->v.s;
+		break;
+	default:
+		t->v.int_value = 0;
+	}
+	return 1;
+}
+
+unsigned long TokenCacheLastLine(CONST struct TokenCache *tc){
+	return tc->h.lastline;
+}
+
+/*------------------------------------------------------------------------------
+  RECORDING
+*/
+
+static TokenRec *tokencache_push(struct TokenCache *tc, int tok
+		, unsigned long line, int kind
+){
+	TokenRec *r;
+	asc_assert(!tc->replay);
+	if(tc->h.ntok == tc->cap_tok){
+		tc->cap_tok *= 2;
+		tc->tok = (TokenRec *)ascrealloc(tc->tok,tc->cap_tok*sizeof(TokenRec));
+	}
+	r = &(tc->tok[tc->h.ntok++]);
+	memset(r,0,sizeof(TokenRec));
+	r->tok = tok;
+	r->kind = kind;
+	r->line = line;
+	return r;
+}
+
+/** @return offset of a copy of str in the character pool */
+static unsigned long tokencache_pool(struct TokenCache *tc, CONST char *str){
+	unsigned long len, off;
+	len = strlen(str) + 1;
+	if(tc->h.nchar + len > tc->cap_char){
+		while(tc->h.nchar + len > tc->cap_char){
+			tc->cap_char *= 2;
+		}
+		tc->pool = (char *)ascrealloc(tc->pool,tc->cap_char);
+	}
+	off = tc->h.nchar;
+	memcpy(tc->pool + off,str,len);
+	tc->h.nchar += len;
+	return off;
+}
+
+void TokenCacheAdd(struct TokenCache *tc, int tok, unsigned long line){
+	if(!tc->valid)return;
+	tokencache_push(tc,tok,line,tk_plain);
+}
+
+void TokenCacheAddReal(struct TokenCache *tc, int tok
+		, unsigned long line, double value
+){
+	if(!tc->valid)return;
+	tokencache_push(tc,tok,line,tk_real)->v.r = value;
+}
+
+void TokenCacheAddInteger(struct TokenCache *tc, int tok
+		, unsigned long line, long value
+){
+	if(!tc->valid)return;
+	tokencache_push(tc,tok,line,tk_integer)->v.i = value;
+}
+
+void TokenCacheAddSymbol(struct TokenCache *tc, int tok
+		, unsigned long line, symchar *sym
+){
+	unsigned long idx;
+	if(!tc->valid)return;
+	idx = (unsigned long)LookupTableData(tc->symtab,SCP(sym));
+	if(idx == 0){
+		if(tc->h.nsym == tc->cap_sym){
+			tc->cap_sym *= 2;
+			tc->symoff = (unsigned long *)ascrealloc(tc->symoff
+				,tc->cap_sym*sizeof(unsigned long)
+			);
+		}
+		tc->symoff[tc->h.nsym] = tokencache_pool(tc,SCP(sym));
+		idx = ++(tc->h.nsym);
+		AddTableData(tc->symtab,(void *)idx,SCP(sym));
+	}
+	tokencache_push(tc,tok,line,tk_symbol)->v.s = idx - 1;
+}
+
+void TokenCacheAddText(struct TokenCache *tc, int tok
+		, unsigned long line, CONST char *text
+){
+	unsigned long off;
+	if(!tc->valid)return;
+	off = tokencache_pool(tc,text);
+	tokencache_push(tc,tok,line,tk_text)->v.s = off;
+}
+
+void TokenCacheInvalidate(struct TokenCache *tc){
+	if(tc != NULL && !tc->replay && tc->valid){
+		MSG("Not caching tokens of '%s'",tc->fn);
+		tc->valid = FALSE;
+	}
+}
+
+/*------------------------------------------------------------------------------
+  SAVING
+*/
+
+static void tokencache_save(struct TokenCache *tc){
+	char *tmp;
+	FILE *f;
+	int ok;
+
+	/* write under a name of our own, so that other processes sharing the
+	cache directory never see a partly written file */
+	tmp = ASC_NEW_ARRAY(char,strlen(tc->fn) + 24);
+	sprintf(tmp,"%s.%lu.tmp",tc->fn,(unsigned long)getpid());
+	f = fopen(tmp,"wb");
+	if(f == NULL){
+		ERROR_REPORTER_HERE(ASC_PROG_WARNING,"Unable to write token cache file '%s'",tmp);
+		ASC_FREE(tmp);
+		return;
+	}
+	ok = fwrite(&(tc->h),sizeof(TokenCacheHeader),1,f) == 1
+		&& fwrite(tc->tok,sizeof(TokenRec),tc->h.ntok,f) == tc->h.ntok
+		&& fwrite(tc->symoff,sizeof(unsigned long),tc->h.nsym,f) == tc->h.nsym
+		&& fwrite(tc->pool,1,tc->h.nchar,f) == tc->h.nchar;
+	if(fclose(f))ok = 0;
+	if(ok && rename(tmp,tc->fn) != 0){
+		/* rename does not replace an existing file on all platforms */
+		remove(tc->fn);
+		ok = (rename(tmp,tc->fn) == 0);
+	}
+	if(!ok){
+		ERROR_REPORTER_HERE(ASC_PROG_WARNING,"Failed to write token cache file '%s'",tc->fn);
+		remove(tmp);
+	}else{
+		MSG("Wrote %lu tokens to '%s'",tc->h.ntok,tc->fn);
+	}
+	ASC_FREE(tmp);
+}
+
+void TokenCacheClose(struct TokenCache *tc, int complete
+		, unsigned long lastline
+){
+	if(tc == NULL)return;
+	if(!tc->replay && tc->valid && complete){
+		tc->h.lastline = lastline;
+		tokencache_save(tc);
+	}
+	if(tc->symtab)DestroyTable(tc->symtab,0);
+	if(tc->sym)ASC_FREE(tc->sym);
+	ASC_FREE(tc->tok);
+	ASC_FREE(tc->symoff);
+	ASC_FREE(tc->pool);
+	ASC_FREE(tc->fn);
+	ASC_FREE(tc);
+}
@@ -0,0 +1,142 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2024 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//**
+	@file
+	Token stream cache for module files.
+
+	Scanning accounts for about half of the time taken to load the model
+	library. When the environment variable ASC_ENV_TOKCACHE names a
+	directory, the scanner records the tokens it returns for each module
+	file and writes them to '<dir>/<basename>.<hash>.a4t', where the hash
+	is computed from the contents of the module file. The next time a file
+	with the same contents is opened, the scanner replays the recorded
+	tokens (with their values and line numbers) instead of scanning the
+	file. The parser sees exactly the same token stream either way.
+
+	A recording is discarded if the scanner reports any error or warning
+	for the file, so that the messages are issued again when the file is
+	next read. Cache files are in native byte order and are not meant to
+	be portable; unreadable or mismatched cache files are ignored and
+	rewritten.
+
+	Requires:
+	#include <stdio.h>
+	#include "utilities/ascConfig.h"
+	#include "symtab.h"
+*/
+
+#ifndef ASC_TOKENCACHE_H
+#define ASC_TOKENCACHE_H
+
+/**	@addtogroup compiler_parse Compiler Scanner/Parser
+	@{
+*/
+
+/** file suffix of token cache files */
+#define TOKENCACHE_SUFFIX ".a4t"
+
+/** A token stream, being either recorded or replayed. */
+struct TokenCache;
+
+/** One token read back from a TokenCache. */
+struct TokenCacheToken{
+	int tok;            /**< token number, as returned by the scanner */
+	unsigned long line; /**< line number at which the token was returned */
+	union{
+		double real_value;
+		long int_value;
+		symchar *sym_ptr;   /**< identifiers and 'symbols' */
+		CONST char *text;   /**< "double quoted" and {braced} text */
+	} v;
+};
+
+extern struct TokenCache *TokenCacheOpen(FILE *f, CONST char *filename
+		, unsigned long grammar
+);
+/**<
+	Open the token stream for module file f, whose name is filename. The
+	contents of f are hashed and f is rewound to its start. grammar is a
+	signature of the token numbering in use; cache files written with a
+	different signature are ignored.
+
+	@return NULL if token caching is disabled, else a stream which replays
+	the cached tokens (TokenCacheReplaying is TRUE) or, if there is no
+	valid cache file, records tokens added by the scanner.
+*/
+
+extern int TokenCacheReplaying(CONST struct TokenCache *tc);
+/**<
+	@return TRUE if tc replays a cache file, FALSE if tc is recording.
+*/
+
+ASC_DLLSPEC unsigned long TokenCacheReplayCount(void);
+/**<
+	@return number of streams opened so far which replay a cache file.
+*/
+
+extern int TokenCacheNext(struct TokenCache *tc, struct TokenCacheToken *t);
+/**<
+	Read the next token of a replaying stream into t.
+	The text of a token is valid until tc is closed.
+	@return 1 if a token was read, 0 at the end of the stream.
+*/
+
+extern unsigned long TokenCacheLastLine(CONST struct TokenCache *tc);
+/**<
+	@return line number of the end of file of a replaying stream.
+*/
+
+extern void TokenCacheAdd(struct TokenCache *tc, int tok, unsigned long line);
+/**< Record a token which has no value. */
+
+extern void TokenCacheAddReal(struct TokenCache *tc, int tok
+		, unsigned long line, double value
+);
+/**< Record a token with a real value. */
+
+extern void TokenCacheAddInteger(struct TokenCache *tc, int tok
+		, unsigned long line, long value
+);
+/**< Record a token with an integer value. */
+
+extern void TokenCacheAddSymbol(struct TokenCache *tc, int tok
+		, unsigned long line, symchar *sym
+);
+/**< Record a token whose value is a symbol table entry. */
+
+extern void TokenCacheAddText(struct TokenCache *tc, int tok
+		, unsigned long line, CONST char *text
+);
+/**< Record a token whose value is a string (copied). */
+
+extern void TokenCacheInvalidate(struct TokenCache *tc);
+/**<
+	Stop recording; tc will not be written when it is closed.
+	Has no effect on a replaying stream. tc may be NULL.
+*/
+
+extern void TokenCacheClose(struct TokenCache *tc, int complete
+		, unsigned long lastline
+);
+/**<
+	Close tc and free its memory. If tc is recording and complete is
+	TRUE (the whole file has been scanned), the cache file is written,
+	with lastline as the line number at end of file. tc may be NULL.
+*/
+
+/* @} */
+
+#endif /* ASC_TOKENCACHE_H */
@@ -70,6 +70,7 @@
 #include "ranki2.h"
 #include "rankiba2.h"
 #include "plainqr.h"
+#include "snlu.h"
 
 #include "linsolqr_impl.h"
 
@@ -117,7 +118,7 @@ char *linsolqr_rmethods() {
 
 char *linsolqr_fmethods() {
   static char names[] =
-    "SPK1/RANKI,SPK1/RANKI+ROW,Fast-SPK1/RANKI,Fast-SPK1/RANKI+ROW,Fastest-SPK1/MR-RANKI,CondQR,CPQR";
+    "SPK1/RANKI,SPK1/RANKI+ROW,Fast-SPK1/RANKI,Fast-SPK1/RANKI+ROW,Fastest-SPK1/MR-RANKI,CondQR,CPQR,SPK1/Supernodal-LU";
   return names;
 }
 
@@ -138,6 +139,7 @@ enum factor_method linsolqr_fmethod_to_enum(char *name) {
   if (strcmp(name,"Fastest-SPK1/MR-RANKI")==0) return ranki_ba2;
   if (strcmp(name,"CondQR")==0) return cond_qr;
   if (strcmp(name,"CPQR")==0) return plain_qr;
+  if (strcmp(name,"SPK1/Supernodal-LU")==0) return sn_lu;
   return unknown_f;
 }
 
@@ -155,6 +157,9 @@ enum factor_class linsolqr_fmethod_to_fclass(enum factor_method fm)
     /* implemented qr things */
     case plain_qr:
       return s_qr;
+    /* compressed-column lu */
+    case sn_lu:
+      return s_lu;
     /* other stuff unimplemented. all fall through */
     case cond_qr:
     case opt_qr:
@@ -187,6 +192,7 @@ char *linsolqr_enum_to_fmethod(enum factor_method meth) {
 		case ranki_ka: return "KIRK-STUFF";
 		case cond_qr: return "CondQR";
 		case plain_qr: return "CPQR";
+		case sn_lu: return "SPK1/Supernodal-LU";
 		default: return "<unknown factorization method>";
 	}
 }
@@ -210,6 +216,7 @@ const char *linsolqr_fmethod_description(const enum factor_method meth) {
 		case ranki_ka: return "KIRK-STUFF/RANKI LU with pseudo-complete pivoting";
 		case cond_qr: return "Sparse QR with condition controlled pivoting";
 		case plain_qr: return "Sparse QR with column pivoting";
+		case sn_lu: return "SPK1 reordering with left-looking supernodal sparse LU";
 		default: return "<unknown factorization method>";
 	}
 }
@@ -319,6 +326,20 @@ static void destroy_qrdata(struct qr_auxdata *d) {
   }
 }
 
+static void destroy_reorder_memo(struct reorder_memo *m){
+  struct reorder_memo *next;
+  while (NOTNULL(m)) {
+    next = m->next;
+    if (NOTNULL(m->orow)) ascfree(m->orow);
+    if (NOTNULL(m->ocol)) ascfree(m->ocol);
+    if (NOTNULL(m->rp)) ascfree(m->rp);
+    if (NOTNULL(m->ci)) ascfree(m->ci);
+    if (NOTNULL(m->mark)) ascfree(m->mark);
+    ascfree(m);
+    m = next;
+  }
+}
+
 linsolqr_system_t linsolqr_create(){
 	linsolqr_system_t sys;
 
@@ -347,6 +368,9 @@ linsolqr_system_t linsolqr_create(){
 	sys->smallest_pivot = MAXDOUBLE;
 	sys->qrdata = NULL;
 	sys->ludata = NULL;
+	sys->sndata = NULL;
+	sys->reuse = FALSE;
+	sys->memo = NULL;
 	return(sys);
 }
 
@@ -373,6 +397,8 @@ void linsolqr_destroy(linsolqr_system_t sys){
    destroy_rhs_list(sys->rl);
    destroy_qrdata(sys->qrdata);
    destroy_ludata(sys->ludata);
+   snlu_destroy_data(sys->sndata);
+   destroy_reorder_memo(sys->memo);
    sys->integrity = DESTROYED;
    ascfree( (POINTER)sys );
 }
@@ -557,6 +583,24 @@ void linsolqr_set_drop_tolerance(linsolqr_system_t sys, real64 dtol){
    }
 }
 
+void linsolqr_set_pivot_reuse(linsolqr_system_t sys, boolean reuse){
+   if(CHECK_SYSTEM(sys)) {
+     ERROR_REPORTER_HERE(ASC_PROG_ERR,"Bad linsolqr_system_t found. set_pivot_reuse ignored.");
+     return;
+   }
+   if( !reuse ) {
+      destroy_reorder_memo(sys->memo);
+      sys->memo = NULL;
+      snlu_trim_data(sys->sndata);
+   }
+   sys->reuse = reuse;
+}
+
+boolean linsolqr_pivot_reuse(linsolqr_system_t sys){
+   CHECK_SYSTEM(sys);
+   return( sys->reuse );
+}
+
 real64 linsolqr_pivot_tolerance(linsolqr_system_t sys){
    CHECK_SYSTEM(sys);
    return( sys->ptol );
@@ -1720,6 +1764,115 @@ void square_region(linsolqr_system_t sys,mtx_region_t *region){
       sys->rng.high = MIN(region->row.high,region->col.high);
 }
 
+/**
+	Record in m the pattern of the square region m->rng of mtx together
+	with the row and column permutations over it, so that a reordering
+	already done can be recognised by reorder_memo_matches.
+	Costs one pass over the nonzeros. m->valid is left FALSE if out of
+	memory.
+*/
+static void reorder_memo_record(struct reorder_memo *m, mtx_matrix_t mtx){
+  mtx_coord_t nz;
+  int32 r, k, n;
+  long top;
+  int32 *ci;
+
+  m->valid = FALSE;
+  n = m->rng.high - m->rng.low + 1;
+  top = 0;
+  for( k = 0 ; k < n ; k++ ) {
+    r = m->rng.low + k;
+    m->orow[k] = mtx_row_to_org(mtx,r);
+    m->ocol[k] = mtx_col_to_org(mtx,r);
+    m->rp[k] = top;
+    nz.row = r;
+    nz.col = mtx_FIRST;
+    while( mtx_next_in_row(mtx,&nz,&(m->rng)), nz.col != mtx_LAST ) {
+      if( top >= m->cicap ) {
+        m->cicap = MAX(2*m->cicap,top+1024);
+        ci = (int32 *)ascrealloc(m->ci,m->cicap*sizeof(int32));
+        if( ISNULL(ci) ) {
+          m->cicap = 0;
+          if( NOTNULL(m->ci) ) ascfree(m->ci);
+          m->ci = NULL;
+          return;
+        }
+        m->ci = ci;
+      }
+      m->ci[top++] = nz.col - m->rng.low;
+    }
+  }
+  m->rp[n] = top;
+  m->valid = TRUE;
+}
+
+/**
+	@return TRUE if the region m->rng of mtx has the pattern and
+	permutation recorded in m. The elements of a row may come in any order.
+*/
+static boolean reorder_memo_matches(struct reorder_memo *m, mtx_matrix_t mtx){
+  mtx_coord_t nz;
+  int32 r, k, n, stamp;
+  long q, count;
+
+  if( !m->valid ) return FALSE;
+  n = m->rng.high - m->rng.low + 1;
+  for( k = 0 ; k < n ; k++ ) m->mark[k] = -1;
+  for( k = 0 ; k < n ; k++ ) {
+    r = m->rng.low + k;
+    if( m->orow[k] != mtx_row_to_org(mtx,r) ||
+        m->ocol[k] != mtx_col_to_org(mtx,r) ) {
+      return FALSE;
+    }
+    stamp = k;
+    for( q = m->rp[k] ; q < m->rp[k+1] ; q++ ) m->mark[m->ci[q]] = stamp;
+    count = 0;
+    nz.row = r;
+    nz.col = mtx_FIRST;
+    while( mtx_next_in_row(mtx,&nz,&(m->rng)), nz.col != mtx_LAST ) {
+      if( m->mark[nz.col - m->rng.low] != stamp ) return FALSE;
+      count++;
+    }
+    if( count != m->rp[k+1] - m->rp[k] ) return FALSE;
+  }
+  return TRUE;
+}
+
+/**
+	Look up the record of reorderings by method over sys->rng, creating an
+	empty one if there is none. @return NULL if out of memory.
+*/
+static struct reorder_memo *find_reorder_memo(linsolqr_system_t sys,
+                                              enum reorder_method method)
+{
+  struct reorder_memo *m;
+  int32 n;
+  for( m = sys->memo ; NOTNULL(m) ; m = m->next ) {
+    if( m->rmethod == method && m->rng.low == sys->rng.low &&
+        m->rng.high == sys->rng.high ) {
+      return m;
+    }
+  }
+  n = MAX(sys->rng.high - sys->rng.low + 1,0);
+  m = ASC_NEW_CLEAR(struct reorder_memo);
+  if( ISNULL(m) ) return NULL;
+  m->rmethod = method;
+  m->rng = sys->rng;
+  m->valid = FALSE;
+  m->orow = ASC_NEW_ARRAY(int32,n+1);
+  m->ocol = ASC_NEW_ARRAY(int32,n+1);
+  m->rp = ASC_NEW_ARRAY(long,n+1);
+  m->mark = ASC_NEW_ARRAY(int32,n+1);
+  if( ISNULL(m->orow) || ISNULL(m->ocol) || ISNULL(m->rp) ||
+      ISNULL(m->mark) ) {
+    destroy_reorder_memo(m);
+    return NULL;
+  }
+  m->next = sys->memo;
+  sys->memo = m;
+  return m;
+}
+
 static int ranki_reorder(linsolqr_system_t sys,mtx_region_t *region)
 /**
 	The region to reorder is first isolated by truncating the region
@@ -1729,18 +1882,27 @@ static int ranki_reorder(linsolqr_system_t sys,mtx_region_t *region)
  **/
 {
    struct reorder_vars vars;
+   struct reorder_memo *memo = NULL;
    CHECK_SYSTEM(sys);
-   if (sys->fclass != ranki) {
+   if (sys->fclass != ranki && sys->fclass != s_lu) {
      ERROR_REPORTER_HERE(ASC_PROG_ERR,"called on system with inappropriate factor class");
      return 1;
    }
    if( region == mtx_ENTIRE_MATRIX ) determine_pivot_range(sys);
    else square_region(sys,region);
 
+   if( sys->reuse ) {
+      memo = find_reorder_memo(sys,spk1);
+      if( NOTNULL(memo) && reorder_memo_matches(memo,sys->coef) ) {
+         return 0;
+      }
+   }
+
    vars.mtx = sys->coef;
    vars.reg.row.low = vars.reg.col.low = sys->rng.low;
    vars.reg.row.high = vars.reg.col.high = sys->rng.high;
    spk1_reorder(&vars);
+   if( NOTNULL(memo) ) reorder_memo_record(memo,sys->coef);
    return 0;
 }
 
@@ -1753,18 +1915,27 @@ static int tranki_reorder(linsolqr_system_t sys,mtx_region_t *region)
  **/
 {
    struct creorder_vars vars;
+   struct reorder_memo *memo = NULL;
    CHECK_SYSTEM(sys);
-   if ( !(sys->fclass==ranki || sys->fclass==s_qr) ) {
+   if ( !(sys->fclass==ranki || sys->fclass==s_qr || sys->fclass==s_lu) ) {
      ERROR_REPORTER_HERE(ASC_PROG_ERR,"reorder called on system with inappropriate factor method");
      return 1;
    }
    if( region == mtx_ENTIRE_MATRIX ) determine_pivot_range(sys);
    else square_region(sys,region);
 
+   if( sys->reuse ) {
+      memo = find_reorder_memo(sys,tspk1);
+      if( NOTNULL(memo) && reorder_memo_matches(memo,sys->coef) ) {
+         return 0;
+      }
+   }
+
    vars.mtx = sys->coef;
    vars.reg.row.low = vars.reg.col.low = sys->rng.low;
    vars.reg.row.high = vars.reg.col.high = sys->rng.high;
    tspk1_reorder(&vars);
+   if( NOTNULL(memo) ) reorder_memo_record(memo,sys->coef);
    return 0;
 }
 
@@ -2892,12 +3063,23 @@ int linsolqr_prep(linsolqr_system_t sys,enum factor_class fclass)
       sys->ludata=create_ludata();
     destroy_qrdata(sys->qrdata);
     sys->qrdata=NULL;
+    snlu_destroy_data(sys->sndata);
+    sys->sndata=NULL;
     break;
   case s_qr:
     if (ISNULL(sys->qrdata))
     sys->qrdata=create_qrdata();
     destroy_ludata(sys->ludata);
     sys->ludata=NULL;
+    snlu_destroy_data(sys->sndata);
+    sys->sndata=NULL;
+    break;
+  case s_lu:
+    /* the factors themselves are allocated by snlu_entry */
+    if (ISNULL(sys->ludata))
+      sys->ludata=create_ludata();
+    destroy_qrdata(sys->qrdata);
+    sys->qrdata=NULL;
     break;
   default:
     ERROR_REPORTER_HERE(ASC_PROG_ERR,"called with unsupported factor class");
@@ -2986,6 +3168,9 @@ int linsolqr_factor(linsolqr_system_t sys, enum factor_method fmeth){
    case plain_qr:
     facstatus = cpqr_entry(sys,&(sys->reg)); /* BAA. check reg */
     break;
+  case sn_lu:
+    facstatus = snlu_entry(sys,&(sys->reg));
+    break;
   default:
     facstatus = 1;
     break;
@@ -3181,6 +3366,9 @@ void linsolqr_calc_row_dependencies(linsolqr_system_t sys){
   case ranki_jz2:
     calc_dependent_rows_ranki2(sys);
     break;
+  case sn_lu:
+    calc_dependent_rows_snlu(sys);
+    break;
   default:
     ERROR_REPORTER_HERE(ASC_PROG_ERR,
       "Don't know how to calculate for method %s."
@@ -3204,6 +3392,9 @@ void linsolqr_calc_col_dependencies(linsolqr_system_t sys){
   case ranki_jz2:
     calc_dependent_cols_ranki2(sys);
     break;
+  case sn_lu:
+    calc_dependent_cols_snlu(sys);
+    break;
   default:
     ERROR_REPORTER_HERE(ASC_PROG_ERR,"Don't know how to calculate for method %s.",
             linsolqr_enum_to_fmethod(sys->fmethod));
@@ -3443,6 +3634,9 @@ int linsolqr_solve(linsolqr_system_t sys,real64 *rhs){
       case plain_qr:
          solstatus = cpqr_solve(sys,rl);
          break;
+      case sn_lu:
+         solstatus = snlu_solve(sys,rl);
+         break;
       default:
          solstatus=1;
          break;
@@ -3752,6 +3946,10 @@ size_t linsolqr_size(linsolqr_system_t sys)
       if (NOTNULL(sys->factors)) s += mtx_size(sys->factors);
       if (NOTNULL(sys->inverse)) s += mtx_size(sys->inverse);
     break;
+    case s_lu:
+      if (NOTNULL(sys->factors)) s += mtx_size(sys->factors);
+      s += snlu_size(sys->sndata);
+    break;
     default: /* this is a best guess if we don't know what we are. */
       if (NOTNULL(sys->factors)) s += mtx_size(sys->factors);
       if (NOTNULL(sys->inverse)) s += mtx_size(sys->inverse);
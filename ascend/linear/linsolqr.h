@@ -229,7 +229,8 @@ typedef struct linsolqr_header *linsolqr_system_t;
 enum factor_class {
   unknown_c,      /**< error handling class */
   ranki = 100,    /**< all ranki (and gauss until broken out) methods */
-  s_qr = 200      /**< all sparse qr methods */
+  s_qr = 200,     /**< all sparse qr methods */
+  s_lu = 300      /**< compressed-column sparse lu methods */
 };
 
 enum reorder_method {
@@ -257,7 +258,8 @@ enum factor_method {
   opt_qr = 8,       /**< coming soon */
   ls_qr = 9,        /**< anticipated */
   gauss_ba2 = 10,   /**< anticipated */
-  symmetric_lu = 11 /**< anticipated */
+  symmetric_lu = 11, /**< anticipated */
+  sn_lu = 13        /**< left-looking supernodal lu, threshold pivoting */
 };
 
 ASC_DLLSPEC int g_linsolqr_timing;
@@ -510,6 +512,40 @@ extern real64 linsolqr_drop_tolerance(linsolqr_system_t sys);
  *  @todo Separate documentation for these linsolqr functions?
  */
 
+ASC_DLLSPEC void linsolqr_set_pivot_reuse(linsolqr_system_t sys,
+                                          boolean reuse);
+/**< See discussion under linsolqr_pivot_reuse(). */
+extern boolean linsolqr_pivot_reuse(linsolqr_system_t sys);
+/**<
+ *  <pre>
+ *  linsolqr_set_pivot_reuse(sys,reuse)
+ *  reuse = linsolqr_pivot_reuse(sys)
+ *
+ *  linsolqr_system_t sys;
+ *  boolean reuse;
+ *
+ *  Sets/gets the pivot reuse mode of the system (default FALSE).
+ *  Solvers calling linsolqr_matrix_was_changed() after refilling a
+ *  matrix with the same sparsity pattern would otherwise redo the
+ *  reordering and the full pivot search every time. With reuse on:
+ *
+ *  spk1, tspk1: the pattern and permutation left by a reordering are
+ *  remembered for each pivot range. If linsolqr_reorder() finds the
+ *  range unchanged since, the reordering is skipped.
+ *
+ *  sn_lu: the pivot sequence, supernodes and fill pattern are kept for
+ *  each region factored. If a region comes back with the same pattern
+ *  and permutation, only the numeric values are recomputed. If an old
+ *  pivot fails the pivot_tolerance/pivot_zero test with the new values,
+ *  or the region was rank deficient, a full factorization is done.
+ *  Other methods are unaffected.
+ *
+ *  Turning reuse off discards everything kept. The caller is still
+ *  responsible for calling linsolqr_matrix_was_changed() when values
+ *  change.
+ *  </pre>
+ */
+
 /* Functions for analyzing and querying linear systems. */
 
 extern enum factor_class linsolqr_fclass(linsolqr_system_t sys);
@@ -107,6 +107,22 @@ struct qr_auxdata { /* all indexed by cur row or cur col number */
 };
 /* structure for CondQR algorithms */
 
+struct snlu_data;
+/* supernodal factors, private to snlu.c */
+
+struct reorder_memo {
+  enum reorder_method rmethod;  /* reordering done */
+  mtx_range_t rng;              /* over this pivot range */
+  boolean valid;                /* ? pattern below was recorded */
+  int32 *orow, *ocol;           /* org row/col at each position of rng */
+  long *rp;                     /* elements of each row in ci */
+  int32 *ci;                    /* element cols, relative to rng.low */
+  long cicap;
+  int32 *mark;                  /* work for comparing rows */
+  struct reorder_memo *next;
+};
+/* record of a reordering kept for pivot reuse */
+
 struct linsolqr_header {
    int integrity;
    enum factor_class fclass;     /* Type of factoring expected */
@@ -134,6 +150,10 @@ struct linsolqr_header {
    real64 smallest_pivot;        /* Smallest pivot accepted */
    struct qr_auxdata *qrdata;    /* Data vectors for qr methods */
    struct lu_auxdata *ludata;    /* Data vectors for lu methods */
+   struct snlu_data *sndata;     /* Supernodal factors (s_lu methods), one
+                                    per region if reuse, most recent first */
+   boolean reuse;                /* ? keep orderings and pivots of regions */
+   struct reorder_memo *memo;    /* Reorderings done, if reuse */
 };
 /* linsol main structure */
 
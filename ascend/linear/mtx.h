@@ -504,6 +504,12 @@ typedef struct mtx_block_perm_structure *mtx_block_perm_t;
  ***  file or use those that are in it.
  **/
 
+#include "mtx_frozen.h"
+/***
+ ***  Frozen-pattern (CSC snapshot) mode, for refilling structurally
+ ***  identical matrices without rebuilding the element lists.
+ **/
+
 /**	@} */
 
 #endif /* ASC_MTX_H */
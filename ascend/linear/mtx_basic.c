@@ -217,6 +217,7 @@ static mtx_matrix_t alloc_header(void){
    mtx_matrix_t mtx;
    mtx = (mtx_matrix_t)ascmalloc( sizeof(struct mtx_header) );
    mtx->integrity = OK;
+   mtx->frozen = NULL;
    return(mtx);
 }
 
@@ -224,6 +225,7 @@ static mtx_matrix_t alloc_header(void){
 	Frees a matrix header.
 */
 static void free_header(mtx_matrix_t mtx){
+   mtx_thaw(mtx);
    mtx->integrity = DESTROYED;
    ascfree(mtx);
 }
@@ -306,6 +308,7 @@ static void delete_from_row(struct element_t **link){
    disclaim_element(p);
    /* conservatively cause mtx_set_value to forget */
    last_value_matrix->last_value = NULL;
+   if( NOTNULL(last_value_matrix->frozen) ) mtx_thaw(last_value_matrix);
 }
 
 /**
@@ -320,6 +323,7 @@ static void delete_from_col(struct element_t **link){
    disclaim_element(p);
    /* conservatively cause mtx_set_value to forget */
    last_value_matrix->last_value = NULL;
+   if( NOTNULL(last_value_matrix->frozen) ) mtx_thaw(last_value_matrix);
 }
 
 /**
@@ -337,6 +341,10 @@ static void nuke_fishnet(mtx_matrix_t mtx){
   }
   if (mtx->capacity<1) return;
   mtx->last_value = NULL;
+  mtx_thaw(mtx);
+  for (i = 0; i < mtx->nslaves; i++) {
+    mtx_thaw(mtx->slaves[i]);
+  }
   mem_clear_store(mtx->ms);
   zero(mtx->hdr.row,mtx->capacity,struct element_t *);
   zero(mtx->hdr.col,mtx->capacity,struct element_t *);
@@ -983,6 +991,12 @@ void mtx_set_order( mtx_matrix_t mtx, int32 order){
     return;
   }
   /* we now have a master matrix */
+  if( order != mtx->order ) {   /* frozen indexes are sized by order */
+    mtx_thaw(mtx);
+    for (i = 0; i < mtx->nslaves; i++) {
+      mtx_thaw(mtx->slaves[i]);
+    }
+  }
   if( order < mtx->order ) {   /* Truncate */
     trim_incidence(mtx,order); /* clean master */
     for (i = 0; i < mtx->nslaves; i++) {
@@ -18,6 +18,48 @@
 
 #ifdef ASC_WITH_UFSPARSE
 
+/**
+	Triplet copy of a matrix frozen with mtx_ENTIRE_MATRIX, built from the
+	snapshot without walking the element lists. Values are read through
+	the snapshot's element pointers so they are current even if the matrix
+	was changed since the last mtx_frozen_gather.
+*/
+static cs *mtx_frozen_to_cs(mtx_matrix_t M){
+	cs *S;
+	struct mtx_frozen_t *f = M->frozen;
+	int32 j, k, *rtocur, *ctocur;
+
+	S = cs_spalloc(f->order,f->order,f->nnz, 1/*alloc for values*/,1/*tripled format*/);
+	if(S == NULL) return NULL;
+	rtocur = M->perm.row.org_to_cur;
+	ctocur = M->perm.col.org_to_cur;
+	for(j = 0; j < f->order; ++j){
+		for(k = f->colptr[j]; k < f->colptr[j+1]; ++k){
+			S->i[k] = rtocur[f->rowind[k]];
+			S->p[k] = ctocur[j];
+			S->x[k] = f->elt[k]->value;
+		}
+	}
+	S->nz = f->nnz;
+	return S;
+}
+
+cs *mtx_frozen_cs(mtx_matrix_t M, cs *view){
+	int32 order;
+	const int32 *colptr, *rowind;
+	real64 *value;
+	if(view == NULL || mtx_frozen_csc(M,&order,&colptr,&rowind,&value)){
+		return NULL;
+	}
+	view->nzmax = mtx_frozen_nonzeros(M);
+	view->m = view->n = order;
+	view->p = (int *)colptr;
+	view->i = (int *)rowind;
+	view->x = value;
+	view->nz = -1; /* compressed-col format */
+	return view;
+}
+
 /**
 	We don't try to make this super-optimal at the moment. Just try to create	
 	the csparse matrix in triplet form.
@@ -38,6 +80,10 @@ cs *mtx_to_cs(mtx_matrix_t M){
 		return NULL;
 	}
 
+	if(M->frozen != NULL && M->frozen->whole && M->frozen->order == mtx_order(M)){
+		return mtx_frozen_to_cs(M);
+	}
+
 	mtx_region( &R, 0, mtx_order(M)-1, 0, mtx_order(M)-1 );
 	nnz = mtx_nonzeros_in_region(M, mtx_ENTIRE_MATRIX);
 
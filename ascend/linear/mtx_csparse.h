@@ -46,6 +46,16 @@ ASC_DLLSPEC cs *mtx_to_cs(mtx_matrix_t M);
 
 ASC_DLLSPEC mtx_matrix_t mtx_from_cs(const cs *C);
 
+ASC_DLLSPEC cs *mtx_frozen_cs(mtx_matrix_t M, cs *view);
+/**<
+	Fill the caller's cs header so that it refers, without copying, to the
+	compressed-column snapshot of a frozen matrix (see mtx_frozen.h), in
+	org coordinates. The header must not be passed to cs_spfree, and is
+	invalid once M thaws.
+
+	@return view, or NULL if M is not frozen
+*/
+
 # endif
 
 #endif
@@ -0,0 +1,202 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @file
+	Frozen-pattern (CSC snapshot) mode for mtx matrices.
+*//*
+	Created: Oct 2026
+*/
+
+#include <ascend/general/platform.h>
+#include <ascend/general/ascMalloc.h>
+#include <ascend/general/panic.h>
+#include <ascend/utilities/error.h>
+#include "mtx.h"
+/* grab our private parts */
+#define __MTX_C_SEEN__
+#include "mtx_use_only.h"
+#include "mtx_frozen.h"
+
+#define free_unless_null(ptr) if( NOTNULL(ptr) ) ascfree(ptr)
+
+static void free_frozen(struct mtx_frozen_t *f){
+  free_unless_null(f->colptr);
+  free_unless_null(f->rowind);
+  free_unless_null(f->value);
+  free_unless_null(f->elt);
+  free_unless_null(f->rowptr);
+  free_unless_null(f->rowcol);
+  free_unless_null(f->rowslot);
+  ascfree(f);
+}
+
+void mtx_thaw(mtx_matrix_t mtx){
+  if( ISNULL(mtx) || ISNULL(mtx->frozen) ) return;
+  free_frozen(mtx->frozen);
+  mtx->frozen = NULL;
+}
+
+int mtx_freeze(mtx_matrix_t mtx, mtx_region_t *region){
+  struct mtx_frozen_t *f;
+  struct element_t *elt;
+  mtx_range_t rows, cols;
+  int32 org, j, k, n, nnz, *rtocur, *ctocur, *pos;
+
+  if(!mtx_check_matrix(mtx)) return 1;
+  mtx_thaw(mtx);
+  n = mtx->order;
+  if(region == mtx_ENTIRE_MATRIX) {
+    rows.low = cols.low = 0;
+    rows.high = cols.high = n - 1;
+  }else{
+    rows = region->row;
+    cols = region->col;
+  }
+  rtocur = mtx->perm.row.org_to_cur;
+  ctocur = mtx->perm.col.org_to_cur;
+
+  f = ASC_NEW_CLEAR(struct mtx_frozen_t);
+  f->order = n;
+  f->whole = (region == mtx_ENTIRE_MATRIX);
+  f->colptr = ASC_NEW_ARRAY_CLEAR(int32,n+1);
+  f->rowptr = ASC_NEW_ARRAY_CLEAR(int32,n+1);
+  pos = ASC_NEW_ARRAY(int32,n+1);
+  if(ISNULL(f->colptr) || ISNULL(f->rowptr) || ISNULL(pos)) {
+    free_unless_null(pos);
+    free_frozen(f);
+    return 1;
+  }
+
+  /* count the nonzeros in each org row and col of the region */
+  for( org = 0; org < n; org++ ) {
+    if(!in_range(&rows,rtocur[org])) continue;
+    for( elt = mtx->hdr.row[org]; NOTNULL(elt); elt = elt->next.col ) {
+      if(in_range(&cols,ctocur[elt->col])) {
+        f->colptr[elt->col + 1]++;
+        f->rowptr[org + 1]++;
+      }
+    }
+  }
+  for( j = 0; j < n; j++ ) {
+    f->colptr[j+1] += f->colptr[j];
+    f->rowptr[j+1] += f->rowptr[j];
+  }
+  nnz = f->nnz = f->colptr[n];
+  if(nnz > 0) {
+    f->rowind = ASC_NEW_ARRAY(int32,nnz);
+    f->value = ASC_NEW_ARRAY(real64,nnz);
+    f->elt = ASC_NEW_ARRAY(struct element_t *,nnz);
+    f->rowcol = ASC_NEW_ARRAY(int32,nnz);
+    f->rowslot = ASC_NEW_ARRAY(int32,nnz);
+    if(ISNULL(f->rowind) || ISNULL(f->value) || ISNULL(f->elt)
+        || ISNULL(f->rowcol) || ISNULL(f->rowslot)
+    ){
+      ascfree(pos);
+      free_frozen(f);
+      return 1;
+    }
+  }
+
+  /* fill the CSC arrays; visiting rows in org order sorts each column */
+  mem_copy_cast(f->colptr,pos,n*sizeof(int32));
+  for( org = 0; org < n; org++ ) {
+    if(!in_range(&rows,rtocur[org])) continue;
+    for( elt = mtx->hdr.row[org]; NOTNULL(elt); elt = elt->next.col ) {
+      if(in_range(&cols,ctocur[elt->col])) {
+        k = pos[elt->col]++;
+        f->rowind[k] = org;
+        f->value[k] = elt->value;
+        f->elt[k] = elt;
+      }
+    }
+  }
+
+  /* build the row index; visiting columns in org order sorts each row */
+  mem_copy_cast(f->rowptr,pos,n*sizeof(int32));
+  for( j = 0; j < n; j++ ) {
+    for( k = f->colptr[j]; k < f->colptr[j+1]; k++ ) {
+      org = pos[f->rowind[k]]++;
+      f->rowcol[org] = j;
+      f->rowslot[org] = k;
+    }
+  }
+  ascfree(pos);
+  mtx->frozen = f;
+  return 0;
+}
+
+boolean mtx_is_frozen(mtx_matrix_t mtx){
+  return (NOTNULL(mtx) && NOTNULL(mtx->frozen));
+}
+
+int32 mtx_frozen_nonzeros(mtx_matrix_t mtx){
+  return mtx_is_frozen(mtx) ? mtx->frozen->nnz : 0;
+}
+
+int32 mtx_frozen_slot(mtx_matrix_t mtx, int32 org_row, int32 org_col){
+  struct mtx_frozen_t *f;
+  int32 lo, hi, mid;
+  if(!mtx_is_frozen(mtx)) return mtx_NONE;
+  f = mtx->frozen;
+  if(org_row < 0 || org_row >= f->order) return mtx_NONE;
+  lo = f->rowptr[org_row];
+  hi = f->rowptr[org_row+1] - 1;
+  while(lo <= hi) {
+    mid = (lo + hi)/2;
+    if(f->rowcol[mid] < org_col) {
+      lo = mid + 1;
+    }else if(f->rowcol[mid] > org_col) {
+      hi = mid - 1;
+    }else{
+      return f->rowslot[mid];
+    }
+  }
+  return mtx_NONE;
+}
+
+real64 *mtx_frozen_values(mtx_matrix_t mtx){
+  return mtx_is_frozen(mtx) ? mtx->frozen->value : NULL;
+}
+
+void mtx_frozen_commit(mtx_matrix_t mtx){
+  struct mtx_frozen_t *f;
+  int32 k;
+  if(!mtx_is_frozen(mtx)) return;
+  f = mtx->frozen;
+  for( k = 0; k < f->nnz; k++ ) {
+    f->elt[k]->value = f->value[k];
+  }
+}
+
+void mtx_frozen_gather(mtx_matrix_t mtx){
+  struct mtx_frozen_t *f;
+  int32 k;
+  if(!mtx_is_frozen(mtx)) return;
+  f = mtx->frozen;
+  for( k = 0; k < f->nnz; k++ ) {
+    f->value[k] = f->elt[k]->value;
+  }
+}
+
+int mtx_frozen_csc(mtx_matrix_t mtx, int32 *order
+		, const int32 **colptr, const int32 **rowind, real64 **value
+){
+  if(!mtx_is_frozen(mtx)) return 1;
+  *order = mtx->frozen->order;
+  *colptr = mtx->frozen->colptr;
+  *rowind = mtx->frozen->rowind;
+  *value = mtx->frozen->value;
+  return 0;
+}
@@ -0,0 +1,110 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @file
+	Frozen-pattern mode for mtx matrices.
+
+	Nonlinear solvers refill a structurally identical Jacobian at every
+	iteration. Clearing a region and filling it again rebuilds the element
+	lists each time. Instead, once the sparsity of a region is known, the
+	region can be 'frozen': a compressed-sparse-column (CSC) snapshot is
+	kept alongside the matrix, with one slot per nonzero and a value array
+	in which each nonzero has a fixed position. New values are written
+	straight into that array, and mtx_frozen_commit copies them to the
+	matrix elements in a single linear pass, with no list traversal or
+	allocation.
+
+	The snapshot stays valid only while the pattern is unchanged. Any mtx
+	operation that creates or deletes elements in the matrix (including
+	clearing a region), transposes it or changes its order thaws it
+	automatically; mtx_is_frozen tells whether that has happened.
+
+	Coordinates in the snapshot are org coordinates, so that row and column
+	permutations of the matrix do not affect it.
+*//*
+	Created: Oct 2026
+*/
+
+#ifndef ASC_MTX_FROZEN_H
+#define ASC_MTX_FROZEN_H
+
+#include "mtx.h"
+
+/**	@addtogroup linear Linear
+	@{
+*/
+
+ASC_DLLSPEC int mtx_freeze(mtx_matrix_t mtx, mtx_region_t *region);
+/**<
+	Take a frozen-pattern snapshot of the nonzeros of mtx lying in the
+	given region (current coordinates; mtx_ENTIRE_MATRIX is allowed). Any
+	earlier snapshot is discarded. The value array is initialised from the
+	elements. Within each column, slots are ordered by org row.
+
+	@return 0 on success, 1 on bad input or insufficient memory (in which
+	case the matrix is left unfrozen).
+*/
+
+ASC_DLLSPEC void mtx_thaw(mtx_matrix_t mtx);
+/**<
+	Discard the frozen-pattern snapshot of mtx, if any. The matrix itself
+	is unchanged.
+*/
+
+ASC_DLLSPEC boolean mtx_is_frozen(mtx_matrix_t mtx);
+/**< TRUE if mtx has a valid frozen-pattern snapshot. */
+
+ASC_DLLSPEC int32 mtx_frozen_nonzeros(mtx_matrix_t mtx);
+/**< Number of slots in the snapshot, or 0 if mtx is not frozen. */
+
+ASC_DLLSPEC int32 mtx_frozen_slot(mtx_matrix_t mtx
+		, int32 org_row, int32 org_col);
+/**<
+	Slot of the element at the given org coordinates, or mtx_NONE if there
+	is none in the snapshot. Costs a binary search within the row, so
+	callers refilling many times should look slots up once and keep them.
+*/
+
+ASC_DLLSPEC real64 *mtx_frozen_values(mtx_matrix_t mtx);
+/**<
+	The value array of the snapshot, mtx_frozen_nonzeros(mtx) long, or NULL
+	if mtx is not frozen. Writing to it does not change the matrix until
+	mtx_frozen_commit is called.
+*/
+
+ASC_DLLSPEC void mtx_frozen_commit(mtx_matrix_t mtx);
+/**< Copy the value array into the matrix elements. */
+
+ASC_DLLSPEC void mtx_frozen_gather(mtx_matrix_t mtx);
+/**<
+	Copy the matrix element values into the value array, e.g. after the
+	matrix has been scaled with mtx_mult_row/col, so that readers of the
+	CSC arrays see the current values.
+*/
+
+ASC_DLLSPEC int mtx_frozen_csc(mtx_matrix_t mtx, int32 *order
+		, const int32 **colptr, const int32 **rowind, real64 **value);
+/**<
+	Give read access to the snapshot in CSC form, without copying: column
+	j (org) occupies slots colptr[j] to colptr[j+1]-1, whose org rows are
+	rowind[] and values value[]. The arrays belong to the matrix and are
+	invalid once it thaws.
+
+	@return 0 on success, 1 if mtx is not frozen.
+*/
+
+/**	@} */
+
+#endif /* ASC_MTX_FROZEN_H */
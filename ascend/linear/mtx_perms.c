@@ -1110,6 +1110,11 @@ int32 mtx_transpose(mtx_matrix_t mtx)
     return mtx_NONE;
   }
   master->perm.transpose = !(master->perm.transpose);
+  /* frozen patterns are in org coordinates, which are about to swap */
+  mtx_thaw(master);
+  for (slave = 0; slave < master->nslaves; slave++) {
+    mtx_thaw(master->slaves[slave]);
+  }
   /* swap perms on master */
   permtmp = mtx->perm.col.org_to_cur;  /* do o2v */
   mtx->perm.col.org_to_cur = mtx->perm.row.org_to_cur;
@@ -72,6 +72,7 @@ struct element_t *mtx_create_element(mtx_matrix_t mtx,
             org_row,org_col);
   }
 #endif
+  if( NOTNULL(mtx->frozen) ) mtx_thaw(mtx); /* pattern grows */
   elt = (struct element_t *)mem_get_element(mtx->ms);
   /* guess who didn't check for the alloc return. */
   elt->value = 0.0;
@@ -97,6 +98,7 @@ struct element_t *mtx_create_element_value(mtx_matrix_t mtx,
             org_row,org_col);
   }
 #endif
+  if( NOTNULL(mtx->frozen) ) mtx_thaw(mtx); /* pattern grows */
   elt = (struct element_t *)mem_get_element(mtx->ms);
   /* guess who didn't check for the alloc return. not needed here. */
   elt->value = val;
@@ -203,6 +203,26 @@ struct structural_data_t {
   mtx_region_t *block;    /**< Pointer to array of blocks */
 };
 
+/**
+ ** Frozen-pattern snapshot of a region of a matrix; see mtx_frozen.h.
+ ** Both indexes are in org coordinates. Slot k of the CSC arrays
+ ** mirrors the element elt[k]. Any operation which creates or destroys
+ ** elements, or changes their coordinates, must discard the snapshot
+ ** with mtx_thaw, since elt[] would then be wrong.
+ **/
+struct mtx_frozen_t {
+  int32 order;            /**< order of the matrix when frozen */
+  int32 nnz;              /**< number of slots */
+  boolean whole;          /**< TRUE if frozen with mtx_ENTIRE_MATRIX */
+  int32 *colptr;          /**< CSC: order+1 slot offsets, by org col */
+  int32 *rowind;          /**< CSC: org row of each slot */
+  real64 *value;          /**< CSC: value of each slot */
+  struct element_t **elt; /**< element of each slot */
+  int32 *rowptr;          /**< order+1 offsets into rowcol/rowslot */
+  int32 *rowcol;          /**< org cols of each row, ascending */
+  int32 *rowslot;         /**< slot of each rowcol entry */
+};
+
 /**<
  ***  capacity may be > order.
  ***  A matrix of capacity 0 doesn't have a mem_store_t yet and elements
@@ -220,6 +240,7 @@ struct mtx_header {
   struct structural_data_t *data; /**< Pointer to structural information */
   mtx_matrix_t master;            /**< the master of this mtx, if slave */
   mtx_matrix_t *slaves;           /**< array of slave matrices */
+  struct mtx_frozen_t *frozen;    /**< frozen pattern, or NULL */
 };
 
 /**<
@@ -0,0 +1,1125 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @file
+	Supernodal sparse LU factorization (linsolqr method sn_lu).
+
+	Notation: the factored region has order n and is addressed in 'local'
+	coordinates, i.e. cur row/col minus sys->rng.low. Column j is factored
+	at 'step' k <= j (deferred singular columns take no step). After
+	factoring, P.A.Q = L.U where the k-th pivot row is prow[k] and the k-th
+	pivot column is pcol[k].
+
+	Supernode s covers steps sfirst[s] .. sfirst[s]+sncol[s]-1. Its
+	snrow[s] rows are listed in srow; the first sncol[s] of them are the
+	pivot rows of its steps, in order. Its values form a dense column-major
+	snrow[s] by sncol[s] block in sval. In column c of the block, rows
+	above c hold U entries, row c holds the pivot and rows below hold the
+	L multipliers (L has a unit diagonal). U entries in rows belonging to
+	earlier supernodes are kept in sparse columns ui/ux, indexed by step.
+
+	When pivot reuse is on (linsolqr_set_pivot_reuse), one set of factors
+	is kept per region factored. If a region comes back with the same
+	pattern and permutation, the pivot sequence, supernode partition and
+	fill pattern of the previous factorization are kept and only the values
+	are recomputed. A full factorization is done instead if the region is
+	rank deficient or one of the old pivots fails the threshold test.
+*//*
+	Created: Oct 2026
+*/
+
+#include "snlu.h"
+
+#include <math.h>
+#include <ascend/general/ascMalloc.h>
+#include <ascend/general/mathmacros.h>
+#include <ascend/general/tm_time.h>
+#include <ascend/utilities/error.h>
+
+/*
+	Widest supernode allowed. The part of a supernode's diagonal block
+	above the diagonal is stored densely, so this bounds the explicit zeros
+	kept for the sake of the dense kernels.
+*/
+#define SNLU_MAX_COLS 64
+
+struct snlu_data {
+  struct snlu_data *next; /* factors of other regions, if kept */
+  int32 low;          /* sys->rng.low of the factored region */
+  int32 n;            /* order of the factored region */
+  int32 rank;         /* number of pivots accepted */
+  boolean reusable;   /* ? structure valid for numeric refactorization */
+  long fnz;           /* number of values stored in the factors */
+  int32 cap;          /* capacity of the arrays of length n */
+  int32 *orow;        /* local row -> org row */
+  int32 *ocol;        /* local col -> org col */
+  int32 *prow;        /* step -> local row; unpivoted rows follow rank */
+  int32 *pcol;        /* step -> local col; deferred cols follow rank */
+  int32 *pinv;        /* local row -> step, or -1 if unpivoted */
+  int32 *sof;         /* step -> supernode */
+  real64 *piv;        /* step -> pivot */
+  int32 nsuper;       /* number of supernodes */
+  int32 *sfirst;      /* supernode -> first step */
+  int32 *sncol;       /* supernode -> number of columns (steps) */
+  int32 *snrow;       /* supernode -> number of rows */
+  long *srowp;        /* supernode -> offset of its rows in srow */
+  long *svalp;        /* supernode -> offset of its block in sval */
+  int32 *srow;
+  real64 *sval;
+  long srowcap, svalcap;
+  long *up;           /* step -> first off-block U entry, n+1 long */
+  int32 *ui;          /* step of the row of each U entry */
+  real64 *ux;
+  long ucap;
+  long *ap;           /* CSC copy of the region, local coordinates */
+  int32 *ai;
+  real64 *ax;
+  long acap;
+  real64 *x;          /* dense work, indexed by local row */
+  real64 *w;          /* dense work, indexed by step or block row */
+  int32 *rmark;       /* row stamps */
+  int32 *smark;       /* supernode stamps */
+  int32 *spos;        /* depth first search position in each supernode */
+  int32 *stack;       /* depth first search stack */
+  int32 *post;        /* supernodes reached, in postorder */
+  int32 *pat;         /* unpivoted rows in the current column */
+  int32 *defer;       /* deferred (singular) columns */
+  int32 *rpos;        /* local row -> row of the dense panel */
+  real64 *pv;         /* dense panel work of snlu_refactor */
+  long pcap;
+};
+
+/*------------------------------------------------------------------------------
+  DENSE KERNELS
+
+  Column-major blocks with leading dimension lda, shaped after the BLAS
+  routines named. Local versions are used since libascend is not linked
+  against the Fortran BLAS in blas/.
+*/
+
+/** x := inv(L).x, L unit lower triangular (dtrsv 'L','N','U'). */
+static void snlu_trsv_lnu(int32 n, const real64 *a, int32 lda, real64 *x){
+  int32 i,j;
+  const real64 *col;
+  real64 xj;
+  for (j = 0; j < n; j++) {
+    xj = x[j];
+    if (xj == D_ZERO) continue;
+    col = a + (long)j*lda;
+    for (i = j+1; i < n; i++) x[i] -= col[i]*xj;
+  }
+}
+
+/** x := inv(L').x, L unit lower triangular (dtrsv 'L','T','U'). */
+static void snlu_trsv_ltu(int32 n, const real64 *a, int32 lda, real64 *x){
+  int32 i,j;
+  const real64 *col;
+  real64 sum;
+  for (j = n-1; j >= 0; j--) {
+    col = a + (long)j*lda;
+    sum = x[j];
+    for (i = j+1; i < n; i++) sum -= col[i]*x[i];
+    x[j] = sum;
+  }
+}
+
+/** x := inv(U).x, U upper triangular (dtrsv 'U','N','N'). */
+static void snlu_trsv_unn(int32 n, const real64 *a, int32 lda, real64 *x){
+  int32 i,j;
+  const real64 *col;
+  real64 xj;
+  for (j = n-1; j >= 0; j--) {
+    col = a + (long)j*lda;
+    xj = x[j] = x[j]/col[j];
+    if (xj == D_ZERO) continue;
+    for (i = 0; i < j; i++) x[i] -= col[i]*xj;
+  }
+}
+
+/** x := inv(U').x, U upper triangular (dtrsv 'U','T','N'). */
+static void snlu_trsv_utn(int32 n, const real64 *a, int32 lda, real64 *x){
+  int32 i,j;
+  const real64 *col;
+  real64 sum;
+  for (j = 0; j < n; j++) {
+    col = a + (long)j*lda;
+    sum = x[j];
+    for (i = 0; i < j; i++) sum -= col[i]*x[i];
+    x[j] = sum/col[j];
+  }
+}
+
+/** y := y - A.x, A m by n (dgemv 'N' with alpha -1). */
+static void snlu_gemv_n(int32 m, int32 n, const real64 *a, int32 lda
+		, const real64 *x, real64 *y
+){
+  int32 i,j;
+  const real64 *col;
+  real64 xj;
+  for (j = 0; j < n; j++) {
+    xj = x[j];
+    if (xj == D_ZERO) continue;
+    col = a + (long)j*lda;
+    for (i = 0; i < m; i++) y[i] -= col[i]*xj;
+  }
+}
+
+/**
+	B := inv(L).B, L m by m unit lower triangular, B m by n
+	(dtrsm 'L','L','N','U' with alpha 1).
+*/
+static void snlu_trsm_llnu(int32 m, int32 n, const real64 *a, int32 lda
+		, real64 *b, int32 ldb
+){
+  int32 j;
+  for (j = 0; j < n; j++) snlu_trsv_lnu(m,a,lda,b+(long)j*ldb);
+}
+
+/**
+	C := C - A.B, A m by k, B k by n, C m by n (dgemm 'N','N' with
+	alpha -1, beta 1). The loops run down the columns of A and C.
+*/
+static void snlu_gemm_nn(int32 m, int32 n, int32 k, const real64 *a
+		, int32 lda, const real64 *b, int32 ldb, real64 *c, int32 ldc
+){
+  int32 i,j,l;
+  const real64 *col;
+  real64 *cj, blj;
+  for (j = 0; j < n; j++) {
+    cj = c + (long)j*ldc;
+    for (l = 0; l < k; l++) {
+      blj = b[(long)j*ldb+l];
+      if (blj == D_ZERO) continue;
+      col = a + (long)l*lda;
+      for (i = 0; i < m; i++) cj[i] -= col[i]*blj;
+    }
+  }
+}
+
+/** y := y - A'.x, A m by n (dgemv 'T' with alpha -1). */
+static void snlu_gemv_t(int32 m, int32 n, const real64 *a, int32 lda
+		, const real64 *x, real64 *y
+){
+  int32 i,j;
+  const real64 *col;
+  real64 sum;
+  for (j = 0; j < n; j++) {
+    col = a + (long)j*lda;
+    sum = D_ZERO;
+    for (i = 0; i < m; i++) sum += col[i]*x[i];
+    y[j] -= sum;
+  }
+}
+
+/*------------------------------------------------------------------------------
+  STORAGE
+*/
+
+static struct snlu_data *snlu_create_data(void){
+  return ASC_NEW_CLEAR(struct snlu_data);
+}
+
+#define free_unless_null(ptr) if( NOTNULL(ptr) ) { ascfree(ptr); (ptr) = NULL; }
+
+static void snlu_free_work(struct snlu_data *d){
+  free_unless_null(d->orow);
+  free_unless_null(d->ocol);
+  free_unless_null(d->prow);
+  free_unless_null(d->pcol);
+  free_unless_null(d->pinv);
+  free_unless_null(d->sof);
+  free_unless_null(d->piv);
+  free_unless_null(d->sfirst);
+  free_unless_null(d->sncol);
+  free_unless_null(d->snrow);
+  free_unless_null(d->srowp);
+  free_unless_null(d->svalp);
+  free_unless_null(d->up);
+  free_unless_null(d->ap);
+  free_unless_null(d->x);
+  free_unless_null(d->w);
+  free_unless_null(d->rmark);
+  free_unless_null(d->smark);
+  free_unless_null(d->spos);
+  free_unless_null(d->stack);
+  free_unless_null(d->post);
+  free_unless_null(d->pat);
+  free_unless_null(d->defer);
+  free_unless_null(d->rpos);
+  d->cap = 0;
+}
+
+void snlu_destroy_data(struct snlu_data *d){
+  struct snlu_data *next;
+  while (NOTNULL(d)) {
+    next = d->next;
+    snlu_free_work(d);
+    free_unless_null(d->srow);
+    free_unless_null(d->sval);
+    free_unless_null(d->ui);
+    free_unless_null(d->ux);
+    free_unless_null(d->ai);
+    free_unless_null(d->ax);
+    free_unless_null(d->pv);
+    ascfree(d);
+    d = next;
+  }
+}
+
+void snlu_trim_data(struct snlu_data *d){
+  if (ISNULL(d)) return;
+  snlu_destroy_data(d->next);
+  d->next = NULL;
+}
+
+size_t snlu_size(struct snlu_data *d){
+  size_t s = 0;
+  for ( ; NOTNULL(d); d = d->next) {
+    s += sizeof(struct snlu_data);
+    s += (size_t)d->cap * (17*sizeof(int32) + 3*sizeof(real64) + 4*sizeof(long));
+    s += (size_t)d->srowcap * sizeof(int32);
+    s += (size_t)d->svalcap * sizeof(real64);
+    s += (size_t)d->ucap * (sizeof(int32) + sizeof(real64));
+    s += (size_t)d->acap * (sizeof(int32) + sizeof(real64));
+    s += (size_t)d->pcap * sizeof(real64);
+  }
+  return s;
+}
+
+/**
+	Find the factors to use for the region sys->rng, making them the head
+	of the sys->sndata list. Without pivot reuse only one set is kept.
+	@return NULL if out of memory.
+*/
+static struct snlu_data *snlu_find(linsolqr_system_t sys, int32 n){
+  struct snlu_data *d, *prev;
+
+  prev = NULL;
+  for (d = sys->sndata; NOTNULL(d); prev = d, d = d->next) {
+    if (!sys->reuse || (d->low == sys->rng.low && d->n == n)) break;
+  }
+  if (ISNULL(d)) {
+    d = snlu_create_data();
+    if (ISNULL(d)) return NULL;
+    d->next = sys->sndata;
+    sys->sndata = d;
+  } else if (NOTNULL(prev)) {
+    prev->next = d->next;
+    d->next = sys->sndata;
+    sys->sndata = d;
+  }
+  if (d->low != sys->rng.low || d->n != n) d->reusable = FALSE;
+  d->low = sys->rng.low;
+  d->n = n;
+  return d;
+}
+
+/**
+	Make room for a region of order n in the arrays of length n.
+	Contents are not preserved. @return 0 on success, 1 if out of memory.
+*/
+static int snlu_ensure_order(struct snlu_data *d, int32 n){
+  int32 cap;
+  if (n <= d->cap && NOTNULL(d->x)) {
+    mtx_zero_real64(d->x,d->cap);
+    mtx_zero_int32(d->rmark,d->cap);
+    mtx_zero_int32(d->smark,d->cap);
+    return 0;
+  }
+  snlu_free_work(d);
+  cap = MAX(n,1);
+  d->orow = ASC_NEW_ARRAY(int32,cap);
+  d->ocol = ASC_NEW_ARRAY(int32,cap);
+  d->prow = ASC_NEW_ARRAY(int32,cap);
+  d->pcol = ASC_NEW_ARRAY(int32,cap);
+  d->pinv = ASC_NEW_ARRAY(int32,cap);
+  d->sof = ASC_NEW_ARRAY(int32,cap);
+  d->piv = ASC_NEW_ARRAY(real64,cap);
+  d->sfirst = ASC_NEW_ARRAY(int32,cap);
+  d->sncol = ASC_NEW_ARRAY(int32,cap);
+  d->snrow = ASC_NEW_ARRAY(int32,cap);
+  d->srowp = ASC_NEW_ARRAY(long,cap);
+  d->svalp = ASC_NEW_ARRAY(long,cap);
+  d->up = ASC_NEW_ARRAY(long,cap+1);
+  d->ap = ASC_NEW_ARRAY(long,cap+1);
+  d->x = ASC_NEW_ARRAY_CLEAR(real64,cap);
+  d->w = ASC_NEW_ARRAY(real64,cap);
+  d->rmark = ASC_NEW_ARRAY_CLEAR(int32,cap);
+  d->smark = ASC_NEW_ARRAY_CLEAR(int32,cap);
+  d->spos = ASC_NEW_ARRAY(int32,cap);
+  d->stack = ASC_NEW_ARRAY(int32,cap);
+  d->post = ASC_NEW_ARRAY(int32,cap);
+  d->pat = ASC_NEW_ARRAY(int32,cap);
+  d->defer = ASC_NEW_ARRAY(int32,cap);
+  d->rpos = ASC_NEW_ARRAY(int32,cap);
+  if (ISNULL(d->orow) || ISNULL(d->ocol) || ISNULL(d->prow)
+      || ISNULL(d->pcol) || ISNULL(d->pinv) || ISNULL(d->sof)
+      || ISNULL(d->piv) || ISNULL(d->sfirst) || ISNULL(d->sncol)
+      || ISNULL(d->snrow) || ISNULL(d->srowp) || ISNULL(d->svalp)
+      || ISNULL(d->up) || ISNULL(d->ap) || ISNULL(d->x) || ISNULL(d->w)
+      || ISNULL(d->rmark) || ISNULL(d->smark) || ISNULL(d->spos)
+      || ISNULL(d->stack) || ISNULL(d->post) || ISNULL(d->pat)
+      || ISNULL(d->defer) || ISNULL(d->rpos)
+  ){
+    snlu_free_work(d);
+    return 1;
+  }
+  d->cap = cap;
+  return 0;
+}
+
+/**
+	Grow an index array and/or a value array sharing the capacity *cap so
+	that they hold at least need entries. Either pointer may be NULL.
+	@return 0 on success, 1 if out of memory.
+*/
+static int snlu_grow(int32 **ind, real64 **val, long *cap, long need){
+  long newcap;
+  int32 *ip;
+  real64 *vp;
+  if (need <= *cap) return 0;
+  newcap = MAX(need,2*(*cap));
+  newcap = MAX(newcap,1024);
+  if (NOTNULL(ind)) {
+    ip = (int32 *)ascrealloc(*ind,newcap*sizeof(int32));
+    if (ISNULL(ip)) return 1;
+    *ind = ip;
+  }
+  if (NOTNULL(val)) {
+    vp = (real64 *)ascrealloc(*val,newcap*sizeof(real64));
+    if (ISNULL(vp)) return 1;
+    *val = vp;
+  }
+  *cap = newcap;
+  return 0;
+}
+
+/**
+	Copy the square region sys->rng of the coefficient matrix into the
+	local CSC arrays. d->reusable is cleared if the pattern or the
+	permutation differs from the one loaded before.
+	@return 0 on success, 1 if out of memory.
+*/
+static int snlu_load(linsolqr_system_t sys, struct snlu_data *d){
+  mtx_coord_t nz;
+  mtx_range_t rows;
+  real64 value;
+  int32 j, org;
+  long top;
+  boolean same;
+
+  same = d->reusable;
+  rows = sys->rng;
+  top = 0;
+  for (j = 0; j < d->n; j++) {
+    org = mtx_row_to_org(sys->coef,rows.low+j);
+    if (same && d->orow[j] != org) same = FALSE;
+    d->orow[j] = org;
+    org = mtx_col_to_org(sys->coef,rows.low+j);
+    if (same && (d->ocol[j] != org || d->ap[j] != top)) same = FALSE;
+    d->ocol[j] = org;
+    d->ap[j] = top;
+    nz.col = rows.low+j;
+    nz.row = mtx_FIRST;
+    while (value = mtx_next_in_col(sys->coef,&nz,&rows),
+           nz.row != mtx_LAST) {
+      if (same && (top >= d->acap || d->ai[top] != nz.row - rows.low)) {
+        same = FALSE;
+      }
+      if (snlu_grow(&(d->ai),&(d->ax),&(d->acap),top+1)) return 1;
+      d->ai[top] = nz.row - rows.low;
+      d->ax[top] = value;
+      top++;
+    }
+  }
+  if (same && d->ap[d->n] != top) same = FALSE;
+  d->ap[d->n] = top;
+  d->reusable = same;
+  return 0;
+}
+
+/*------------------------------------------------------------------------------
+  FACTORIZATION
+*/
+
+/**
+	Find the supernodes whose columns will update column j: those owning a
+	pivot row in which A(:,j) has an entry, and, recursively, those owning
+	a pivot row among the off-diagonal rows of a supernode already found.
+	They are left in d->post in postorder, so reading d->post backwards
+	gives an order in which every supernode comes after all that update
+	it. @return the number found.
+*/
+static int32 snlu_reach(struct snlu_data *d, int32 j, int32 stamp){
+  int32 nt, top, s, s2, t, i;
+  int32 *R;
+  long q;
+
+  nt = 0;
+  for (q = d->ap[j]; q < d->ap[j+1]; q++) {
+    i = d->ai[q];
+    if (d->pinv[i] < 0) continue;
+    s = d->sof[d->pinv[i]];
+    if (d->smark[s] == stamp) continue;
+    d->smark[s] = stamp;
+    d->spos[s] = d->sncol[s];
+    top = 0;
+    d->stack[0] = s;
+    while (top >= 0) {
+      s = d->stack[top];
+      R = d->srow + d->srowp[s];
+      s2 = -1;
+      for (t = d->spos[s]; t < d->snrow[s]; t++) {
+        i = R[t];
+        if (d->pinv[i] < 0) continue;
+        s2 = d->sof[d->pinv[i]];
+        if (d->smark[s2] != stamp) break;
+        s2 = -1;
+      }
+      if (s2 >= 0) {
+        d->spos[s] = t+1;
+        d->smark[s2] = stamp;
+        d->spos[s2] = d->sncol[s2];
+        d->stack[++top] = s2;
+      } else {
+        top--;
+        d->post[nt++] = s;
+      }
+    }
+  }
+  return nt;
+}
+
+/**
+	Apply the first nc columns of supernode s to the dense column d->x:
+	solve with the unit lower triangle of their diagonal block, then
+	subtract the product of the rows below it.
+*/
+static void snlu_apply(struct snlu_data *d, int32 s, int32 nc){
+  int32 t, nr;
+  int32 *R;
+  real64 *V, *w;
+
+  nr = d->snrow[s];
+  R = d->srow + d->srowp[s];
+  V = d->sval + d->svalp[s];
+  w = d->w;
+  for (t = 0; t < nc; t++) w[t] = d->x[R[t]];
+  snlu_trsv_lnu(nc,V,nr,w);
+  for (t = 0; t < nc; t++) d->x[R[t]] = w[t];
+  if (nr == nc) return;
+  for (t = nc; t < nr; t++) w[t] = D_ZERO;
+  snlu_gemv_n(nr-nc,nc,V+nc,nr,w,w+nc);
+  for (t = nc; t < nr; t++) d->x[R[t]] += w[t];
+}
+
+/**
+	Apply supernode s to the dense column d->x as snlu_apply, adding the
+	unpivoted rows newly reached to d->pat.
+*/
+static void snlu_update(struct snlu_data *d, int32 s, int32 stamp
+		, int32 *npat
+){
+  int32 t, i;
+  int32 *R;
+
+  snlu_apply(d,s,d->sncol[s]);
+  R = d->srow + d->srowp[s];
+  for (t = d->sncol[s]; t < d->snrow[s]; t++) {
+    i = R[t];
+    if (d->pinv[i] < 0 && d->rmark[i] != stamp) {
+      d->rmark[i] = stamp;
+      d->pat[(*npat)++] = i;
+    }
+  }
+}
+
+/**
+	Left-looking supernodal LU of the loaded region with threshold partial
+	pivoting. The diagonal (in the reordered matrix) is preferred as pivot
+	if within sys->ptol of the largest candidate; columns with no candidate
+	above sys->pivot_zero are deferred.
+	@return 0 on success, 1 if out of memory.
+*/
+static int snlu_factor(linsolqr_system_t sys, struct snlu_data *d){
+  int32 n, j, k, s, p, i, t, c, q, nt, npat, ndef, open, nc, nr, stamp;
+  int32 *R;
+  real64 *V, *x, maxv, v, pivot;
+  long qa, srowtop, svaltop, utop;
+  boolean join;
+
+  n = d->n;
+  x = d->x;
+  for (i = 0; i < n; i++) d->pinv[i] = -1;
+  d->nsuper = 0;
+  d->up[0] = 0;
+  srowtop = svaltop = utop = 0;
+  k = ndef = 0;
+  open = -1;
+  sys->smallest_pivot = MAXDOUBLE;
+
+  for (j = 0; j < n; j++) {
+    stamp = j+1;
+    nt = snlu_reach(d,j,stamp);
+
+    npat = 0;
+    for (qa = d->ap[j]; qa < d->ap[j+1]; qa++) {
+      i = d->ai[qa];
+      x[i] = d->ax[qa];
+      if (d->pinv[i] < 0 && d->rmark[i] != stamp) {
+        d->rmark[i] = stamp;
+        d->pat[npat++] = i;
+      }
+    }
+    for (q = nt-1; q >= 0; q--) {
+      snlu_update(d,d->post[q],stamp,&npat);
+    }
+
+    /* choose the pivot */
+    maxv = D_ZERO;
+    p = -1;
+    for (q = 0; q < npat; q++) {
+      v = fabs(x[d->pat[q]]);
+      if (v > maxv) {
+        maxv = v;
+        p = d->pat[q];
+      }
+    }
+    if (p >= 0 && maxv > sys->pivot_zero) {
+      v = fabs(x[j]);
+      if (d->pinv[j] < 0 && d->rmark[j] == stamp
+          && v > sys->pivot_zero && v >= sys->ptol * maxv) {
+        p = j;
+      }
+    } else {
+      p = -1;
+    }
+
+    if (p >= 0) {
+      pivot = x[p];
+      if (fabs(pivot) < sys->smallest_pivot) {
+        sys->smallest_pivot = fabs(pivot);
+      }
+      /* same L structure as the open supernode: extend it */
+      join = FALSE;
+      if (open >= 0 && d->sncol[open] < SNLU_MAX_COLS
+          && d->snrow[open] - d->sncol[open] == npat) {
+        R = d->srow + d->srowp[open];
+        join = TRUE;
+        for (t = d->sncol[open]; t < d->snrow[open]; t++) {
+          if (d->rmark[R[t]] != stamp) {
+            join = FALSE;
+            break;
+          }
+        }
+      }
+
+      /*
+        U entries in rows of other supernodes. All of them are kept, zero
+        or not, as whole groups in postorder: snlu_refactor recovers the
+        supernodes to apply from these groups.
+      */
+      for (q = 0; q < nt; q++) {
+        s = d->post[q];
+        if (join && s == open) continue;
+        nc = d->sncol[s];
+        if (snlu_grow(&(d->ui),&(d->ux),&(d->ucap),utop+nc)) return 1;
+        R = d->srow + d->srowp[s];
+        for (t = 0; t < nc; t++) {
+          d->ui[utop] = d->sfirst[s] + t;
+          d->ux[utop] = x[R[t]];
+          utop++;
+        }
+      }
+      d->up[k+1] = utop;
+
+      if (join) {
+        s = open;
+        nc = d->sncol[s];
+        nr = d->snrow[s];
+        if (snlu_grow(NULL,&(d->sval),&(d->svalcap),svaltop+nr)) return 1;
+        R = d->srow + d->srowp[s];
+        V = d->sval + d->svalp[s];
+        /* move the pivot row up to the diagonal of the block */
+        for (t = nc; R[t] != p; t++);
+        R[t] = R[nc];
+        R[nc] = p;
+        for (c = 0; c < nc; c++) {
+          v = V[(long)c*nr+t];
+          V[(long)c*nr+t] = V[(long)c*nr+nc];
+          V[(long)c*nr+nc] = v;
+        }
+        V += (long)nc*nr;
+        for (t = 0; t < nc; t++) V[t] = x[R[t]];
+        V[nc] = pivot;
+        for (t = nc+1; t < nr; t++) V[t] = x[R[t]]/pivot;
+        svaltop += nr;
+        d->sncol[s]++;
+      } else {
+        s = open = d->nsuper++;
+        if (snlu_grow(&(d->srow),NULL,&(d->srowcap),srowtop+npat)
+            || snlu_grow(NULL,&(d->sval),&(d->svalcap),svaltop+npat)) {
+          return 1;
+        }
+        d->sfirst[s] = k;
+        d->sncol[s] = 1;
+        d->snrow[s] = npat;
+        d->srowp[s] = srowtop;
+        d->svalp[s] = svaltop;
+        R = d->srow + srowtop;
+        V = d->sval + svaltop;
+        R[0] = p;
+        V[0] = pivot;
+        t = 1;
+        for (q = 0; q < npat; q++) {
+          i = d->pat[q];
+          if (i == p) continue;
+          R[t] = i;
+          V[t] = x[i]/pivot;
+          t++;
+        }
+        srowtop += npat;
+        svaltop += npat;
+      }
+      d->pinv[p] = k;
+      d->prow[k] = p;
+      d->pcol[k] = j;
+      d->piv[k] = pivot;
+      d->sof[k] = s;
+      k++;
+    } else {
+      d->defer[ndef++] = j;
+    }
+
+    /* return the work column to zero */
+    for (q = 0; q < nt; q++) {
+      s = d->post[q];
+      R = d->srow + d->srowp[s];
+      for (t = 0; t < d->snrow[s]; t++) x[R[t]] = D_ZERO;
+    }
+    for (q = 0; q < npat; q++) x[d->pat[q]] = D_ZERO;
+  }
+
+  d->rank = k;
+  d->fnz = svaltop + utop;
+  for (i = 0; i < n; i++) {
+    if (d->pinv[i] < 0) d->prow[k++] = i;
+  }
+  for (q = 0; q < ndef; q++) d->pcol[d->rank+q] = d->defer[q];
+  return 0;
+}
+
+/**
+	Numeric refactorization with the pivot sequence and structure of the
+	previous factorization of the same pattern.
+
+	The columns of each supernode s are computed together as a dense panel
+	holding the rows of s followed by those of the supernodes updating
+	any of its columns. Each updating supernode is applied to the whole
+	panel at once: a triangular solve with its diagonal block and a matrix
+	product with the rows below it (BLAS-3). A supernode can only update
+	later ones, so applying them in increasing order respects their
+	dependencies; applying one to a column with zeros in its pivot rows
+	changes nothing. The panel is then factored column by column as in
+	snlu_factor, with the threshold test on each old pivot.
+	@return 0 on success, 1 if a pivot fails the threshold test or the
+	panel cannot be allocated (the factors are then unusable and a full
+	factorization is needed).
+*/
+static int snlu_refactor(linsolqr_system_t sys, struct snlu_data *d){
+  int32 s, s2, k, j, c, nc, nr, nc2, nr2, np, npr, t, i, stamp;
+  int32 *R, *R2;
+  real64 *V, *V2, *P, *Pc, *G, maxv, pivot;
+  long qa, q, need;
+  int status;
+
+  status = 0;
+  sys->smallest_pivot = MAXDOUBLE;
+  for (s = 0; s < d->nsuper && status == 0; s++) {
+    stamp = s+1;
+    k = d->sfirst[s];
+    nc = d->sncol[s];
+    nr = d->snrow[s];
+    R = d->srow + d->srowp[s];
+    V = d->sval + d->svalp[s];
+
+    /* the supernodes updating any column of s, in increasing order */
+    np = 0;
+    for (c = 0; c < nc; c++) {
+      for (q = d->up[k+c+1]; q > d->up[k+c]; q -= d->sncol[s2]) {
+        s2 = d->sof[d->ui[q-1]];
+        if (d->smark[s2] != stamp) {
+          d->smark[s2] = stamp;
+          d->post[np++] = s2;
+        }
+      }
+    }
+    for (q = 1; q < np; q++) {
+      s2 = d->post[q];
+      for (t = (int32)q; t > 0 && d->post[t-1] > s2; t--) {
+        d->post[t] = d->post[t-1];
+      }
+      d->post[t] = s2;
+    }
+
+    /* panel rows: those of s first, so block row t is panel row t */
+    npr = 0;
+    for (t = 0; t < nr; t++) {
+      d->rmark[R[t]] = stamp;
+      d->rpos[R[t]] = npr++;
+    }
+    need = 0;
+    for (q = 0; q < np; q++) {
+      s2 = d->post[q];
+      R2 = d->srow + d->srowp[s2];
+      for (t = 0; t < d->snrow[s2]; t++) {
+        i = R2[t];
+        if (d->rmark[i] != stamp) {
+          d->rmark[i] = stamp;
+          d->rpos[i] = npr++;
+        }
+      }
+      need = MAX(need,d->snrow[s2]);
+    }
+    if (snlu_grow(NULL,&(d->pv),&(d->pcap),(npr+need)*nc)) {
+      status = 1;
+      break;
+    }
+    P = d->pv;
+    G = P + (long)npr*nc;
+    for (q = 0; q < (long)npr*nc; q++) P[q] = D_ZERO;
+    for (c = 0; c < nc; c++) {
+      Pc = P + (long)c*npr;
+      j = d->pcol[k+c];
+      for (qa = d->ap[j]; qa < d->ap[j+1]; qa++) {
+        Pc[d->rpos[d->ai[qa]]] = d->ax[qa];
+      }
+    }
+
+    /* apply each updating supernode to all the columns of the panel */
+    for (q = 0; q < np; q++) {
+      s2 = d->post[q];
+      nc2 = d->sncol[s2];
+      nr2 = d->snrow[s2];
+      R2 = d->srow + d->srowp[s2];
+      V2 = d->sval + d->svalp[s2];
+      for (c = 0; c < nc; c++) {
+        Pc = P + (long)c*npr;
+        for (t = 0; t < nr2; t++) G[(long)c*nr2+t] = Pc[d->rpos[R2[t]]];
+      }
+      snlu_trsm_llnu(nc2,nc,V2,nr2,G,nr2);
+      if (nr2 > nc2) {
+        snlu_gemm_nn(nr2-nc2,nc,nc2,V2+nc2,nr2,G,nr2,G+nc2,nr2);
+      }
+      for (c = 0; c < nc; c++) {
+        Pc = P + (long)c*npr;
+        for (t = 0; t < nr2; t++) Pc[d->rpos[R2[t]]] = G[(long)c*nr2+t];
+      }
+    }
+
+    /* factor the panel with the old pivots */
+    for (c = 0; c < nc; c++) {
+      Pc = P + (long)c*npr;
+      if (c > 0) {
+        snlu_trsv_lnu(c,V,nr,Pc);
+        snlu_gemv_n(nr-c,c,V+c,nr,Pc,Pc+c);
+      }
+      pivot = Pc[c];
+      maxv = D_ZERO;
+      for (t = c; t < nr; t++) maxv = MAX(maxv,fabs(Pc[t]));
+      if (fabs(pivot) <= sys->pivot_zero || fabs(pivot) < sys->ptol * maxv) {
+        status = 1;
+        break;
+      }
+      for (q = d->up[k+c]; q < d->up[k+c+1]; q++) {
+        d->ux[q] = Pc[d->rpos[d->prow[d->ui[q]]]];
+      }
+      V2 = V + (long)c*nr;
+      for (t = 0; t < c; t++) V2[t] = Pc[t];
+      V2[c] = pivot;
+      for (t = c+1; t < nr; t++) V2[t] = Pc[t]/pivot;
+      d->piv[k+c] = pivot;
+      if (fabs(pivot) < sys->smallest_pivot) {
+        sys->smallest_pivot = fabs(pivot);
+      }
+    }
+  }
+
+  /* leave the stamps clear for snlu_factor */
+  mtx_zero_int32(d->rmark,d->n);
+  mtx_zero_int32(d->smark,d->n);
+  return status;
+}
+
+/**
+	Permute sys->factors so that cur position rng.low+k holds the k-th
+	pivot row and column, followed by the unpivoted ones.
+*/
+static void snlu_permute_factors(linsolqr_system_t sys, struct snlu_data *d){
+  int32 k, cur, at;
+  mtx_matrix_t mtx;
+
+  mtx = sys->factors;
+  for (k = 0; k < d->n; k++) {
+    cur = sys->rng.low + k;
+    at = mtx_org_to_row(mtx,d->orow[d->prow[k]]);
+    if (at != cur) mtx_swap_rows(mtx,cur,at);
+    at = mtx_org_to_col(mtx,d->ocol[d->pcol[k]]);
+    if (at != cur) mtx_swap_cols(mtx,cur,at);
+  }
+}
+
+/*------------------------------------------------------------------------------
+  SOLUTION
+*/
+
+/**
+	Solve with the factors, following the linsolqr convention: arr comes in
+	indexed by org row (org col if transpose) and leaves holding, at the
+	org row (col) of each pivot, the solution component for the matching
+	pivot column (row).
+*/
+static void snlu_solve_vec(struct snlu_data *d, real64 *arr
+		, boolean transpose
+){
+  int32 s, f, nc, nr, t, k, i;
+  int32 *R;
+  real64 *V, *b, *w;
+  long q;
+
+  b = d->x;
+  w = d->w;
+  if (transpose) {
+    for (k = 0; k < d->rank; k++) w[k] = arr[d->ocol[d->pcol[k]]];
+    /* U'.z = c */
+    for (s = 0; s < d->nsuper; s++) {
+      f = d->sfirst[s];
+      nc = d->sncol[s];
+      for (k = f; k < f+nc; k++) {
+        for (q = d->up[k]; q < d->up[k+1]; q++) {
+          w[k] -= d->ux[q] * w[d->ui[q]];
+        }
+      }
+      snlu_trsv_utn(nc,d->sval+d->svalp[s],d->snrow[s],w+f);
+    }
+    /* L'.y = z, gathering the solved part of y into b */
+    for (s = d->nsuper-1; s >= 0; s--) {
+      f = d->sfirst[s];
+      nc = d->sncol[s];
+      nr = d->snrow[s];
+      R = d->srow + d->srowp[s];
+      V = d->sval + d->svalp[s];
+      if (nr > nc) {
+        for (t = nc; t < nr; t++) {
+          i = d->pinv[R[t]];
+          b[t-nc] = (i >= 0) ? w[i] : D_ZERO;
+        }
+        snlu_gemv_t(nr-nc,nc,V+nc,nr,b,w+f);
+      }
+      snlu_trsv_ltu(nc,V,nr,w+f);
+    }
+    for (k = 0; k < d->rank; k++) arr[d->ocol[d->pcol[k]]] = w[k];
+    for (i = 0; i < d->n; i++) b[i] = D_ZERO;
+  } else {
+    for (i = 0; i < d->n; i++) b[i] = arr[d->orow[i]];
+    /* L.z = b, in row space */
+    for (s = 0; s < d->nsuper; s++) {
+      nc = d->sncol[s];
+      nr = d->snrow[s];
+      R = d->srow + d->srowp[s];
+      V = d->sval + d->svalp[s];
+      for (t = 0; t < nc; t++) w[t] = b[R[t]];
+      snlu_trsv_lnu(nc,V,nr,w);
+      for (t = 0; t < nc; t++) b[R[t]] = w[t];
+      if (nr > nc) {
+        for (t = nc; t < nr; t++) w[t] = D_ZERO;
+        snlu_gemv_n(nr-nc,nc,V+nc,nr,w,w+nc);
+        for (t = nc; t < nr; t++) b[R[t]] += w[t];
+      }
+    }
+    for (k = 0; k < d->rank; k++) w[k] = b[d->prow[k]];
+    for (i = 0; i < d->n; i++) b[i] = D_ZERO;
+    /* U.x = z, in step space */
+    for (s = d->nsuper-1; s >= 0; s--) {
+      f = d->sfirst[s];
+      nc = d->sncol[s];
+      snlu_trsv_unn(nc,d->sval+d->svalp[s],d->snrow[s],w+f);
+      for (k = f; k < f+nc; k++) {
+        for (q = d->up[k]; q < d->up[k+1]; q++) {
+          w[d->ui[q]] -= d->ux[q] * w[k];
+        }
+      }
+    }
+    for (k = 0; k < d->rank; k++) arr[d->orow[d->prow[k]]] = w[k];
+  }
+}
+
+int snlu_solve(linsolqr_system_t sys, struct rhs_list *rl){
+  if (ISNULL(sys->sndata)) return 1;
+  zero_unpivoted_vars(sys,rl->varvalue,rl->transpose);
+  snlu_solve_vec(sys->sndata,rl->varvalue,rl->transpose);
+  return 0;
+}
+
+/*------------------------------------------------------------------------------
+  DEPENDENCIES
+
+  As for ranki2, with the solves done by the supernodal factors.
+*/
+
+void calc_dependent_rows_snlu(linsolqr_system_t sys){
+  mtx_coord_t nz;
+  real64 value;
+  mtx_range_t colrange;
+  mtx_range_t rowrange;
+  real64 *lc;
+  mtx_matrix_t mtx;
+
+  sys->rowdeps = TRUE;
+  if( ( (sys->reg.row.low == sys->rng.low) &&
+        ( sys->reg.row.high == sys->rng.low+sys->rank-1 )
+      ) || sys->rank==0 )
+    return;
+
+  lc = sys->ludata->tmp;
+  colrange.low = sys->rng.low;
+  colrange.high = colrange.low + sys->rank - 1;
+  rowrange.low = sys->rng.high;
+  rowrange.high = sys->rng.low+sys->rank;
+  mtx=sys->factors;
+
+  nz.row = sys->reg.row.low;
+  for( ; nz.row <= sys->reg.row.high; nz.row++ ) {
+    if( nz.row == sys->rng.low ) {
+      nz.row = rowrange.high-1;
+      continue;
+    }
+    mtx_zero_real64(lc,(sys->capacity));
+    mtx_org_row_vec(mtx,nz.row,lc,&colrange);
+    snlu_solve_vec(sys->sndata,lc,TRUE);
+    mtx_clear_row(mtx,nz.row,&colrange);
+    for( nz.col=colrange.low; nz.col <= colrange.high; nz.col++ ) {
+      value = lc[mtx_col_to_org(mtx,nz.col)];
+      if( value != D_ZERO ) mtx_fill_value(mtx,&nz,value);
+    }
+  }
+}
+
+void calc_dependent_cols_snlu(linsolqr_system_t sys){
+  mtx_coord_t nz;
+  real64 value;
+  mtx_range_t rowrange;
+  mtx_range_t colrange;
+  real64 *lc;
+  mtx_matrix_t mtx;
+
+  sys->coldeps = TRUE;
+  if( ( (sys->reg.col.low == sys->rng.low) &&
+        ( sys->reg.col.high == sys->rng.low+sys->rank-1 )
+      ) || sys->rank==0 )
+    return;
+
+  lc = sys->ludata->tmp;
+  rowrange.low = sys->rng.low;
+  rowrange.high = rowrange.low + sys->rank - 1;
+  colrange.high = sys->rng.low+sys->rank;
+  colrange.low = sys->rng.high;
+  mtx=sys->factors;
+
+  nz.col = sys->reg.col.low;
+  for( ; nz.col <= sys->reg.col.high; nz.col++ ) {
+    if( nz.col == sys->rng.low ) {
+      nz.col = colrange.high-1;
+      continue;
+    }
+    mtx_zero_real64(lc,sys->capacity);
+    mtx_org_col_vec(mtx,nz.col,lc,&rowrange);
+    snlu_solve_vec(sys->sndata,lc,FALSE);
+    mtx_clear_col(mtx,nz.col,&rowrange);
+    for( nz.row=rowrange.low; nz.row <= rowrange.high; nz.row++ ) {
+      value = lc[mtx_row_to_org(mtx,nz.row)];
+      if( value != D_ZERO ) mtx_fill_value(mtx,&nz,value);
+    }
+  }
+}
+
+/*------------------------------------------------------------------------------
+  ENTRY POINT
+*/
+
+int snlu_entry(linsolqr_system_t sys, mtx_region_t *region){
+  struct rhs_list *rl;
+  struct snlu_data *d;
+  double comptime;
+  int32 k;
+  boolean refactored;
+
+  CHECK_SYSTEM(sys);
+  if (sys->factored) return 0;
+  if (sys->fmethod != sn_lu) return 1;
+  if (ISNULL(sys->ludata)) return 1;
+
+  if (NOTNULL(sys->inverse)) mtx_destroy(sys->inverse);
+  sys->inverse = NULL;
+  if (NOTNULL(sys->factors)) mtx_destroy(sys->factors);
+  if (region == mtx_ENTIRE_MATRIX) determine_pivot_range(sys);
+  else square_region(sys,region);
+
+  sys->factors = mtx_copy_region(sys->coef,region);
+  sys->rank = -1;
+  sys->smallest_pivot = MAXDOUBLE;
+  for (rl = sys->rl ; NOTNULL(rl) ; rl = rl->next)
+    rl->solved = FALSE;
+  ensure_capacity(sys);
+  ensure_lu_capacity(sys);
+
+  d = snlu_find(sys,MAX(sys->rng.high - sys->rng.low + 1,0));
+  if (ISNULL(d)) return 2;
+
+  comptime = tm_cpu_time();
+  if (snlu_ensure_order(d,d->n) || snlu_load(sys,d)) {
+    ERROR_REPORTER_HERE(ASC_PROG_ERR,"Insufficient memory for supernodal LU");
+    d->rank = d->nsuper = 0;
+    d->reusable = FALSE;
+    return 2;
+  }
+  refactored = (sys->reuse && d->reusable && snlu_refactor(sys,d) == 0);
+  if (!refactored) {
+    d->rank = d->nsuper = 0;
+    d->fnz = 0;
+    if (snlu_factor(sys,d)) {
+      ERROR_REPORTER_HERE(ASC_PROG_ERR,"Insufficient memory for supernodal LU");
+      d->rank = d->nsuper = 0;
+      d->reusable = FALSE;
+      return 2;
+    }
+  }
+  /* a deferred column might find a pivot next time: search again then */
+  d->reusable = (d->rank == d->n);
+  snlu_permute_factors(sys,d);
+  for (k = 0; k < d->rank; k++) {
+    sys->ludata->pivlist[sys->rng.low + k] = d->piv[k];
+  }
+  sys->rank = d->rank;
+  sys->factored = TRUE;
+
+  if (g_linsolqr_timing) {
+    comptime = tm_cpu_time() - comptime;
+    CONSOLE_DEBUG("A-NNZ: %ld %s time: %f Supernodes: %d Fill %g",
+      d->ap[d->n],(refactored ? "Refactor" : "Factor"),comptime,d->nsuper,
+      ( d->ap[d->n]>0 ? (double)d->fnz/(double)d->ap[d->n] : 0));
+  }
+  return 0;
+}
@@ -0,0 +1,60 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @file
+	Supernodal sparse LU factorization for linsolqr (factor class s_lu).
+
+	The region is copied into compressed-column form and factored by a
+	left-looking LU with threshold partial pivoting, one column at a time.
+	Consecutive columns of L that share the same row structure are stored
+	together as a 'supernode' in a dense column-major block. Each new
+	column is updated by the supernodes it depends on with dense
+	triangular-solve and matrix-vector kernels over their blocks (BLAS-2),
+	instead of element by element list traversals; the forward and back
+	substitutions use the same kernels.
+
+	A numeric refactorization with the pivot sequence of the previous
+	factorization of the same pattern computes all the columns of a
+	supernode together as a dense panel, and applies each updating
+	supernode to the panel with matrix-matrix kernels (BLAS-3).
+
+	Columns with no acceptable pivot are left unpivoted, so rank-deficient
+	regions are handled as in the RANKI methods. On exit sys->factors is a
+	copy of the region permuted into pivot order, with sys->inverse unused,
+	so that the usual pivot and dependency queries of linsolqr work.
+*//*
+	Created: Oct 2026
+*/
+
+#ifndef ASC_SNLU_H
+#define ASC_SNLU_H
+
+#include "linsolqr_impl.h"
+
+int snlu_entry(linsolqr_system_t sys, mtx_region_t *region);
+int snlu_solve(linsolqr_system_t sys, struct rhs_list *rl);
+void calc_dependent_rows_snlu(linsolqr_system_t sys);
+void calc_dependent_cols_snlu(linsolqr_system_t sys);
+
+void snlu_destroy_data(struct snlu_data *d);
+/**< Free the supernodal factors. NULL is ignored. */
+
+void snlu_trim_data(struct snlu_data *d);
+/**< Free all but the most recent factors in the list d. */
+
+size_t snlu_size(struct snlu_data *d);
+/**< Bytes held by the supernodal factors. */
+
+#endif
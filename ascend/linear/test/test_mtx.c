@@ -77,11 +77,71 @@ static void test_csparse(void){
 #endif
 }
 
+/*
+	Test the frozen-pattern mode: refill through the value array, and check
+	that creating an element thaws the snapshot.
+*/
+static void test_frozen(void){
+	mtx_matrix_t M;
+	mtx_coord_t C;
+	const int32 *colptr, *rowind;
+	real64 *val;
+	int32 order, k;
+
+	M = mtx_create();
+	mtx_set_order(M,3);
+	mtx_set_value(M,mtx_coord(&C,0,0), 1.0);
+	mtx_set_value(M,mtx_coord(&C,1,1), 3.0);
+	mtx_set_value(M,mtx_coord(&C,2,2), 7.0);
+	mtx_set_value(M,mtx_coord(&C,0,2), 2.0);
+	mtx_set_value(M,mtx_coord(&C,2,1), 6.0);
+
+	CU_ASSERT(0==mtx_freeze(M,mtx_ENTIRE_MATRIX));
+	CU_ASSERT(mtx_is_frozen(M));
+	CU_ASSERT(mtx_frozen_nonzeros(M)==5);
+	CU_ASSERT(mtx_frozen_slot(M,1,0)==mtx_NONE);
+
+	CU_ASSERT(0==mtx_frozen_csc(M,&order,&colptr,&rowind,&val));
+	CU_ASSERT(order==3);
+	CU_ASSERT(colptr[0]==0 && colptr[1]==1 && colptr[2]==3 && colptr[3]==5);
+	/* rows sorted within each column */
+	CU_ASSERT(rowind[1]==1 && rowind[2]==2);
+	CU_ASSERT(rowind[3]==0 && rowind[4]==2);
+	CU_ASSERT(val[mtx_frozen_slot(M,2,1)]==6.0);
+
+	/* refill */
+	for(k=0; k<mtx_frozen_nonzeros(M); ++k){
+		val[k] = 10.0 * (k+1);
+	}
+	mtx_frozen_commit(M);
+	CU_ASSERT(mtx_value(M,mtx_coord(&C,0,0))==10.0);
+	CU_ASSERT(mtx_value(M,mtx_coord(&C,2,2))==50.0);
+	CU_ASSERT(mtx_is_frozen(M));
+
+	/* scaling in place is seen by gather */
+	mtx_mult_row(M,0,0.5,mtx_ALL_COLS);
+	mtx_frozen_gather(M);
+	CU_ASSERT(val[mtx_frozen_slot(M,0,2)]==20.0);
+
+	/* a new element changes the pattern */
+	mtx_fill_value(M,mtx_coord(&C,1,0),1.0);
+	CU_ASSERT(!mtx_is_frozen(M));
+
+	/* as does clearing */
+	CU_ASSERT(0==mtx_freeze(M,mtx_ENTIRE_MATRIX));
+	CU_ASSERT(mtx_frozen_nonzeros(M)==6);
+	mtx_clear_coord(M,0,0);
+	CU_ASSERT(!mtx_is_frozen(M));
+
+	mtx_destroy(M);
+}
+
 /*===========================================================================*/
 /* Registration information */
 
 #define TESTS(T) \
-	T(csparse)
+	T(csparse) \
+	T(frozen)
 
 REGISTER_TESTS_SIMPLE(linear_mtx, TESTS)
 
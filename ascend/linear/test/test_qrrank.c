@@ -161,13 +161,204 @@ static void test_qr3x3(void){
 	mtx_destroy(M);
 }
 
+/*
+	Solve a 40x40 system with the supernodal LU method, directly and
+	transposed. The trailing block is dense so that supernodes form, and
+	the leading diagonal is weak so that pivots move off it.
+*/
+static void test_snlu(void){
+	linsolqr_system_t L;
+	mtx_matrix_t M;
+	mtx_coord_t C;
+	mtx_range_t R;
+	mtx_region_t G;
+	real64 a[40][40], x[40], b[40], c[40];
+	unsigned long seed = 12345;
+	int i, j, n = 40;
+
+	memset(a,0,sizeof(a));
+	for(i=0; i<n; ++i){
+		a[i][i] = (i < 10) ? 1e-3 : 4.0 + i;
+		if(i > 0) a[i][i-1] = 1.0;
+		if(i < n-1) a[i][i+1] = -2.0;
+		seed = (seed*1103515245UL + 12345UL) % 2147483648UL;
+		a[i][seed % n] += 0.5;
+		for(j=30; j<n; ++j){
+			if(i >= 30) a[i][j] += 1.0/(1.0 + i + j);
+		}
+	}
+
+	M = mtx_create();
+	mtx_set_order(M,n);
+	for(i=0; i<n; ++i){
+		x[i] = i + 1.0;
+		for(j=0; j<n; ++j){
+			if(a[i][j] != 0.0) mtx_set_value(M,mtx_coord(&C,i,j),a[i][j]);
+		}
+	}
+	for(i=0; i<n; ++i){
+		b[i] = c[i] = 0.0;
+		for(j=0; j<n; ++j){
+			b[i] += a[i][j]*x[j];
+			c[i] += a[j][i]*x[j];
+		}
+	}
+
+	R.low = 0;
+	R.high = n - 1;
+	G.row = R;
+	G.col = R;
+
+	L = linsolqr_create_default();
+	linsolqr_set_matrix(L,M);
+	linsolqr_set_region(L,G);
+	CU_ASSERT(0 == linsolqr_prep(L,linsolqr_fmethod_to_fclass(sn_lu)));
+	linsolqr_reorder(L, &G, spk1);
+	linsolqr_add_rhs(L,b,FALSE);
+	linsolqr_add_rhs(L,c,TRUE);
+	CU_ASSERT(0 == linsolqr_factor(L,sn_lu));
+	CU_ASSERT(linsolqr_rank(L)==n);
+
+	CU_ASSERT(0 == linsolqr_solve(L,b));
+	for(j=0; j<n; ++j){
+		CU_ASSERT_DOUBLE_EQUAL(linsolqr_var_value(L,b,j), x[j], 1e-8);
+	}
+	CU_ASSERT(0 == linsolqr_solve(L,c));
+	for(i=0; i<n; ++i){
+		CU_ASSERT_DOUBLE_EQUAL(linsolqr_var_value(L,c,i), x[i], 1e-8);
+	}
+
+	linsolqr_destroy(L);
+	mtx_destroy(M);
+}
+
+/*
+	Test the rank of a singular matrix with the supernodal LU method
+
+	[ 1 2 3
+	  2 4 6
+	  1 0 1 ]
+*/
+static void test_snlu_rank(void){
+	linsolqr_system_t L;
+	mtx_matrix_t M;
+	mtx_coord_t C;
+	mtx_range_t R;
+	mtx_region_t G;
+	int r;
+
+	M = mtx_create();
+	mtx_set_order(M,3);
+	mtx_set_value(M,mtx_coord(&C,0,0), 1.0);
+	mtx_set_value(M,mtx_coord(&C,0,1), 2.0);
+	mtx_set_value(M,mtx_coord(&C,0,2), 3.0);
+	mtx_set_value(M,mtx_coord(&C,1,0), 2.0);
+	mtx_set_value(M,mtx_coord(&C,1,1), 4.0);
+	mtx_set_value(M,mtx_coord(&C,1,2), 6.0);
+	mtx_set_value(M,mtx_coord(&C,2,0), 1.0);
+	mtx_set_value(M,mtx_coord(&C,2,2), 1.0);
+
+	R.low = 0;
+	R.high = mtx_order(M) - 1;
+	G.row = R;
+	G.col = R;
+
+	L = linsolqr_create_default();
+	linsolqr_set_matrix(L,M);
+	linsolqr_set_region(L,G);
+	linsolqr_prep(L,linsolqr_fmethod_to_fclass(sn_lu));
+	linsolqr_reorder(L, &G, spk1);
+	linsolqr_factor(L,sn_lu);
+	r = linsolqr_rank(L);
+
+	CU_ASSERT(r==2);
+
+	linsolqr_destroy(L);
+	mtx_destroy(M);
+}
+
+/*
+	Refactor a matrix whose values change but not its pattern, with pivot
+	reuse on. The second set of values reuses the old pivots; the third
+	makes one of them tiny, so that a full factorization has to be done.
+*/
+static void test_snlu_refactor(void){
+	linsolqr_system_t L;
+	mtx_matrix_t M;
+	mtx_coord_t C;
+	mtx_range_t R;
+	mtx_region_t G;
+	real64 a[30][30], x[30], b[30];
+	int i, j, k, n = 30;
+
+	memset(a,0,sizeof(a));
+	for(i=0; i<n; ++i){
+		x[i] = 1.0 - 0.1*i;
+		a[i][i] = 3.0 + i;
+		if(i > 0) a[i][i-1] = 1.0;
+		if(i < n-1) a[i][i+1] = -1.0;
+		a[i][(7*i + 3) % n] += 0.5;
+	}
+
+	M = mtx_create();
+	mtx_set_order(M,n);
+	R.low = 0;
+	R.high = n - 1;
+	G.row = R;
+	G.col = R;
+
+	L = linsolqr_create_default();
+	linsolqr_set_matrix(L,M);
+	linsolqr_set_region(L,G);
+	CU_ASSERT(0 == linsolqr_prep(L,linsolqr_fmethod_to_fclass(sn_lu)));
+	linsolqr_set_pivot_reuse(L,TRUE);
+	CU_ASSERT(linsolqr_pivot_reuse(L));
+	linsolqr_add_rhs(L,b,FALSE);
+
+	for(k=0; k<3; ++k){
+		if(k == 1){
+			for(i=0; i<n; ++i){
+				for(j=0; j<n; ++j){
+					a[i][j] *= 1.0 + 0.1*((i + 2*j) % 5);
+				}
+			}
+		}else if(k == 2){
+			a[n/2][n/2] = 1e-14;
+		}
+		for(i=0; i<n; ++i){
+			b[i] = 0.0;
+			for(j=0; j<n; ++j){
+				/* reordering permutes M: address it by org row and col */
+				if(a[i][j] != 0.0) mtx_set_value(M,mtx_coord(&C
+					,mtx_org_to_row(M,i),mtx_org_to_col(M,j)),a[i][j]);
+				b[i] += a[i][j]*x[j];
+			}
+		}
+		linsolqr_matrix_was_changed(L);
+		linsolqr_rhs_was_changed(L,b);
+		linsolqr_reorder(L, &G, spk1);
+		CU_ASSERT(0 == linsolqr_factor(L,sn_lu));
+		CU_ASSERT(linsolqr_rank(L)==n);
+		CU_ASSERT(0 == linsolqr_solve(L,b));
+		for(j=0; j<n; ++j){
+			CU_ASSERT_DOUBLE_EQUAL(linsolqr_var_value(L,b,j), x[j], 1e-8);
+		}
+	}
+
+	linsolqr_destroy(L);
+	mtx_destroy(M);
+}
+
 /*===========================================================================*/
 /* Registration information */
 
 #define TESTS(T)\
 	T(qr1x1) \
 	T(qr2x2) \
-	T(qr3x3)
+	T(qr3x3) \
+	T(snlu) \
+	T(snlu_rank) \
+	T(snlu_refactor)
 
 REGISTER_TESTS_SIMPLE(linear_qrrank, TESTS)
 
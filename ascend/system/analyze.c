@@ -93,6 +93,7 @@
 #include <ascend/compiler/logrel_util.h>
 #include <ascend/compiler/case.h>
 #include <ascend/compiler/when_util.h>
+#include <ascend/compiler/instantiate.h>
 #include <ascend/compiler/link.h>
 
 #include "slv_server.h"
@@ -2751,6 +2752,105 @@ int analyze_make_problem(slv_system_t sys, struct Instance *inst){
   return 0;
 }
 
+/*----------------------------------------------------------------------------*/
+/*
+	Incremental re-analysis. The lists, incidence arrays and solver lists
+	made by analyze_make_problem depend only on the structure of the
+	instance tree, not on the values of the 'fixed' and 'included' flags
+	(fixed vars and unincluded rels stay in the lists, and are merely
+	flagged). Bounds and nominals are read from the instances each time
+	the solvers ask for them. So when a METHOD has only changed values,
+	it is enough to set the cached flag bits from the instances again,
+	as analyze_make_problem would; the tree need not be walked again.
+
+	The bits set are VAR_FIXED (solver_vars only), REL_INCLUDED and
+	REL_INBLOCK (both follow 'included', and REL_INBLOCK is cleared by
+	the solvers as they finish with each block), LOGREL_INCLUDED and
+	DIS_FIXED (boolean_vars only).
+
+	We do check that the compiler has not been run since the system was
+	built, in case the caller has been careless about recompiling. The
+	check compares g_compiler_counter with the value recorded by
+	system_build; the instances in the lists are not looked at, as after
+	a recompile they may no longer exist.
+
+	@return number of flags changed, or -1 if the system must be rebuilt.
+*/
+int analyze_refresh_problem(slv_system_t sys){
+  struct var_variable **vp;
+  struct rel_relation **rp;
+  struct logrel_relation **lp;
+  struct dis_discrete **dp;
+  uint32 now;
+  int changed = 0;
+
+  if(sys == NULL || slv_instance(sys) == NULL){
+    return -1;
+  }
+  /* the structure must be as we left it */
+  if(slv_compiler_counter(sys) != g_compiler_counter){
+    return -1;
+  }
+
+  INCLUDED_A = AddSymbol("included");
+  FIXED_A = AddSymbol("fixed");
+
+  /* pars are always fixed; unattached vars may not be solver_vars */
+#define REFRESH_VARS(LIST) \
+  vp = LIST(sys); \
+  if(vp != NULL){ \
+    for(; *vp != NULL; vp++){ \
+      if(!var_flagbit(*vp,VAR_SVAR))continue; \
+      now = BooleanChildValue((struct Instance *)var_instance(*vp),FIXED_A) ? 1 : 0; \
+      if(!var_flagbit(*vp,VAR_FIXED) != !now)changed++; \
+      var_set_flagbit(*vp,VAR_FIXED,now); \
+    } \
+  }
+  REFRESH_VARS(slv_get_master_var_list);
+  REFRESH_VARS(slv_get_master_unattached_list);
+#undef REFRESH_VARS
+
+#define REFRESH_RELS(LIST) \
+  rp = LIST(sys); \
+  if(rp != NULL){ \
+    for(; *rp != NULL; rp++){ \
+      now = BooleanChildValue((struct Instance *)rel_instance(*rp),INCLUDED_A) ? 1 : 0; \
+      if(!rel_flagbit(*rp,REL_INCLUDED) != !now)changed++; \
+      rel_set_flagbit(*rp,REL_INCLUDED | REL_INBLOCK,now); \
+    } \
+  }
+  REFRESH_RELS(slv_get_master_rel_list);
+  REFRESH_RELS(slv_get_master_condrel_list);
+  REFRESH_RELS(slv_get_master_obj_list);
+#undef REFRESH_RELS
+
+#define REFRESH_LOGRELS(LIST) \
+  lp = LIST(sys); \
+  if(lp != NULL){ \
+    for(; *lp != NULL; lp++){ \
+      now = BooleanChildValue((struct Instance *)logrel_instance(*lp),INCLUDED_A) ? 1 : 0; \
+      if(!logrel_flagbit(*lp,LOGREL_INCLUDED) != !now)changed++; \
+      logrel_set_flagbit(*lp,LOGREL_INCLUDED,now); \
+    } \
+  }
+  REFRESH_LOGRELS(slv_get_master_logrel_list);
+  REFRESH_LOGRELS(slv_get_master_condlogrel_list);
+#undef REFRESH_LOGRELS
+
+  /* only boolean_vars have a 'fixed' flag */
+  dp = slv_get_master_dvar_list(sys);
+  if(dp != NULL){
+    for(; *dp != NULL; dp++){
+      if(!dis_flagbit(*dp,DIS_BVAR))continue;
+      now = BooleanChildValue((struct Instance *)dis_instance(*dp),FIXED_A) ? 1 : 0;
+      if(!dis_flagbit(*dp,DIS_FIXED) != !now)changed++;
+      dis_set_flagbit(*dp,DIS_FIXED,now);
+    }
+  }
+
+  return changed;
+}
+
 extern void analyze_free_reused_mem(void){
   resize_ipbuf((size_t)0,0);
 }
@@ -78,6 +78,20 @@ extern int analyze_make_problem(slv_system_t sys, struct Instance *inst);
 		back end.
 */
 
+extern int analyze_refresh_problem(slv_system_t sys);
+/**<
+	Brings a system made by analyze_make_problem back into line with its
+	instance tree after 'fixed' or 'included' flags, bounds or nominals
+	have been changed (eg by running a METHOD), without visiting the tree
+	again. Called by system_refresh -- you don't need to call it yourself.
+
+	Degrees of freedom and the block partitioning are not recomputed here;
+	the solvers do that in slv_presolve when they see changed flags.
+
+	@return number of flags that changed, or -1 if the system no longer
+	matches the instance tree and must be rebuilt.
+*/
+
 extern void analyze_free_reused_mem(void);
 /**< 
 	Resets all internal memory recycles.
@@ -129,6 +129,495 @@ static int reindex_rels_from_mtx(slv_system_t sys, int32 lo, int32 hi,
   PARTITIONING INTO BLOCK LOWER/UPPER TRIANGULAR FORM
 */
 
+/*------------------------------------------------------------------------------
+  INCREMENTAL BLOCK LOWER TRIANGULAR PARTITIONING
+
+  After a BLT partition, the output assignment (which var is matched to which
+  rel) is kept in the dof_t, by master index, so that it survives the
+  reordering of the solver's lists within blocks (eg by slv_spk1_reorder_block).
+  When the partition is next asked for and the only changes are in the fixed
+  flags of a few vars (the usual specify/solve cycle), the matching is repaired
+  by augmenting paths from the rows that lost their vars, and the strong
+  components are recomputed only over the range of blocks that the repair can
+  have affected:
+
+  In BLT form a row only has incidence in its own block or earlier ones, so
+  any path in the old block graph between two rows stays within the blocks
+  between them. The edges that are new after the repair all lead to rows on
+  the augmenting paths, and start either from those rows, from rows incident
+  on a column whose assigned row changed (which are no earlier than that row),
+  or from rows incident on a newly assigned column. Any new cycle, and any
+  block that might split, therefore lies between the earliest of these rows'
+  blocks and the latest block on an augmenting path; the blocks outside that
+  range keep their order and positions.
+*/
+
+/* give up and do the full partition if more than 1 in BTF_INCR_FRACTION of
+   the assigned rows would be affected: it is about as cheap by then. */
+#define BTF_INCR_FRACTION 16
+
+#define BTF_ROWBITS (REL_INCLUDED | REL_EQUALITY | REL_ACTIVE)
+#define BTF_COLBITS (VAR_INCIDENT | VAR_SVAR | VAR_ACTIVE)
+#define BTF_ROW(rel) ((rel_flags(rel) & BTF_ROWBITS) == BTF_ROWBITS)
+#define BTF_FREE(var) ((var_flags(var) & (BTF_COLBITS|VAR_FIXED)) == BTF_COLBITS)
+#define BTF_FIXED(var) ((var_flags(var) & (BTF_COLBITS|VAR_FIXED)) == (BTF_COLBITS|VAR_FIXED))
+
+/** Whine about the degrees of freedom found by a partitioning */
+static void report_dof(int32 nrow, int32 ncol, int32 rank){
+  if (rank < nrow) {
+    ERROR_REPORTER_NOLINE(ASC_USER_ERROR,"System is row rank deficient (%d dependent equations)",
+            nrow - rank);
+  }
+  if (rank < ncol) {
+    if ( nrow != rank) {
+      ERROR_REPORTER_NOLINE(ASC_USER_ERROR,"System is row rank deficient with %d excess columns.",
+              ncol - rank);
+    } else {
+      ERROR_REPORTER_NOLINE(ASC_USER_ERROR,"System has %d degrees of freedom.", ncol - rank);
+    }
+  }
+  if (ncol == nrow) {
+    if (ncol != rank) {
+      ERROR_REPORTER_NOLINE(ASC_USER_ERROR,"System is (%d) square but rank deficient.",ncol);
+    } else {
+      ERROR_REPORTER_NOLINE(ASC_USER_NOTE,"System is (%d) square.",ncol);
+    }
+  }
+}
+
+static void forget_assignment(dof_t *d){
+  if (d->assign != NULL) {
+    ascfree(d->assign);
+  }
+  d->assign = NULL;
+  d->n_assign = 0;
+}
+
+/**
+	Record the output assignment of a freshly partitioned system, which
+	is the diagonal of the first structural_rank rows and columns.
+*/
+static void save_assignment(slv_system_t sys, dof_t *d){
+  struct rel_relation **rp;
+  struct var_variable **vp;
+  int32 c, mlen;
+
+  forget_assignment(d);
+  mlen = slv_get_num_master_rels(sys);
+  if (mlen <= 0) return;
+  d->assign = ASC_NEW_ARRAY(int32,mlen);
+  if (d->assign == NULL) return;
+  d->n_assign = mlen;
+  for (c = 0; c < mlen; c++) {
+    d->assign[c] = -1;
+  }
+  rp = slv_get_solvers_rel_list(sys);
+  vp = slv_get_solvers_var_list(sys);
+  for (c = 0; c < d->structural_rank; c++) {
+    d->assign[rel_mindex(rp[c])] = var_mindex(vp[c]);
+  }
+}
+
+/** working storage of block_partition_incremental, all by list position */
+struct btf_work {
+  struct rel_relation **rp;
+  struct var_variable **vp;
+  int32 *rowmate;  /**< column assigned to each row, or -1 */
+  int32 *colmate;  /**< row assigned to each column, or -1 */
+  int32 *blk;      /**< block of each assigned row */
+  int32 *seen;     /**< visit stamps of rows */
+  int32 stamp;
+  int32 *stack;    /**< rows on the current path */
+  int32 *via;      /**< column taken from each row on the path */
+  int32 *next;     /**< next incidence to try from each row on the path */
+  int32 lo, hi;    /**< range of blocks affected so far */
+};
+
+/**
+	Find an augmenting path from unassigned row r to an unassigned free
+	column, depth first through the assigned columns, and flip the
+	assignment along it. The blocks of the rows on the path are added to
+	the affected range.
+	@return 0 on success, 1 if no path exists (rank would drop).
+*/
+static int btf_augment(struct btf_work *w, int32 r){
+  const struct var_variable **inc;
+  int32 top, row, c, col, n, k;
+
+  w->stamp++;
+  top = 0;
+  w->stack[0] = r;
+  w->next[0] = 0;
+  w->seen[r] = w->stamp;
+  while (top >= 0) {
+    row = w->stack[top];
+    inc = rel_incidence_list(w->rp[row]);
+    n = rel_n_incidences(w->rp[row]);
+    col = -1;
+    if (w->next[top] == 0) {
+      /* cheap assignment first */
+      for (c = 0; c < n; c++) {
+        k = var_sindex(inc[c]);
+        if (BTF_FREE(inc[c]) && w->colmate[k] < 0) {
+          col = k;
+          break;
+        }
+      }
+    }
+    if (col >= 0) {
+      /* flip the assignment along the path */
+      for (k = top; k >= 0; k--) {
+        row = w->stack[k];
+        w->rowmate[row] = col;
+        w->colmate[col] = row;
+        w->lo = MIN(w->lo,w->blk[row]);
+        w->hi = MAX(w->hi,w->blk[row]);
+        if (k > 0) col = w->via[k-1];
+      }
+      return 0;
+    }
+    /* go deeper through the next unvisited assigned column */
+    for (c = w->next[top]; c < n; c++) {
+      k = var_sindex(inc[c]);
+      if (BTF_FREE(inc[c]) && w->seen[w->colmate[k]] != w->stamp) {
+        break;
+      }
+    }
+    if (c < n) {
+      w->next[top] = c + 1;
+      w->via[top] = k;
+      top++;
+      w->stack[top] = w->colmate[k];
+      w->next[top] = 0;
+      w->seen[w->stack[top]] = w->stamp;
+    } else {
+      top--;
+    }
+  }
+  return 1;
+}
+
+/**
+	Find the strong components of the rows from position plo to phi, in
+	the graph with an edge from each row to the row assigned to each free
+	column it is incident on (Tarjan, without recursion). The rows are
+	written to order[] and the component sizes to sizes[], dependencies
+	first, which is the BLT order.
+	@return the number of components.
+*/
+static int32 btf_components(struct btf_work *w, int32 plo, int32 phi
+		, int32 *order, int32 *sizes
+){
+  const struct var_variable **inc;
+  int32 m, v, x, y, c, n, top, ctop, nord, nscc, idx;
+  int32 *index, *low, *cstack, *estack, *enext;
+  char *onstack;
+
+  m = phi - plo + 1;
+  index = ASC_NEW_ARRAY(int32,5*m);
+  onstack = ASC_NEW_ARRAY_CLEAR(char,m);
+  low = index + m;
+  cstack = low + m;   /* component stack */
+  estack = cstack + m; /* dfs stack */
+  enext = estack + m;
+  for (v = 0; v < m; v++) {
+    index[v] = -1;
+  }
+  idx = nord = nscc = 0;
+  for (v = 0; v < m; v++) {
+    if (index[v] >= 0) continue;
+    top = 0; ctop = 0;
+    estack[0] = v; enext[0] = 0;
+    index[v] = low[v] = idx++;
+    cstack[ctop++] = v; onstack[v] = 1;
+    while (top >= 0) {
+      x = estack[top];
+      inc = rel_incidence_list(w->rp[x + plo]);
+      n = rel_n_incidences(w->rp[x + plo]);
+      for (c = enext[top]; c < n; c++) {
+        if (!BTF_FREE(inc[c])) continue;
+        y = w->colmate[var_sindex(inc[c])];
+        if (y < plo || y > phi) continue;
+        y -= plo;
+        if (index[y] < 0) break;
+        if (onstack[y]) low[x] = MIN(low[x],index[y]);
+      }
+      if (c < n) {
+        /* descend to y */
+        enext[top] = c + 1;
+        top++;
+        estack[top] = y; enext[top] = 0;
+        index[y] = low[y] = idx++;
+        cstack[ctop++] = y; onstack[y] = 1;
+        continue;
+      }
+      if (low[x] == index[x]) {
+        /* x roots a component: pop it */
+        sizes[nscc] = 0;
+        do {
+          y = cstack[--ctop];
+          onstack[y] = 0;
+          order[nord++] = y + plo;
+          sizes[nscc]++;
+        } while (y != x);
+        nscc++;
+      }
+      top--;
+      if (top >= 0) {
+        low[estack[top]] = MIN(low[estack[top]],low[x]);
+      }
+    }
+  }
+  ascfree(index);
+  ascfree(onstack);
+  return nscc;
+}
+
+/**
+	Try to update the BLT partition of sys incrementally, see above.
+	@return 0 if the partition is up to date, nonzero if a full
+	partition is needed.
+*/
+static int block_partition_incremental(slv_system_t sys){
+  struct btf_work w;
+  dof_t *d;
+  const mtx_block_t *b;
+  struct var_variable **vmaster, **vtmp = NULL;
+  struct rel_relation **rtmp = NULL;
+  mtx_region_t *newblocks;
+  int32 rlen, vlen, rank, ncol, nfixed, nfreed, c, k, r, m, nscc, nb;
+  int32 plo, phi, *lost = NULL, nlost = 0, *order = NULL, *sizes = NULL;
+  int32 *vacant = NULL, nvacant, ndof, nfix;
+  int stat = 1;
+
+  d = slv_get_dofdata(sys);
+  b = slv_get_solvers_blocks(sys);
+  rank = d->structural_rank;
+  if (d->assign == NULL || !d->reorder.partition || b->nblocks < 1
+      || b->block == NULL || rank <= 0 || rank != d->n_rows
+      || d->n_assign != slv_get_num_master_rels(sys)
+  ){
+    return 1;
+  }
+  w.rp = slv_get_solvers_rel_list(sys);
+  w.vp = slv_get_solvers_var_list(sys);
+  rlen = slv_get_num_solvers_rels(sys);
+  vlen = slv_get_num_solvers_vars(sys);
+  vmaster = slv_get_master_var_list(sys);
+  ncol = d->n_cols;
+  if (rank > rlen || ncol > vlen) return 1;
+
+  /* the blocks must still be the square diagonal blocks over the rank */
+  for (k = 0, c = 0; k < b->nblocks; k++) {
+    if (b->block[k].row.low != c || b->block[k].col.low != c
+        || b->block[k].row.high != b->block[k].col.high
+    ){
+      return 1;
+    }
+    c = b->block[k].row.high + 1;
+  }
+  if (c != rank) return 1;
+
+  /* the included equations must be the same */
+  for (r = 0; r < rlen; r++) {
+    if ((r < rank) != (BTF_ROW(w.rp[r]) != 0)) return 1;
+  }
+
+  /* only fixed flags may have changed among the columns */
+  nfixed = nfreed = 0;
+  for (c = 0; c < vlen; c++) {
+    if (c < ncol) {
+      if (BTF_FREE(w.vp[c])) continue;
+      if (!BTF_FIXED(w.vp[c])) return 1;
+      nfixed++;
+    } else if (BTF_FREE(w.vp[c])) {
+      nfreed++;
+    }
+  }
+  if ((nfixed + nfreed) * BTF_INCR_FRACTION > rank) return 1;
+
+  w.rowmate = ASC_NEW_ARRAY(int32,rlen);
+  w.colmate = ASC_NEW_ARRAY(int32,vlen);
+  w.blk = ASC_NEW_ARRAY(int32,rlen);
+  w.seen = ASC_NEW_ARRAY(int32,rlen);
+  w.stack = ASC_NEW_ARRAY(int32,3*rlen);
+  w.via = w.stack + rlen;
+  w.next = w.via + rlen;
+  lost = ASC_NEW_ARRAY(int32,nfixed + 1);
+  if (w.rowmate == NULL || w.colmate == NULL || w.blk == NULL
+      || w.seen == NULL || w.stack == NULL || lost == NULL
+  ){
+    goto done;
+  }
+  w.stamp = 0;
+  w.lo = b->nblocks;
+  w.hi = -1;
+  for (c = 0; c < vlen; c++) {
+    w.colmate[c] = -1;
+  }
+  for (r = 0; r < rlen; r++) {
+    w.rowmate[r] = -1;
+    w.seen[r] = 0;
+  }
+  for (k = 0; k < b->nblocks; k++) {
+    for (r = b->block[k].row.low; r <= b->block[k].row.high; r++) {
+      w.blk[r] = k;
+    }
+  }
+
+  /* recover the old assignment, checking it still fits the blocks */
+  for (r = 0; r < rank; r++) {
+    k = d->assign[rel_mindex(w.rp[r])];
+    if (k < 0) goto done;
+    c = var_sindex(vmaster[k]);
+    if (c < 0 || c >= vlen || w.vp[c] != vmaster[k] || w.colmate[c] >= 0
+        || c < b->block[w.blk[r]].col.low || c > b->block[w.blk[r]].col.high
+    ){
+      goto done;
+    }
+    w.rowmate[r] = c;
+    w.colmate[c] = r;
+  }
+  if (nfixed == 0 && nfreed == 0) {
+    report_dof(d->n_rows,ncol,rank);
+    stat = 0;
+    goto done;
+  }
+
+  /* unassign the newly fixed columns */
+  for (c = 0; c < rank; c++) {
+    if (!BTF_FREE(w.vp[c])) {
+      r = w.colmate[c];
+      w.colmate[c] = -1;
+      w.rowmate[r] = -1;
+      lost[nlost++] = r;
+    }
+  }
+  /* and repair the assignment */
+  for (k = 0; k < nlost; k++) {
+    if (btf_augment(&w,lost[k])) {
+      goto done; /* structural rank drops */
+    }
+  }
+
+  /* rows incident on newly assigned columns may now depend on later rows */
+  for (c = rank; c < vlen; c++) {
+    const struct rel_relation **vinc;
+    int32 n;
+    if (w.colmate[c] < 0) continue;
+    vinc = var_incidence_list(w.vp[c]);
+    n = var_n_incidences(w.vp[c]);
+    for (k = 0; k < n; k++) {
+      r = rel_sindex(vinc[k]);
+      if (r >= 0 && r < rank && w.rp[r] == vinc[k]) {
+        w.lo = MIN(w.lo,w.blk[r]);
+      }
+    }
+  }
+
+  if (w.hi >= 0) {
+    plo = b->block[w.lo].row.low;
+    phi = b->block[w.hi].row.high;
+    m = phi - plo + 1;
+    order = ASC_NEW_ARRAY(int32,m);
+    sizes = ASC_NEW_ARRAY(int32,m);
+    rtmp = ASC_NEW_ARRAY(struct rel_relation *,m);
+    vtmp = ASC_NEW_ARRAY(struct var_variable *,m);
+    vacant = ASC_NEW_ARRAY(int32,m);
+    if (order == NULL || sizes == NULL || rtmp == NULL || vtmp == NULL
+        || vacant == NULL
+    ){
+      goto done;
+    }
+    nscc = btf_components(&w,plo,phi,order,sizes);
+
+    /* columns assigned from outside the range take the place of the
+       columns in the range which lost their rows */
+    nvacant = 0;
+    for (k = 0; k < m; k++) {
+      c = w.rowmate[order[k]];
+      if (c < plo || c > phi) vacant[nvacant++] = c;
+      rtmp[k] = w.rp[order[k]];
+      vtmp[k] = w.vp[c];
+    }
+    for (c = plo, k = 0; c <= phi; c++) {
+      if (w.colmate[c] < 0) {
+        asc_assert(k < nvacant);
+        w.vp[vacant[k++]] = w.vp[c];
+      }
+    }
+    for (k = 0; k < m; k++) {
+      w.rp[plo + k] = rtmp[k];
+      rel_set_sindex(rtmp[k],plo + k);
+      w.vp[plo + k] = vtmp[k];
+      var_set_sindex(vtmp[k],plo + k);
+      d->assign[rel_mindex(rtmp[k])] = var_mindex(vtmp[k]);
+    }
+
+    /* splice the new blocks in */
+    nb = w.lo + nscc + (b->nblocks - 1 - w.hi);
+    newblocks = ASC_NEW_ARRAY(mtx_region_t,nb);
+    if (newblocks == NULL) goto done;
+    for (k = 0; k < w.lo; k++) {
+      newblocks[k] = b->block[k];
+    }
+    for (k = 0, r = plo; k < nscc; k++) {
+      newblocks[w.lo + k].row.low = newblocks[w.lo + k].col.low = r;
+      r += sizes[k];
+      newblocks[w.lo + k].row.high = newblocks[w.lo + k].col.high = r - 1;
+    }
+    for (k = w.hi + 1; k < b->nblocks; k++) {
+      newblocks[w.lo + nscc + k - w.hi - 1] = b->block[k];
+    }
+    slv_set_solvers_blocks(sys,nb,newblocks);
+  }
+
+  /* sort the unassigned columns into |dof|fixed|the rest| order */
+  ascfree(vtmp);
+  vtmp = ASC_NEW_ARRAY(struct var_variable *,vlen - rank + 1);
+  if (vtmp == NULL) goto done;
+  ndof = nfix = 0;
+  for (c = rank; c < vlen; c++) {
+    if (BTF_FREE(w.vp[c])) vtmp[ndof++] = w.vp[c];
+  }
+  for (c = rank; c < vlen; c++) {
+    if (BTF_FIXED(w.vp[c])) vtmp[ndof + nfix++] = w.vp[c];
+  }
+  for (c = rank, k = ndof + nfix; c < vlen; c++) {
+    if (!BTF_FREE(w.vp[c]) && !BTF_FIXED(w.vp[c])) vtmp[k++] = w.vp[c];
+  }
+  for (c = rank; c < vlen; c++) {
+    w.vp[c] = vtmp[c - rank];
+    var_set_sindex(w.vp[c],c);
+  }
+  d->n_cols = rank + ndof;
+  d->n_fixed = nfix;
+  report_dof(d->n_rows,d->n_cols,rank);
+  stat = 0;
+
+done:
+  if (stat == 0) {
+    /* as after a full partition */
+    d->reorder.partition = 1;
+    d->reorder.basis_selection = 0;
+    d->reorder.block_reordering = 0;
+  }
+  /* on failure the lists may be part way reordered: the full partition
+     doesn't mind that */
+  if (w.rowmate) ascfree(w.rowmate);
+  if (w.colmate) ascfree(w.colmate);
+  if (w.blk) ascfree(w.blk);
+  if (w.seen) ascfree(w.seen);
+  if (w.stack) ascfree(w.stack);
+  if (lost) ascfree(lost);
+  if (order) ascfree(order);
+  if (sizes) ascfree(sizes);
+  if (rtmp) ascfree(rtmp);
+  if (vtmp) ascfree(vtmp);
+  if (vacant) ascfree(vacant);
+  return stat;
+}
+
 /**
 	Perform var and rel reordering to achieve block form.
 
@@ -161,6 +650,10 @@ int slv_block_partition_real(slv_system_t sys,int uppertriangular){
   if (rlen ==0 || vlen == 0) return 1;
   order = MAX(rlen,vlen);
 
+  if (!uppertriangular && !block_partition_incremental(sys)) {
+    return 0;
+  }
+
   rf.matchbits = (REL_INCLUDED | REL_EQUALITY | REL_ACTIVE);
   rf.matchvalue = (REL_ACTIVE);
   vf.matchbits = (VAR_INCIDENT | VAR_SVAR | VAR_ACTIVE);
@@ -199,26 +692,7 @@ int slv_block_partition_real(slv_system_t sys,int uppertriangular){
 
   /* CONSOLE_DEBUG("FIRST REL = %p",rp[0]); */
 
-  /* lot of whining about dof */
-  if (rank < nrow) {
-    ERROR_REPORTER_NOLINE(ASC_USER_ERROR,"System is row rank deficient (%d dependent equations)",
-            nrow - rank);
-  }
-  if (rank < ncol) {
-    if ( nrow != rank) {
-      ERROR_REPORTER_NOLINE(ASC_USER_ERROR,"System is row rank deficient with %d excess columns.",
-              ncol - rank);
-    } else {
-      ERROR_REPORTER_NOLINE(ASC_USER_ERROR,"System has %d degrees of freedom.", ncol - rank);
-    }
-  }
-  if (ncol == nrow) {
-    if (ncol != rank) {
-      ERROR_REPORTER_NOLINE(ASC_USER_ERROR,"System is (%d) square but rank deficient.",ncol);
-    } else {
-      ERROR_REPORTER_NOLINE(ASC_USER_NOTE,"System is (%d) square.",ncol);
-    }
-  }
+  report_dof(nrow,ncol,rank);
   if (uppertriangular) {
     mtx_ut_partition(mtx);
   } else {
@@ -346,6 +820,11 @@ int slv_block_partition_real(slv_system_t sys,int uppertriangular){
   /* CONSOLE_DEBUG("FIRST REL = %p",rp[0]); */
 
   mtx_destroy(mtx);
+  if (uppertriangular) {
+    forget_assignment(d);
+  } else {
+    save_assignment(sys,d);
+  }
   return 0;
 }
 
@@ -694,6 +1173,7 @@ int slv_block_unify(slv_system_t sys)
       return 1;
     }
     slv_set_solvers_blocks(sys,1,newblocks);
+    d->reorder.partition = 0;	/* no longer the strong components */
   }
   return 0;
 }
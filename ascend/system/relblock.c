@@ -0,0 +1,245 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @file
+	Batched relation blocks, see relblock.h
+*//*
+	Created: Oct 2026
+*/
+
+#include "relblock.h"
+
+#include <stdlib.h>
+#include <math.h>
+#include <ascend/general/platform.h>
+#include <ascend/general/ascMalloc.h>
+#include <ascend/general/panic.h>
+
+#include <ascend/compiler/instance_enum.h>
+#include <ascend/compiler/atomvalue.h>
+#include <ascend/compiler/mathinst.h>
+#include <ascend/compiler/vlist.h>
+#include <ascend/compiler/relation.h>
+#include <ascend/compiler/relation_util.h>
+#include <ascend/compiler/bintoken.h>
+
+/* #define RELBLOCK_DEBUG */
+
+#define IPTR(i) ((struct Instance *)(i))
+
+/**
+	Relations sharing one batch function. Arrays are interleaved: value j
+	of relation i is at [j*n + i].
+*/
+struct relblock_group{
+	int btable, bindex;           /**< any one relation of the group */
+	int32 n;                      /**< number of relations */
+	int32 nvars;                  /**< variables per relation */
+	struct rel_relation **rels;
+	CONST double **vals;          /**< resolved variable value addresses */
+	double *x;                    /**< gathered values */
+	double *r;                    /**< residuals */
+	double *g;                    /**< gradients */
+};
+
+struct RelBlock{
+	int32 ngroups;
+	int32 nrels;
+	struct relblock_group *groups;
+};
+
+/** A candidate relation while grouping */
+struct relblock_cand{
+	void *key;
+	int32 nvars;
+	int32 pos;                    /**< position in the caller's list */
+	int btable, bindex;
+	struct rel_relation *rel;
+};
+
+#define RELBLOCK_SAME(a,b) ((a).key == (b).key && (a).nvars == (b).nvars)
+
+static int relblock_cmp(const void *a, const void *b){
+	const struct relblock_cand *ca = (const struct relblock_cand *)a;
+	const struct relblock_cand *cb = (const struct relblock_cand *)b;
+	if(ca->key != cb->key){
+		return ((size_t)ca->key < (size_t)cb->key) ? -1 : 1;
+	}
+	if(ca->nvars != cb->nvars)return (ca->nvars < cb->nvars) ? -1 : 1;
+	return (ca->pos < cb->pos) ? -1 : (ca->pos > cb->pos);
+}
+
+static void relblock_group_init(struct relblock_group *grp
+		, struct relblock_cand *cand, int32 n
+){
+	CONST struct relation *r;
+	int32 i, j;
+	grp->btable = cand[0].btable;
+	grp->bindex = cand[0].bindex;
+	grp->n = n;
+	grp->nvars = cand[0].nvars;
+	grp->rels = ASC_NEW_ARRAY(struct rel_relation *,n);
+	grp->vals = ASC_NEW_ARRAY_OR_NULL(CONST double *,grp->nvars * n);
+	grp->x = ASC_NEW_ARRAY_OR_NULL(double,grp->nvars * n);
+	grp->g = ASC_NEW_ARRAY_OR_NULL(double,grp->nvars * n);
+	grp->r = ASC_NEW_ARRAY(double,n);
+	for(i = 0; i < n; ++i){
+		grp->rels[i] = cand[i].rel;
+		r = GetInstanceRelationOnly(IPTR(cand[i].rel->instance));
+		for(j = 0; j < grp->nvars; ++j){
+			grp->vals[j*n + i] = RealAtomValuePtr(RelationVariable(r,j+1));
+		}
+	}
+}
+
+struct RelBlock *relblock_create(struct rel_relation **rels, int32 n){
+	struct relblock_cand *cand;
+	struct RelBlock *b;
+	CONST struct relation *r;
+	int32 c, ncand = 0, first, ngroups = 0;
+
+	if(rels == NULL || n < 2)return NULL;
+	cand = ASC_NEW_ARRAY(struct relblock_cand,n);
+	for(c = 0; c < n; ++c){
+		struct relblock_cand *k = &(cand[ncand]);
+		if(rels[c] == NULL || rels[c]->type != e_rel_token)continue;
+		r = GetInstanceRelationOnly(IPTR(rels[c]->instance));
+		if(r == NULL || RTOKEN(r).btable <= 0)continue;
+		k->btable = RTOKEN(r).btable;
+		k->bindex = RTOKEN(r).bindex;
+		k->key = BinTokenBatchKey(k->btable,k->bindex);
+		if(k->key == NULL)continue;
+		k->nvars = (int32)NumberVariables(r);
+		if(k->nvars != rel_n_incidences(rels[c]))continue;
+		k->pos = c;
+		k->rel = rels[c];
+		ncand++;
+	}
+	qsort(cand,ncand,sizeof(struct relblock_cand),relblock_cmp);
+
+	/* count groups of two or more */
+	for(first = 0; first < ncand; first = c){
+		for(c = first + 1; c < ncand && RELBLOCK_SAME(cand[c],cand[first]); ++c);
+		if(c - first > 1)ngroups++;
+	}
+	if(ngroups == 0){
+		ASC_FREE(cand);
+		return NULL;
+	}
+
+	b = ASC_NEW(struct RelBlock);
+	b->ngroups = 0;
+	b->nrels = 0;
+	b->groups = ASC_NEW_ARRAY(struct relblock_group,ngroups);
+	for(first = 0; first < ncand; first = c){
+		for(c = first + 1; c < ncand && RELBLOCK_SAME(cand[c],cand[first]); ++c);
+		if(c - first > 1){
+			relblock_group_init(&(b->groups[b->ngroups]),cand + first,c - first);
+			b->ngroups++;
+			b->nrels += c - first;
+		}
+	}
+	ASC_FREE(cand);
+#ifdef RELBLOCK_DEBUG
+	CONSOLE_DEBUG("%d of %d relations in %d batches",b->nrels,n,b->ngroups);
+#endif
+	return b;
+}
+
+void relblock_destroy(struct RelBlock *b){
+	int32 k;
+	struct relblock_group *grp;
+	if(b == NULL)return;
+	for(k = 0; k < b->ngroups; ++k){
+		grp = &(b->groups[k]);
+		ASC_FREE(grp->rels);
+		if(grp->vals != NULL)ASC_FREE(grp->vals);
+		if(grp->x != NULL)ASC_FREE(grp->x);
+		if(grp->g != NULL)ASC_FREE(grp->g);
+		ASC_FREE(grp->r);
+	}
+	ASC_FREE(b->groups);
+	ASC_FREE(b);
+}
+
+int32 relblock_size(const struct RelBlock *b){
+	return (b == NULL) ? 0 : b->nrels;
+}
+
+/*------------------------------------------------------------------------------
+  EVALUATION
+*/
+
+/**
+	Gather the variable values of a group and call its batch function.
+	@return nonzero if the batch function is gone.
+*/
+static int relblock_group_eval(struct relblock_group *grp, int withgrad){
+	int32 k, len = grp->n * grp->nvars;
+	for(k = 0; k < len; ++k){
+		grp->x[k] = *(grp->vals[k]);
+	}
+	return BinTokenCalcBatch(grp->btable,grp->bindex,grp->n
+		,grp->x,grp->r,withgrad ? grp->g : NULL
+	);
+}
+
+void relblock_eval(struct RelBlock *b, real64 *resid, int32 *done){
+	int32 k, i, ind;
+	struct relblock_group *grp;
+	asc_assert(b != NULL && resid != NULL && done != NULL);
+	for(k = 0; k < b->ngroups; ++k){
+		grp = &(b->groups[k]);
+		if(relblock_group_eval(grp,0)){
+			for(i = 0; i < grp->n; ++i)done[rel_sindex(grp->rels[i])] = 0;
+			continue;
+		}
+		for(i = 0; i < grp->n; ++i){
+			ind = rel_sindex(grp->rels[i]);
+			resid[ind] = grp->r[i];
+			done[ind] = asc_finite(grp->r[i]) ? 1 : 0;
+			if(done[ind])rel_set_residual(grp->rels[i],grp->r[i]);
+		}
+	}
+}
+
+void relblock_resid_grad(struct RelBlock *b, real64 *resid, int32 *done
+		, real64 *grad, const int32 *gstart
+){
+	int32 k, i, j, ind, ok;
+	real64 *g;
+	struct relblock_group *grp;
+	asc_assert(b != NULL && resid != NULL && done != NULL);
+	asc_assert(grad != NULL && gstart != NULL);
+	for(k = 0; k < b->ngroups; ++k){
+		grp = &(b->groups[k]);
+		if(relblock_group_eval(grp,1)){
+			for(i = 0; i < grp->n; ++i)done[rel_sindex(grp->rels[i])] = 0;
+			continue;
+		}
+		for(i = 0; i < grp->n; ++i){
+			ind = rel_sindex(grp->rels[i]);
+			g = grad + gstart[rel_mindex(grp->rels[i])];
+			ok = asc_finite(grp->r[i]);
+			for(j = 0; j < grp->nvars; ++j){
+				g[j] = grp->g[j*grp->n + i];
+				ok = ok && asc_finite(g[j]);
+			}
+			resid[ind] = grp->r[i];
+			done[ind] = ok ? 1 : 0;
+			if(ok)rel_set_residual(grp->rels[i],grp->r[i]);
+		}
+	}
+}
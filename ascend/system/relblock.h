@@ -0,0 +1,92 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @defgroup system_relblock System Batched Relation Blocks
+
+	Batched evaluation of the compiled binary token relations of a block.
+
+	Relations that are instances of the same equation share one compiled
+	batch function (see BinTokenCalcBatch). A RelBlock groups the relations
+	of a block by that function, and evaluates each group with a single
+	call, the variable values of the group being gathered into one
+	interleaved array first. This replaces one call and one table lookup
+	per relation by one per group, and lets the compiler vectorize the
+	generated loop over the relations of a group.
+
+	Only groups of at least two relations are kept; other relations are
+	left to the usual relman routines, as are relations whose batch result
+	is not finite, so that 'safe' error handling is unchanged.
+
+	A RelBlock holds pointers into the instance tree and into the loaded
+	bintoken tables: it must be destroyed whenever the system is
+	re-analysed or the bintoken tables are cleared. It owns its scratch
+	space and so must not be evaluated from several threads at once.
+*//*
+	Created: Oct 2026
+*/
+
+#ifndef ASC_RELBLOCK_H
+#define ASC_RELBLOCK_H
+
+#include <ascend/general/platform.h>
+#include "rel.h"
+
+/**	@addtogroup system_relblock
+	@{
+*/
+
+struct RelBlock;
+/**< Opaque batched evaluation plan for a set of relations. */
+
+ASC_DLLSPEC struct RelBlock *relblock_create(struct rel_relation **rels
+		, int32 n);
+/**<
+	Group those of the n relations in rels that have compiled batch
+	functions.
+
+	@return the new plan, or NULL if no two relations share a batch
+	function.
+*/
+
+ASC_DLLSPEC void relblock_destroy(struct RelBlock *b);
+/**< Free a plan created by relblock_create. NULL is ignored. */
+
+ASC_DLLSPEC int32 relblock_size(const struct RelBlock *b);
+/**< Number of relations evaluated by the plan. */
+
+ASC_DLLSPEC void relblock_eval(struct RelBlock *b, real64 *resid
+		, int32 *done);
+/**<
+	Evaluate the residuals of all relations in the plan at the current
+	variable values, and set them as relman_eval would.
+
+	@param resid  indexed by rel_sindex; receives the residuals.
+	@param done   indexed by rel_sindex; set to 1 for each relation whose
+	              residual is finite, else 0. Entries of relations not in
+	              the plan are not touched.
+*/
+
+ASC_DLLSPEC void relblock_resid_grad(struct RelBlock *b, real64 *resid
+		, int32 *done, real64 *grad, const int32 *gstart);
+/**<
+	As relblock_eval, also computing gradients. The gradient of relation
+	rel is written densely, in rel_incidence_list order, to
+	grad + gstart[rel_mindex(rel)]. done is set to 1 only if the residual
+	and all gradient elements are finite.
+*/
+
+/* @} */
+
+#endif /* ASC_RELBLOCK_H */
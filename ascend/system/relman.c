@@ -631,6 +631,30 @@ int relman_hess(struct rel_relation *rel, const var_filter_t *filter
 	return status;
 }
 
+/* return 0 on success */
+int relman_hess_lower(struct rel_relation *rel, ltmatrix *work, int32 safe){
+	unsigned long len, k;
+	int status;
+
+	assert(rel!=NULL && work!=NULL);
+	len = rel_n_incidences(rel);
+	asc_assert(work->access_type==LTMATRIX_LOWER && len <= work->dimension);
+
+	/* the second derivatives are accumulated into the rows */
+	for(k = 0; k < (len*(len+1))/2; ++k){
+		work->h[k] = 0.0;
+	}
+	if(len == 0)return 0;
+
+	if(safe){
+		status = (int)RelationCalcHessianMtxSafe(rel_instance(rel),work,len);
+		safe_error_to_stderr((enum safe_err *)&status);
+	}else{
+		status = RelationCalcHessianMtx(rel_instance(rel),work,len);
+	}
+	return status;
+}
+
 /* return 0 on success */
 int relman_diff3(struct rel_relation *rel
 		, const var_filter_t *filter
@@ -924,6 +948,156 @@ int relman_diffs(struct rel_relation *rel
   return status;
 }
 
+real64 relman_eval_prog(struct rel_relation *rel, const struct RelProg *prog
+		, int32 *calc_ok, int safe, double *work
+){
+	real64 res;
+	asc_assert(calc_ok!=NULL);
+	if(prog != NULL && !relprog_eval(prog,work,&res)){
+		*calc_ok = 1;
+		rel_set_residual(rel,res);
+		return res;
+	}
+	/* no program, or a non-finite result: let the usual code report it */
+	return relman_eval(rel,calc_ok,safe);
+}
+
+int relman_diffs_prog(struct rel_relation *rel, const struct RelProg *prog
+		, const var_filter_t *filter, mtx_matrix_t mtx, real64 *resid
+		, int safe, double *work
+){
+	real64 *gradient;
+
+	if(prog == NULL){
+		return relman_diffs(rel,filter,mtx,resid,safe);
+	}
+	assert(rel!=NULL && filter!=NULL && mtx != NULL);
+	asc_assert(rel_n_incidences(rel) == relprog_num_vars(prog));
+	gradient = work + relprog_work_size(prog);
+	if(relprog_resid_grad(prog,work,resid,gradient)){
+		return relman_diffs(rel,filter,mtx,resid,safe);
+	}
+	relman_map_grad(rel,filter,mtx,gradient);
+	return 0;
+}
+
+real64 relman_eval_ctx(struct rel_relation *rel, const struct RelProg *prog
+		, struct RelationEvalContext *ctx, int32 *status, int safe, double *work
+){
+	real64 res;
+	asc_assert(status!=NULL && rel!=NULL);
+	if(prog != NULL && !relprog_eval(prog,work,&res)){
+		*status = 0;
+		rel_set_residual(rel,res);
+		return res;
+	}
+	if(safe){
+		*status = (int32)RelationCalcResidualSafeCtx(ctx,rel_instance(rel),&res);
+		rel_set_residual(rel,res);
+		return res;
+	}
+	*status = RelationCalcResidualCtx(ctx,rel_instance(rel),&res);
+	if(*status){
+		res = 1.0e8;
+	}else{
+		rel_set_residual(rel,res);
+	}
+	return res;
+}
+
+int relman_grad_ctx(struct rel_relation *rel, const struct RelProg *prog
+		, struct RelationEvalContext *ctx, real64 *resid, real64 *grad
+		, int safe, double *work
+){
+	asc_assert(rel!=NULL && grad!=NULL);
+	if(prog != NULL && !relprog_resid_grad(prog,work,resid,grad)){
+		return 0;
+	}
+	if(safe){
+		return (int)RelationCalcResidGradSafeCtx(ctx,rel_instance(rel),resid,grad);
+	}
+	return RelationCalcResidGradCtx(ctx,rel_instance(rel),resid,grad);
+}
+
+int relman_has_binary(struct rel_relation *rel){
+	CONST struct relation *r;
+	asc_assert(rel!=NULL);
+	if(rel->type != e_rel_token)return 0;
+	r = GetInstanceRelationOnly(IPTR(rel->instance));
+	return r != NULL && RTOKEN(r).btable > 0;
+}
+
+int relman_grad_binary(struct rel_relation *rel, real64 *resid, real64 *grad){
+	int32 len,c;
+	real64 res;
+	asc_assert(rel!=NULL && resid!=NULL && grad!=NULL);
+	if(!relman_has_binary(rel))return 1;
+	res = HUGE_VAL; /* left alone by a non-finite evaluation */
+	if(RelationCalcGradientBinary(GetInstanceRelationOnly(IPTR(rel->instance))
+			,&res,grad) || !asc_finite(res)
+	){
+		return 1;
+	}
+	len = rel_n_incidences(rel);
+	for(c=0; c < len; c++){
+		if(!asc_finite(grad[c]))return 1;
+	}
+	*resid = res;
+	return 0;
+}
+
+int relman_diff_dir(struct rel_relation *rel, const struct RelProg *prog
+		, const real64 *dir, real64 *deriv, int safe, double *work
+){
+	real64 resid, *gradient;
+	int32 len,c;
+	int status;
+
+	asc_assert(rel!=NULL && dir!=NULL && deriv!=NULL);
+	if(prog != NULL){
+		if(!relprog_resid_dir(prog,work,dir,&resid,deriv))return 0;
+		gradient = work + relprog_work_size(prog);
+	}else{
+		gradient = work;
+	}
+
+	/* no program, or a non-finite result: full gradient, then the product */
+	len = rel_n_incidences(rel);
+	if(safe){
+		status = (int)RelationCalcResidGradSafe(rel_instance(rel),&resid,gradient);
+		safe_error_to_stderr((enum safe_err *)&status);
+	}else{
+		status = RelationCalcResidGrad(rel_instance(rel),&resid,gradient);
+		if(status)return status;
+	}
+	*deriv = 0.0;
+	for(c=0; c < len; c++){
+		if(dir[c] != 0.0)*deriv += gradient[c] * dir[c];
+	}
+	return status;
+}
+
+void relman_map_grad(struct rel_relation *rel, const var_filter_t *filter
+		, mtx_matrix_t mtx, const real64 *grad
+){
+	const struct var_variable **vlist;
+	int32 len,c;
+	mtx_coord_t coord;
+
+	assert(rel!=NULL && filter!=NULL && mtx != NULL);
+	len = rel_n_incidences(rel);
+	vlist = rel_incidence_list(rel);
+	coord.row = rel_sindex(rel);
+	assert(coord.row>=0 && coord.row < mtx_order(mtx));
+	for(c=0; c < len; c++){
+		if(var_apply_filter(vlist[c],filter)){
+			coord.col = var_sindex(vlist[c]);
+			assert(coord.col >= 0 && coord.col < mtx_order(mtx));
+			mtx_fill_org_value(mtx,&coord,grad[c]);
+		}
+	}
+}
+
 #if 0 & REIMPLEMENT /* this needs to be reimplemented in the compiler */
 real64 relman_diffs_orig( struct rel_relation *rel, var_filter_t *filter
 		,mtx_matrix_t mtx
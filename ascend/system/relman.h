@@ -39,6 +39,7 @@
 
 #include "var.h"
 #include "rel.h"
+#include "relprog.h"
 
 /**	@addtogroup system_relman
 	@{
@@ -201,6 +202,21 @@ ASC_DLLSPEC int relman_hess(struct rel_relation *rel,
 	@return 0 on success, non-zero if an error is encountered in the calculation
 */
 
+ASC_DLLSPEC int relman_hess_lower(struct rel_relation *rel,
+							ltmatrix *work,
+							int32 safe);
+/**<
+	Lower triangle of the Hessian of rel with respect to all of its
+	incidences, unfiltered and in rel_incidence_list order. Element (i,j),
+	j <= i, is left in work->h[i*(i+1)/2 + j].
+
+	@param work is an LTMATRIX_LOWER matrix of dimension at least
+	rel_n_incidences(rel); it can be reused for any number of relations.
+	Only the first len*(len+1)/2 elements are overwritten.
+
+	@return 0 on success, non-zero if an error is encountered in the calculation
+*/
+
 ASC_DLLSPEC int relman_diff3(struct rel_relation *rel,
                         const var_filter_t *filter,
                         real64 *derivatives,
@@ -281,6 +297,101 @@ ASC_DLLSPEC int relman_diffs(struct rel_relation *rel,
 	harwellian matrices, glassbox rels and blackbox.
 */
 
+ASC_DLLSPEC real64 relman_eval_prog(struct rel_relation *rel,
+		const struct RelProg *prog, int32 *calc_ok, int safe, double *work);
+/**<
+	As relman_eval, but using a compiled relation program (see relprog.h)
+	when one is given. If prog is NULL, or the program gives a non-finite
+	residual, the normal relman_eval route is taken so that 'safe' error
+	handling and reporting are unchanged.
+
+	@param work  scratch space of at least relprog_work_size(prog) doubles.
+*/
+
+ASC_DLLSPEC int relman_diffs_prog(struct rel_relation *rel,
+		const struct RelProg *prog, const var_filter_t *filter,
+		mtx_matrix_t mtx, real64 *resid, int safe, double *work);
+/**<
+	As relman_diffs, but using a compiled relation program when one is
+	given, with the same fallback rules as relman_eval_prog.
+
+	@param work  scratch space of at least
+	             relprog_work_size(prog) + relprog_num_vars(prog) doubles.
+	             The caller owns it, so this function keeps no hidden state.
+*/
+
+struct RelationEvalContext;
+
+ASC_DLLSPEC real64 relman_eval_ctx(struct rel_relation *rel,
+		const struct RelProg *prog, struct RelationEvalContext *ctx,
+		int32 *status, int safe, double *work);
+/**<
+	Reentrant form of relman_eval_prog, for use from worker threads. Uses
+	the program if one is given, otherwise the relation_util routines with
+	the caller's evaluation context (see RelationEvalContextCreate).
+	Compiled binary tokens are not used.
+
+	Errors are not reported here, so that the caller can report them in a
+	deterministic order afterwards: *status is 0 on success, otherwise
+	(if safe) the enum safe_err code, suitable for safe_error_to_stderr.
+	The relation residual is set as relman_eval would set it.
+
+	@param work  scratch space of at least relprog_work_size(prog) doubles.
+*/
+
+ASC_DLLSPEC int relman_grad_ctx(struct rel_relation *rel,
+		const struct RelProg *prog, struct RelationEvalContext *ctx,
+		real64 *resid, real64 *grad, int safe, double *work);
+/**<
+	Reentrant residual and gradient evaluation for use from worker threads.
+	The gradient is written densely to grad in rel_incidence_list order
+	(rel_n_incidences(rel) doubles); nothing is written to any matrix.
+	Errors are not reported.
+
+	@param work  scratch space of at least relprog_work_size(prog) doubles.
+	@return 0 on success, else (if safe) the enum safe_err code. As for
+	relman_diffs, when safe is FALSE and the return is non-zero the
+	gradient must not be used.
+*/
+
+ASC_DLLSPEC int relman_has_binary(struct rel_relation *rel);
+/**< Nonzero if rel is a token relation with compiled binary tokens. */
+
+ASC_DLLSPEC int relman_grad_binary(struct rel_relation *rel,
+		real64 *resid, real64 *grad);
+/**<
+	Residual and gradient of rel from its compiled binary tokens, as
+	relman_diffs takes them, written densely to grad as for relman_grad_ctx.
+	Not reentrant.
+
+	@return 0 on success, nonzero if rel has no binary tokens or they
+	failed, in which case resid and grad must not be used.
+*/
+
+ASC_DLLSPEC int relman_diff_dir(struct rel_relation *rel,
+		const struct RelProg *prog, const real64 *dir, real64 *deriv,
+		int safe, double *work);
+/**<
+	Directional derivative of the residual of rel along dir, i.e. one
+	element of a Jacobian-vector product. dir is given in rel_incidence_list
+	order (rel_n_incidences(rel) doubles); entries for variables that are to
+	be left out should be zero. Uses one forward sweep of the program if
+	one is given, otherwise (or if that is not finite) the full gradient
+	from the relation_util routines, with the usual 'safe' handling.
+
+	@param work  scratch space of at least relprog_work_size(prog) (0 if
+	             prog is NULL) + rel_n_incidences(rel) doubles.
+	@return 0 on success, as for relman_diff3 otherwise.
+*/
+
+ASC_DLLSPEC void relman_map_grad(struct rel_relation *rel,
+		const var_filter_t *filter, mtx_matrix_t mtx, const real64 *grad);
+/**<
+	Fill the org row rel_sindex(rel) of mtx with those elements of the
+	dense gradient grad (as computed by relman_grad_ctx) whose variables
+	pass filter, at org columns var_sindex.
+*/
+
 #if 0 && THIS_IS_A_DISUSED_FUNCTION
 extern int32 relman_diff_harwell(struct rel_relation **rlist,
 		var_filter_t *vfilter, rel_filter_t *rfilter,
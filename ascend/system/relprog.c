@@ -0,0 +1,450 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @file
+	Compiled relation programs, see relprog.h
+*//*
+	Created: Oct 2026
+*/
+
+#include "relprog.h"
+
+#include <math.h>
+#include <ascend/general/platform.h>
+#include <ascend/general/ascMalloc.h>
+#include <ascend/general/panic.h>
+#include <ascend/general/list.h>
+
+#include <ascend/compiler/instance_enum.h>
+#include <ascend/compiler/expr_types.h>
+#include <ascend/compiler/func.h>
+#include <ascend/compiler/atomvalue.h>
+#include <ascend/compiler/mathinst.h>
+#include <ascend/compiler/vlist.h>
+#include <ascend/compiler/relation.h>
+#include <ascend/compiler/relation_util.h>
+
+/* #define RELPROG_DEBUG */
+
+#define IPTR(i) ((struct Instance *)(i))
+
+enum relprog_op{
+	rp_const,
+	rp_var,
+	rp_plus,
+	rp_minus,
+	rp_times,
+	rp_divide,
+	rp_power,
+	rp_ipower,
+	rp_uminus,
+	rp_func
+};
+
+/**
+	One instruction. The result of instruction k is always written to
+	register k; 'left' and 'right' are the registers holding the operands.
+	Because the source is a tree, every register is read by exactly one
+	later instruction, which lets the reverse sweep assign adjoints rather
+	than accumulate them.
+*/
+struct relprog_instr{
+	unsigned char op;      /**< enum relprog_op */
+	unsigned char hasvar;  /**< nonzero if the subtree contains a variable */
+	int32 left, right;
+	union{
+		double c;            /**< rp_const */
+		int32 slot;          /**< rp_var: index into vals, base 0 */
+		CONST struct Func *f;/**< rp_func */
+	} u;
+};
+
+struct RelProg{
+	int32 n;                      /**< number of instructions */
+	int32 nvars;                  /**< number of variable slots */
+	struct relprog_instr *code;
+	CONST double **vals;          /**< resolved variable value addresses */
+};
+
+/*------------------------------------------------------------------------------
+  COMPILATION
+*/
+
+/**
+	Apply a binary or unary operation to constant operands, as done at
+	run time. Used only for folding literal subexpressions.
+*/
+static double relprog_apply(CONST struct relprog_instr *ins, double x, double y){
+	switch(ins->op){
+	case rp_plus: return x + y;
+	case rp_minus: return x - y;
+	case rp_times: return x * y;
+	case rp_divide: return x / y;
+	case rp_power: return pow(x,y);
+	case rp_ipower: return asc_ipow(x,(int)y);
+	case rp_uminus: return -x;
+	case rp_func: return FuncEval(ins->u.f,x);
+	default:
+		ASC_PANIC("invalid op");
+	}
+}
+
+/**
+	Append the postfix terms of one side of the relation to the program.
+	@return the register holding the value of that side.
+*/
+static int32 relprog_compile_side(struct RelProg *p, CONST struct relation *r
+		, int lhs, int32 *stack
+){
+	unsigned long t, len;
+	int32 s = -1, k, arity;
+	CONST struct relation_term *term;
+	struct relprog_instr *ins;
+
+	len = RelationLength(r,lhs);
+	for(t = 0; t < len; ++t){
+		term = NewRelationTerm(r,t,lhs);
+		k = p->n;
+		ins = &(p->code[k]);
+		ins->left = ins->right = -1;
+		ins->hasvar = 0;
+		arity = 0;
+		switch(RelationTermType(term)){
+		case e_zero:
+			ins->op = rp_const; ins->u.c = 0.0; break;
+		case e_real:
+			ins->op = rp_const; ins->u.c = TermReal(term); break;
+		case e_int:
+			ins->op = rp_const; ins->u.c = (double)TermInteger(term); break;
+		case e_var:
+			ins->op = rp_var;
+			ins->u.slot = (int32)TermVarNumber(term) - 1;
+			ins->hasvar = 1;
+			break;
+		case e_plus: ins->op = rp_plus; arity = 2; break;
+		case e_minus: ins->op = rp_minus; arity = 2; break;
+		case e_times: ins->op = rp_times; arity = 2; break;
+		case e_divide: ins->op = rp_divide; arity = 2; break;
+		case e_power: ins->op = rp_power; arity = 2; break;
+		case e_ipower: ins->op = rp_ipower; arity = 2; break;
+		case e_uminus: ins->op = rp_uminus; arity = 1; break;
+		case e_func:
+			ins->op = rp_func; ins->u.f = TermFunc(term); arity = 1;
+			break;
+		default:
+			ERROR_REPORTER_HERE(ASC_PROG_ERR,"Unknown relation term type");
+			return -1;
+		}
+		if(arity == 2){
+			ins->right = stack[s--];
+			ins->left = stack[s--];
+			ins->hasvar = p->code[ins->left].hasvar | p->code[ins->right].hasvar;
+		}else if(arity == 1){
+			ins->left = stack[s--];
+			ins->hasvar = p->code[ins->left].hasvar;
+		}
+		if(arity && !ins->hasvar && p->code[ins->left].op == rp_const
+			&& (arity == 1 || p->code[ins->right].op == rp_const)
+		){
+			/* literal subexpression: its operands are the most recent
+			registers, so they can be dropped and replaced by one constant */
+			double x, y, v;
+			x = p->code[ins->left].u.c;
+			y = (arity == 2) ? p->code[ins->right].u.c : 0.0;
+			v = relprog_apply(ins,x,y);
+			if(asc_finite(v)){
+				k = ins->left;
+				p->code[k].op = rp_const;
+				p->code[k].hasvar = 0;
+				p->code[k].left = p->code[k].right = -1;
+				p->code[k].u.c = v;
+				p->n = k;
+			}
+		}
+		stack[++s] = k;
+		p->n = k + 1;
+	}
+	asc_assert(s == 0);
+	return stack[s];
+}
+
+struct RelProg *relprog_create(struct rel_relation *rel){
+	CONST struct relation *r;
+	struct RelProg *p;
+	unsigned long len_lhs, len_rhs, c;
+	int32 *stack, lroot = -1, rroot = -1, ntot;
+	struct relprog_instr *ins;
+
+	if(rel == NULL || rel->type != e_rel_token)return NULL;
+	r = GetInstanceRelationOnly(IPTR(rel->instance));
+	if(r == NULL)return NULL;
+	if(RTOKEN(r).btable > 0)return NULL;
+
+	len_lhs = RelationLength(r,1);
+	len_rhs = RelationLength(r,0);
+	if(len_lhs + len_rhs == 0)return NULL;
+
+	ntot = (int32)(len_lhs + len_rhs + 1);
+	p = ASC_NEW(struct RelProg);
+	p->n = 0;
+	p->nvars = (int32)NumberVariables(r);
+	p->code = ASC_NEW_ARRAY(struct relprog_instr,ntot);
+	p->vals = ASC_NEW_ARRAY_OR_NULL(CONST double *,p->nvars);
+	for(c = 1; c <= (unsigned long)p->nvars; ++c){
+		p->vals[c-1] = RealAtomValuePtr(RelationVariable(r,c));
+	}
+
+	stack = ASC_NEW_ARRAY(int32,MAX(len_lhs,len_rhs) + 1);
+	if(len_lhs){
+		lroot = relprog_compile_side(p,r,1,stack);
+	}
+	if(len_rhs && (len_lhs == 0 || lroot >= 0)){
+		rroot = relprog_compile_side(p,r,0,stack);
+	}
+	ASC_FREE(stack);
+	if((len_lhs && lroot < 0) || (len_rhs && rroot < 0)){
+		relprog_destroy(p);
+		return NULL;
+	}
+
+	/* residual = LHS - RHS, left in the last register */
+	if(len_rhs){
+		ins = &(p->code[p->n]);
+		if(len_lhs){
+			ins->op = rp_minus;
+			ins->left = lroot;
+			ins->right = rroot;
+			ins->hasvar = p->code[lroot].hasvar | p->code[rroot].hasvar;
+		}else{
+			ins->op = rp_uminus;
+			ins->left = rroot;
+			ins->right = -1;
+			ins->hasvar = p->code[rroot].hasvar;
+		}
+		p->n++;
+	}
+#ifdef RELPROG_DEBUG
+	CONSOLE_DEBUG("compiled %lu terms into %d instructions",len_lhs+len_rhs,p->n);
+#endif
+	return p;
+}
+
+void relprog_destroy(struct RelProg *prog){
+	if(prog == NULL)return;
+	if(prog->code != NULL)ASC_FREE(prog->code);
+	if(prog->vals != NULL)ASC_FREE(prog->vals);
+	ASC_FREE(prog);
+}
+
+int32 relprog_length(const struct RelProg *prog){
+	return prog->n;
+}
+
+int32 relprog_num_vars(const struct RelProg *prog){
+	return prog->nvars;
+}
+
+int32 relprog_work_size(const struct RelProg *prog){
+	return 2 * prog->n;
+}
+
+/*------------------------------------------------------------------------------
+  EVALUATION
+*/
+
+/**
+	Forward sweep: fill registers v[0..n-1] and return the residual.
+*/
+static double relprog_forward(const struct RelProg *p, double *v){
+	int32 k;
+	CONST struct relprog_instr *ins = p->code;
+	for(k = 0; k < p->n; ++k, ++ins){
+		switch(ins->op){
+		case rp_const:  v[k] = ins->u.c; break;
+		case rp_var:    v[k] = *(p->vals[ins->u.slot]); break;
+		case rp_plus:   v[k] = v[ins->left] + v[ins->right]; break;
+		case rp_minus:  v[k] = v[ins->left] - v[ins->right]; break;
+		case rp_times:  v[k] = v[ins->left] * v[ins->right]; break;
+		case rp_divide: v[k] = v[ins->left] / v[ins->right]; break;
+		case rp_power:  v[k] = pow(v[ins->left],v[ins->right]); break;
+		case rp_ipower: v[k] = asc_ipow(v[ins->left],(int)v[ins->right]); break;
+		case rp_uminus: v[k] = -v[ins->left]; break;
+		case rp_func:   v[k] = FuncEval(ins->u.f,v[ins->left]); break;
+		default:
+			ASC_PANIC("invalid op");
+		}
+	}
+	return v[p->n - 1];
+}
+
+int relprog_eval(const struct RelProg *prog, double *work, double *resid){
+	asc_assert(prog != NULL && work != NULL && resid != NULL);
+	*resid = relprog_forward(prog,work);
+	return asc_finite(*resid) ? 0 : 1;
+}
+
+int relprog_resid_grad(const struct RelProg *prog, double *work
+		, double *resid, double *grad
+){
+	int32 k, c;
+	double *v, *a, ak, x, y;
+	CONST struct relprog_instr *ins;
+	int status;
+
+	asc_assert(prog != NULL && work != NULL && resid != NULL && grad != NULL);
+	v = work;
+	a = work + prog->n;
+
+	*resid = relprog_forward(prog,v);
+	status = asc_finite(*resid) ? 0 : 1;
+
+	for(c = 0; c < prog->nvars; ++c)grad[c] = 0.0;
+
+	/* reverse sweep; registers without variables are never visited */
+	a[prog->n - 1] = 1.0;
+	for(k = prog->n - 1; k >= 0; --k){
+		ins = &(prog->code[k]);
+		if(!ins->hasvar)continue;
+		ak = a[k];
+		switch(ins->op){
+		case rp_var:
+			grad[ins->u.slot] += ak;
+			break;
+		case rp_plus:
+			a[ins->left] = ak;
+			a[ins->right] = ak;
+			break;
+		case rp_minus:
+			a[ins->left] = ak;
+			a[ins->right] = -ak;
+			break;
+		case rp_times:
+			a[ins->left] = ak * v[ins->right];
+			a[ins->right] = ak * v[ins->left];
+			break;
+		case rp_divide:
+			/* d(u/w) = du/w - (u/w)*dw/w */
+			y = 1.0 / v[ins->right];
+			a[ins->left] = ak * y;
+			a[ins->right] = -ak * v[k] * y;
+			break;
+		case rp_power:
+			/* d(u^w) = w*u^(w-1)*du + ln(u)*u^w*dw */
+			x = v[ins->left];
+			y = v[ins->right];
+			if(prog->code[ins->left].hasvar){
+				a[ins->left] = ak * y * pow(x, y - 1.0);
+			}
+			if(prog->code[ins->right].hasvar){
+				a[ins->right] = ak * log(x) * v[k];
+			}
+			break;
+		case rp_ipower:
+			x = v[ins->left];
+			y = v[ins->right];
+			a[ins->left] = ak * asc_d1ipow(x,(int)y);
+			if(prog->code[ins->right].hasvar){
+				a[ins->right] = ak * log(x) * v[k];
+			}
+			break;
+		case rp_uminus:
+			a[ins->left] = -ak;
+			break;
+		case rp_func:
+			a[ins->left] = ak * FuncDeriv(ins->u.f,v[ins->left]);
+			break;
+		default:
+			ASC_PANIC("invalid op");
+		}
+	}
+
+	if(!status){
+		for(c = 0; c < prog->nvars; ++c){
+			if(!asc_finite(grad[c])){
+				status = 1;
+				break;
+			}
+		}
+	}
+	return status;
+}
+
+int relprog_resid_dir(const struct RelProg *prog, double *work
+		, const double *dir, double *resid, double *deriv
+){
+	int32 k;
+	double *v, *t, x, y;
+	CONST struct relprog_instr *ins;
+
+	asc_assert(prog != NULL && work != NULL && dir != NULL);
+	asc_assert(resid != NULL && deriv != NULL);
+	v = work;
+	t = work + prog->n;
+
+	/* forward sweep carrying the tangent of each register along dir */
+	*resid = relprog_forward(prog,v);
+	for(k = 0, ins = prog->code; k < prog->n; ++k, ++ins){
+		if(!ins->hasvar){
+			t[k] = 0.0;
+			continue;
+		}
+		switch(ins->op){
+		case rp_var:
+			t[k] = dir[ins->u.slot];
+			break;
+		case rp_plus:
+			t[k] = t[ins->left] + t[ins->right];
+			break;
+		case rp_minus:
+			t[k] = t[ins->left] - t[ins->right];
+			break;
+		case rp_times:
+			t[k] = t[ins->left] * v[ins->right] + v[ins->left] * t[ins->right];
+			break;
+		case rp_divide:
+			t[k] = (t[ins->left] - v[k] * t[ins->right]) / v[ins->right];
+			break;
+		case rp_power:
+			x = v[ins->left];
+			y = v[ins->right];
+			t[k] = 0.0;
+			if(prog->code[ins->left].hasvar){
+				t[k] += t[ins->left] * y * pow(x, y - 1.0);
+			}
+			if(prog->code[ins->right].hasvar){
+				t[k] += t[ins->right] * log(x) * v[k];
+			}
+			break;
+		case rp_ipower:
+			x = v[ins->left];
+			y = v[ins->right];
+			t[k] = t[ins->left] * asc_d1ipow(x,(int)y);
+			if(prog->code[ins->right].hasvar){
+				t[k] += t[ins->right] * log(x) * v[k];
+			}
+			break;
+		case rp_uminus:
+			t[k] = -t[ins->left];
+			break;
+		case rp_func:
+			t[k] = t[ins->left] * FuncDeriv(ins->u.f,v[ins->left]);
+			break;
+		default:
+			ASC_PANIC("invalid op");
+		}
+	}
+	*deriv = t[prog->n - 1];
+	return (asc_finite(*resid) && asc_finite(*deriv)) ? 0 : 1;
+}
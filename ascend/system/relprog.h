@@ -0,0 +1,124 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @defgroup system_relprog System Compiled Relation Programs
+
+	Flat 'register programs' for token relations.
+
+	The postfix term arrays of a token relation are translated once (typically
+	at solver presolve time) into a linear array of instructions in which
+	every instruction writes to its own register and refers to its operands
+	by register number. Variable slots are resolved to the addresses of the
+	real atom values, so evaluation does not walk gl_lists or term trees.
+	Subexpressions that contain only literal constants are folded.
+
+	Residuals are computed by a single forward sweep; gradients by a forward
+	sweep followed by one reverse (adjoint) sweep, so the cost of a gradient
+	does not grow with the number of incident variables. Directional
+	derivatives (for Jacobian-vector products) take one forward sweep that
+	carries a tangent alongside each register.
+
+	The programs are read-only once built. All scratch space is supplied by
+	the caller, so a single program may be evaluated from several threads
+	at once as long as each uses its own work array.
+
+	Programs hold pointers into the instance tree: they must be destroyed
+	and rebuilt whenever the system is re-analysed.
+*//*
+	Created: Oct 2026
+*/
+
+#ifndef ASC_RELPROG_H
+#define ASC_RELPROG_H
+
+#include <ascend/general/platform.h>
+#include "rel.h"
+
+/**	@addtogroup system_relprog
+	@{
+*/
+
+struct RelProg;
+/**< Opaque compiled form of a token relation. */
+
+ASC_DLLSPEC struct RelProg *relprog_create(struct rel_relation *rel);
+/**<
+	Compile the given relation into a register program.
+
+	@return the new program, or NULL if the relation is not a token
+	relation, is empty, or already has compiled binary tokens (in which
+	case the binary tokens remain the preferred route).
+*/
+
+ASC_DLLSPEC void relprog_destroy(struct RelProg *prog);
+/**< Free a program created by relprog_create. NULL is ignored. */
+
+ASC_DLLSPEC int32 relprog_length(const struct RelProg *prog);
+/**< Number of instructions (registers) in the program. */
+
+ASC_DLLSPEC int32 relprog_num_vars(const struct RelProg *prog);
+/**<
+	Number of variable slots, which equals the length of the relation's
+	variable list (and of rel_incidence_list).
+*/
+
+ASC_DLLSPEC int32 relprog_work_size(const struct RelProg *prog);
+/**<
+	Number of doubles of scratch space that relprog_eval, relprog_resid_grad
+	and relprog_resid_dir need in their 'work' argument.
+*/
+
+ASC_DLLSPEC int relprog_eval(const struct RelProg *prog, double *work
+		, double *resid);
+/**<
+	Evaluate the residual (LHS - RHS) of the relation at the current
+	variable values.
+
+	@param work  at least relprog_work_size(prog) doubles
+	@return 0 on success, 1 if the residual is not finite (the value is
+	still returned in *resid). Callers wanting 'safe' error handling
+	should fall back to the relation_util routines on failure.
+*/
+
+ASC_DLLSPEC int relprog_resid_grad(const struct RelProg *prog, double *work
+		, double *resid, double *grad);
+/**<
+	Evaluate residual and gradient of the relation at the current variable
+	values by reverse-mode differentiation of the program.
+
+	@param work  at least relprog_work_size(prog) doubles
+	@param grad  relprog_num_vars(prog) doubles, filled in relation variable
+	             list order (the same order as RelationCalcResidGrad).
+	@return 0 on success, 1 if the residual or any gradient element is not
+	finite.
+*/
+
+ASC_DLLSPEC int relprog_resid_dir(const struct RelProg *prog, double *work
+		, const double *dir, double *resid, double *deriv);
+/**<
+	Evaluate the residual of the relation and its directional derivative
+	along 'dir', that is the sum of grad[c]*dir[c], by one forward-mode
+	sweep of the program. Cheaper than relprog_resid_grad when only a
+	Jacobian-vector product is wanted.
+
+	@param work  at least relprog_work_size(prog) doubles
+	@param dir   relprog_num_vars(prog) doubles, in relation variable list
+	             order.
+	@return 0 on success, 1 if the residual or the derivative is not finite.
+*/
+
+/* @} */
+
+#endif /* ASC_RELPROG_H */
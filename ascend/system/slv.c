@@ -240,6 +240,7 @@ int slv_destroy(slv_system_t sys)
 
 	DEFINE_SET_INCIDENCES(SLV_FREE_INCIDENCE,SLV_FREE_INCIDENCE)
 
+    if(sys->dof.assign != NULL) ascfree(sys->dof.assign);
     ascfree( (POINTER)sys );
   }
   return ret;
@@ -289,6 +290,26 @@ void slv_set_instance(slv_system_t sys,SlvBackendToken instance)
   }
 }
 
+long int slv_compiler_counter(slv_system_t sys)
+{
+  if (sys == NULL) {
+    ERROR_REPORTER_HERE(ASC_PROG_ERR,"slv_compiler_counter: called with NULL system.");
+    return -1;
+  } else {
+    return sys->compiler_counter;
+  }
+}
+
+void slv_set_compiler_counter(slv_system_t sys,long int counter)
+{
+  if (sys == NULL) {
+    ERROR_REPORTER_HERE(ASC_PROG_ERR,"slv_set_compiler_counter: called with NULL system.");
+    return;
+  } else {
+    sys->compiler_counter = counter;
+  }
+}
+
 dof_t *slv_get_dofdata(slv_system_t sys)
 {
   return &(sys->dof);
@@ -323,6 +323,10 @@ typedef struct dof_data_structure {
   int32 n_fixed;          /**< total fixed solver variables */
   int32 n_unincluded;     /**< total unincluded equations */
   struct slv_reorder_data reorder;
+  int32 *assign;          /**< output assignment of the last BLT partition:
+                               for each rel master index, the master index
+                               of the var assigned to it, or -1 */
+  int32 n_assign;         /**< length of assign */
 } dof_t;
 /**< dof data type */
 
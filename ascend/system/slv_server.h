@@ -84,6 +84,21 @@ extern void slv_set_instance(slv_system_t sys, SlvBackendToken root);
 	NEEDED, GIVEN THE KNOWLEDGE OF THE BACK END IN QUESTION.
 */
 
+extern long int slv_compiler_counter(slv_system_t sys);
+/**<
+	Returns the value of g_compiler_counter recorded when the system
+	was built.
+	@see slv_set_compiler_counter().
+*/
+
+extern void slv_set_compiler_counter(slv_system_t sys, long int counter);
+/**<
+	Records the value of g_compiler_counter at which the instance tree
+	was analysed. system_refresh compares it with the current value to
+	find out whether the tree may have been recompiled since, without
+	looking at any instance the system points to.
+*/
+
 extern void slv_set_num_models(slv_system_t sys, int32 nmod);
 /**<
 	Sets the number of models associated with a system.
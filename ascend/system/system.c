@@ -30,6 +30,7 @@
 
 #include <ascend/compiler/instance_enum.h>
 #include <ascend/compiler/check.h>
+#include <ascend/compiler/instantiate.h>
 
 #include <ascend/linear/mtx.h>
 
@@ -93,6 +94,7 @@ slv_system_t system_build(SlvBackendToken inst){
   }
 
   slv_set_instance(sys,inst);
+  slv_set_compiler_counter(sys,g_compiler_counter);
 
 #if DOTIME
   comptime = tm_cpu_time() - comptime;
@@ -107,6 +109,18 @@ slv_system_t system_build(SlvBackendToken inst){
   return(sys);
 }
 
+int system_refresh(slv_system_t sys){
+  int changed;
+
+  changed = analyze_refresh_problem(sys);
+  if(changed < 0){
+    MSG("System no longer matches its instance; must be rebuilt");
+    return 1;
+  }
+  MSG("System refreshed (%d flags changed)",changed);
+  return 0;
+}
+
 void system_destroy(slv_system_t sys){
 	struct gl_list_t *symbollist;
 	void *l;
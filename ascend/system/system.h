@@ -58,6 +58,22 @@ ASC_DLLSPEC slv_system_t system_build(SlvBackendToken inst);
 	need to be re-called if the a new solver is selected. -- JP
 */
 
+ASC_DLLSPEC int system_refresh(slv_system_t sys);
+/**<
+	Updates a system built by system_build after a METHOD (or the user) has
+	changed only values in its instance tree: 'fixed' and 'included' flags,
+	bounds, nominals. This is much cheaper than destroying and rebuilding the
+	system, and the selected solver is kept. Call slv_presolve afterwards,
+	as for any other change of flags.
+
+	Changes of structure (anything done by the compiler, eg REFINE, or new
+	relations) are not picked up. If the compiler has been run since the
+	system was built (g_compiler_counter has changed), nothing is touched
+	and nonzero is returned; use system_destroy and system_build instead.
+
+	@return 0 on success, nonzero if the system must be rebuilt.
+*/
+
 ASC_DLLSPEC void system_destroy(slv_system_t sys);
 /**<
 	Destroys the latest model formulation.
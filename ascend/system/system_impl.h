@@ -62,6 +62,11 @@ struct system_structure {
 
 	SlvBackendToken instance;	/* should be void * in the most generic case */
 
+	long int compiler_counter;
+	/**< Value of g_compiler_counter when the instance tree was analysed.
+		If it has moved on since, the tree may have been recompiled and
+		the instance pointers held in the lists may be stale. */
+
 	/* All solver handles.  sysI can't be dereferenced outside slvI.c
 	* should be an array of pointers to arrays of the functions provided
 	* by dynamically loaded clients, or at least by the client which this
@@ -0,0 +1,349 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2024 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//*
+	Test of system_refresh: a system refreshed in place after METHODs have
+	changed 'fixed' and 'included' flags must have the same flags and the
+	same block partition as a system built again from the instance tree.
+	Also tests the incremental update of the block partition against the
+	full partition, and that a refresh is refused once the compiler has
+	been run again.
+*/
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <ascend/general/env.h>
+#include <ascend/general/platform.h>
+
+#include <ascend/utilities/ascEnvVar.h>
+#include <ascend/utilities/error.h>
+
+#include <ascend/compiler/ascCompiler.h>
+#include <ascend/compiler/module.h>
+#include <ascend/compiler/parser.h>
+#include <ascend/compiler/library.h>
+#include <ascend/compiler/symtab.h>
+#include <ascend/compiler/simlist.h>
+#include <ascend/compiler/instquery.h>
+#include <ascend/compiler/initialize.h>
+#include <ascend/compiler/name.h>
+
+#include <ascend/system/system.h>
+#include <ascend/system/slv_client.h>
+#include <ascend/system/block.h>
+#include <ascend/system/var.h>
+#include <ascend/system/rel.h>
+
+#include <test/common.h>
+
+/* #define REFRESH_DEBUG */
+#ifdef REFRESH_DEBUG
+# define MSG CONSOLE_DEBUG
+#else
+# define MSG(ARGS...) ((void)0)
+#endif
+
+static void run_method(struct Instance *root, char *method){
+	enum Proc_enum pe;
+	pe = Initialize(root,CreateIdName(AddSymbol(method)),"sim1"
+		,ASCERR,WP_STOPONERR,NULL,NULL
+	);
+	CU_ASSERT(pe==Proc_all_ok);
+}
+
+/**
+	Label each var and rel (by master index) with the number of the block
+	it was put in, or -1.
+*/
+static void block_labels(slv_system_t sys, int32 *vb, int32 *rb){
+	const mtx_block_t *b;
+	struct var_variable **vp;
+	struct rel_relation **rp;
+	int32 k, c;
+
+	for(c = 0; c < slv_get_num_master_vars(sys); ++c)vb[c] = -1;
+	for(c = 0; c < slv_get_num_master_rels(sys); ++c)rb[c] = -1;
+	b = slv_get_solvers_blocks(sys);
+	vp = slv_get_solvers_var_list(sys);
+	rp = slv_get_solvers_rel_list(sys);
+	for(k = 0; k < b->nblocks; ++k){
+		for(c = b->block[k].col.low; c <= b->block[k].col.high; ++c){
+			vb[var_mindex(vp[c])] = k;
+		}
+		for(c = b->block[k].row.low; c <= b->block[k].row.high; ++c){
+			rb[rel_mindex(rp[c])] = k;
+		}
+	}
+}
+
+/**
+	@return 1 if labellings l1 and l2 of n items put the same items
+	together, the block numbers aside.
+*/
+static int same_blocks(int32 n, int32 *l1, int32 *l2, int32 nblocks){
+	int32 *map, *inv, i;
+	int ok = 1;
+
+	map = ASC_NEW_ARRAY(int32,nblocks);
+	inv = ASC_NEW_ARRAY(int32,nblocks);
+	for(i = 0; i < nblocks; ++i)map[i] = inv[i] = -1;
+	for(i = 0; i < n && ok; ++i){
+		if(l1[i] < 0 || l2[i] < 0){
+			ok = (l1[i] == l2[i]);
+		}else if(map[l1[i]] < 0 && inv[l2[i]] < 0){
+			map[l1[i]] = l2[i];
+			inv[l2[i]] = l1[i];
+		}else{
+			ok = (map[l1[i]] == l2[i]);
+		}
+	}
+	ASC_FREE(map);
+	ASC_FREE(inv);
+	return ok;
+}
+
+/**
+	Compare the flags and the partition of the refreshed system with those
+	of a system built from scratch.
+*/
+static void compare_with_rebuild(slv_system_t sys, struct Instance *root
+		, int32 nblocks
+){
+	slv_system_t sys2;
+	struct var_variable **vp, **vp2;
+	struct rel_relation **rp, **rp2;
+	dof_t *d, *d2;
+	int32 nv, nr, c, *vb, *vb2, *rb, *rb2;
+
+	sys2 = system_build(root);
+	CU_ASSERT_FATAL(sys2 != NULL);
+	CU_ASSERT(0 == slv_block_partition(sys2));
+
+	nv = slv_get_num_master_vars(sys);
+	nr = slv_get_num_master_rels(sys);
+	CU_ASSERT_FATAL(nv == slv_get_num_master_vars(sys2));
+	CU_ASSERT_FATAL(nr == slv_get_num_master_rels(sys2));
+
+	vp = slv_get_master_var_list(sys);
+	vp2 = slv_get_master_var_list(sys2);
+	for(c = 0; c < nv; ++c){
+		CU_ASSERT(var_instance(vp[c]) == var_instance(vp2[c]));
+		CU_ASSERT(var_flagbit(vp[c],VAR_FIXED) == var_flagbit(vp2[c],VAR_FIXED));
+	}
+	rp = slv_get_master_rel_list(sys);
+	rp2 = slv_get_master_rel_list(sys2);
+	for(c = 0; c < nr; ++c){
+		CU_ASSERT(rel_instance(rp[c]) == rel_instance(rp2[c]));
+		CU_ASSERT(rel_flagbit(rp[c],REL_INCLUDED) == rel_flagbit(rp2[c],REL_INCLUDED));
+		CU_ASSERT(rel_flagbit(rp[c],REL_INBLOCK) == rel_flagbit(rp2[c],REL_INBLOCK));
+	}
+
+	d = slv_get_dofdata(sys);
+	d2 = slv_get_dofdata(sys2);
+	CU_ASSERT(d->structural_rank == d2->structural_rank);
+	CU_ASSERT(d->n_rows == d2->n_rows);
+	CU_ASSERT(d->n_cols == d2->n_cols);
+	CU_ASSERT(d->n_fixed == d2->n_fixed);
+	CU_ASSERT(d->n_unincluded == d2->n_unincluded);
+
+	MSG("%d blocks after refresh, %d after rebuild"
+		,slv_get_solvers_blocks(sys)->nblocks,slv_get_solvers_blocks(sys2)->nblocks
+	);
+	CU_ASSERT(slv_get_solvers_blocks(sys)->nblocks == nblocks);
+	CU_ASSERT_FATAL(slv_get_solvers_blocks(sys2)->nblocks == nblocks);
+
+	vb = ASC_NEW_ARRAY(int32,nv);
+	vb2 = ASC_NEW_ARRAY(int32,nv);
+	rb = ASC_NEW_ARRAY(int32,nr);
+	rb2 = ASC_NEW_ARRAY(int32,nr);
+	block_labels(sys,vb,rb);
+	block_labels(sys2,vb2,rb2);
+	CU_ASSERT(same_blocks(nv,vb,vb2,nblocks));
+	CU_ASSERT(same_blocks(nr,rb,rb2,nblocks));
+	ASC_FREE(vb);
+	ASC_FREE(vb2);
+	ASC_FREE(rb);
+	ASC_FREE(rb2);
+
+	system_destroy(sys2);
+}
+
+static struct Instance *load_fixfree(void){
+	struct module_t *m;
+	struct Instance *siminst;
+	int status;
+
+	Asc_CompilerInit(1);
+	Asc_PutEnv(ASC_ENV_LIBRARY "=models");
+
+	m = Asc_OpenModule("test/refresh/fixfree.a4c",&status);
+	CU_ASSERT_FATAL(m != NULL);
+	CU_ASSERT(status == 0);
+	CU_ASSERT(0 == zz_parse());
+	CU_ASSERT_FATAL(FindType(AddSymbol("fixfree"))!=NULL);
+
+	siminst = SimsCreateInstance(AddSymbol("fixfree"),AddSymbol("sim1"),e_normal,NULL);
+	CU_ASSERT_FATAL(siminst!=NULL);
+	run_method(GetSimulationRoot(siminst),"on_load");
+	return siminst;
+}
+
+static void unload_fixfree(struct Instance *siminst){
+	system_free_reused_mem();
+	sim_destroy(siminst);
+	Asc_CompilerDestroy();
+}
+
+static void test_fixfree(void){
+	struct Instance *siminst, *root;
+	struct rel_relation **rp;
+	slv_system_t sys;
+
+	siminst = load_fixfree();
+	root = GetSimulationRoot(siminst);
+
+	sys = system_build(root);
+	CU_ASSERT_FATAL(sys != NULL);
+	CU_ASSERT(0 == slv_block_partition(sys));
+	CU_ASSERT(slv_get_solvers_blocks(sys)->nblocks == 40);
+
+	/* x[0] freed, y[20] fixed */
+	for(rp = slv_get_master_rel_list(sys); *rp != NULL; ++rp){
+		rel_set_in_block(*rp,FALSE); /* as the solvers leave them */
+	}
+	run_method(root,"respecify");
+	CU_ASSERT(0 == system_refresh(sys));
+	CU_ASSERT(0 == slv_block_partition(sys));
+	compare_with_rebuild(sys,root,60);
+
+	/* ey[30] unincluded, y[30] fixed, x[0] fixed, y[20] freed */
+	for(rp = slv_get_master_rel_list(sys); *rp != NULL; ++rp){
+		rel_set_in_block(*rp,FALSE);
+	}
+	run_method(root,"drop");
+	CU_ASSERT(0 == system_refresh(sys));
+	CU_ASSERT(0 == slv_block_partition(sys));
+	compare_with_rebuild(sys,root,40);
+
+	system_destroy(sys);
+	unload_fixfree(siminst);
+}
+
+/**
+	After a change of a few fixed flags the BLT partition is updated in
+	place (block_partition_incremental). Its result must match the full
+	partition of the same lists, and leave the same reorder state.
+*/
+static void test_incremental(void){
+	struct Instance *siminst;
+	slv_system_t sys;
+	dof_t *d;
+	int32 nv, nr, nblocks, rank, ncols, nfixed, *vb, *vb2, *rb, *rb2;
+
+	siminst = load_fixfree();
+	sys = system_build(GetSimulationRoot(siminst));
+	CU_ASSERT_FATAL(sys != NULL);
+	CU_ASSERT(0 == slv_block_partition(sys));
+	nv = slv_get_num_master_vars(sys);
+	nr = slv_get_num_master_rels(sys);
+
+	/* as left by a solver which has reordered within the blocks */
+	d = slv_get_dofdata(sys);
+	d->reorder.basis_selection = 1;
+	d->reorder.block_reordering = 1;
+
+	run_method(GetSimulationRoot(siminst),"respecify");
+	CU_ASSERT(0 == system_refresh(sys));
+	CU_ASSERT(0 == slv_block_partition(sys));
+	CU_ASSERT(d->reorder.partition == 1);
+	CU_ASSERT(d->reorder.basis_selection == 0);
+	CU_ASSERT(d->reorder.block_reordering == 0);
+
+	nblocks = slv_get_solvers_blocks(sys)->nblocks;
+	rank = d->structural_rank;
+	ncols = d->n_cols;
+	nfixed = d->n_fixed;
+	CU_ASSERT(nblocks == 60);
+	vb = ASC_NEW_ARRAY(int32,nv);
+	rb = ASC_NEW_ARRAY(int32,nr);
+	block_labels(sys,vb,rb);
+
+	/* now the full partition of the same lists */
+	d->reorder.partition = 0;
+	CU_ASSERT(0 == slv_block_partition(sys));
+	CU_ASSERT_FATAL(slv_get_solvers_blocks(sys)->nblocks == nblocks);
+	CU_ASSERT(d->structural_rank == rank);
+	CU_ASSERT(d->n_cols == ncols);
+	CU_ASSERT(d->n_fixed == nfixed);
+	vb2 = ASC_NEW_ARRAY(int32,nv);
+	rb2 = ASC_NEW_ARRAY(int32,nr);
+	block_labels(sys,vb2,rb2);
+	CU_ASSERT(same_blocks(nv,vb,vb2,nblocks));
+	CU_ASSERT(same_blocks(nr,rb,rb2,nblocks));
+	ASC_FREE(vb);
+	ASC_FREE(vb2);
+	ASC_FREE(rb);
+	ASC_FREE(rb2);
+
+	system_destroy(sys);
+	unload_fixfree(siminst);
+}
+
+/**
+	Once the compiler has been run, the system may point at instances that
+	no longer exist. system_refresh must refuse, and leave the flags alone.
+*/
+static void test_recompiled(void){
+	struct Instance *siminst, *siminst2;
+	struct var_variable **vp;
+	slv_system_t sys;
+	int32 c, nv, *fixed;
+
+	siminst = load_fixfree();
+	sys = system_build(GetSimulationRoot(siminst));
+	CU_ASSERT_FATAL(sys != NULL);
+	CU_ASSERT(0 == system_refresh(sys));
+
+	vp = slv_get_master_var_list(sys);
+	nv = slv_get_num_master_vars(sys);
+	fixed = ASC_NEW_ARRAY(int32,nv);
+	for(c = 0; c < nv; ++c){
+		fixed[c] = var_flagbit(vp[c],VAR_FIXED);
+	}
+
+	run_method(GetSimulationRoot(siminst),"respecify");
+	siminst2 = SimsCreateInstance(AddSymbol("fixfree"),AddSymbol("sim2"),e_normal,NULL);
+	CU_ASSERT_FATAL(siminst2 != NULL);
+	CU_ASSERT(0 != system_refresh(sys));
+	for(c = 0; c < nv; ++c){
+		CU_ASSERT(fixed[c] == var_flagbit(vp[c],VAR_FIXED));
+	}
+	ASC_FREE(fixed);
+
+	system_destroy(sys);
+	sim_destroy(siminst2);
+	unload_fixfree(siminst);
+}
+
+/*===========================================================================*/
+/* Registration information */
+
+#define TESTS(T) \
+	T(fixfree) \
+	T(incremental) \
+	T(recompiled)
+
+REGISTER_TESTS_SIMPLE(system_refresh, TESTS)
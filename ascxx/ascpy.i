@@ -15,6 +15,7 @@
 #include "compiler.h"
 #include "type.h"
 #include "instance.h"
+#include "instancevalues.h"
 #include "variable.h"
 #include "relation.h"
 #include "name.h"
@@ -535,6 +536,85 @@ public:
 	%}
 }
 
+/*
+	Bulk access to real values. The buffer is shared with Python without
+	copying. A memoryview holds a reference to the object exporting its
+	buffer, and the exporter here holds a reference to the Python
+	InstanceValues object which owns the memory, so the memory lasts as
+	long as any view of it.
+*/
+%{
+typedef struct{
+	PyObject_HEAD
+	PyObject *owner;
+	double *data;
+	Py_ssize_t len;
+} InstanceValuesBuffer;
+
+static int InstanceValuesBuffer_getbuffer(PyObject *self, Py_buffer *view, int flags){
+	static double empty;
+	InstanceValuesBuffer *b = (InstanceValuesBuffer *)self;
+	return PyBuffer_FillInfo(view,self,b->data ? (void *)b->data : (void *)&empty
+		,b->len,0,flags
+	);
+}
+
+static void InstanceValuesBuffer_dealloc(PyObject *self){
+	Py_XDECREF(((InstanceValuesBuffer *)self)->owner);
+	PyObject_Del(self);
+}
+
+static PyBufferProcs InstanceValuesBuffer_procs = {InstanceValuesBuffer_getbuffer, NULL};
+static PyTypeObject InstanceValuesBufferType = {PyVarObject_HEAD_INIT(NULL,0)};
+
+static PyObject *InstanceValuesBuffer_new(PyObject *owner, double *data, Py_ssize_t len){
+	InstanceValuesBuffer *b;
+	if(InstanceValuesBufferType.tp_name == NULL){
+		InstanceValuesBufferType.tp_name = "ascpy.InstanceValuesBuffer";
+		InstanceValuesBufferType.tp_basicsize = sizeof(InstanceValuesBuffer);
+		InstanceValuesBufferType.tp_flags = Py_TPFLAGS_DEFAULT;
+		InstanceValuesBufferType.tp_dealloc = InstanceValuesBuffer_dealloc;
+		InstanceValuesBufferType.tp_as_buffer = &InstanceValuesBuffer_procs;
+		if(PyType_Ready(&InstanceValuesBufferType) < 0){
+			InstanceValuesBufferType.tp_name = NULL;
+			return NULL;
+		}
+	}
+	b = PyObject_New(InstanceValuesBuffer,&InstanceValuesBufferType);
+	if(b == NULL)return NULL;
+	Py_INCREF(owner);
+	b->owner = owner;
+	b->data = data;
+	b->len = len;
+	return (PyObject *)b;
+}
+%}
+%ignore InstanceValues::data;
+%include "instancevalues.h"
+%extend InstanceValues{
+	PyObject *_buffer(PyObject *owner){
+		PyObject *b, *v;
+		b = InstanceValuesBuffer_new(owner,self->data(),self->size() * sizeof(double));
+		if(b == NULL)return NULL;
+		v = PyMemoryView_FromObject(b);
+		Py_DECREF(b);
+		return v;
+	}
+	unsigned long __len__(){
+		return self->size();
+	}
+	%pythoncode %{
+		def buffer(self):
+			"""Return a writable memoryview of doubles sharing the value buffer.
+
+			Call gather() to refresh it from the model, and scatter() to write
+			it back. The view keeps this object alive. It can be used without
+			copying by, for example, numpy.frombuffer.
+			"""
+			return self._buffer(self).cast('d')
+	%}
+}
+
 /*
 	This 'registry' thing is a bit of a hack that allows interface pointers to 
 	be registered with libascend so that they can be accessed from external
@@ -60,6 +60,22 @@ Compiler::setUseRelationSharing(const bool &use_relation_sharing){
 	}
 }
 
+const bool
+Compiler::getUseModelCache() const{
+	if(g_use_modelcache){
+		return true;
+	}
+	return false;
+}
+
+void
+Compiler::setUseModelCache(const bool &use_model_cache){
+	g_use_modelcache = 0;
+	if(use_model_cache){
+		g_use_modelcache = 1;
+	}
+}
+
 void
 Compiler::setBinaryCompilation(const bool &use_bintoken){
 	this->use_bintoken = use_bintoken;
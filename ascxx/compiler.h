@@ -45,6 +45,9 @@ public:
 	const bool getUseRelationSharing() const;
 	void setUseRelationSharing(const bool&);
 
+	const bool getUseModelCache() const;
+	void setUseModelCache(const bool&);
+
 	void setBinaryCompilation(const bool&);
 
 	void setVerbosity(const int&);
@@ -36,6 +36,7 @@ IncidencePoint::IncidencePoint() : row(-1), col(-1), type(IM_NULL){
 IncidenceMatrix::IncidenceMatrix(Simulation &sim) : sim(sim){
 	// constructor
 	is_built = FALSE;
+	sysid = 0;
 }
 
 IncidenceMatrix::~IncidenceMatrix(){
@@ -51,6 +52,7 @@ IncidenceMatrix::buildPlotData(){
 	//cerr << "BUILDPLOTDATA" << endl;
 
 	slv_system_t sys = sim.getSystem();
+	sysid = slv_serial_id(sys);
 
 	//cerr << "GOT SYSTEM DATA" << endl;
 
@@ -98,6 +100,17 @@ IncidenceMatrix::buildPlotData(){
 	is_built = TRUE;
 }
 
+/**
+	Throw if the Simulation has been rebuilt since the data was collected, as
+	it then refers to vars and rels that no longer exist.
+*/
+void
+IncidenceMatrix::checkSystem() const{
+	if(is_built && (sim.sys==NULL || slv_serial_id(sim.sys)!=sysid)){
+		throw runtime_error("Simulation has been rebuilt: create a new IncidenceMatrix");
+	}
+}
+
 const int &
 IncidenceMatrix::getNumRows() const{
 	return i.nprow;
@@ -114,12 +127,14 @@ IncidenceMatrix::getIncidenceData(){
 	if(!is_built){
 		buildPlotData();
 	}
+	checkSystem();
 	return data;
 }
 
 const Variable
 IncidenceMatrix::getVariable(const int &col) const{
 	if(!is_built)throw runtime_error("Not built");
+	checkSystem();
 	if(col < 0 || col >= getNumCols())throw range_error("Column out of range");
 	int vindex = i.pc2v[col];
 	struct var_variable *var = i.vlist[vindex];
@@ -130,6 +145,7 @@ IncidenceMatrix::getVariable(const int &col) const{
 const Relation
 IncidenceMatrix::getRelation(const int &row) const{
 	if(!is_built)throw runtime_error("Not built");
+	checkSystem();
 	if(row < 0 || row >= getNumRows())throw range_error("Row out of range");
 	int rindex = i.pr2e[row];
 	struct rel_relation *rel = i.rlist[rindex];
@@ -139,6 +155,7 @@ IncidenceMatrix::getRelation(const int &row) const{
 const int
 IncidenceMatrix::getBlockRow(const int &row) const{
 	if(!is_built)throw runtime_error("Not built");
+	checkSystem();
 	if(row < 0 || row >= getNumRows())throw range_error("Row out of range");
 	const mtx_block_t *bb = slv_get_solvers_blocks(sim.getSystem());
 	for(int i=0; i < bb->nblocks; ++i){
@@ -157,6 +174,7 @@ IncidenceMatrix::getBlockRow(const int &row) const{
 const vector<int>
 IncidenceMatrix::getBlockLocation(const int &block) const{
 	if(!is_built)throw runtime_error("Not built");
+	checkSystem();
 	const mtx_block_t *bb = slv_get_solvers_blocks(sim.getSystem());
 	if(block < 0 || block >= bb->nblocks){
 		throw range_error("Invalid block number");
@@ -172,6 +190,7 @@ IncidenceMatrix::getBlockLocation(const int &block) const{
 const BlockStatusType
 IncidenceMatrix::getBlockStatus(const int &block) const{
 	if(!is_built)throw runtime_error("Not build");
+	checkSystem();
 	SolverStatus st;
 	st.getSimulationStatus(sim);
 	
@@ -193,6 +212,7 @@ IncidenceMatrix::getBlockVars(const int &block){
 	if(!is_built){
 		buildPlotData();
 	}
+	checkSystem();
 	vector<Variable> v;
 	const mtx_block_t *bb = slv_get_solvers_blocks(sim.getSystem());
 	if(block < 0 || block >= bb->nblocks){
@@ -213,6 +233,7 @@ IncidenceMatrix::getBlockRels(const int &block){
 	if(!is_built){
 		buildPlotData();
 	}
+	checkSystem();
 	vector<Relation> v;
 	const mtx_block_t *bb = slv_get_solvers_blocks(sim.getSystem());
 	if(block < 0 || block >= bb->nblocks){
@@ -233,6 +254,7 @@ IncidenceMatrix::getNumBlocks(){
 	if(!is_built){
 		buildPlotData();
 	}
+	checkSystem();
 	const mtx_block_t *bb = slv_get_solvers_blocks(sim.getSystem());
 	return bb->nblocks;
 }
@@ -46,13 +46,14 @@ class IncidenceMatrix{
 
 private:
 	Simulation &sim;
-	slv_system_t sys;
+	unsigned sysid; /**< slv_serial_id of the system the data came from */
 
 	std::vector<IncidencePoint> data;
 	incidence_vars_t i;
 	bool is_built;
 
 	void buildPlotData();
+	void checkSystem() const;
 public:
 	explicit IncidenceMatrix(Simulation &sim);
 	~IncidenceMatrix();
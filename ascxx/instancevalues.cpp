@@ -0,0 +1,181 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* needs to be first so that <Python.h> gets included before <iostream> */
+#include "library.h"
+
+#include "instancevalues.h"
+
+extern "C"{
+#include <ascend/general/platform.h>
+#include <ascend/compiler/instance_enum.h>
+#include <ascend/compiler/instquery.h>
+#include <ascend/compiler/parentchild.h>
+#include <ascend/compiler/atomvalue.h>
+#include <ascend/compiler/qlfdid.h>
+}
+
+#include <algorithm>
+#include <stdexcept>
+#include <sstream>
+
+using namespace std;
+
+InstanceValues::InstanceValues(){
+	// empty
+}
+
+/**
+	Collect the real-valued elements of an array instance, in child
+	order. Elements that are themselves arrays are flattened.
+*/
+InstanceValues::InstanceValues(const Instanc &array){
+	struct Instance *i = array.getInternalType();
+	if(!array.isArray()){
+		stringstream ss;
+		ss << "Instance '" << array.getName() << "' is not an array";
+		throw runtime_error(ss.str());
+	}
+	addArray(i);
+	buf.resize(insts.size());
+	gather();
+}
+
+/**
+	Find each of the named instances, relative to 'root', using the same
+	syntax as in METHODS, eg "x", "y[3]" or "a.b[1][2].c". If 'root' is a
+	simulation, names are relative to its model.
+*/
+InstanceValues::InstanceValues(const Instanc &root, const vector<string> &names){
+	struct Instance *r = root.getInternalType();
+	if(InstanceKind(r)==SIM_INST){
+		r = GetSimulationRoot(r);
+	}
+	insts.reserve(names.size());
+	for(vector<string>::const_iterator n=names.begin(); n!=names.end(); ++n){
+		g_relative_inst = r;
+		if(Asc_QlfdidSearch3(n->c_str(),1) || g_search_inst==NULL){
+			stringstream ss;
+			ss << "Instance '" << *n << "' not found in '" << root.getName() << "'";
+			throw runtime_error(ss.str());
+		}
+		add(g_search_inst,*n);
+	}
+	buf.resize(insts.size());
+	gather();
+}
+
+InstanceValues::~InstanceValues(){
+	// nothing: the instances belong to the simulation
+}
+
+void
+InstanceValues::addArray(struct Instance *i){
+	unsigned long c, len = NumberChildren(i);
+	struct Instance *ch;
+	for(c=1; c<=len; ++c){
+		ch = InstanceChild(i,c);
+		if(ch==NULL)continue;
+		if(InstanceKind(ch) & IARR){
+			addArray(ch);
+		}else{
+			stringstream ss;
+			ss << "element " << c << " of array";
+			add(ch,ss.str());
+		}
+	}
+}
+
+void
+InstanceValues::add(struct Instance *i, const string &name){
+	switch(InstanceKind(i)){
+		case REAL_INST:
+		case REAL_ATOM_INST:
+			insts.push_back(i);
+			return;
+		case REAL_CONSTANT_INST:{
+			/* already assigned, so scatter() could not set it */
+			stringstream ss;
+			ss << "Instance '" << name << "' is a constant";
+			throw runtime_error(ss.str());
+		}
+		default:{
+			stringstream ss;
+			ss << "Instance '" << name << "' is not real-valued";
+			throw runtime_error(ss.str());
+		}
+	}
+}
+
+const unsigned long
+InstanceValues::size() const{
+	return insts.size();
+}
+
+Instanc
+InstanceValues::getInstance(const unsigned long &index) const{
+	if(index >= insts.size()){
+		throw range_error("InstanceValues index out of range");
+	}
+	return Instanc(insts[index]);
+}
+
+/// Copy the current values of all the instances into the buffer.
+void
+InstanceValues::gather(){
+	unsigned long k, n = insts.size();
+	for(k=0; k<n; ++k){
+		buf[k] = RealAtomValue(insts[k]);
+	}
+}
+
+/// Assign the values in the buffer to the instances, as setRealValue would.
+void
+InstanceValues::scatter(const unsigned &depth){
+	unsigned long k, n = insts.size();
+	for(k=0; k<n; ++k){
+		SetRealAtomValue(insts[k],buf[k],depth);
+	}
+}
+
+/**
+	The buffer, of size() doubles. Its address does not change for the
+	life of the object.
+*/
+double *
+InstanceValues::data(){
+	return buf.empty() ? NULL : &buf[0];
+}
+
+/// Gather the values and return a copy of them.
+const vector<double>
+InstanceValues::getValues(){
+	gather();
+	return buf;
+}
+
+/// Copy the given values into the buffer and scatter them.
+void
+InstanceValues::setValues(const vector<double> &values, const unsigned &depth){
+	if(values.size() != buf.size()){
+		stringstream ss;
+		ss << "Expected " << buf.size() << " values, got " << values.size();
+		throw runtime_error(ss.str());
+	}
+	copy(values.begin(),values.end(),buf.begin());
+	scatter(depth);
+}
@@ -0,0 +1,66 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2026 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ASCXX_INSTANCEVALUES_H
+#define ASCXX_INSTANCEVALUES_H
+
+#include "instance.h"
+
+#include <string>
+#include <vector>
+
+/**
+	Bulk access to the values of many real-valued instances.
+
+	The instances are found once, when the object is created, either as the
+	real-valued elements of an array instance (in child order, nested
+	arrays flattened) or from a list of names relative to some instance.
+	Real constants are not accepted, since their values cannot be set.
+	After that, 'gather' copies all their values into a contiguous buffer
+	and 'scatter' writes the buffer back, each in a single call, so that a
+	script moving many values does not pay for a wrapper object and a
+	function call per value.
+
+	The buffer is allocated once and never moves, so it may be shared with
+	Python (see 'buffer' in ascpy.i) or other code without copying, as long
+	as this object is kept alive. Like Instanc, the object holds pointers
+	into the instance tree and must not outlive the simulation.
+*/
+class InstanceValues{
+private:
+	std::vector<struct Instance *> insts;
+	std::vector<double> buf;
+	void addArray(struct Instance *i);
+	void add(struct Instance *i, const std::string &name);
+public:
+	InstanceValues();
+	InstanceValues(const Instanc &array);
+	InstanceValues(const Instanc &root, const std::vector<std::string> &names);
+	~InstanceValues();
+
+	const unsigned long size() const;
+	Instanc getInstance(const unsigned long &index) const;
+
+	void gather();
+	void scatter(const unsigned &depth=0);
+
+	double *data();
+	const std::vector<double> getValues();
+	void setValues(const std::vector<double> &values, const unsigned &depth=0);
+};
+
+#endif
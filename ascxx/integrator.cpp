@@ -21,6 +21,7 @@ Integrator::Integrator(Simulation &simulation)
 {
 	// create the C-level object
 	this->blsys = integrator_new(simulation.getSystem(),simulation.getModel().getInternalType());
+	sysid = slv_serial_id(simulation.getSystem());
 
 	samplelist = NULL;
 
@@ -46,6 +47,17 @@ Integrator::~Integrator(){
 	if(samplelist)samplelist_free(samplelist);
 }
 
+/**
+	Throw if the Simulation has been rebuilt since this Integrator was made,
+	as blsys then refers to a system that no longer exists.
+*/
+void
+Integrator::checkSystem() const{
+	if(simulation.sys==NULL || slv_serial_id(simulation.sys)!=sysid){
+		throw runtime_error("Simulation has been rebuilt: create a new Integrator");
+	}
+}
+
 SolverParameters
 Integrator::getParameters() const{
 	SolverParameters params;
@@ -89,6 +101,7 @@ Integrator::getNumSteps(){
 */
 void
 Integrator::findIndependentVar(){
+	checkSystem();
 	int res = integrator_find_indep_var(blsys);
 
 	if(res){
@@ -101,6 +114,7 @@ Integrator::findIndependentVar(){
 void
 Integrator::analyse(){
 
+	checkSystem();
 	int res;
 	/*
 		Note, we never need to call analyze_make_system in any of the Integrator
@@ -128,6 +142,7 @@ Integrator::analyse(){
 */
 void
 Integrator::solve(){
+	checkSystem();
 	// clear previous values and reserve space for new ones in order to avoid memory reallocation
 	obs.clear();
 	obs.reserve((unsigned long) getNumSteps());
@@ -160,6 +175,7 @@ Integrator::solve(){
 
 void
 Integrator::writeMatrix(char *fname,const char *type) const{
+	checkSystem();
 	FILE *fp = fopen(fname,"w");
 	if(integrator_write_matrix(this->blsys, fp, type)){
 		fclose(fp);
@@ -170,6 +186,7 @@ Integrator::writeMatrix(char *fname,const char *type) const{
 
 void
 Integrator::writeDebug(char *fname) const{
+	checkSystem();
 	FILE *fp = fopen(fname,"w");
 	if(!fp)throw runtime_error("Failed to open file for writing");
 	if(integrator_debug(this->blsys, fp)){
@@ -261,6 +278,7 @@ Integrator::setLogTimesteps(UnitsM units, double start, double end, unsigned lon
 
 vector<double>
 Integrator::getCurrentObservations(){
+	checkSystem();
 	double *d = ASC_NEW_ARRAY(double,getNumObservedVars());
 	integrator_get_observations(blsys,d);
 	vector<double> v=vector<double>(d,d+getNumObservedVars());
@@ -278,12 +296,14 @@ Integrator::saveObservations() {
 
 Variable
 Integrator::getObservedVariable(const long &i){
+	checkSystem();
 	var_variable *v = integrator_get_observed_var(blsys,i);
 	return Variable(&simulation,v);
 }
 
 Variable
 Integrator::getIndependentVariable(){
+	checkSystem();
 	var_variable *v = integrator_get_independent_var(blsys);
 	if(v==NULL){
 		throw runtime_error("independent variable is null");
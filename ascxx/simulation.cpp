@@ -80,6 +80,7 @@ extern "C"{
 Simulation::Simulation(Instance *i, const SymChar &name) : Instanc(i, name), simroot(GetSimulationRoot(i),SymChar("simroot")){
 	MSG("Created simulation at %p",this);	
 	sys = NULL;
+	sing = NULL;
 	solverhooks = NULL;
 	//is_built = false;
 	// Create an Instance object for the 'simulation root' (we'll call
@@ -598,16 +599,27 @@ Simulation::getSolver() const{
 
 /**
 	Build the system (send it to the solver)
+
+	If the system is already built, it is refreshed to pick up any fixed or
+	included flags changed since. If the instance tree has been recompiled
+	since, the system is left alone and an exception is thrown: other objects
+	(Integrator, IncidenceMatrix) may be holding on to it, so only the caller
+	can decide to call rebuild().
 */
 void
 Simulation::build(){
 	if(sys){
-		//CONSOLE_DEBUG("System is already built (%p)",sys);
-		return;
-	}else{
-		MSG("Building system...");
+		/* pick up any fixed/included flags changed since it was built */
+		if(!system_refresh(sys)){
+			//CONSOLE_DEBUG("System is already built (%p)",sys);
+			return;
+		}
+		throw runtime_error("System no longer matches the instance tree;"
+			" call Simulation.rebuild()");
 	}
 
+	MSG("Building system...");
+
 	if(simroot.getKind() != MODEL_INST){
 		throw runtime_error("Simulation does not contain a MODEL_INST");
 	}
@@ -626,6 +638,72 @@ Simulation::build(){
 	MSG("System built OK");
 }
 
+/**
+	Copy the values of the parameters in 'from' to those of the same name in
+	'to'. The two sets belong to the same solver, but to different systems, so
+	the parameter arrays themselves can't be shared.
+*/
+static void
+copy_parameter_values(slv_parameters_t *to, const slv_parameters_t *from){
+	for(int k=0; k<from->num_parms; ++k){
+		const struct slv_parameter *a = &(from->parms[k]);
+		int j = slv_param_lookup(to,a->name);
+		if(j<0 || to->parms[j].type != a->type)continue;
+		struct slv_parameter *b = &(to->parms[j]);
+		switch(a->type){
+			case int_parm: b->info.i.value = a->info.i.value; break;
+			case bool_parm: b->info.b.value = a->info.b.value; break;
+			case real_parm: b->info.r.value = a->info.r.value; break;
+			case char_parm: slv_set_char_parameter(&(b->info.c.value),a->info.c.value); break;
+		}
+	}
+	to->tolerance = from->tolerance;
+	to->ignore_bounds = from->ignore_bounds;
+	to->partition = from->partition;
+	to->time_limit = from->time_limit;
+	to->rho = from->rho;
+	to->iteration_limit = from->iteration_limit;
+	to->factor_option = from->factor_option;
+}
+
+/**
+	Throw away the system and build it again from the instance tree, for use
+	after the tree has been recompiled (see build()). The selected solver and
+	its parameter values are carried over to the new system.
+
+	Integrator and IncidenceMatrix objects made from the old system, and any
+	Variable or Relation taken from them, refer to the old system and must
+	not be used afterwards; the Integrator and IncidenceMatrix will throw if
+	they are. Other copies of this Simulation must not be used either.
+*/
+void
+Simulation::rebuild(){
+	slv_system_t old = sys;
+	sys = NULL;
+	try{
+		build();
+	}catch(runtime_error &e){
+		sys = old;
+		throw;
+	}
+
+	if(old){
+		int index = slv_get_selected_solver(old);
+		if(index >= 0 && slv_select_solver(sys,index) == index){
+			slv_parameters_t pold, pnew;
+			slv_get_parameters(old,&pold);
+			slv_get_parameters(sys,&pnew);
+			copy_parameter_values(&pnew,&pold);
+			slv_set_parameters(sys,&pnew);
+		}
+		system_destroy(old);
+	}
+	if(sing){
+		delete sing;
+		sing = NULL;
+	}
+}
+
 
 //------------------------------------------------------------------------------
 // SOLVER CONFIGURATION PARAMETERS
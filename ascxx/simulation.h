@@ -99,6 +99,7 @@ public:
 	void checkDimensions();
 
 	void build();
+	void rebuild();
 
 	// checks of solver lists/structure
 	enum StructuralStatus checkDoF() const;
@@ -261,6 +261,7 @@ int datareader_acdb_eof(DataReader *d){
 	/* set the number of inputs and outputs */
 	d->ninputs = 1;
 	d->noutputs = 5;
+	d->nmaxoutputs = 5;
 	return 0;
 }
 
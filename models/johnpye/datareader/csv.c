@@ -94,6 +94,8 @@ int datareader_csv_header(DataReader *d){
 int datareader_csv_eof(DataReader *d){
     if(feof(d->f)){
         MSG("REACHED END OF FILE");
+        /* ndata from the header count includes any header line */
+        if(d->i < d->ndata) d->ndata = d->i;
         MSG("Read: %d rows",d->ndata);
         return 1;
     }
@@ -20,6 +20,7 @@
 #include <string.h>
 
 #include <ascend/general/platform.h>
+#include <ascend/general/ascMalloc.h>
 #include <ascend/general/panic.h>
 #include <ascend/utilities/error.h>
 
@@ -233,6 +234,61 @@ int asc_datareader_prepare(struct BBoxInterp *slv_interp,
 	return 0;
 }
 
+/**
+	Batch evaluation, for arrayed models where the INPUT is a list of n
+	times and the OUTPUTs are lists of n values each, eg
+
+		filereader:datareader(
+			t[1..n] : INPUT;
+			Gb[1..n], T[1..n] : OUTPUT;
+			params : DATA
+		);
+
+	All n points are evaluated in one pass of datareader_batch instead of
+	n separate calls. Output i at t[k] is outputs[i*n + k], as laid out by
+	the compiler for the above argument lists. Only the 'diagonal' entries
+	d(outputs[i*n+k])/d(t[k]) of the jacobian are nonzero.
+
+	@return 0 on success
+*/
+static int asc_datareader_calc_batch(struct BBoxInterp *slv_interp
+		, DataReader *d, int ninputs, int noutputs
+		, double *inputs, double *outputs, double *jacobian
+){
+	int i, k, n = ninputs;
+	double *deriv;
+
+	switch(slv_interp->task){
+		case bb_func_eval:
+			MSG("DATA READER BATCH EVALUATION (%d points)",n);
+			if(datareader_batch(d,n,inputs,outputs,NULL)){
+				CONSOLE_DEBUG("Datareader batch evaluation error");
+				return 1;
+			}
+			return 0;
+		case bb_deriv_eval:
+			MSG("DATA READER BATCH DERIVATIVE (%d points)",n);
+			deriv = ASC_NEW_ARRAY(double,noutputs);
+			if(datareader_batch(d,n,inputs,NULL,deriv)){
+				MSG("Datareader batch derivative evaluation error");
+				ASC_FREE(deriv);
+				return 1;
+			}
+			/* jacobian[row*ninputs + col], row = i*n + k, col = k */
+			memset(jacobian,0,sizeof(double)*noutputs*ninputs);
+			for(i=0; i < noutputs/n; ++i){
+				for(k=0; k < n; ++k){
+					jacobian[(size_t)(i*n + k)*ninputs + k] = deriv[i*n + k];
+				}
+			}
+			ASC_FREE(deriv);
+			return 0;
+		default:
+			CONSOLE_DEBUG("UNHANDLED REQUEST");
+			return 1;
+	}
+}
+
 /* return 0 on success */
 int asc_datareader_calc(struct BBoxInterp *slv_interp,
 		int ninputs, int noutputs,
@@ -248,6 +304,14 @@ int asc_datareader_calc(struct BBoxInterp *slv_interp,
 		return 1;
 	}
 
+	if(ninputs > datareader_num_inputs(d)
+		&& noutputs == ninputs * datareader_num_outputs(d)
+	){
+		return asc_datareader_calc_batch(slv_interp, d, ninputs, noutputs
+			, inputs, outputs, jacobian
+		);
+	}
+
 	if(ninputs!=datareader_num_inputs(d)){
 		ERROR_REPORTER_HERE(ASC_USER_ERROR
 			,"Invalid number of inputs, expected %d but received %d"
@@ -286,7 +350,7 @@ int asc_datareader_calc(struct BBoxInterp *slv_interp,
 			return 0; /* success */
 		case bb_deriv_eval:
 			MSG("DATA READER DERIVATIVE");
-			if(datareader_deriv(d,inputs,outputs)){
+			if(datareader_deriv(d,inputs,jacobian)){
 				MSG("Datareader derivative evaluation error");
 				return 1;
 			}
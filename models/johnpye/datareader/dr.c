@@ -24,6 +24,7 @@
 #include "acdb.h"
 #include "csv.h"
 #include "ee.h"
+#include "drcache.h"
 
 #include <ascend/utilities/config.h>
 #include <ascend/general/ospath.h>
@@ -73,9 +74,12 @@ DataReader *datareader_new(const char *fn, int noutputs) {
 
     d = ASC_NEW(DataReader);
     d->fn = fn;
+    d->format = NULL;
     d->fp = NULL;
     d->f = NULL;
+    d->data = NULL;
     d->noutputs = noutputs; //maybe this is not the right place to put this!
+    d->nmaxoutputs = 0;
 
     //create a data allocation for the parameter list
     d->cols = ASC_NEW_ARRAY(int,noutputs);
@@ -254,6 +258,7 @@ int datareader_set_format(DataReader *d, const char *format) {
         return 1;
     }
 
+    d->format = fmts[found]; /* string literal, so safe to keep */
     return 0;
 }
 
@@ -296,6 +301,11 @@ int datareader_searchpath_test(struct FilePath *path, void *searchdata){
 
 /**
 	Initialise the datareader: open the file, check the number of columns, etc.
+
+	If cache files are enabled (see drcache.h) and an up to date binary cache
+	of the file exists, the data is loaded from there and the file is not
+	parsed. Otherwise the file is parsed by the format handler, and the cache
+	is written if enabled.
 	@return 0 on success
 
 	@TODO search for the file in the ASCENDLIBRARY if not found immediately
@@ -353,6 +363,16 @@ int datareader_init(DataReader *d){
             return 1;
         }
     }
+    if(ospath_stat(d->fp, &s)){
+        ERROR_REPORTER_HERE(ASC_USER_ERROR, "The file '%s' cannot be accessed.", d->fn);
+        return 1;
+    }
+
+    if(0 == datareader_cache_load(d, &s)){
+        MSG("Data loaded from cache");
+        goto loaded;
+    }
+
     MSG("About to open the data file");
     d->f = ospath_fopen(d->fp, "r");
     if(d->f == NULL){
@@ -384,6 +404,11 @@ int datareader_init(DataReader *d){
 	d->f = NULL;
     MSG("Closed file");
 
+    if(0 == datareader_cache_build(d)){
+        datareader_cache_save(d, &s);
+    }
+
+loaded:
     d->i = 0; /* set current position to zero */
 
     /*	these values are set to ensure that the polynomial coefficients
@@ -437,39 +462,113 @@ int datareader_num_outputs(const DataReader *d){
 }
 
 
+/** @return independent variable at data point i, leaving d->i == i */
+static double datareader_indep_at(DataReader *d, int i){
+    double t;
+    d->i = i;
+    (*d->indepfn)(d, &t);
+    return t;
+}
+
+/**
+	Find the interval of the data containing t, starting from the interval
+	found last time (d->i). The search gallops away from d->i in steps of
+	1, 2, 4, ... until t is bracketed, then bisects, so successive calls at
+	nearby t cost O(1) and arbitrary jumps cost O(log n).
+
+	On return, d->i is the index of the end of the interval, so that
+	t1 = t[d->i-1] <= t < t2 = t[d->i]. Values before the first data point
+	are extrapolated from the first interval.
+	@return 0 on success, 1 if t is at or beyond the last data point.
+*/
 int datareader_locate(DataReader *d, double t, double *t1, double *t2){
-    (*d->indepfn)(d, t1);
-    if(*t1 > t && d->i > 0){
-        /* start of current interval is too late */
-        do{
-            --(d->i);
-            (*d->indepfn)(d, t1);
-            /*CONSOLE_DEBUG("STEPPING BACK (d->i = %d currently), t1=%lf",d->i, *t1); */
-        }while (*t1 > t && d->i > 0);
-    }
-    /* now either d->i==0 or t1 < t*/
-    /* CONSOLE_DEBUG("d->i==%d, t1=%lf",d->i,*t1); */
-    ++d->i;
-    (*d->indepfn)(d, t2);
-    if(*t2 <= t){
-        /* end of current interface is too early */
-        do {
-            /* CONSOLE_DEBUG("STEPPING FORWARD (d->i = %d currently), t1=%lf, t2=%lf",d->i,*t1,*t2); */
-            (*d->indepfn)(d, t1);
-            ++(d->i);
-            (*d->indepfn)(d, t2);
-        } while (*t2 < t && d->i < d->ndata);
+    int n = d->ndata;
+    int lo, hi, mid, step;
+
+    if(n < 2){
+        return 1;
+    }
+
+    /* start from the last interval found, clamped in case it was out of range */
+    hi = d->i;
+    if(hi < 1) hi = 1;
+    if(hi > n - 1) hi = n - 1;
+
+    if(datareader_indep_at(d, hi - 1) <= t){
+        /* gallop forward: invariant t[lo] <= t, and t[hi] > t unless hi == n */
+        lo = hi - 1;
+        step = 1;
+        while(hi < n && datareader_indep_at(d, hi) <= t){
+            lo = hi;
+            hi = (n - lo > step) ? lo + step : n;
+            step *= 2;
+        }
+    }else{
+        /* gallop backward: invariant t[hi] > t, and t[lo] <= t unless lo == -1 */
+        hi = hi - 1;
+        step = 1;
+        lo = hi - 1;
+        while(lo >= 0 && datareader_indep_at(d, lo) > t){
+            hi = lo;
+            lo = (hi > step) ? hi - step : -1;
+            step *= 2;
+        }
+    }
+    while(hi - lo > 1){
+        mid = lo + (hi - lo) / 2;
+        if(datareader_indep_at(d, mid) <= t) lo = mid;
+        else hi = mid;
     }
-    MSG("d->i==%d, t1[0] = %lf, t2[0] = %lf", d->i, t1[0], t2[0]);
 
-    if(d->i == d->ndata || d->i == 0){
+    if(hi == n){
+        d->i = n;
         return 1;
     }
+    if(hi == 0){
+        /* before the start of the data: use the first interval */
+        hi = 1;
+    }
 
-    /* CONSOLE_DEBUG("INTERVAL OK"); */
+    d->i = hi - 1;
+    (*d->indepfn)(d, t1);
+    d->i = hi;
+    (*d->indepfn)(d, t2);
+    MSG("d->i==%d, t1[0] = %lf, t2[0] = %lf", d->i, t1[0], t2[0]);
     return 0;
 }
 
+/**
+	Load the data samples around the interval located by datareader_locate:
+	v1 and v2 at the start and end of the interval, v0 and v3 at the points
+	before and after it, where those exist (used for cubic interpolation).
+	At the ends of the data, the missing v0 or v3 is set equal to v1 or v2
+	respectively, so that the spline end conditions see defined values.
+	On return, d->i is the index of the start of the interval.
+*/
+static void datareader_samples(DataReader *d, double *v0, double *v1, double *v2, double *v3){
+    int j;
+
+    (*d->valfn)(d, v2);
+    if(d->i < d->ndata-1){
+        ++d->i; //go one step forward
+        (*d->valfn)(d, v3); //take a data sample at t1+2
+        --d->i; //go back one step
+    }else{
+        for(j = 0; j < d->nmaxoutputs; ++j) v3[j] = v2[j];
+    }
+
+    --d->i;
+    (*d->valfn)(d, v1);
+
+    if(d->i > 0){
+        --d->i; //go one step backward
+        (*d->valfn)(d, v0); //take a data sample at t1-1
+        ++d->i; //should be positioned at v1 t1
+    }else{
+        for(j = 0; j < d->nmaxoutputs; ++j) v0[j] = v1[j];
+    }
+}
+
 /**
 	Return an interpolated set of output values for the given input values.
 	This is computed according to user defined parameters.
@@ -477,13 +576,9 @@ int datareader_locate(DataReader *d, double t, double *t1, double *t2){
 	The required memory for the inputs and outputs must be allocated by the
 	caller, and indicated by the pointers 'inputs' and 'outputs'.
 
-	@see datareader_deriv
-	@TODO implement this
+	@see datareader_deriv, datareader_batch
 */
 int datareader_func(DataReader *d, double *inputs, double *outputs) {
-#ifdef DR_DEBUG
-    boolean AtStart, AtEnd; //keep track of dataset ends, they affect constrained spline calculations
-#endif
     int i,j;
     double t1[1], t2[1];
     double v0[d->nmaxoutputs], v1[d->nmaxoutputs], v2[d->nmaxoutputs], v3[d->nmaxoutputs];
@@ -504,36 +599,7 @@ int datareader_func(DataReader *d, double *inputs, double *outputs) {
     }
 
     MSG("LOCATED AT t1 = %lf, t2 = %lf", t1[0], t2[0]);
-    if(d->i < d->ndata-1){
-        ++d->i; //go one step forward
-        (*d->valfn)(d, v3); //take a data sample at t1+2
-        --d->i; //go back one step
-#ifdef DR_DEBUG
-        AtEnd = FALSE; //index is not at the end of the dataset
-#endif
-    }
-#ifdef DR_DEBUG
-    else
-	AtEnd = TRUE;
-#endif
-
-    (*d->valfn)(d, v2);
-    --d->i;
-    (*d->valfn)(d, v1);
-
-    if(d->i > 0){
-        --d->i; //go one step backward
-        (*d->valfn)(d, v0); //take a data sample at t1-1
-        ++d->i; //should be positioned at v1 t1
-#ifdef DR_DEBUG
-        AtStart = FALSE;
-#endif
-    }
-#ifdef DR_DEBUG
-    else 
-		AtStart = TRUE;
-#endif
-
+    datareader_samples(d, v0, v1, v2, v3);
     MSG("LOCATED OK, d->i = %d, t1 = %lf, t2 = %lf, v1=%lf, v2=%lf", d->i, t1[0], t2[0], v1[0], v2[0]);
 
     for(i = 0;i < d->noutputs;++i){
@@ -561,15 +627,9 @@ int datareader_func(DataReader *d, double *inputs, double *outputs) {
 	values. These can be smooth if the cubic interpolation method is selected.
 */
 int datareader_deriv(DataReader *d, double *inputs, double *jacobian) {
-#ifdef DR_DEBUG
-    boolean AtStart, AtEnd; //keep track of dataset ends, they affect constrained spline calculations
-#endif
     int i,j;
     double t1[1], t2[1];
     double v0[d->nmaxoutputs], v1[d->nmaxoutputs], v2[d->nmaxoutputs], v3[d->nmaxoutputs];
-    /** this is a fixed size...
-    the maximum size determined by the format handler, which is included in the datareader struct.
-    @TODO the TmyDataPoint has the output variables declared as float, why?**/
 
     double t = inputs[0];
 
@@ -584,34 +644,7 @@ int datareader_deriv(DataReader *d, double *inputs, double *jacobian) {
     }
 
     MSG("LOCATED AT t1 = %lf, t2 = %lf", t1[0], t2[0]);
-    if(d->i < d->ndata-1){
-        ++d->i; //go one step forward
-        (*d->valfn)(d, v3); //take a data sample at t1+2
-        --d->i; //go back one step
-#ifdef DR_DEBUG
-        AtEnd = FALSE; //index is not at the end of the dataset
-#endif
-    }
-#ifdef DR_DEBUG
-    else AtEnd = TRUE;
-#endif
-
-    (*d->valfn)(d, v2);
-    --d->i;
-    (*d->valfn)(d, v1);
-
-    if(d->i > 0){
-        --d->i; //go one step backward
-        (*d->valfn)(d, v0); //take a data sample at t1-1
-        ++d->i; //should be positioned at v1 t1
-#ifdef DR_DEBUG
-        AtStart = FALSE;
-#endif
-    }
-#ifdef DR_DEBUG
-    else AtStart = TRUE;
-#endif
-
+    datareader_samples(d, v0, v1, v2, v3);
     MSG("LOCATED OK, d->i = %d, t1 = %lf, t2 = %lf, v1=%lf, v2=%lf", d->i, t1[0], t2[0], v1[0], v2[0]);
 
     for(i = 0;i < d->noutputs;++i){
@@ -633,6 +666,59 @@ int datareader_deriv(DataReader *d, double *inputs, double *jacobian) {
 }
 
 
+/**
+	Interpolate the outputs (and/or their derivatives) at n values of the
+	independent variable in a single pass. The data samples around an
+	interval are loaded once and reused for all the t[k] that fall in it,
+	and the search for the next interval starts from the current one, so
+	with t sorted in increasing order the whole batch costs one sweep
+	through the data. Unsorted t are still handled correctly.
+
+	Results are stored output-major: outputs[i*n + k] is output i at t[k],
+	and deriv[i*n + k] is its derivative with respect to t[k]. Either of
+	'outputs' or 'deriv' may be NULL if not required.
+
+	@return 0 on success, 1 if any t[k] is out of range.
+*/
+int datareader_batch(DataReader *d, int n, const double *t, double *outputs, double *deriv){
+    int i,j,k;
+    int located = 0;
+    double t1[1], t2[1];
+    double v0[d->nmaxoutputs], v1[d->nmaxoutputs], v2[d->nmaxoutputs], v3[d->nmaxoutputs];
+
+    asc_assert(d->indepfn);
+
+    for(k = 0; k < n; ++k){
+        if(!located || !(t1[0] <= t[k] && t[k] < t2[0])){
+            if(datareader_locate(d, t[k], t1, t2)){
+                ERROR_REPORTER_HERE(ASC_USER_ERROR, "Time value t=%f is out of range", t[k]);
+                return 1;
+            }
+            datareader_samples(d, v0, v1, v2, v3);
+            located = 1;
+        }
+
+        for(i = 0; i < d->noutputs; ++i){
+            j = d->cols[i]-1;
+            switch(d->interp_t[i]){
+            case linear:
+                if(outputs) outputs[i*n + k] = dr_linearinterp(t[k],t1,t2,v1[j],v2[j]);
+                if(deriv) deriv[i*n + k] = dr_linearderiv(t[k],t1,t2,v1[j],v2[j]);
+                break;
+            case default_interp:
+            case sun:
+            case cubic:
+                if(outputs) outputs[i*n + k] = dr_cubicinterp(d,i,t[k],t1,t2,v0[j],v1[j],v2[j],v3[j]);
+                if(deriv) deriv[i*n + k] = dr_cubicderiv(d,i,t[k],t1,t2,v0[j],v1[j],v2[j],v3[j]);
+                break;
+            }
+        }
+    }
+    MSG("Evaluated batch of %d points", n);
+    return 0;
+}
+
+
 double dr_linearinterp(double t, double *t1, double *t2, double v1, double v2) {
     double g, dt;
     dt = (*t2)-(*t1);
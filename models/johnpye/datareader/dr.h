@@ -46,6 +46,7 @@ int datareader_num_outputs(const DataReader *d);
 
 int datareader_func(DataReader *d, double *inputs, double *outputs);
 int datareader_deriv(DataReader *d, double *inputs, double *jacobian);
+int datareader_batch(DataReader *d, int n, const double *t, double *outputs, double *deriv);
 
 double dr_linearinterp(double t, double *t1, double *t2, double v1, double v2);
 double dr_cubicinterp(DataReader *d, int j, double t, double *t1, double *t2, double v0, double v1, double v2, double v3);
@@ -140,6 +141,7 @@ interp_t datareader_int_type(const char *interpToken);
 
 struct DataReader_struct{
 	const char *fn;
+	const char *format; /**< format name, as given to datareader_set_format */
 	struct FilePath *fp;
 	FILE *f;
 	int ninputs;
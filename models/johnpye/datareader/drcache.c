@@ -0,0 +1,291 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2024 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//**
+	@file
+	Binary columnar cache for the Data Reader, see drcache.h.
+
+	Cache file layout (native byte order, it is not meant to be portable):
+	DrCacheHeader, then the data file path (pathlen chars, no terminator),
+	then t[ndata], then the output columns v[nmaxoutputs][ndata].
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef WIN32
+# include <process.h> /* for getpid() */
+#else
+# include <unistd.h> /* for getpid() */
+#endif
+
+#include "drcache.h"
+
+#include <ascend/general/ascMalloc.h>
+#include <ascend/utilities/error.h>
+#include <ascend/general/panic.h>
+
+//#define DRCACHE_DEBUG
+#ifdef DRCACHE_DEBUG
+# define MSG CONSOLE_DEBUG
+#else
+# define MSG(ARGS...) ((void)0)
+#endif
+
+#define DR_CACHE_MAGIC "ASCDRC1"
+
+typedef struct DrCacheHeader_struct{
+	char magic[8];
+	char format[8];
+	double mtime; /**< modification time of the data file */
+	double size;  /**< size of the data file in bytes */
+	int ninputs, noutputs, nmaxoutputs, ndata;
+	int pathlen;  /**< length of the data file path that follows */
+	int pad;
+} DrCacheHeader;
+
+/** in-memory columnar data, stored at d->data */
+typedef struct DrCache_struct{
+	double *t; /**< independent variable, t[ndata] */
+	double *v; /**< output columns, v[j*ndata + i] */
+} DrCache;
+
+#define CACHE(D) ((DrCache *)(D->data))
+
+/**
+	@return cache file name for d->fp, to be freed with ASC_FREE, or NULL
+	if cache files are disabled. *path is set to the data file path, to be
+	freed with ASC_FREE, if a name is returned.
+*/
+static char *drcache_filename(DataReader *d, char **path){
+	const char *dir, *base, *p;
+	unsigned long h;
+	char *fn;
+	dir = getenv(DR_CACHE_ENV);
+	if(dir == NULL || *dir == '\0')return NULL;
+	*path = ospath_str(d->fp);
+	if(*path == NULL)return NULL;
+	/* FNV-1a hash of the full path, so that data files of the same name in
+	different directories get different cache files */
+	h = 2166136261UL;
+	base = *path;
+	for(p = *path; *p != '\0'; ++p){
+		h = ((h ^ (unsigned char)*p) * 16777619UL) & 0xffffffffUL;
+		if(*p == '/' || *p == '\\')base = p + 1;
+	}
+	fn = ASC_NEW_ARRAY(char,strlen(dir) + strlen(base) + 16 + strlen(DR_CACHE_SUFFIX));
+	sprintf(fn,"%s/%s.%08lx" DR_CACHE_SUFFIX,dir,base,h);
+	return fn;
+}
+
+static void drcache_header_fill(DrCacheHeader *h, DataReader *d
+		, const ospath_stat_t *s, int pathlen
+){
+	memset(h,0,sizeof(DrCacheHeader));
+	strncpy(h->magic,DR_CACHE_MAGIC,sizeof(h->magic));
+	strncpy(h->format,d->format,sizeof(h->format) - 1);
+	h->mtime = (double)s->st_mtime;
+	h->size = (double)s->st_size;
+	h->ninputs = d->ninputs;
+	h->noutputs = d->noutputs;
+	h->nmaxoutputs = d->nmaxoutputs;
+	h->ndata = d->ndata;
+	h->pathlen = pathlen;
+}
+
+static DrCache *drcache_new(int ndata, int nmaxoutputs){
+	DrCache *c = ASC_NEW(DrCache);
+	c->t = ASC_NEW_ARRAY(double,ndata*(nmaxoutputs + 1));
+	c->v = c->t + ndata;
+	return c;
+}
+
+static void drcache_use(DataReader *d, DrCache *c){
+	d->data = c;
+	d->indepfn = &datareader_cache_time;
+	d->valfn = &datareader_cache_vals;
+	d->freefn = &datareader_cache_free;
+}
+
+int datareader_cache_load(DataReader *d, const ospath_stat_t *s){
+	DrCacheHeader h, ref;
+	char *path, *fn, *cpath;
+	FILE *f;
+	DrCache *c;
+	size_t n;
+
+	if(d->format == NULL)return 1;
+
+	fn = drcache_filename(d,&path);
+	if(fn == NULL)return 1;
+	f = fopen(fn,"rb");
+	if(f == NULL){
+		MSG("No cache file '%s'",fn);
+		ASC_FREE(fn);
+		ASC_FREE(path);
+		return 1;
+	}
+
+	if(fread(&h,sizeof(DrCacheHeader),1,f) != 1){
+		goto stale;
+	}
+	drcache_header_fill(&ref,d,s,strlen(path));
+	if(strncmp(h.magic,ref.magic,sizeof(h.magic))
+		|| strncmp(h.format,ref.format,sizeof(h.format))
+		|| h.mtime != ref.mtime || h.size != ref.size
+		|| h.pathlen != ref.pathlen
+		|| h.ndata < 2 || h.nmaxoutputs < 1 || h.ninputs != 1
+	){
+		goto stale;
+	}
+	cpath = ASC_NEW_ARRAY(char,h.pathlen);
+	n = fread(cpath,1,h.pathlen,f);
+	if(n != (size_t)h.pathlen || strncmp(cpath,path,h.pathlen)){
+		ASC_FREE(cpath);
+		goto stale;
+	}
+	ASC_FREE(cpath);
+
+	c = drcache_new(h.ndata,h.nmaxoutputs);
+	n = (size_t)h.ndata * (h.nmaxoutputs + 1);
+	if(fread(c->t,sizeof(double),n,f) != n){
+		ASC_FREE(c->t);
+		ASC_FREE(c);
+		goto stale;
+	}
+	fclose(f);
+
+	d->ninputs = h.ninputs;
+	d->noutputs = h.noutputs;
+	d->nmaxoutputs = h.nmaxoutputs;
+	d->ndata = h.ndata;
+	drcache_use(d,c);
+
+	ERROR_REPORTER_HERE(ASC_PROG_NOTE,"Read %d rows from cache '%s'",d->ndata,fn);
+	ASC_FREE(fn);
+	ASC_FREE(path);
+	return 0;
+
+stale:
+	MSG("Cache file '%s' is stale or invalid",fn);
+	fclose(f);
+	ASC_FREE(fn);
+	ASC_FREE(path);
+	return 1;
+}
+
+int datareader_cache_build(DataReader *d){
+	DrCache *c;
+	double *v;
+	int i, j;
+
+	if(d->ninputs != 1 || d->ndata < 2 || d->nmaxoutputs < 1){
+		MSG("Data not suitable for columnar cache");
+		return 1;
+	}
+	asc_assert(d->indepfn);
+	asc_assert(d->valfn);
+
+	c = drcache_new(d->ndata,d->nmaxoutputs);
+	v = ASC_NEW_ARRAY(double,d->nmaxoutputs);
+	for(i = 0; i < d->ndata; ++i){
+		d->i = i;
+		(*d->indepfn)(d, &c->t[i]);
+		(*d->valfn)(d, v);
+		for(j = 0; j < d->nmaxoutputs; ++j){
+			c->v[j*d->ndata + i] = v[j];
+		}
+	}
+	ASC_FREE(v);
+	d->i = 0;
+
+	if(d->freefn){
+		(*d->freefn)(d);
+	}
+	drcache_use(d,c);
+	return 0;
+}
+
+int datareader_cache_save(DataReader *d, const ospath_stat_t *s){
+	DrCacheHeader h;
+	char *path, *fn, *tmp;
+	FILE *f;
+	size_t n;
+	int ok;
+
+	if(d->freefn != &datareader_cache_free || d->format == NULL){
+		return 1;
+	}
+
+	fn = drcache_filename(d,&path);
+	if(fn == NULL)return 1;
+	/* write under a name of our own, so that other processes sharing the
+	cache directory never see a partly written file */
+	tmp = ASC_NEW_ARRAY(char,strlen(fn) + 24);
+	sprintf(tmp,"%s.%lu.tmp",fn,(unsigned long)getpid());
+	f = fopen(tmp,"wb");
+	if(f == NULL){
+		MSG("Unable to write cache file '%s'",tmp);
+		ASC_FREE(tmp);
+		ASC_FREE(fn);
+		ASC_FREE(path);
+		return 1;
+	}
+
+	drcache_header_fill(&h,d,s,strlen(path));
+	n = (size_t)d->ndata * (d->nmaxoutputs + 1);
+	ok = fwrite(&h,sizeof(DrCacheHeader),1,f) == 1
+		&& fwrite(path,1,h.pathlen,f) == (size_t)h.pathlen
+		&& fwrite(CACHE(d)->t,sizeof(double),n,f) == n;
+	if(fclose(f))ok = 0;
+	if(ok && rename(tmp,fn) != 0){
+		/* rename does not replace an existing file on all platforms */
+		remove(fn);
+		ok = (rename(tmp,fn) == 0);
+	}
+	if(!ok){
+		ERROR_REPORTER_HERE(ASC_PROG_WARNING,"Failed to write cache file '%s'",fn);
+		remove(tmp);
+	}else{
+		MSG("Wrote cache file '%s'",fn);
+	}
+	ASC_FREE(tmp);
+	ASC_FREE(fn);
+	ASC_FREE(path);
+	return !ok;
+}
+
+int datareader_cache_time(DataReader *d, double *t){
+	*t = CACHE(d)->t[d->i];
+	return 0;
+}
+
+int datareader_cache_vals(DataReader *d, double *v){
+	int j;
+	const double *col = CACHE(d)->v + d->i;
+	for(j = 0; j < d->nmaxoutputs; ++j){
+		v[j] = col[j*d->ndata];
+	}
+	return 0;
+}
+
+int datareader_cache_free(DataReader *d){
+	if(d->data){
+		ASC_FREE(CACHE(d)->t);
+		ASC_FREE(d->data);
+		d->data = NULL;
+	}
+	return 0;
+}
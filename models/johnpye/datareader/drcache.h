@@ -0,0 +1,74 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2024 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//**
+	@file
+	Binary columnar cache for the Data Reader.
+
+	Once a data file has been parsed by its format handler, the independent
+	variable and each output column are copied into contiguous arrays, and
+	the handler's indepfn/valfn are replaced by ones reading those arrays.
+
+	When the environment variable ASCENDDRCACHE names a directory, the
+	arrays are also written to '<dir>/<basename>.<hash>.drc', where the hash
+	is computed from the full path of the data file. The cache file is keyed
+	by the data file's path, format, size and modification time. On the next
+	run, datareader_init loads the arrays straight from that file and the
+	text file is not parsed at all. Cache files are neither read nor written
+	if the variable is not set (the in-memory columnar form is still used).
+*/
+
+#ifndef DATAREADER_CACHE_H
+#define DATAREADER_CACHE_H
+
+#include "dr.h"
+
+#include <ascend/general/ospath.h>
+
+/** environment variable naming the directory for cache files */
+#define DR_CACHE_ENV "ASCENDDRCACHE"
+
+/** file suffix of cache files */
+#define DR_CACHE_SUFFIX ".drc"
+
+/**
+	Load the cache file for the data file d->fp, if one exists and matches
+	the format, size and modification time of the data file.
+	On success, d->data holds the columnar arrays and the indepfn, valfn
+	and freefn of d have been replaced.
+	@return 0 on success, nonzero if no usable cache was found.
+*/
+int datareader_cache_load(DataReader *d, const ospath_stat_t *s);
+
+/**
+	Copy the data loaded by the format handler into columnar arrays,
+	free the handler's data, and switch d over to the cache functions.
+	@return 0 on success, nonzero if the handler data was left in place.
+*/
+int datareader_cache_build(DataReader *d);
+
+/**
+	Write the columnar arrays of d (from datareader_cache_build) to the
+	cache file for d->fp. Failure to write is not an error for the caller,
+	the data reader will just parse the file again next time.
+	@return 0 on success.
+*/
+int datareader_cache_save(DataReader *d, const ospath_stat_t *s);
+
+DataReaderIndepFn datareader_cache_time;
+DataReaderValFn datareader_cache_vals;
+DataReaderFreeFn datareader_cache_free;
+
+#endif
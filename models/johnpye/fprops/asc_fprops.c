@@ -43,6 +43,7 @@
 #include "solve_ph.h"
 #include "thcond.h"
 #include "visc.h"
+#include "lut.h"
 
 /* for the moment, species data are defined in C code, we'll implement something
 better later on, hopefully. */
@@ -78,6 +79,15 @@ ExtBBoxFunc fprops_cv_Trho_calc;
 ExtBBoxFunc fprops_w_Trho_calc;
 ExtBBoxFunc fprops_mu_Trho_calc;
 ExtBBoxFunc fprops_lam_Trho_calc;
+ExtBBoxFunc fprops_p_Trho_array_calc;
+ExtBBoxFunc fprops_u_Trho_array_calc;
+ExtBBoxFunc fprops_s_Trho_array_calc;
+ExtBBoxFunc fprops_h_Trho_array_calc;
+ExtBBoxFunc fprops_a_Trho_array_calc;
+ExtBBoxFunc fprops_g_Trho_array_calc;
+ExtBBoxFunc fprops_cp_Trho_array_calc;
+ExtBBoxFunc fprops_cv_Trho_array_calc;
+ExtBBoxFunc fprops_w_Trho_array_calc;
 ExtBBoxFunc fprops_rho_Tp_calc;
 ExtBBoxFunc fprops_cp_Tp_calc;
 ExtBBoxFunc fprops_h_Tp_calc;
@@ -121,6 +131,18 @@ static const char *fprops_w_Trho_help = "Calculate speed of sound from temperatu
 static const char *fprops_mu_Trho_help = "Calculate viscosity from temperature and density, using FPROPS";
 static const char *fprops_lam_Trho_help = "Calculate thermal conductivity sound from temperature and density, using FPROPS";
 
+#define ARRAYHELP(WHAT) "Calculate " WHAT " at each of an array of states, from arrays of temperature and density, using FPROPS"
+static const char *fprops_p_Trho_array_help = ARRAYHELP("pressure");
+static const char *fprops_u_Trho_array_help = ARRAYHELP("specific internal energy");
+static const char *fprops_s_Trho_array_help = ARRAYHELP("specific entropy");
+static const char *fprops_h_Trho_array_help = ARRAYHELP("specific enthalpy");
+static const char *fprops_a_Trho_array_help = ARRAYHELP("specific Helmholtz energy");
+static const char *fprops_g_Trho_array_help = ARRAYHELP("specific Gibbs energy");
+static const char *fprops_cp_Trho_array_help = ARRAYHELP("isobaric specific heat");
+static const char *fprops_cv_Trho_array_help = ARRAYHELP("isochoric specific heat");
+static const char *fprops_w_Trho_array_help = ARRAYHELP("speed of sound");
+#undef ARRAYHELP
+
 static const char *fprops_rho_Tp_help = "rho(T,p) esp. for incompressible substances";
 static const char *fprops_cp_Tp_help = "h(T,p) esp. for incompressible substances";
 static const char *fprops_h_Tp_help = "h(T,p) esp. for incompressible substances";
@@ -184,6 +206,16 @@ ASC_EXPORT int fprops_register(){
 	CALCFN(fprops_mu_Trho,2,1);
 	CALCFN(fprops_lam_Trho,2,1);
 
+	CALCFN(fprops_p_Trho_array,2,1);
+	CALCFN(fprops_u_Trho_array,2,1);
+	CALCFN(fprops_s_Trho_array,2,1);
+	CALCFN(fprops_h_Trho_array,2,1);
+	CALCFN(fprops_a_Trho_array,2,1);
+	CALCFN(fprops_g_Trho_array,2,1);
+	CALCFN(fprops_cp_Trho_array,2,1);
+	CALCFN(fprops_cv_Trho_array,2,1);
+	CALCFN(fprops_w_Trho_array,2,1);
+
 	CALCFN(fprops_rho_Tp,2,1);
 	CALCFN(fprops_cp_Tp,2,1);
 	CALCFN(fprops_h_Tp,2,1);
@@ -499,6 +531,40 @@ int fprops_w_Trho_calc(struct BBoxInterp *bbox,
 	return 0;
 }
 
+/**
+	Evaluation functions for the arrayed forms 'fprops_p_Trho_array' etc, used
+	as
+		fprops_h_Trho_array(T[1..n], rho[1..n] : INPUT; h[1..n] : OUTPUT; cd : DATA);
+	ASCEND passes the input arguments flattened one after the other, so the
+	temperatures arrive as inputs[0..n-1] and the densities as inputs[n..2n-1],
+	which is the form taken by the FPROPS batch functions: all n states are
+	evaluated in one call instead of n separate relations.
+	@param jacobian ignored
+	@return 0 on success
+*/
+#define ARRAYCALCFN(VAR) \
+	int fprops_##VAR##_Trho_array_calc(struct BBoxInterp *bbox,\
+			int ninputs, int noutputs,\
+			double *inputs, double *outputs,\
+			double *jacobian\
+	){\
+		CALCPREPARE(2*noutputs,noutputs);\
+		fprops_##VAR##_batch(inputs, inputs + noutputs, outputs, noutputs, FLUID, &err);\
+		/* no need to worry about error states etc. */\
+		return 0;\
+	}
+
+ARRAYCALCFN(p);
+ARRAYCALCFN(u);
+ARRAYCALCFN(s);
+ARRAYCALCFN(h);
+ARRAYCALCFN(a);
+ARRAYCALCFN(g);
+ARRAYCALCFN(cp);
+ARRAYCALCFN(cv);
+ARRAYCALCFN(w);
+#undef ARRAYCALCFN
+
 /**
 	Evaluation function for 'fprops_mu'
 	@param jacobian ignored
@@ -688,6 +754,23 @@ int fprops_Tvsx_ph_calc(struct BBoxInterp *bbox,
 	p = inputs[0];
 	h = inputs[1];
 	switch(FLUID->type){
+	case FPROPS_LUT:
+		if(lut_ph_tabulated(p,h,FLUID)){
+			/* single-phase state, straight from the (p,h) table */
+			FluidState2 S = fprops_solve_ph(p,h,FLUID,&err);
+			T = S.vals.Trho.T;
+			v = 1./S.vals.Trho.rho;
+			s = FLUID->s_fn(S.vals, FLUID->data, &err);
+			x = (v > 1./RHOCRIT(FLUID)) ? 1 : 0;
+			last = FLUID;
+			outputs[0] = T;
+			outputs[1] = v;
+			outputs[2] = s;
+			outputs[3] = x;
+			return 0;
+		}
+		/* otherwise, as for the underlying EOS */
+		/* fall through */
 	case FPROPS_HELMHOLTZ:
 	case FPROPS_PENGROB:
 		{
@@ -42,6 +42,13 @@ typedef enum FpropsError_enum{
 #define FPROPS_ERROR -1
 
 
+/** Storage class for per-thread state, such as the warm-start memos */
+#ifdef _MSC_VER
+# define FPROPS_THREAD_LOCAL __declspec(thread)
+#else
+# define FPROPS_THREAD_LOCAL __thread
+#endif
+
 #define FPROPS_NEW(TYPE) ((TYPE *)malloc(sizeof(TYPE)))
 
 #define FPROPS_FREE(PTR) free(PTR)
@@ -554,6 +554,7 @@ typedef enum EosType_enum{
 	,FPROPS_SOAVE = 4
 	,FPROPS_HELMHOLTZ = 5
 	,FPROPS_MBWR = 6//etc.
+	,FPROPS_LUT = 9 /**< tabulated, wrapping one of the above; only in PureFluid objects */
 } EosType;
 
 /** Union of all possible EOS data structures */
@@ -3,6 +3,7 @@
 #include "fprops.h"
 #include "helmholtz.h"
 #include "pengrob.h"
+#include "lut.h"
 
 #include <string.h>
 #include <stdio.h>
@@ -46,6 +47,10 @@ static int nfluids = 0 + FLUIDS(F,X) + RPPFLUIDS(F,X);
 #undef F
 #undef X
 
+/* tabulated fluids are expensive to prepare, so each is built only once and
+shared by all callers of fprops_fluid */
+static const PureFluid *lutfluids[sizeof(fluids)/sizeof(fluids[0])];
+
 const PureFluid *fprops_fluid(const char *name, const char *corrtype, const char *source){
 	int i;
 	MSG("Looking for fluid '%s' of type '%s', with source text '%s'",name,corrtype,source);
@@ -62,6 +67,10 @@ const PureFluid *fprops_fluid(const char *name, const char *corrtype, const char
 			}
 			if(fprops_corr_avail(fluids[i],corrtype)){
 				MSG("Match! %d",i);
+				if(FPROPS_LUT == fprops_corr_avail(fluids[i],corrtype)){
+					if(!lutfluids[i])lutfluids[i] = fprops_prepare(fluids[i],corrtype);
+					return lutfluids[i];
+				}
 				return fprops_prepare(fluids[i],corrtype);
 			}else{
 				MSG("No match");
@@ -87,6 +96,7 @@ const PureFluid *fprops_get_fluid(int i){
 }
 
 void fprops_fluid_destroy(PureFluid *P){
+	int i;
 	MSG("Freeing data for lfuid '%s'",P->name);
 	switch(P->type){
 	case FPROPS_HELMHOLTZ:
@@ -95,6 +105,13 @@ void fprops_fluid_destroy(PureFluid *P){
 	case FPROPS_PENGROB:
 		pengrob_destroy(P);
 		break;
+	case FPROPS_LUT:
+		/* shared fluids from fprops_fluid are kept until exit */
+		for(i = 0; i < nfluids; ++i){
+			if(lutfluids[i] == P)return;
+		}
+		lut_destroy(P);
+		break;
 	case FPROPS_CUBIC:
 		assert(FPROPS_CUBIC != P->type);
 		break;
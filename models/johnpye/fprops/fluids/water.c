@@ -291,6 +291,8 @@ static const unsigned ntd1 = sizeof(td1)/sizeof(TestData);
 # include "../helmholtz_impl.h"
 # include "../sat.h"
 # include "../helmholtz.h"
+# include "../solve_ph.h"
+# include "../lut.h"
 
 void test_fluid_water(void){
 	double rho, T;
@@ -329,6 +331,16 @@ void test_fluid_water(void){
 	ASSERT_TOL_3(helm_resid_tau, tau, delta, D, -0.581403435E1, 1e-8);
 	ASSERT_TOL_3(helm_resid_tautau, tau, delta, D, -0.223440737E1, 1e-8);
 	ASSERT_TOL_3(helm_resid_deltau, tau, delta, D, -0.112176915e1, 1e-8);
+
+	/* the same values from a single fused evaluation */
+	HelmResidDerivs R;
+	helm_resid_derivs(tau, delta, D, 2, &R);
+	ASSERT_TOL_VAL(R.phir, -0.342693206E1, 1e-8);
+	ASSERT_TOL_VAL(R.phir_d, -0.364366650, 1e-8);
+	ASSERT_TOL_VAL(R.phir_dd, 0.856063701, 1e-8);
+	ASSERT_TOL_VAL(R.phir_t, -0.581403435E1, 1e-8);
+	ASSERT_TOL_VAL(R.phir_tt, -0.223440737E1, 1e-8);
+	ASSERT_TOL_VAL(R.phir_dt, -0.112176915e1, 1e-8);
 #undef D
 
 #if 0
@@ -365,6 +377,52 @@ void test_fluid_water(void){
 		ASSERT_PROP(w, S, &error, w, w*2e-5);
 	}
 
+	TEST_MSG("IAPWS95 TABLE 7 TESTS, BATCH EVALUATION");
+	{
+		double Tb[ntd], rhob[ntd], pb[ntd], cvb[ntd], wb[ntd], sb[ntd];
+		for(i=0; i<ntd; ++i){
+			Tb[i] = td[i].T;
+			rhob[i] = td[i].rho;
+		}
+		fprops_p_batch(Tb, rhob, pb, ntd, P, &error);
+		fprops_cv_batch(Tb, rhob, cvb, ntd, P, &error);
+		fprops_w_batch(Tb, rhob, wb, ntd, P, &error);
+		fprops_s_batch(Tb, rhob, sb, ntd, P, &error);
+		ASSERT(error == 0);
+		for(i=0; i<ntd; ++i){
+			ASSERT_TOL_VAL(pb[i], td[i].p * 1e6, td[i].p * 1e6 * 1e-8);
+			ASSERT_TOL_VAL(cvb[i], td[i].cv * 1e3, td[i].cv * 1e3 * 1e-8);
+			ASSERT_TOL_VAL(wb[i], td[i].w, td[i].w * 2e-5);
+			ASSERT_TOL_VAL(sb[i], td[i].s * 1e3, td[i].s * 1e3 * 1e-8);
+		}
+	}
+
+	TEST_MSG("IAPWS95 TABLE 7 TESTS, TABULATED (LUT) FLUID");
+	{
+		PureFluid *PL = fprops_prepare(&eos_water,"lut");
+		ASSERT(PL != NULL);
+		ASSERT(PL->type == FPROPS_LUT);
+		for(i=0; i<ntd; ++i){
+			error = 0;
+			FluidState2 S = fprops_set_Trho(td[i].T, td[i].rho, PL, &error);
+			double p = fprops_p(S, &error);
+			double h = fprops_h(S, &error);
+			ASSERT(error == 0);
+			ASSERT_TOL_VAL(p, td[i].p * 1e6, td[i].p * 1e6 * 2e-6);
+			double h_ref = fprops_h(fprops_set_Trho(td[i].T, td[i].rho, P, &error), &error);
+			ASSERT_TOL_VAL(h, h_ref, fabs(h_ref) * 2e-6 + 1);
+			ASSERT_TOL_VAL(fprops_s(S, &error), td[i].s * 1e3, fabs(td[i].s) * 1e3 * 2e-6 + 1e-2);
+			/* inverse solution, where the (p,h) table covers the state */
+			if(lut_ph_tabulated(p, h, PL)){
+				FluidState2 S1 = fprops_solve_ph(p, h, PL, &error);
+				ASSERT(error == 0);
+				ASSERT_TOL_VAL(S1.vals.Trho.T, td[i].T, td[i].T * 2e-6);
+				ASSERT_TOL_VAL(S1.vals.Trho.rho, td[i].rho, td[i].rho * 2e-5);
+			}
+		}
+		lut_destroy(PL);
+	}
+
 	TEST_MSG("IAPWS95 TABLE 8 (SATURATION) TESTS (%d items)",ntds);
 	for(i=0; i<ntds; ++i){
 		double T = tds[i].T;
@@ -34,6 +34,7 @@
 #include "sat.h"
 //#include "redkw.h"
 #include "pengrob.h"
+#include "lut.h"
 #include "visc.h"
 #include "thcond.h"
 //#include "mbwr.h"
@@ -100,6 +101,14 @@ int fprops_corr_avail(const EosData *E, const char *corrtype){
 			return 0;
 		/* TODO in future we could 'downsample' here from eg Helmholtz? */
 		}
+	}else if(strcmp(corrtype,"lut")==0){
+		switch(E->type){
+		case FPROPS_HELMHOLTZ:
+		case FPROPS_CUBIC:
+			return FPROPS_LUT;
+		default:
+			return 0;
+		}
 	}
 	return 0;
 }
@@ -123,6 +132,19 @@ PureFluid *fprops_prepare(const EosData *E,const char *corrtype){
 	case FPROPS_INCOMP:
 		P= incomp_prepare(E,NULL);
 		break;
+	case FPROPS_LUT:
+		/* tabulate the best available correlation with VLE */
+		P = (E->type == FPROPS_HELMHOLTZ) ? helmholtz_prepare(E,NULL) : pengrob_prepare(E,NULL);
+		if(P){
+			PureFluid *P1 = lut_prepare(P,NULL,&err);
+			if(!P1){
+				if(E->type == FPROPS_HELMHOLTZ)helmholtz_destroy(P);
+				else pengrob_destroy(P);
+				err = FPROPS_NO_ERROR;
+			}
+			P = P1;
+		}
+		break;
 	default:
 		ERRMSG("Invalid EOS data, unimplemented correlation type requested");
 		return NULL;
@@ -164,6 +186,7 @@ FluidState2 fprops_set_Trho(double T, double rho, const PureFluid *fluid, Fprops
 	case FPROPS_HELMHOLTZ:
 	case FPROPS_IDEAL:
 	case FPROPS_PENGROB:
+	case FPROPS_LUT:
 		return (FluidState2){.vals={.Trho={T,rho}},.fluid=fluid};
 	case FPROPS_INCOMP:
 		ERRMSG("Unable to set incompressible state using (T,rho).");
@@ -211,6 +234,7 @@ and if not, just redirect immediately to the EOS evaluation function. */
 		switch(state.fluid->type){\
 		case FPROPS_HELMHOLTZ:\
 		case FPROPS_PENGROB:\
+		case FPROPS_LUT:\
 			if(state.vals.Trho.T >= state.fluid->data->T_t && state.vals.Trho.T < state.fluid->data->T_c){\
 		double p, rho_f, rho_g;\
 				fprops_sat_T(state.vals.Trho.T, &p, &rho_f, &rho_g, state.fluid, err);\
@@ -245,6 +269,7 @@ and if not, just redirect immediately to the EOS evaluation function. */
 		switch(state.fluid->type){\
 		case FPROPS_HELMHOLTZ:\
 		case FPROPS_PENGROB:\
+		case FPROPS_LUT:\
 			{\
 		double p, rho_f, rho_g;\
 				if(state.vals.Trho.T >= state.fluid->data->T_t && state.vals.Trho.T < state.fluid->data->T_c){\
@@ -289,6 +314,7 @@ double fprops_T(FluidState2 state, FpropsError *err){
 	switch(state.fluid->type){
 	 	case FPROPS_HELMHOLTZ:
 		case FPROPS_PENGROB:
+		case FPROPS_LUT:
 		case FPROPS_IDEAL:
 			return state.vals.Trho.T;
 		case FPROPS_INCOMP:
@@ -303,6 +329,7 @@ double fprops_rho(FluidState2 state, FpropsError *err){
 	switch(state.fluid->type){
 	 	case FPROPS_HELMHOLTZ:
 		case FPROPS_PENGROB:
+		case FPROPS_LUT:
 		case FPROPS_IDEAL:
 			return state.vals.Trho.rho;
 		case FPROPS_INCOMP:
@@ -320,6 +347,7 @@ double fprops_p(FluidState2 state, FpropsError *err){
 		return state.vals.Tp.p;
 	case FPROPS_HELMHOLTZ:
 	case FPROPS_PENGROB:
+	case FPROPS_LUT:
 		// fluids with a (T,rho) state and VLE
 		if(state.vals.Trho.T >= state.fluid->data->T_t && state.vals.Trho.T < state.fluid->data->T_c){
 			fprops_sat_T(state.vals.Trho.T, &p, &rho_f, &rho_g, state.fluid, err);
@@ -437,6 +465,135 @@ double fprops_dudrho_T(FluidState2 state, FpropsError *err){
 	return 0;
 }
 
+/*------------------------------------------------------------------------------
+  BATCH EVALUATION
+*/
+
+/* states are handled in blocks of this size, to keep work arrays on the stack */
+#define FPROPS_BATCH_BLOCK 64
+
+/* treatment of states inside the saturation dome, as in EVALFN etc above */
+typedef enum{
+	BATCH_SAT_MIX /* quality-weighted mean of the saturated liquid and vapour values */
+	,BATCH_SAT_UNDEFINED /* evaluate the EOS anyway, but flag FPROPS_VALUE_UNDEFINED */
+	,BATCH_SAT_PSAT /* pressure: return psat */
+} BatchSatMode;
+
+/* evaluate without phase equilibrium, by batch_fn if the fluid has one */
+static void fprops_batch_raw(FpropsBatchProp prop, PropEvalFn2 *fn, size_t n
+	, const double *T, const double *rho, double *out, const PureFluid *fluid
+	, FpropsError *err
+){
+	size_t i;
+	if(fluid->batch_fn){
+		fluid->batch_fn(prop, n, T, rho, out, fluid->data, err);
+		return;
+	}
+	for(i=0; i<n; ++i){
+		out[i] = fn((FluidStateUnion){.Trho={T[i],rho[i]}}, fluid->data, err);
+	}
+}
+
+/*
+	Evaluate a property at n (T,rho) states, giving the same values as calling
+	the corresponding fprops_* function on each state, for the fluid types
+	that take a (T,rho) state (not FPROPS_INCOMP). States within the
+	saturation dome are replaced by their saturated liquid and vapour states
+	(or handled according to 'mode'), after which all the states of a block
+	are passed to the EOS together.
+*/
+static void fprops_batch(FpropsBatchProp prop, PropEvalFn2 *fn, BatchSatMode mode
+	, const double *T, const double *rho, double *out, size_t n
+	, const PureFluid *fluid, FpropsError *err
+){
+	double Tb[2*FPROPS_BATCH_BLOCK], rhob[2*FPROPS_BATCH_BLOCK], Qb[2*FPROPS_BATCH_BLOCK];
+	double x[FPROPS_BATCH_BLOCK];
+	size_t i0, i;
+	unsigned k, m, nb, j;
+	int vle;
+
+	switch(fluid->type){
+	case FPROPS_HELMHOLTZ:
+	case FPROPS_PENGROB:
+	case FPROPS_LUT:
+		vle = 1;
+		break;
+	case FPROPS_IDEAL:
+		vle = 0;
+		break;
+	default:
+		/* (T,rho) is not a valid state for incompressible fluids, just as
+		in fprops_set_Trho: these are not supported here */
+		*err = FPROPS_INVALID_REQUEST;
+		for(i=0; i<n; ++i)out[i] = NAN;
+		return;
+	}
+
+	for(i0=0; i0<n; i0+=m){
+		m = (n - i0 > FPROPS_BATCH_BLOCK ? FPROPS_BATCH_BLOCK : (unsigned)(n - i0));
+		nb = 0;
+		for(k=0; k<m; ++k){
+			i = i0 + k;
+			x[k] = -1; /* single phase */
+			if(vle && T[i] >= fluid->data->T_t && T[i] < fluid->data->T_c){
+				double psat, rho_f, rho_g;
+				FpropsError serr = FPROPS_NO_ERROR;
+				fprops_sat_T(T[i], &psat, &rho_f, &rho_g, fluid, &serr);
+				if(serr){
+					MSG("Got error %d from saturation calc in %s\n",serr,__func__);
+					*err = serr;
+					out[i] = (mode == BATCH_SAT_UNDEFINED ? fluid->data->rho_c : 0);
+					x[k] = -2; /* done */
+					continue;
+				}
+				if(rho_g < rho[i] && rho[i] < rho_f){
+					if(mode == BATCH_SAT_PSAT){
+						out[i] = psat;
+						x[k] = -2;
+						continue;
+					}else if(mode == BATCH_SAT_MIX){
+						x[k] = rho_g*(rho_f/rho[i] - 1)/(rho_f - rho_g);
+						Tb[nb] = T[i]; rhob[nb++] = rho_f;
+						Tb[nb] = T[i]; rhob[nb++] = rho_g;
+						continue;
+					}
+					*err = FPROPS_VALUE_UNDEFINED;
+				}
+			}
+			Tb[nb] = T[i]; rhob[nb++] = rho[i];
+		}
+
+		fprops_batch_raw(prop, fn, nb, Tb, rhob, Qb, fluid, err);
+
+		for(k=0, j=0; k<m; ++k){
+			if(x[k] == -2)continue;
+			if(x[k] >= 0){
+				out[i0 + k] = x[k]*Qb[j+1] + (1-x[k])*Qb[j];
+				j += 2;
+			}else{
+				out[i0 + k] = Qb[j++];
+			}
+		}
+	}
+}
+
+#define BATCHFN(VAR,PROP,MODE) \
+	void fprops_##VAR##_batch(const double *T, const double *rho, double *VAR\
+			, size_t n, const PureFluid *fluid, FpropsError *err\
+	){\
+		fprops_batch(PROP, fluid->VAR##_fn, MODE, T, rho, VAR, n, fluid, err);\
+	}
+
+BATCHFN(p,FPROPS_BATCH_P,BATCH_SAT_PSAT);
+BATCHFN(u,FPROPS_BATCH_U,BATCH_SAT_MIX);
+BATCHFN(h,FPROPS_BATCH_H,BATCH_SAT_MIX);
+BATCHFN(s,FPROPS_BATCH_S,BATCH_SAT_MIX);
+BATCHFN(a,FPROPS_BATCH_A,BATCH_SAT_MIX);
+BATCHFN(g,FPROPS_BATCH_G,BATCH_SAT_MIX);
+BATCHFN(cv,FPROPS_BATCH_CV,BATCH_SAT_UNDEFINED);
+BATCHFN(cp,FPROPS_BATCH_CP,BATCH_SAT_UNDEFINED);
+BATCHFN(w,FPROPS_BATCH_W,BATCH_SAT_UNDEFINED);
+
 char *fprops_error(FpropsError err){
 	switch (err) {
 	case FPROPS_NO_ERROR:return NULL;
@@ -469,6 +626,8 @@ const char *fprops_corr_type(EosType type){
 		return "helmholtz";
 	case FPROPS_MBWR:
 		return "mbwr";
+	case FPROPS_LUT:
+		return "lut";
 	}
 	return NULL;
 }
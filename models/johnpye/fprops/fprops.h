@@ -86,6 +86,32 @@ double fprops_dudrho_T(const FluidState2 state, FpropsError *err);
 #endif
 
 
+/**
+	Batch evaluation of properties at n (T,rho) states, given as separate
+	arrays T[0..n-1] and rho[0..n-1], with the results written to the
+	n-element output array. Each value is the same as that from the
+	corresponding single-state function above (including the treatment of
+	states inside the saturation dome), but the states are passed to the EOS
+	in blocks, so that for Helmholtz fluids the residual terms are evaluated
+	for many states per pass rather than once per call.
+
+	Incompressible fluids (FPROPS_INCOMP) are not supported: their states
+	are given by (T,p), which fprops_set_Trho also refuses. For them *err is
+	set to FPROPS_INVALID_REQUEST and every output is NAN; use
+	fprops_set_Tp and the single-state functions instead.
+
+	*err is set if the evaluation of any of the states fails.
+*/
+void fprops_p_batch(const double *T, const double *rho, double *p, size_t n, const PureFluid *fluid, FpropsError *err);
+void fprops_u_batch(const double *T, const double *rho, double *u, size_t n, const PureFluid *fluid, FpropsError *err);
+void fprops_h_batch(const double *T, const double *rho, double *h, size_t n, const PureFluid *fluid, FpropsError *err);
+void fprops_s_batch(const double *T, const double *rho, double *s, size_t n, const PureFluid *fluid, FpropsError *err);
+void fprops_a_batch(const double *T, const double *rho, double *a, size_t n, const PureFluid *fluid, FpropsError *err);
+void fprops_g_batch(const double *T, const double *rho, double *g, size_t n, const PureFluid *fluid, FpropsError *err);
+void fprops_cv_batch(const double *T, const double *rho, double *cv, size_t n, const PureFluid *fluid, FpropsError *err);
+void fprops_cp_batch(const double *T, const double *rho, double *cp, size_t n, const PureFluid *fluid, FpropsError *err);
+void fprops_w_batch(const double *T, const double *rho, double *w, size_t n, const PureFluid *fluid, FpropsError *err);
+
 double fprops_mu(FluidState2 state, FpropsError *err); ///< Dynamic viscosity / [Pa*s]
 double fprops_lam(FluidState2 state, FpropsError *err); ///< Thermal conductivity / [W/m/K]
 
@@ -50,6 +50,7 @@ PropEvalFn2 helmholtz_dpdrho_T;
 PropEvalFn2 helmholtz_alphap;
 PropEvalFn2 helmholtz_betap;
 SatEvalFn helmholtz_sat;
+BatchEvalFn helmholtz_batch;
 
 double helmholtz_dpdT_rho(FluidStateUnion vals, const FluidData *data, FpropsError *err);
 double helmholtz_d2pdrho2_T(FluidStateUnion vals, const FluidData *data, FpropsError *err);
@@ -148,6 +149,7 @@ PureFluid *helmholtz_prepare(const EosData *E, const ReferenceState *ref){
 	P->data->Tstar = I->T_c;
 	P->data->rhostar = I->rho_c;
 	P->data->cp0 = cp0_prepare(E->data.helm->ideal, P->data->R, P->data->T_c);
+	P->data->sat = NULL;
 
 	/* data specific to helmholtz correlations */
 #define H P->data->corr.helm
@@ -169,6 +171,7 @@ PureFluid *helmholtz_prepare(const EosData *E, const ReferenceState *ref){
 	FN(p); FN(u); FN(h); FN(s); FN(a); FN(g); FN(cp); FN(cv); FN(w);
 	FN(alphap); FN(betap); FN(dpdrho_T);
 	FN(sat);
+	FN(batch);
 #undef FN
 	P->setref_fn = refstate_set_for_phi0;
 
@@ -189,6 +192,8 @@ PureFluid *helmholtz_prepare(const EosData *E, const ReferenceState *ref){
 		//return NULL;
 	}
 
+	fprops_sat_cache_prepare(P);
+
 	// ref0 is not yet supported for this fluid type:
 	P->data->ref0 = (ReferenceState){FPROPS_REF_TPHG,{.tphg={298.15,0,NAN,NAN}}};
 
@@ -210,6 +215,7 @@ PureFluid *helmholtz_prepare(const EosData *E, const ReferenceState *ref){
 void helmholtz_destroy(PureFluid *P){
 	assert(FPROPS_HELMHOLTZ == P->data);
 	cp0_destroy(P->data->cp0);
+	fprops_sat_cache_destroy(P->data);
 	FPROPS_FREE(P->data->corr.helm);
 	FPROPS_FREE(P->data);
 	FPROPS_FREE(P);
@@ -265,7 +271,9 @@ double helmholtz_p(FluidStateUnion vals, const FluidData *data, FpropsError *err
 	//fprintf(stderr,"T = %f\n", T);
 	//fprintf(stderr,"rhob = %f, rhob* = %f, delta = %f\n", rho/HD->M, HD->rho_star/HD->M, delta);
 
-	double p = HD_R * T * rho * (1 + delta * helm_resid_del(tau,delta,HD));
+	HelmResidDerivs r;
+	helm_resid_derivs(tau,delta,HD,1,&r);
+	double p = HD_R * T * rho * (1 + delta * r.phir_d);
 #if 0
 	if(isnan(p)){
 		fprintf(stderr,"T = %.12e, rho = %.12e\n",T,rho);
@@ -301,7 +309,9 @@ double helmholtz_u(FluidStateUnion vals, const FluidData *data, FpropsError *err
 	fprintf(stderr,"R T = %f\n",HD_R * HD->T_star);
 #endif
 
-	return HD_R * HD->T_star * (ideal_phi_tau(tau,HD_CP0) + helm_resid_tau(tau,delta,HD));
+	HelmResidDerivs r;
+	helm_resid_derivs(tau,delta,HD,1,&r);
+	return HD_R * HD->T_star * (ideal_phi_tau(tau,HD_CP0) + r.phir_t);
 }
 
 /**
@@ -322,8 +332,10 @@ double helmholtz_h(FluidStateUnion vals, const FluidData *data, FpropsError *err
 	assert(!isnan(delta));
 	assert(!isnan(HD_R));
 //#endif
-	double h = HD_R * T * (1 + tau * (ideal_phi_tau(tau,HD_CP0) + helm_resid_tau(tau,delta,HD)) \
-		+ delta*helm_resid_del(tau,delta,HD));
+	HelmResidDerivs r;
+	helm_resid_derivs(tau,delta,HD,1,&r);
+	double h = HD_R * T * (1 + tau * (ideal_phi_tau(tau,HD_CP0) + r.phir_t) \
+		+ delta*r.phir_d);
 	assert(!isnan(h));
 	return h;
 }
@@ -351,9 +363,11 @@ double helmholtz_s(FluidStateUnion vals, const FluidData *data, FpropsError *err
 	fprintf(stderr,"ideal_phi = %f\n",ideal_phi(tau,delta,HD_CP0));
 	fprintf(stderr,"helm_resid = %f\n",helm_resid(tau,delta,HD));
 #endif
+	HelmResidDerivs r;
+	helm_resid_derivs(tau,delta,HD,1,&r);
 	return HD_R * (
-		tau * (ideal_phi_tau(tau,HD_CP0) + helm_resid_tau(tau,delta,HD))
-		- (ideal_phi(tau,delta,HD_CP0) + helm_resid(tau,delta,HD))
+		tau * (ideal_phi_tau(tau,HD_CP0) + r.phir_t)
+		- (ideal_phi(tau,delta,HD_CP0) + r.phir)
 	);
 }
 
@@ -381,7 +395,9 @@ double helmholtz_a(FluidStateUnion vals, const FluidData *data, FpropsError *err
 	fprintf(stderr,"multiplying by RT = %f\n",HD_R*T);
 #endif
 
-	return HD_R * T * (ideal_phi(tau,delta,HD_CP0) + helm_resid(tau,delta,HD));
+	HelmResidDerivs r;
+	helm_resid_derivs(tau,delta,HD,1,&r);
+	return HD_R * T * (ideal_phi(tau,delta,HD_CP0) + r.phir);
 }
 
 /**
@@ -395,7 +411,9 @@ double helmholtz_a(FluidStateUnion vals, const FluidData *data, FpropsError *err
 double helmholtz_cv(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
 
-	return - HD_R * SQ(tau) * (ideal_phi_tautau(tau,HD_CP0) + helm_resid_tautau(tau,delta,HD));
+	HelmResidDerivs r;
+	helm_resid_derivs(tau,delta,HD,2,&r);
+	return - HD_R * SQ(tau) * (ideal_phi_tautau(tau,HD_CP0) + r.phir_tt);
 }
 
 /**
@@ -409,14 +427,13 @@ double helmholtz_cv(FluidStateUnion vals, const FluidData *data, FpropsError *er
 double helmholtz_cp(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
 
-	double phir_d = helm_resid_del(tau,delta,HD);
-	double phir_dd = helm_resid_deldel(tau,delta,HD);
-	double phir_dt = helm_resid_deltau(tau,delta,HD);
+	HelmResidDerivs r;
+	helm_resid_derivs(tau,delta,HD,2,&r);
 
 	/* note similarities with helmholtz_w */
-	double temp1 = 1 + 2*delta*phir_d + SQ(delta)*phir_dd;
-	double temp2 = 1 + delta*phir_d - delta*tau*phir_dt;
-	double temp3 = -SQ(tau)*(ideal_phi_tautau(tau,HD_CP0) + helm_resid_tautau(tau,delta,HD));
+	double temp1 = 1 + 2*delta*r.phir_d + SQ(delta)*r.phir_dd;
+	double temp2 = 1 + delta*r.phir_d - delta*tau*r.phir_dt;
+	double temp3 = -SQ(tau)*(ideal_phi_tautau(tau,HD_CP0) + r.phir_tt);
 
 	return HD_R * (temp3 + SQ(temp2)/temp1);
 }
@@ -433,14 +450,13 @@ double helmholtz_cp(FluidStateUnion vals, const FluidData *data, FpropsError *er
 double helmholtz_w(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
 
-	double phir_d = helm_resid_del(tau,delta,HD);
-	double phir_dd = helm_resid_deldel(tau,delta,HD);
-	double phir_dt = helm_resid_deltau(tau,delta,HD);
+	HelmResidDerivs r;
+	helm_resid_derivs(tau,delta,HD,2,&r);
 
 	/* note similarities with helmholtz_cp */
-	double temp1 = 1. + 2.*delta*phir_d + SQ(delta)*phir_dd;
-	double temp2 = 1. + delta*phir_d - delta*tau*phir_dt;
-	double temp3 = -SQ(tau)*(ideal_phi_tautau(tau,HD_CP0) + helm_resid_tautau(tau,delta,HD));
+	double temp1 = 1. + 2.*delta*r.phir_d + SQ(delta)*r.phir_dd;
+	double temp2 = 1. + delta*r.phir_d - delta*tau*r.phir_dt;
+	double temp3 = -SQ(tau)*(ideal_phi_tautau(tau,HD_CP0) + r.phir_tt);
 
 	return sqrt(HD_R * T * (temp1 + SQ(temp2)/temp3));
 
@@ -457,11 +473,11 @@ double helmholtz_w(FluidStateUnion vals, const FluidData *data, FpropsError *err
 double helmholtz_g(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
 
-	double phir_d = helm_resid_del(tau,delta,HD);
-	double phir = helm_resid(tau,delta,HD);
+	HelmResidDerivs r;
+	helm_resid_derivs(tau,delta,HD,1,&r);
 	double phi0 = ideal_phi(tau,delta,HD_CP0);
 
-	return HD_R * T * (phi0 + phir + 1. + delta * phir_d);
+	return HD_R * T * (phi0 + r.phir + 1. + delta * r.phir_d);
 }
 
 /**
@@ -470,9 +486,9 @@ double helmholtz_g(FluidStateUnion vals, const FluidData *data, FpropsError *err
 */
 double helmholtz_alphap(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
-	double phir_d = helm_resid_del(tau,delta,HD);
-	double phir_dt = helm_resid_deltau(tau,delta,HD);
-	return 1./T * (1. - delta*tau*phir_dt/(1 + delta*phir_d));
+	HelmResidDerivs r;
+	helm_resid_derivs(tau,delta,HD,2,&r);
+	return 1./T * (1. - delta*tau*r.phir_dt/(1 + delta*r.phir_d));
 }
 
 /**
@@ -481,9 +497,9 @@ double helmholtz_alphap(FluidStateUnion vals, const FluidData *data, FpropsError
 */
 double helmholtz_betap(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
-	double phir_d = helm_resid_del(tau,delta,HD);
-	double phir_dd = helm_resid_deldel(tau,delta,HD);
-	return rho*(1. + (delta*phir_d + SQ(delta)*phir_dd)/(1+delta*phir_d));
+	HelmResidDerivs r;
+	helm_resid_derivs(tau,delta,HD,2,&r);
+	return rho*(1. + (delta*r.phir_d + SQ(delta)*r.phir_dd)/(1+delta*r.phir_d));
 }
 
 /*----------------------------------------------------------------------------
@@ -496,8 +512,10 @@ double helmholtz_betap(FluidStateUnion vals, const FluidData *data, FpropsError
 double helmholtz_dpdT_rho(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
 
-	double phir_del = helm_resid_del(tau,delta,HD);
-	double phir_deltau = helm_resid_deltau(tau,delta,HD);
+	HelmResidDerivs r;
+	helm_resid_derivs(tau,delta,HD,2,&r);
+	double phir_del = r.phir_d;
+	double phir_deltau = r.phir_dt;
 #ifdef TEST
 	assert(!isinf(phir_del));
 	assert(!isinf(phir_deltau));
@@ -523,8 +541,10 @@ double helmholtz_dpdT_rho(FluidStateUnion vals, const FluidData *data, FpropsErr
 double helmholtz_dpdrho_T(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
 	//MSG("...");
-	double phir_del = helm_resid_del(tau,delta,HD);
-	double phir_deldel = helm_resid_deldel(tau,delta,HD);
+	HelmResidDerivs r;
+	helm_resid_derivs(tau,delta,HD,2,&r);
+	double phir_del = r.phir_d;
+	double phir_deldel = r.phir_dd;
 #ifdef TEST
 	assert(!isinf(phir_del));
 	assert(!isinf(phir_deldel));
@@ -536,9 +556,11 @@ double helmholtz_dpdrho_T(FluidStateUnion vals, const FluidData *data, FpropsErr
 double helmholtz_d2pdrho2_T(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
 
-	double phir_del = helm_resid_del(tau,delta,HD);
-	double phir_deldel = helm_resid_deldel(tau,delta,HD);
-	double phir_deldeldel = helm_resid_deldeldel(tau,delta,HD);
+	HelmResidDerivs r;
+	helm_resid_derivs(tau,delta,HD,3,&r);
+	double phir_del = r.phir_d;
+	double phir_deldel = r.phir_dd;
+	double phir_deldeldel = r.phir_ddd;
 #ifdef TEST
 	assert(!isinf(phir_del));
 	assert(!isinf(phir_deldel));
@@ -554,9 +576,11 @@ double helmholtz_d2pdrho2_T(FluidStateUnion vals, const FluidData *data, FpropsE
 double helmholtz_dhdT_rho(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
 
-	double phir_del = helm_resid_del(tau,delta,HD);
-	double phir_deltau = helm_resid_deltau(tau,delta,HD);
-	double phir_tautau = helm_resid_tautau(tau,delta,HD);
+	HelmResidDerivs r;
+	helm_resid_derivs(tau,delta,HD,2,&r);
+	double phir_del = r.phir_d;
+	double phir_deltau = r.phir_dt;
+	double phir_tautau = r.phir_tt;
 	double phi0_tautau = ideal_phi_tautau(tau,HD_CP0);
 
 	//fprintf(stderr,"phir_del = %f, phir_deltau = %f, phir_tautau = %f, phi0_tautau = %f\n",phir_del,phir_deltau,phir_tautau,phi0_tautau);
@@ -571,9 +595,11 @@ double helmholtz_dhdT_rho(FluidStateUnion vals, const FluidData *data, FpropsErr
 double helmholtz_dhdrho_T(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
 
-	double phir_del = helm_resid_del(tau,delta,HD);
-	double phir_deltau = helm_resid_deltau(tau,delta,HD);
-	double phir_deldel = helm_resid_deldel(tau,delta,HD);
+	HelmResidDerivs r;
+	helm_resid_derivs(tau,delta,HD,2,&r);
+	double phir_del = r.phir_d;
+	double phir_deltau = r.phir_dt;
+	double phir_deldel = r.phir_dd;
 
 	return HD_R * T / rho * (tau*delta*(0 + phir_deltau) + delta * phir_del + SQ(delta)*phir_deldel);
 }
@@ -585,7 +611,9 @@ double helmholtz_dhdrho_T(FluidStateUnion vals, const FluidData *data, FpropsErr
 double helmholtz_dudT_rho(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
 
-	double phir_tautau = helm_resid_tautau(tau,delta,HD);
+	HelmResidDerivs r;
+	helm_resid_derivs(tau,delta,HD,2,&r);
+	double phir_tautau = r.phir_tt;
 	double phi0_tautau = ideal_phi_tautau(tau,HD_CP0);
 
 	return -HD_R * SQ(tau) * (phi0_tautau + phir_tautau);
@@ -598,11 +626,122 @@ double helmholtz_dudT_rho(FluidStateUnion vals, const FluidData *data, FpropsErr
 double helmholtz_dudrho_T(FluidStateUnion vals, const FluidData *data, FpropsError *err){
 	DEFINE_TD;
 
-	double phir_deltau = helm_resid_deltau(tau,delta,HD);
+	HelmResidDerivs r;
+	helm_resid_derivs(tau,delta,HD,2,&r);
+
+	return HD_R * T / rho * (tau * delta * r.phir_dt);
+}
+
+
+/**
+	Evaluate one property at many (T,rho) states (the BatchEvalFn of Helmholtz
+	fluids). States are taken in blocks of HELM_BATCH_MAX and the residual
+	terms evaluated for a whole block by helm_resid_derivs_batch; the ideal
+	part and the combination into the requested property follow per state.
+	Like the other helmholtz_* functions, phase equilibrium is not considered.
+*/
+void helmholtz_batch(FpropsBatchProp prop, size_t n, const double *T
+	, const double *rho, double *out, const FluidData *data, FpropsError *err
+){
+	double tau[HELM_BATCH_MAX], delta[HELM_BATCH_MAX];
+	double phir[HELM_BATCH_MAX], phir_d[HELM_BATCH_MAX], phir_t[HELM_BATCH_MAX];
+	double phir_dd[HELM_BATCH_MAX], phir_dt[HELM_BATCH_MAX], phir_tt[HELM_BATCH_MAX];
+	HelmResidDerivsBatch r = {phir, phir_d, phir_t, phir_dd, phir_dt, phir_tt};
+	int order = (prop >= FPROPS_BATCH_CV ? 2 : 1);
+	size_t k0;
+	unsigned k, m;
+
+	for(k0=0; k0<n; k0+=m){
+		const double *Tb = T + k0;
+		double *o = out + k0;
+		m = (n - k0 > HELM_BATCH_MAX ? HELM_BATCH_MAX : (unsigned)(n - k0));
+		for(k=0; k<m; ++k){
+			tau[k] = HD->T_star / Tb[k];
+			delta[k] = rho[k0 + k] / HD->rho_star;
+		}
+		helm_resid_derivs_batch(tau, delta, m, HD, order, &r);
 
-	return HD_R * T / rho * (tau * delta * phir_deltau);
+		switch(prop){
+		case FPROPS_BATCH_P:
+			for(k=0; k<m; ++k){
+				o[k] = HD_R * Tb[k] * rho[k0 + k] * (1 + delta[k] * phir_d[k]);
+			}
+			break;
+		case FPROPS_BATCH_U:
+			for(k=0; k<m; ++k){
+				o[k] = HD_R * HD->T_star * (ideal_phi_tau(tau[k],HD_CP0) + phir_t[k]);
+			}
+			break;
+		case FPROPS_BATCH_H:
+			for(k=0; k<m; ++k){
+				o[k] = HD_R * Tb[k] * (1 + tau[k] * (ideal_phi_tau(tau[k],HD_CP0) + phir_t[k])
+					+ delta[k] * phir_d[k]);
+			}
+			break;
+		case FPROPS_BATCH_S:
+			for(k=0; k<m; ++k){
+				o[k] = HD_R * (tau[k] * (ideal_phi_tau(tau[k],HD_CP0) + phir_t[k])
+					- (ideal_phi(tau[k],delta[k],HD_CP0) + phir[k]));
+			}
+			break;
+		case FPROPS_BATCH_A:
+			for(k=0; k<m; ++k){
+				o[k] = HD_R * Tb[k] * (ideal_phi(tau[k],delta[k],HD_CP0) + phir[k]);
+			}
+			break;
+		case FPROPS_BATCH_G:
+			for(k=0; k<m; ++k){
+				o[k] = HD_R * Tb[k] * (ideal_phi(tau[k],delta[k],HD_CP0) + phir[k]
+					+ 1. + delta[k] * phir_d[k]);
+			}
+			break;
+		case FPROPS_BATCH_CV:
+			for(k=0; k<m; ++k){
+				o[k] = - HD_R * SQ(tau[k]) * (ideal_phi_tautau(tau[k],HD_CP0) + phir_tt[k]);
+			}
+			break;
+		case FPROPS_BATCH_CP:
+		case FPROPS_BATCH_W:
+			for(k=0; k<m; ++k){
+				/* as in helmholtz_cp and helmholtz_w */
+				double temp1 = 1. + 2.*delta[k]*phir_d[k] + SQ(delta[k])*phir_dd[k];
+				double temp2 = 1. + delta[k]*phir_d[k] - delta[k]*tau[k]*phir_dt[k];
+				double temp3 = -SQ(tau[k])*(ideal_phi_tautau(tau[k],HD_CP0) + phir_tt[k]);
+				if(prop == FPROPS_BATCH_CP){
+					o[k] = HD_R * (temp3 + SQ(temp2)/temp1);
+				}else{
+					o[k] = sqrt(HD_R * Tb[k] * (temp1 + SQ(temp2)/temp3));
+				}
+			}
+			break;
+		default:
+			*err = FPROPS_INVALID_REQUEST;
+			return;
+		}
+		for(k=0; k<m; ++k){
+			if(isnan(o[k]))*err = FPROPS_NUMERIC_ERROR;
+		}
+	}
 }
 
+/**
+	Pressure, Gibbs energy and dp/drho at constant T, as needed for each
+	iteration of helmholtz_sat, from a single evaluation of the residual
+	terms (same values as helmholtz_p, helmholtz_a + p/rho and
+	helmholtz_dpdrho_T).
+*/
+static void helmholtz_sat_eval(double T, double rho, const FluidData *data
+	, double *p, double *g, double *dpdrho, FpropsError *err
+){
+	double tau = data->corr.helm->T_star / T;
+	double delta = rho / data->corr.helm->rho_star;
+	HelmResidDerivs r;
+	helm_resid_derivs(tau,delta,HD,2,&r);
+	*p = HD_R * T * rho * (1 + delta * r.phir_d);
+	if(isnan(*p))*err = FPROPS_NUMERIC_ERROR;
+	*g = HD_R * T * (ideal_phi(tau,delta,HD_CP0) + r.phir) + *p/rho;
+	*dpdrho = HD_R * T * (1 + 2*delta*r.phir_d + SQ(delta)*r.phir_dd);
+}
 
 /**
 	Solve saturation condition for a specified temperature using approach of
@@ -637,10 +776,20 @@ double helmholtz_sat(double T, double *rhof_out, double * rhog_out, const FluidD
 	// or maybe there's a problem with the acentric factor or something like
 	// that. This factor 0.4 will be slowing down the whole system, so it's not
 	// good. TODO XXX.
+	// Starting from the saturation curve cache, full Newton steps are used,
+	// with a restart from the correlations if that doesn't converge quickly.
 
 	// initial guesses for liquid and vapour density
-	double rhof = 1.1 * fprops_rhof_T_rackett(T,data);
-	double rhog= 0.9 * fprops_rhog_T_chouaieb(T,data);
+	double psat, rhof, rhog, gamma;
+	FpropsError err0 = *err;
+	int warm = !fprops_sat_guess(T, &psat, &rhof, &rhog, data);
+	if(warm){
+		gamma = 1.0;
+	}else{
+		rhof = 1.1 * fprops_rhof_T_rackett(T,data);
+		rhog = 0.9 * fprops_rhog_T_chouaieb(T,data);
+		gamma = 0.40;
+	}
 	double R = data->R;
 	double pc = data->p_c;
 
@@ -651,18 +800,25 @@ double helmholtz_sat(double T, double *rhof_out, double * rhog_out, const FluidD
 
 	int i = 0;
 	while(i++ < 200){
+		if(warm && (i > 20 || isnan(rhof) || isnan(rhog))){
+			MSG("Restarting from correlations at T = %f",T);
+			warm = 0;
+			i = 0;
+			rhof = 1.1 * fprops_rhof_T_rackett(T,data);
+			rhog = 0.9 * fprops_rhog_T_chouaieb(T,data);
+			gamma = 0.40;
+			*err = err0;
+			continue;
+		}
 		assert(!isnan(rhog));
 		assert(!isnan(rhof));
 #ifdef SAT_DEBUG
 		MSG("iter %d: T = %f, rhof = %f, rhog = %f",i,T, rhof, rhog);
 #endif
 
-		double pf = helmholtz_p((FluidStateUnion){.Trho={T,rhof}},data,err);
-		double pg = helmholtz_p((FluidStateUnion){.Trho={T,rhog}},data,err);
-		double gf = helmholtz_a((FluidStateUnion){.Trho={T,rhof}},data,err) + pf/rhof;
-		double gg = helmholtz_a((FluidStateUnion){.Trho={T,rhog}},data,err) + pg/rhog;
-		double dpdrf = helmholtz_dpdrho_T((FluidStateUnion){.Trho={T,rhof}},data,err);
-		double dpdrg = helmholtz_dpdrho_T((FluidStateUnion){.Trho={T,rhog}},data,err);
+		double pf, pg, gf, gg, dpdrf, dpdrg;
+		helmholtz_sat_eval(T,rhof,data,&pf,&gf,&dpdrf,err);
+		helmholtz_sat_eval(T,rhog,data,&pg,&gg,&dpdrg,err);
 
 		// jacobian for [F;G](rhof, rhog) --- derivatives wrt rhof and rhog
 		double F = (pf - pg)/pc;
@@ -689,13 +845,14 @@ double helmholtz_sat(double T, double *rhof_out, double * rhog_out, const FluidD
 
 		// 'gamma' needs to be increased to 0.5 for water to solve correctly (see 'test/sat.c')
 		// 'gamma' needs to be not more than 0.4 for ethanol to solve correctly (see 'test/sat.c')
-#define gamma 0.40
 		rhof += gamma/DET * (Fg*G - Gg*F);
 		rhog += gamma/DET * ( Gf*F - Ff*G);
-#undef gamma
 
-		assert(!isnan(rhof));
-		assert(!isnan(rhog));
+		/* a NaN from a warm start is dealt with by the restart above */
+		if(!warm){
+			assert(!isnan(rhof));
+			assert(!isnan(rhog));
+		}
 
 		if(rhog < 0)rhog = -0.5*rhog;
 		if(rhof < 0)rhof = -0.5*rhof;
@@ -796,11 +953,13 @@ static double ipow(double x, int n){
 #define DEFINE_D3PSIDDELTA3 \
 	double d3PSIddelta3 = -4. * d1 * SQ(ct->C) * (2.*d12*ct->C - 3.) * PSI
 
+/* needs DEFINE_D2DELDDELTA2 (for powd12bm1) */
 #define DEFINE_D3DELDDELTA3 \
-	double d3DELddelta3 = 1./(d1*d12*ct->beta*SQ(ct->beta)) * (\
-		4*ct->B*ct->a*(1.+ct->a*(2*ct->a-3))*SQ(ct->beta)*pow(d12,ct->a)\
-		+ ct->A * (1.+ct->beta*(2*ct->beta-3))*pow(d12,0.5/ct->beta)\
-	)
+	double dthetaddelta = ct->A/ct->beta * d1 * powd12bm1; \
+	double d2thetaddelta2 = ct->A/ct->beta * (1./ct->beta - 1.) * powd12bm1; \
+	double d3thetaddelta3 = 2. * d2thetaddelta2 * (0.5/ct->beta - 1.) * d1 / d12; \
+	double d3DELddelta3 = 6. * dthetaddelta * d2thetaddelta2 + 2. * theta * d3thetaddelta3 \
+		+ 4. * ct->B * ct->a * (2. * ct->a - 1.) * (ct->a - 1.) * d1 * pow(d12, ct->a - 2.)
 
 #define DEFINE_D3DELBDDELTA3 \
 	double d3DELbddelta3 = ct->b / (DELTA*SQ(DELTA)) * ( \
@@ -809,6 +968,312 @@ static double ipow(double x, int n){
 		+ 3*(ct->b-1) * DELB * DELTA * dDELddelta * d2DELddelta2 \
 	)
 
+/*
+	Critical terms of the second kind, added to r unscaled (as in
+	helm_resid_del, helm_resid_deldel etc). Shared by the fused kernels.
+*/
+static void helm_resid_crit_derivs(double tau, double delta
+	, const HelmholtzRunData *HD, int order, HelmResidDerivs *r
+){
+	unsigned n, i;
+	const HelmholtzCritTerm *ct;
+
+	n = HD->nc;
+	ct = &(HD->ct[0]);
+	for(i=0; i<n; ++i){
+		DEFINE_DELTA;
+		DEFINE_DELB;
+		DEFINE_DPSIDDELTA;
+		DEFINE_DDELDDELTA;
+		DEFINE_DDELBDDELTA;
+		DEFINE_DDELBDTAU;
+		DEFINE_DPSIDTAU;
+
+		r->phir += ct->n * DELB * delta * PSI;
+		r->phir_d += ct->n * (DELB * (PSI + delta * dPSIddelta) + dDELbddelta * delta * PSI);
+		r->phir_t += ct->n * delta * (dDELbdtau * PSI + DELB * dPSIdtau);
+		if(order >= 2){
+			DEFINE_D2DELDDELTA2;
+			DEFINE_D2DELBDDELTA2;
+			DEFINE_D2PSIDDELTA2;
+			double d2DELbddeldtau = -ct->A * ct->b * 2./ct->beta * (DELB/DELTA)*d1*powd12bm1 \
+				- 2. * theta * ct->b * (ct->b - 1) * (DELB/SQ(DELTA)) * dDELddelta;
+			double d2PSIddeldtau = 4. * ct->C*ct->D*d1*t1*PSI;
+			double d2DELbdtau2 = 2. * ct->b * (DELB/DELTA) + 4. * SQ(theta) * ct->b * (ct->b - 1) * (DELB/SQ(DELTA));
+			double d2PSIdtau2 = 2. * ct->D * PSI * (2. * ct->D * SQ(t1) -1.);
+
+			r->phir_dd += ct->n * (DELB*(2.*dPSIddelta + delta*d2PSIddelta2) + 2.*dDELbddelta*(PSI+delta*dPSIddelta) + d2DELbddelta2*delta*PSI);
+			r->phir_dt += ct->n * (DELB * (dPSIdtau + delta * d2PSIddeldtau) \
+				+ delta *dDELbdtau*dPSIdtau \
+				+ dDELbdtau*(PSI+delta*dPSIddelta) \
+				+ d2DELbddeldtau*delta*PSI
+			);
+			r->phir_tt += ct->n * delta * (d2DELbdtau2 * PSI + 2 * dDELbdtau*dPSIdtau + DELB * d2PSIdtau2);
+			if(order >= 3){
+				DEFINE_D3PSIDDELTA3;
+				DEFINE_D3DELDDELTA3;
+				DEFINE_D3DELBDDELTA3;
+				r->phir_ddd += ct->n * (
+					delta * (DELB*d3PSIddelta3 + 3 * dDELbddelta * d2PSIddelta2 + 3 * d2DELbddelta2 * dPSIddelta + PSI * d3DELbddelta3)
+					+ 3 * (DELB*d2PSIddelta2 +  2 *  dDELbddelta * dPSIddelta + d2DELbddelta2 * PSI)
+				);
+			}
+		}
+		++ct;
+	}
+}
+
+/*
+	Fused evaluation of phir and its derivatives. Each term is written as
+	base * f(delta) * g(tau), where 'base' is the value of the term, and the
+	derivatives of f and g are taken relative to f and g themselves. For
+	example delta * d(phir)/d(delta) is the sum over the terms of base * G1,
+	with G1 = delta f'/f. Once 'base' (which holds all of the pow and exp
+	calls) is known, all the derivatives of a term cost only a few
+	multiplications. The scaled sums are divided by powers of tau and delta
+	at the end.
+
+	For power terms, f = delta^d exp(-delta^l) and g = tau^t. With
+	L = l delta^l, the delta-derivatives of ln f scaled by powers of delta are
+		G1 = d - L,  G2 = -d - (l-1) L,  G3 = 2 d - (l-1)(l-2) L
+	and delta^2 f''/f = G1^2 + G2, delta^3 f'''/f = G1^3 + 3 G1 G2 + G3.
+	Gaussian terms have f = delta^d exp(-alpha (delta-epsilon)^2) and similarly
+	for g, giving G1 = d - 2 alpha delta (delta-epsilon), G2 = -d - 2 alpha
+	delta^2, G3 = 2 d.
+*/
+void helm_resid_derivs(double tau, double delta, const HelmholtzRunData *HD
+	, int order, HelmResidDerivs *r
+){
+	double dell, E, base, G1, G2, H1, H2;
+	/* sums for terms sharing an exponential, and the scaled totals */
+	double s0, sd, st, sdd, sdt, stt, sddd;
+	double r0 = 0, rd = 0, rt = 0, rdd = 0, rdt = 0, rtt = 0, rddd = 0;
+	unsigned n, i, oldl;
+	const HelmholtzPowTerm *pt;
+	const HelmholtzGausTerm *gt;
+
+	if(delta == 0){
+		/* the scaled sums can't be divided by delta: evaluate one by one */
+		r->phir = helm_resid(tau,delta,HD);
+		r->phir_d = helm_resid_del(tau,delta,HD);
+		r->phir_t = helm_resid_tau(tau,delta,HD);
+		r->phir_dd = r->phir_dt = r->phir_tt = r->phir_ddd = 0;
+		if(order >= 2){
+			r->phir_dd = helm_resid_deldel(tau,delta,HD);
+			r->phir_dt = helm_resid_deltau(tau,delta,HD);
+			r->phir_tt = helm_resid_tautau(tau,delta,HD);
+		}
+		if(order >= 3){
+			r->phir_ddd = helm_resid_deldeldel(tau,delta,HD);
+		}
+		return;
+	}
+
+	/* power terms */
+	n = HD->np;
+	pt = &(HD->pt[0]);
+	s0 = sd = st = sdd = sdt = stt = sddd = 0;
+	dell = (n ? ipow(delta,pt->l) : 0);
+	for(i=0; i<n; ++i){
+		double L = pt->l * dell;
+		base = pt->a * pow(tau, pt->t) * ipow(delta, pt->d);
+		G1 = pt->d - L;
+		s0 += base;
+		sd += base * G1;
+		st += base * pt->t;
+		if(order >= 2){
+			G2 = -pt->d - (pt->l - 1.) * L;
+			sdd += base * (SQ(G1) + G2);
+			sdt += base * G1 * pt->t;
+			stt += base * pt->t * (pt->t - 1);
+			if(order >= 3){
+				sddd += base * (G1 * (SQ(G1) + 3. * G2)
+					+ 2. * pt->d - (pt->l - 1.) * (pt->l - 2.) * L);
+			}
+		}
+		oldl = pt->l;
+		++pt;
+		if(i+1==n || oldl != pt->l){
+			E = (oldl == 0 ? 1. : exp(-dell));
+			r0 += s0 * E; rd += sd * E; rt += st * E;
+			rdd += sdd * E; rdt += sdt * E; rtt += stt * E; rddd += sddd * E;
+			s0 = sd = st = sdd = sdt = stt = sddd = 0;
+			if(i+1<n){
+				dell = ipow(delta,pt->l);
+			}
+		}
+	}
+
+	/* gaussian terms */
+	n = HD->ng;
+	gt = &(HD->gt[0]);
+	for(i=0; i<n; ++i){
+		double d1 = delta - gt->epsilon;
+		double t1 = tau - gt->gamma;
+		base = gt->n * pow(tau,gt->t) * pow(delta,gt->d)
+			* exp(-gt->alpha*SQ(d1) - gt->beta*SQ(t1));
+		G1 = gt->d - 2. * gt->alpha * delta * d1;
+		H1 = gt->t - 2. * gt->beta * tau * t1;
+		r0 += base;
+		rd += base * G1;
+		rt += base * H1;
+		if(order >= 2){
+			G2 = -gt->d - 2. * gt->alpha * SQ(delta);
+			H2 = -gt->t - 2. * gt->beta * SQ(tau);
+			rdd += base * (SQ(G1) + G2);
+			rdt += base * G1 * H1;
+			rtt += base * (SQ(H1) + H2);
+			if(order >= 3){
+				rddd += base * (G1 * (SQ(G1) + 3. * G2) + 2. * gt->d);
+			}
+		}
+		++gt;
+	}
+
+	r->phir = r0;
+	r->phir_d = rd / delta;
+	r->phir_t = rt / tau;
+	r->phir_dd = rdd / SQ(delta);
+	r->phir_dt = rdt / (delta * tau);
+	r->phir_tt = rtt / SQ(tau);
+	r->phir_ddd = rddd / (delta * SQ(delta));
+
+	helm_resid_crit_derivs(tau,delta,HD,order,r);
+}
+
+/*
+	Batch form of helm_resid_derivs. The power and Gaussian terms are summed
+	as in the scalar version, but with each term written as a single
+	exponential, base = a exp(t ln(tau) + d ln(delta) - delta^l), so that the
+	inner loop over the states has no data-dependent branches or integer
+	powers. ln(tau), ln(delta) and delta^l are worked out once per state (and
+	per distinct l) before the term loops. States with delta <= 0, where the
+	logarithm is not defined, are redone with the scalar kernel.
+*/
+void helm_resid_derivs_batch(const double *tau, const double *delta, unsigned n
+	, const HelmholtzRunData *HD, int order, HelmResidDerivsBatch *r
+){
+	double lt[HELM_BATCH_MAX], ld[HELM_BATCH_MAX], dell[HELM_BATCH_MAX];
+	double b[HELM_BATCH_MAX];
+	double *r0 = r->phir, *rd = r->phir_d, *rt = r->phir_t;
+	double *rdd = r->phir_dd, *rdt = r->phir_dt, *rtt = r->phir_tt;
+	unsigned i, k, np, ng, l;
+	const HelmholtzPowTerm *pt;
+	const HelmholtzGausTerm *gt;
+
+	assert(n <= HELM_BATCH_MAX);
+	for(k=0; k<n; ++k){
+		lt[k] = log(tau[k]);
+		ld[k] = log(delta[k]);
+		dell[k] = 0;
+		r0[k] = rd[k] = rt[k] = 0;
+	}
+	if(order >= 2){
+		for(k=0; k<n; ++k){
+			rdd[k] = rdt[k] = rtt[k] = 0;
+		}
+	}
+
+	/* power terms; the data lists them grouped by l */
+	np = HD->np;
+	pt = &(HD->pt[0]);
+	l = 0;
+	for(i=0; i<np; ++i, ++pt){
+		const double a = pt->a, t = pt->t, d = pt->d, lm1 = pt->l - 1.;
+		if(pt->l != l){
+			l = pt->l;
+			for(k=0; k<n; ++k){
+				dell[k] = (l == 0 ? 0. : ipow(delta[k],l));
+			}
+		}
+		for(k=0; k<n; ++k){
+			b[k] = a * exp(t * lt[k] + d * ld[k] - dell[k]);
+		}
+		for(k=0; k<n; ++k){
+			double G1 = d - l * dell[k];
+			r0[k] += b[k];
+			rd[k] += b[k] * G1;
+			rt[k] += b[k] * t;
+		}
+		if(order >= 2){
+			for(k=0; k<n; ++k){
+				double G1 = d - l * dell[k];
+				double G2 = -d - lm1 * l * dell[k];
+				rdd[k] += b[k] * (G1 * G1 + G2);
+				rdt[k] += b[k] * G1 * t;
+				rtt[k] += b[k] * t * (t - 1.);
+			}
+		}
+	}
+
+	/* gaussian terms */
+	ng = HD->ng;
+	gt = &(HD->gt[0]);
+	for(i=0; i<ng; ++i, ++gt){
+		const double c = gt->n, t = gt->t, d = gt->d;
+		const double alpha = gt->alpha, beta = gt->beta;
+		const double gam = gt->gamma, eps = gt->epsilon;
+		for(k=0; k<n; ++k){
+			double d1 = delta[k] - eps;
+			double t1 = tau[k] - gam;
+			b[k] = c * exp(t * lt[k] + d * ld[k] - alpha * d1 * d1 - beta * t1 * t1);
+		}
+		for(k=0; k<n; ++k){
+			double G1 = d - 2. * alpha * delta[k] * (delta[k] - eps);
+			double H1 = t - 2. * beta * tau[k] * (tau[k] - gam);
+			r0[k] += b[k];
+			rd[k] += b[k] * G1;
+			rt[k] += b[k] * H1;
+		}
+		if(order >= 2){
+			for(k=0; k<n; ++k){
+				double G1 = d - 2. * alpha * delta[k] * (delta[k] - eps);
+				double H1 = t - 2. * beta * tau[k] * (tau[k] - gam);
+				double G2 = -d - 2. * alpha * delta[k] * delta[k];
+				double H2 = -t - 2. * beta * tau[k] * tau[k];
+				rdd[k] += b[k] * (G1 * G1 + G2);
+				rdt[k] += b[k] * G1 * H1;
+				rtt[k] += b[k] * (H1 * H1 + H2);
+			}
+		}
+	}
+
+	/* unscale */
+	for(k=0; k<n; ++k){
+		rd[k] /= delta[k];
+		rt[k] /= tau[k];
+	}
+	if(order >= 2){
+		for(k=0; k<n; ++k){
+			rdd[k] /= delta[k] * delta[k];
+			rdt[k] /= delta[k] * tau[k];
+			rtt[k] /= tau[k] * tau[k];
+		}
+	}
+
+	/* critical terms, and any states the loops above couldn't handle */
+	for(k=0; k<n; ++k){
+		HelmResidDerivs s;
+		if(delta[k] <= 0){
+			helm_resid_derivs(tau[k],delta[k],HD,order,&s);
+		}else if(HD->nc){
+			s.phir = s.phir_d = s.phir_t = 0;
+			s.phir_dd = s.phir_dt = s.phir_tt = s.phir_ddd = 0;
+			helm_resid_crit_derivs(tau[k],delta[k],HD,order,&s);
+			s.phir += r0[k]; s.phir_d += rd[k]; s.phir_t += rt[k];
+			if(order >= 2){
+				s.phir_dd += rdd[k]; s.phir_dt += rdt[k]; s.phir_tt += rtt[k];
+			}
+		}else{
+			continue;
+		}
+		r0[k] = s.phir; rd[k] = s.phir_d; rt[k] = s.phir_t;
+		if(order >= 2){
+			rdd[k] = s.phir_dd; rdt[k] = s.phir_dt; rtt[k] = s.phir_tt;
+		}
+	}
+}
+
 /**
 	Residual part of helmholtz function.
 */
@@ -39,6 +39,57 @@ double helm_resid_tautau(double tau, double delta, const HelmholtzRunData *data)
 double helm_resid_deldeldel(double tau, double delta, const HelmholtzRunData *data);
 #endif
 
+/**
+	Residual part of the reduced Helmholtz function and its partial
+	derivatives at one point (tau, delta), as returned by helm_resid_derivs.
+	Suffix '_d' denotes a derivative with respect to delta, '_t' with respect
+	to tau.
+*/
+typedef struct HelmResidDerivs_struct{
+	double phir;
+	double phir_d, phir_t;
+	double phir_dd, phir_dt, phir_tt;
+	double phir_ddd;
+} HelmResidDerivs;
+
+/**
+	Evaluate the residual Helmholtz function and its derivatives in a single
+	pass over the power, Gaussian and critical terms, sharing the pow/exp
+	evaluations of each term among all the derivatives. Gives the same
+	results as helm_resid, helm_resid_del etc. called one at a time.
+
+	@param order 1 for phir and its first derivatives only, 2 to add the
+		second derivatives, 3 to add also phir_ddd. Fields beyond the
+		requested order are set to zero.
+*/
+void helm_resid_derivs(double tau, double delta, const HelmholtzRunData *data
+	, int order, HelmResidDerivs *r);
+
+/** Largest number of states accepted by one call of helm_resid_derivs_batch */
+#define HELM_BATCH_MAX 64
+
+/**
+	Structure-of-arrays form of HelmResidDerivs, for helm_resid_derivs_batch.
+	Arrays for derivatives beyond the requested order may be NULL.
+*/
+typedef struct HelmResidDerivsBatch_struct{
+	double *phir;
+	double *phir_d, *phir_t;
+	double *phir_dd, *phir_dt, *phir_tt;
+} HelmResidDerivsBatch;
+
+/**
+	Evaluate the residual Helmholtz function and its derivatives (up to
+	second order) at n states at once. The loops run over the terms on the
+	outside and over the states on the inside, so that the inner loops are
+	straight-line code on contiguous arrays which the compiler can vectorise.
+
+	@param n number of states, at most HELM_BATCH_MAX
+	@param order 1 or 2, as for helm_resid_derivs
+*/
+void helm_resid_derivs_batch(const double *tau, const double *delta, unsigned n
+	, const HelmholtzRunData *data, int order, HelmResidDerivsBatch *r);
+
 /*
 	Note: the cross partial derivative with respect to delta and tau is
 	identically zero
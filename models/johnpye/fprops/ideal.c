@@ -60,6 +60,7 @@
 PureFluid *ideal_prepare(const EosData *E, const ReferenceState *ref){
 	PureFluid *P = FPROPS_NEW(PureFluid);
 	P->data = FPROPS_NEW(FluidData);
+	P->data->sat = NULL;
 #define D P->data
 
 	//MSG("...");
@@ -125,6 +126,7 @@ PureFluid *ideal_prepare(const EosData *E, const ReferenceState *ref){
 	FN(dpdrho_T);
 	FN(sat);
 	P->setref_fn = refstate_set_for_phi0;
+	P->batch_fn = NULL;
 #undef FN
 
 	//MSG("Setting reference state...");
@@ -76,6 +76,7 @@ SatEvalFn incomp_sat;
 PureFluid *incomp_prepare(const EosData *E, const ReferenceState *ref){
 	PureFluid *P = FPROPS_NEW(PureFluid);
 	P->data = FPROPS_NEW(FluidData);
+	P->data->sat = NULL;
 #define D P->data
 #define I E->data.incomp
 
@@ -147,6 +148,7 @@ PureFluid *incomp_prepare(const EosData *E, const ReferenceState *ref){
 	FN(sat);
 #undef FN
 	P->setref_fn = &refstate_set_for_incomp;
+	P->batch_fn = NULL;
 
 	MSG("Setting reference state...");
 	// store the standard reference state, even if we're not using it now
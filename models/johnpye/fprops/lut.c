@@ -0,0 +1,802 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2024 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @file
+	Tabulated property backend; see lut.h.
+
+	Node values in both tables come straight from the wrapped EOS. Node
+	derivatives are estimated by finite differences over the neighbouring
+	nodes, which gives a C1 interpolant (good for the Newton solvers that
+	will use it) at the cost of fourth-order convergence, so the accuracy of
+	each cell is verified against the EOS at the quarter points of the cell
+	and of its edges (see lut_check_points) rather than assumed.
+*/
+
+#include "lut.h"
+#include "fprops.h"
+#include "sat.h"
+#include "solve_ph.h"
+#include "zeroin.h"
+#include "helmholtz.h"
+#include "pengrob.h"
+
+#include <math.h>
+#include <stdio.h>
+
+//#define LUT_DEBUG
+#define LUT_ERRORS
+
+#ifdef LUT_DEBUG
+# include "color.h"
+# define MSG FPROPS_MSG
+#else
+# define MSG(ARGS...) ((void)0)
+#endif
+
+#ifdef LUT_ERRORS
+# include "color.h"
+# define ERRMSG FPROPS_ERRMSG
+#else
+# define ERRMSG(ARGS...) ((void)0)
+#endif
+
+/* functions in the (T, ln rho) table */
+enum{LUT_P, LUT_U, LUT_H, LUT_S, LUT_CV, LUT_CP, LUT_W, LUT_NTRHO};
+/* functions in the (ln p, h) table */
+enum{LUT_T, LUT_LNRHO, LUT_NPH};
+
+static const FpropsBatchProp lut_trho_props[LUT_NTRHO] = {
+	FPROPS_BATCH_P, FPROPS_BATCH_U, FPROPS_BATCH_H, FPROPS_BATCH_S
+	, FPROPS_BATCH_CV, FPROPS_BATCH_CP, FPROPS_BATCH_W
+};
+
+#define LUT_NT_DEFAULT 100
+#define LUT_NRHO_DEFAULT 100
+#define LUT_NP_DEFAULT 100
+#define LUT_NH_DEFAULT 100
+#define LUT_TOL_DEFAULT 1e-6
+/* interpolation errors peak near, not at, the points where they are checked,
+so the check is made against a fraction of the requested tolerance */
+#define LUT_TOL_CHECK 0.5
+
+#define FSU_TRHO(T,RHO) (FluidStateUnion){.Trho={T, RHO}}
+#define STATE_NAN(FLUID) (FluidState2){.vals={.Trho={NAN,NAN}},.fluid=FLUID}
+#define STATE_TRHO(FLUID,T,RHO) (FluidState2){.vals={.Trho={T,RHO}},.fluid=FLUID}
+
+/* node data, and index of a cell's 'ok' flags */
+#define LUT_NODE(TAB,I,J) ((TAB)->f + (((size_t)(I)*(TAB)->ny + (J))*(TAB)->nf)*4)
+#define LUT_CELL(TAB,I,J) ((size_t)(I)*((TAB)->ny - 1) + (J))
+
+/*------------------------------------------------------------------------------
+  TABLE STORAGE AND INTERPOLATION
+*/
+
+static int lut_table_alloc(LutTable *t, unsigned nx, unsigned ny, unsigned nf
+	, double x0, double x1, double y0, double y1
+){
+	size_t i, nc = (size_t)(nx - 1)*(ny - 1);
+	t->nx = nx; t->ny = ny; t->nf = nf;
+	t->x0 = x0; t->dx = (x1 - x0)/(nx - 1);
+	t->y0 = y0; t->dy = (y1 - y0)/(ny - 1);
+	t->f = FPROPS_NEW_ARRAY(double,(size_t)nx*ny*nf*4);
+	t->ok = FPROPS_NEW_ARRAY(unsigned char,nc);
+	if(!t->f || !t->ok)return 1;
+	for(i = 0; i < nc; ++i)t->ok[i] = 0;
+	return 0;
+}
+
+static void lut_table_free(LutTable *t){
+	if(t->f)FPROPS_FREE(t->f);
+	if(t->ok)FPROPS_FREE(t->ok);
+	t->f = NULL;
+	t->ok = NULL;
+}
+
+/* derivative of f along a line of n nodes with the given stride, in units of
+the node spacing: fourth-order differences, one-sided near the ends */
+static double lut_fd(const double *f, unsigned n, unsigned i, size_t stride){
+	long s = (long)stride;
+	if(n < 5){
+		if(i == 0)return f[s] - f[0];
+		return f[i*s] - f[(i - 1)*s];
+	}
+	f += i*stride;
+	if(i == 0)return (-25*f[0] + 48*f[s] - 36*f[2*s] + 16*f[3*s] - 3*f[4*s])/12.;
+	if(i == 1)return (-3*f[-s] - 10*f[0] + 18*f[s] - 6*f[2*s] + f[3*s])/12.;
+	if(i == n - 2)return (3*f[s] + 10*f[0] - 18*f[-s] + 6*f[-2*s] - f[-3*s])/12.;
+	if(i == n - 1)return (25*f[0] - 48*f[-s] + 36*f[-2*s] - 16*f[-3*s] + 3*f[-4*s])/12.;
+	return (f[-2*s] - 8*f[-s] + 8*f[s] - f[2*s])/12.;
+}
+
+/* fill in node derivatives once the node values are set */
+static void lut_table_derivs(LutTable *t){
+	size_t si = (size_t)t->ny*t->nf*4, sj = (size_t)t->nf*4;
+	unsigned i, j, k;
+	for(i = 0; i < t->nx; ++i)for(j = 0; j < t->ny; ++j)for(k = 0; k < t->nf; ++k){
+		double *n = LUT_NODE(t,i,j) + 4*k;
+		n[1] = lut_fd(LUT_NODE(t,0,j) + 4*k, t->nx, i, si);
+		n[2] = lut_fd(LUT_NODE(t,i,0) + 4*k, t->ny, j, sj);
+	}
+	for(i = 0; i < t->nx; ++i)for(j = 0; j < t->ny; ++j)for(k = 0; k < t->nf; ++k){
+		LUT_NODE(t,i,j)[4*k + 3] = lut_fd(LUT_NODE(t,0,j) + 4*k + 2, t->nx, i, si);
+	}
+}
+
+/* cubic Hermite basis: value at 0, slope at 0, value at 1, slope at 1 */
+static void lut_basis(double u, double b[4]){
+	double u2 = u*u, u3 = u2*u;
+	b[0] = 2*u3 - 3*u2 + 1;
+	b[1] = u3 - 2*u2 + u;
+	b[2] = 3*u2 - 2*u3;
+	b[3] = u3 - u2;
+}
+
+/**
+	Find the cell containing (x,y) and its basis function values.
+	@return 0 if the point is inside the table and its cell can be
+	interpolated for all the functions in 'mask', else 1.
+*/
+static int lut_locate(const LutTable *t, double x, double y, unsigned mask
+	, unsigned *i, unsigned *j, double bu[4], double bv[4]
+){
+	double X = (x - t->x0)/t->dx, Y = (y - t->y0)/t->dy;
+	unsigned I, J;
+	if(!(X >= 0 && X <= t->nx - 1 && Y >= 0 && Y <= t->ny - 1))return 1;
+	I = (unsigned)X; if(I > t->nx - 2)I = t->nx - 2;
+	J = (unsigned)Y; if(J > t->ny - 2)J = t->ny - 2;
+	if((t->ok[LUT_CELL(t,I,J)] & mask) != mask)return 1;
+	lut_basis(X - I, bu);
+	lut_basis(Y - J, bv);
+	*i = I; *j = J;
+	return 0;
+}
+
+static double lut_interp(const LutTable *t, unsigned i, unsigned j
+	, const double bu[4], const double bv[4], unsigned k
+){
+	size_t si = (size_t)t->ny*t->nf*4, sj = (size_t)t->nf*4;
+	const double *f00 = LUT_NODE(t,i,j) + 4*k;
+	const double *f01 = f00 + sj, *f10 = f00 + si, *f11 = f10 + sj;
+	return bu[0]*(bv[0]*f00[0] + bv[1]*f00[2] + bv[2]*f01[0] + bv[3]*f01[2])
+		+ bu[1]*(bv[0]*f00[1] + bv[1]*f00[3] + bv[2]*f01[1] + bv[3]*f01[3])
+		+ bu[2]*(bv[0]*f10[0] + bv[1]*f10[2] + bv[2]*f11[0] + bv[3]*f11[2])
+		+ bu[3]*(bv[0]*f10[1] + bv[1]*f10[3] + bv[2]*f11[1] + bv[3]*f11[3]);
+}
+
+/* interpolate at any point (X,Y) of the table, in units of the node spacing */
+static double lut_interp_at(const LutTable *t, double X, double Y, unsigned k){
+	unsigned I = (unsigned)X, J = (unsigned)Y;
+	double bu[4], bv[4];
+	if(I > t->nx - 2)I = t->nx - 2;
+	if(J > t->ny - 2)J = t->ny - 2;
+	lut_basis(X - I, bu);
+	lut_basis(Y - J, bv);
+	return lut_interp(t, I, J, bu, bv, k);
+}
+
+/*
+	Points at which interpolation is checked for the cells in column i. With
+	node derivatives from finite differences, the error along a cell edge is
+	largest near the quarter points and vanishes at the midpoint, so we use
+	the quarter points inside each cell and along its edges (right-hand edges
+	only in the last column, as they are otherwise the left-hand edges of the
+	next column). Writes at most 10*ny points to X, Y.
+*/
+static unsigned lut_check_points(const LutTable *t, unsigned i, double *X, double *Y){
+	static const double q[2] = {0.25, 0.75};
+	unsigned j, a, b, m = 0;
+	for(j = 0; j < t->ny; ++j){
+		for(a = 0; a < 2; ++a){
+			X[m] = i + q[a]; Y[m++] = j;
+			if(j == t->ny - 1)continue;
+			X[m] = i; Y[m++] = j + q[a];
+			if(i == t->nx - 2){
+				X[m] = i + 1; Y[m++] = j + q[a];
+			}
+			for(b = 0; b < 2; ++b){
+				X[m] = i + q[a]; Y[m++] = j + q[b];
+			}
+		}
+	}
+	return m;
+}
+
+/* clear the 'ok' flags in 'mask' of every cell touching the point (X,Y) */
+static void lut_reject(LutTable *t, double X, double Y, unsigned mask){
+	int i, j;
+	for(i = (int)ceil(X) - 1; i <= (int)floor(X); ++i){
+		for(j = (int)ceil(Y) - 1; j <= (int)floor(Y); ++j){
+			if(i >= 0 && j >= 0 && i < (int)t->nx - 1 && j < (int)t->ny - 1){
+				t->ok[LUT_CELL(t,i,j)] &= ~mask;
+			}
+		}
+	}
+}
+
+/*------------------------------------------------------------------------------
+  PROPERTY EVALUATION
+*/
+
+PropEvalFn2 lut_p, lut_u, lut_h, lut_s, lut_a, lut_g, lut_cv, lut_cp, lut_w;
+PropEvalFn2 lut_alphap, lut_betap, lut_dpdrho_T;
+SatEvalFn lut_sat;
+static SetRefStateFn lut_setref;
+
+#define LUT_BASE(DATA) ((DATA)->corr.lut->base)
+
+/* tabulated properties: interpolate, or fall back to the wrapped EOS */
+#define LUT_PROPFN(PROP,K) \
+	double lut_##PROP(FluidStateUnion vals, const FluidData *data, FpropsError *err){\
+		const LutTable *t = &(data->corr.lut->trho);\
+		unsigned i, j;\
+		double bu[4], bv[4];\
+		if(vals.Trho.rho > 0 && !lut_locate(t, vals.Trho.T, log(vals.Trho.rho), 1u<<K, &i, &j, bu, bv)){\
+			return lut_interp(t, i, j, bu, bv, K);\
+		}\
+		return LUT_BASE(data)->PROP##_fn(vals, LUT_BASE(data)->data, err);\
+	}
+LUT_PROPFN(p,LUT_P) LUT_PROPFN(u,LUT_U) LUT_PROPFN(h,LUT_H) LUT_PROPFN(s,LUT_S)
+LUT_PROPFN(cv,LUT_CV) LUT_PROPFN(cp,LUT_CP) LUT_PROPFN(w,LUT_W)
+#undef LUT_PROPFN
+
+/* a = u - T s and g = h - T s, from the tabulated u, h and s */
+#define LUT_FREEFN(PROP,K) \
+	double lut_##PROP(FluidStateUnion vals, const FluidData *data, FpropsError *err){\
+		const LutTable *t = &(data->corr.lut->trho);\
+		unsigned i, j;\
+		double bu[4], bv[4];\
+		if(vals.Trho.rho > 0 && !lut_locate(t, vals.Trho.T, log(vals.Trho.rho), (1u<<K)|(1u<<LUT_S), &i, &j, bu, bv)){\
+			return lut_interp(t, i, j, bu, bv, K) - vals.Trho.T * lut_interp(t, i, j, bu, bv, LUT_S);\
+		}\
+		return LUT_BASE(data)->PROP##_fn(vals, LUT_BASE(data)->data, err);\
+	}
+LUT_FREEFN(a,LUT_U) LUT_FREEFN(g,LUT_H)
+#undef LUT_FREEFN
+
+/* derivatives are not tabulated, they always come from the wrapped EOS */
+#define LUT_BASEFN(PROP) \
+	double lut_##PROP(FluidStateUnion vals, const FluidData *data, FpropsError *err){\
+		return LUT_BASE(data)->PROP##_fn(vals, LUT_BASE(data)->data, err);\
+	}
+LUT_BASEFN(alphap) LUT_BASEFN(betap) LUT_BASEFN(dpdrho_T)
+#undef LUT_BASEFN
+
+double lut_sat(double T, double *rhof, double *rhog, const FluidData *data, FpropsError *err){
+	return LUT_BASE(data)->sat_fn(T, rhof, rhog, LUT_BASE(data)->data, err);
+}
+
+static int lut_setref(PureFluid *P, const ReferenceState *ref){
+	(void)ref;
+	ERRMSG("Reference state of tabulated fluid '%s' can't be changed (set it before tabulating)",P->name);
+	return 1;
+}
+
+/*------------------------------------------------------------------------------
+  TABLE PREPARATION
+*/
+
+/* raw EOS evaluation of one property at n states, NAN where it fails */
+static void lut_base_eval(const PureFluid *B, FpropsBatchProp prop, size_t n
+	, const double *T, const double *rho, double *out
+){
+	FpropsError e = FPROPS_NO_ERROR;
+	PropEvalFn2 *fn;
+	size_t i;
+	if(B->batch_fn){
+		B->batch_fn(prop, n, T, rho, out, B->data, &e);
+		if(!e)return;
+	}
+	switch(prop){
+	case FPROPS_BATCH_P: fn = B->p_fn; break;
+	case FPROPS_BATCH_U: fn = B->u_fn; break;
+	case FPROPS_BATCH_H: fn = B->h_fn; break;
+	case FPROPS_BATCH_S: fn = B->s_fn; break;
+	case FPROPS_BATCH_A: fn = B->a_fn; break;
+	case FPROPS_BATCH_G: fn = B->g_fn; break;
+	case FPROPS_BATCH_CV: fn = B->cv_fn; break;
+	case FPROPS_BATCH_CP: fn = B->cp_fn; break;
+	default: fn = B->w_fn; break;
+	}
+	for(i = 0; i < n; ++i){
+		e = FPROPS_NO_ERROR;
+		out[i] = fn(FSU_TRHO(T[i],rho[i]), B->data, &e);
+		if(e)out[i] = NAN;
+	}
+}
+
+/*
+	Newton iteration for (T,rho) given (p,h) in the single-phase region,
+	starting from the given T, rho.
+	@return 0 on convergence.
+*/
+static int lut_base_newton_ph(const PureFluid *B, double p, double h, double *T, double *rho){
+	const FluidData *D = B->data;
+	double hs = D->R * D->T_c;
+	double T1 = *T, rho1 = *rho;
+	int i;
+	for(i = 0; i < 50; ++i){
+		FpropsError e = FPROPS_NO_ERROR;
+		FluidStateUnion v = FSU_TRHO(T1,rho1);
+		double p1 = B->p_fn(v, D, &e);
+		double h1 = B->h_fn(v, D, &e);
+		if(e || !(p1 > 0) || isnan(h1))return 1;
+		double f = log(p1/p);
+		double g = (h1 - h)/hs;
+		if(fabs(f) < 1e-12 && fabs(g) < 1e-12){
+			*T = T1;
+			*rho = rho1;
+			return 0;
+		}
+		double alphap = B->alphap_fn(v, D, &e);
+		double betap = B->betap_fn(v, D, &e);
+		double cv = B->cv_fn(v, D, &e);
+		if(e)return 1;
+		/* derivatives of f, g with respect to T and rho */
+		double f_T = alphap;
+		double f_rho = betap/(rho1*rho1);
+		double g_T = (cv + p1/rho1*alphap)/hs;
+		double g_rho = -p1/(rho1*rho1)*(T1*alphap - betap/rho1)/hs;
+		double det = f_T*g_rho - f_rho*g_T;
+		if(det == 0 || isnan(det))return 1;
+		double dT = -(f*g_rho - g*f_rho)/det;
+		double drho = -(g*f_T - f*g_T)/det;
+		/* limit the step size */
+		double r = 1;
+		if(fabs(dT) > 0.1*T1)r = 0.1*T1/fabs(dT);
+		if(fabs(drho) > 0.5*rho1 && 0.5*rho1/fabs(drho) < r)r = 0.5*rho1/fabs(drho);
+		T1 += r*dT;
+		rho1 += r*drho;
+		if(fabs(r*dT) < 1e-13*T1 && fabs(r*drho) < 1e-13*rho1){
+			/* p is too sensitive to rho (eg liquid at low pressure) for the
+			residual test above to be met */
+			*T = T1;
+			*rho = rho1;
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* nonzero if [a0,a1] and [b0,b1] overlap */
+#define LUT_OVERLAP(A0,A1,B0,B1) ((A0) <= (B1) && (B0) <= (A1))
+
+static int lut_build_trho(LutRunData *L, double T_lo, FpropsError *err){
+	const PureFluid *B = L->base;
+	const FluidData *D = B->data;
+	LutTable *t = &(L->trho);
+	unsigned nx = L->opt.nT, ny = L->opt.nrho, i, j, k;
+	double *Tb, *rb, *vb, *Xb, *Yb;
+	double scale[LUT_NTRHO], tol = LUT_TOL_CHECK * L->opt.tol;
+
+	if(lut_table_alloc(t, nx, ny, LUT_NTRHO, T_lo, L->opt.T_max
+		, log(L->opt.rho_min), log(L->opt.rho_max))
+	){
+		*err = FPROPS_RANGE_ERROR;
+		return 1;
+	}
+	Tb = FPROPS_NEW_ARRAY(double,10*ny);
+	rb = FPROPS_NEW_ARRAY(double,10*ny);
+	vb = FPROPS_NEW_ARRAY(double,10*ny);
+	Xb = FPROPS_NEW_ARRAY(double,10*ny);
+	Yb = FPROPS_NEW_ARRAY(double,10*ny);
+
+	for(i = 0; i < nx; ++i){
+		for(j = 0; j < ny; ++j){
+			Tb[j] = t->x0 + i*t->dx;
+			rb[j] = exp(t->y0 + j*t->dy);
+		}
+		for(k = 0; k < LUT_NTRHO; ++k){
+			lut_base_eval(B, lut_trho_props[k], ny, Tb, rb, vb);
+			for(j = 0; j < ny; ++j)LUT_NODE(t,i,j)[4*k] = vb[j];
+		}
+	}
+	lut_table_derivs(t);
+
+	/* values near zero are compared against these scales */
+	scale[LUT_P] = 1e-3 * D->p_c;
+	scale[LUT_U] = scale[LUT_H] = D->R * D->T_c;
+	scale[LUT_S] = scale[LUT_CV] = scale[LUT_CP] = D->R;
+	scale[LUT_W] = sqrt(D->R * D->T_c);
+
+	/* check the interpolation within each column of cells */
+	for(i = 0; i < (nx - 1)*(ny - 1); ++i)t->ok[i] = (1u<<LUT_NTRHO) - 1;
+	for(i = 0; i < nx - 1; ++i){
+		double Ti = t->x0 + i*t->dx, Ti1 = Ti + t->dx;
+		double rhof = 0, rhog = 0;
+		unsigned m = lut_check_points(t, i, Xb, Yb);
+		for(j = 0; j < m; ++j){
+			Tb[j] = t->x0 + Xb[j]*t->dx;
+			rb[j] = exp(t->y0 + Yb[j]*t->dy);
+		}
+		for(k = 0; k < LUT_NTRHO; ++k){
+			lut_base_eval(B, lut_trho_props[k], m, Tb, rb, vb);
+			for(j = 0; j < m; ++j){
+				double fi = lut_interp_at(t, Xb[j], Yb[j], k);
+				if(!(fabs(fi - vb[j]) <= tol * (fabs(vb[j]) + scale[k]))){
+					lut_reject(t, Xb[j], Yb[j], 1u<<k);
+				}
+			}
+		}
+		if(Ti < D->T_c){
+			FpropsError e = FPROPS_NO_ERROR;
+			B->sat_fn(Ti, &rhof, &rhog, D, &e);
+			if(e){
+				/* can't locate the dome, so don't use this column */
+				rhog = 0;
+				rhof = INFINITY;
+			}
+		}
+		for(j = 0; j < ny - 1; ++j){
+			double r0 = exp(t->y0 + j*t->dy), r1 = exp(t->y0 + (j + 1)*t->dy);
+			/* the dome: rhog rises and rhof falls with T, so [rhog(Ti),
+			rhof(Ti)] covers the part of it within this column */
+			if(Ti < D->T_c && LUT_OVERLAP(r0,r1,rhog,rhof)){
+				t->ok[LUT_CELL(t,i,j)] = 0;
+			}
+			/* the critical point, with a margin of one cell */
+			if(LUT_OVERLAP(Ti - t->dx, Ti1 + t->dx, D->T_c, D->T_c)
+				&& LUT_OVERLAP(r0/exp(t->dy), r1*exp(t->dy), D->rho_c, D->rho_c)
+			){
+				t->ok[LUT_CELL(t,i,j)] = 0;
+			}
+		}
+	}
+
+	FPROPS_FREE(Tb);
+	FPROPS_FREE(rb);
+	FPROPS_FREE(vb);
+	FPROPS_FREE(Xb);
+	FPROPS_FREE(Yb);
+	return 0;
+}
+
+static int lut_build_ph(LutRunData *L, double T_lo, double h_min, double h_max, FpropsError *err){
+	const PureFluid *B = L->base;
+	const FluidData *D = B->data;
+	LutTable *t = &(L->ph);
+	unsigned nx = L->opt.np, ny = L->opt.nh, i, j;
+	double T_hi = 1.5 * L->opt.T_max;
+	double Trow = T_lo, rhorow = 0;
+	double *hf, *hg, *Xb, *Yb, hc, tol = LUT_TOL_CHECK * L->opt.tol;
+	FpropsError e = FPROPS_NO_ERROR;
+
+	if(lut_table_alloc(t, nx, ny, LUT_NPH, log(L->opt.p_min), log(L->opt.p_max), h_min, h_max)){
+		*err = FPROPS_RANGE_ERROR;
+		return 1;
+	}
+	hf = FPROPS_NEW_ARRAY(double,2*nx);
+	hg = FPROPS_NEW_ARRAY(double,2*nx);
+	Xb = FPROPS_NEW_ARRAY(double,10*ny);
+	Yb = FPROPS_NEW_ARRAY(double,10*ny);
+	hc = B->h_fn(FSU_TRHO(D->T_c,D->rho_c), D, &e);
+
+	{
+		double rhog;
+		B->sat_fn(T_lo, &rhorow, &rhog, D, &e);
+		if(e){
+			*err = FPROPS_SAT_CVGC_ERROR;
+			FPROPS_FREE(hf);
+			FPROPS_FREE(hg);
+			FPROPS_FREE(Xb);
+			FPROPS_FREE(Yb);
+			return 1;
+		}
+	}
+
+	/* saturation enthalpies at each node pressure (even entries) and each
+	cell-centre pressure (odd entries); hf > hg where p >= p_c */
+	for(i = 0; i < 2*nx - 1; ++i){
+		double p = exp(t->x0 + 0.5*i*t->dx), Ts, rf, rg;
+		hf[i] = INFINITY;
+		hg[i] = -INFINITY;
+		if(p < D->p_c){
+			e = FPROPS_NO_ERROR;
+			fprops_sat_p(p, &Ts, &rf, &rg, B, &e);
+			if(e){
+				/* mark the whole row as saturated, so it is never used */
+				hf[i] = -INFINITY;
+				hg[i] = INFINITY;
+				continue;
+			}
+			hf[i] = B->h_fn(FSU_TRHO(Ts,rf), D, &e);
+			hg[i] = B->h_fn(FSU_TRHO(Ts,rg), D, &e);
+		}
+	}
+
+	/* node values, solved along each row of increasing h */
+	for(i = 0; i < nx; ++i){
+		double p = exp(t->x0 + i*t->dx), Ts = 0, rf = 0, rg = 0;
+		double T = Trow, rho = rhorow;
+		int have_guess = 1, first = 1;
+		int subcrit = (p < D->p_c && isfinite(hf[2*i]));
+		if(subcrit){
+			e = FPROPS_NO_ERROR;
+			fprops_sat_p(p, &Ts, &rf, &rg, B, &e);
+		}
+		for(j = 0; j < ny; ++j){
+			double h = t->y0 + j*t->dy;
+			double *n = LUT_NODE(t,i,j);
+			if(subcrit && h >= hf[2*i] && h <= hg[2*i]){
+				double x = (h - hf[2*i])/(hg[2*i] - hf[2*i]);
+				n[4*LUT_T] = Ts;
+				n[4*LUT_LNRHO] = log(1./(x/rg + (1. - x)/rf));
+				T = Ts;
+				rho = rg;
+				have_guess = 1;
+				continue;
+			}
+			if(!have_guess){
+				if(subcrit && h < hf[2*i]){
+					T = Ts; rho = rf;
+				}else if(subcrit){
+					T = Ts; rho = rg;
+				}else{
+					T = Trow; rho = rhorow;
+				}
+			}
+			if(lut_base_newton_ph(B, p, h, &T, &rho)
+				|| T < T_lo || T > T_hi
+				|| (subcrit && h < hf[2*i] && rho < rf)
+				|| (subcrit && h > hg[2*i] && rho > rg)
+			){
+				n[4*LUT_T] = NAN;
+				n[4*LUT_LNRHO] = NAN;
+				have_guess = 0;
+				continue;
+			}
+			n[4*LUT_T] = T;
+			n[4*LUT_LNRHO] = log(rho);
+			have_guess = 1;
+			if(first){
+				/* start of the next row */
+				Trow = T;
+				rhorow = rho;
+				first = 0;
+			}
+		}
+	}
+	lut_table_derivs(t);
+
+	/* check the interpolation within each row of cells */
+	for(i = 0; i < (nx - 1)*(ny - 1); ++i)t->ok[i] = (1u<<LUT_NPH) - 1;
+	for(i = 0; i < nx - 1; ++i){
+		unsigned m = lut_check_points(t, i, Xb, Yb);
+		/* span of the dome in h over this row of cells */
+		double hlo = hf[2*i], hhi = hg[2*i];
+		for(j = 2*i + 1; j <= 2*i + 2; ++j){
+			if(hf[j] < hlo)hlo = hf[j];
+			if(hg[j] > hhi)hhi = hg[j];
+		}
+		if(exp(t->x0 + (i + 1)*t->dx) >= D->p_c){
+			/* row touching the critical pressure */
+			if(hc < hlo)hlo = hc;
+			if(hc > hhi)hhi = hc;
+		}
+		for(j = 0; j < ny - 1; ++j){
+			if(LUT_OVERLAP(t->y0 + j*t->dy, t->y0 + (j + 1)*t->dy, hlo, hhi)){
+				t->ok[LUT_CELL(t,i,j)] = 0;
+			}
+		}
+		for(j = 0; j < m; ++j){
+			double p = exp(t->x0 + Xb[j]*t->dx), h = t->y0 + Yb[j]*t->dy;
+			double Ti = lut_interp_at(t, Xb[j], Yb[j], LUT_T);
+			double lrhoi = lut_interp_at(t, Xb[j], Yb[j], LUT_LNRHO);
+			double T = Ti, rho = exp(lrhoi);
+			if(isnan(Ti) || isnan(lrhoi)
+				|| lut_base_newton_ph(B, p, h, &T, &rho)
+				|| !(fabs(Ti - T) <= tol * T && fabs(lrhoi - log(rho)) <= tol)
+			){
+				lut_reject(t, Xb[j], Yb[j], (1u<<LUT_NPH) - 1);
+			}
+		}
+	}
+
+	FPROPS_FREE(hf);
+	FPROPS_FREE(hg);
+	FPROPS_FREE(Xb);
+	FPROPS_FREE(Yb);
+	return 0;
+}
+
+PureFluid *lut_prepare(PureFluid *base, const LutOptions *opt, FpropsError *err){
+	PureFluid *P;
+	LutRunData *L;
+	const FluidData *BD;
+	double T_lo, p_lo, rhof_lo, rhog_lo, h_min, h_max;
+	FpropsError e = FPROPS_NO_ERROR;
+
+	if(!base){
+		ERRMSG("Base fluid is NULL");
+		*err = FPROPS_INVALID_REQUEST;
+		return NULL;
+	}
+	switch(base->type){
+	case FPROPS_HELMHOLTZ:
+	case FPROPS_PENGROB:
+		break;
+	default:
+		ERRMSG("Tabulation is only implemented for Helmholtz and Peng-Robinson fluids");
+		*err = FPROPS_NOT_IMPLEMENTED;
+		return NULL;
+	}
+	BD = base->data;
+
+	/* lower limit of the tables is the triple point, where known */
+	T_lo = BD->T_t;
+	if(T_lo == 0)T_lo = 0.2 * BD->T_c;
+	p_lo = base->sat_fn(T_lo, &rhof_lo, &rhog_lo, BD, &e);
+	if(e){
+		ERRMSG("Unable to solve saturation at T = %f K for '%s'",T_lo,base->name);
+		*err = FPROPS_SAT_CVGC_ERROR;
+		return NULL;
+	}
+
+	L = FPROPS_NEW(LutRunData);
+	L->base = base;
+	L->trho.f = L->ph.f = NULL;
+	L->trho.ok = L->ph.ok = NULL;
+	if(opt)L->opt = *opt;
+	else L->opt = (LutOptions){0};
+#define DEF(VAR,VAL) if(L->opt.VAR == 0)L->opt.VAR = (VAL)
+	DEF(nT, LUT_NT_DEFAULT);
+	DEF(nrho, LUT_NRHO_DEFAULT);
+	DEF(np, LUT_NP_DEFAULT);
+	DEF(nh, LUT_NH_DEFAULT);
+	DEF(T_max, 2 * BD->T_c);
+	DEF(rho_min, rhog_lo);
+	DEF(rho_max, 1.1 * rhof_lo);
+	DEF(p_min, p_lo);
+	DEF(p_max, 10 * BD->p_c);
+	DEF(tol, LUT_TOL_DEFAULT);
+#undef DEF
+	if(L->opt.nT < 4 || L->opt.nrho < 4 || L->opt.np < 4 || L->opt.nh < 4
+		|| !(L->opt.T_max > T_lo) || !(L->opt.rho_min > 0) || !(L->opt.rho_max > L->opt.rho_min)
+		|| !(L->opt.p_min > 0) || !(L->opt.p_max > L->opt.p_min)
+	){
+		ERRMSG("Invalid table options for '%s'",base->name);
+		FPROPS_FREE(L);
+		*err = FPROPS_INVALID_REQUEST;
+		return NULL;
+	}
+
+	/* enthalpy range: saturated liquid at the lower limit up to the hottest
+	state in the (T,rho) table */
+	h_min = base->h_fn(FSU_TRHO(T_lo,rhof_lo), BD, &e);
+	h_max = base->h_fn(FSU_TRHO(L->opt.T_max,L->opt.rho_min), BD, &e);
+
+	if(lut_build_trho(L, T_lo, err) || lut_build_ph(L, T_lo, h_min, h_max, err)){
+		ERRMSG("Unable to build tables for '%s'",base->name);
+		lut_table_free(&L->trho);
+		lut_table_free(&L->ph);
+		FPROPS_FREE(L);
+		return NULL;
+	}
+
+	P = FPROPS_NEW(PureFluid);
+	P->data = FPROPS_NEW(FluidData);
+	*(P->data) = *BD; /* including the saturation cache, owned by 'base' */
+	P->data->corr.lut = L;
+	P->name = base->name;
+	P->source = base->source;
+	P->type = FPROPS_LUT;
+	P->T_fn = NULL;
+	P->rho_fn = NULL;
+#define FN(VAR) P->VAR##_fn = &lut_##VAR
+	FN(p); FN(u); FN(h); FN(s); FN(a); FN(g); FN(cp); FN(cv); FN(w);
+	FN(alphap); FN(betap); FN(dpdrho_T);
+	FN(sat);
+#undef FN
+	P->setref_fn = &lut_setref;
+	P->batch_fn = NULL;
+	P->visc = NULL;
+	P->thcond = NULL;
+	return P;
+}
+
+void lut_destroy(PureFluid *P){
+	LutRunData *L = P->data->corr.lut;
+	if(P->data->sat != L->base->data->sat)fprops_sat_cache_destroy(P->data);
+	switch(L->base->type){
+	case FPROPS_HELMHOLTZ:
+		helmholtz_destroy(L->base);
+		break;
+	case FPROPS_PENGROB:
+		pengrob_destroy(L->base);
+		break;
+	default:
+		break;
+	}
+	lut_table_free(&L->trho);
+	lut_table_free(&L->ph);
+	FPROPS_FREE(L);
+	FPROPS_FREE(P->data);
+	FPROPS_FREE(P);
+}
+
+/*------------------------------------------------------------------------------
+  INVERSE SOLVERS
+*/
+
+int lut_ph_tabulated(double p, double h, const PureFluid *P){
+	unsigned i, j;
+	double bu[4], bv[4];
+	return p > 0 && !lut_locate(&(P->data->corr.lut->ph), log(p), h, (1u<<LUT_NPH) - 1, &i, &j, bu, bv);
+}
+
+FluidState2 lut_solve_ph(double p, double h, const PureFluid *P, FpropsError *err){
+	const LutTable *t = &(P->data->corr.lut->ph);
+	unsigned i, j;
+	double bu[4], bv[4];
+	FluidState2 S;
+	if(p > 0 && !lut_locate(t, log(p), h, (1u<<LUT_NPH) - 1, &i, &j, bu, bv)){
+		return STATE_TRHO(P, lut_interp(t, i, j, bu, bv, LUT_T)
+			, exp(lut_interp(t, i, j, bu, bv, LUT_LNRHO)));
+	}
+	S = fprops_solve_ph(p, h, P->data->corr.lut->base, err);
+	S.fluid = P;
+	return S;
+}
+
+typedef struct{
+	const PureFluid *P;
+	double T, p;
+} LutPTData;
+
+static ZeroInSubjectFunction lut_pT_resid;
+static double lut_pT_resid(double lnrho, void *user_data){
+	LutPTData *d = (LutPTData *)user_data;
+	FpropsError e = FPROPS_NO_ERROR;
+	return d->P->p_fn(FSU_TRHO(d->T, exp(lnrho)), d->P->data, &e) - d->p;
+}
+
+FluidState2 lut_solve_pT(double p, double T, const PureFluid *P, FpropsError *err){
+	const FluidData *D = P->data;
+	const LutRunData *L = D->corr.lut;
+	LutPTData d = {P, T, p};
+	double lo, hi, lnrho, resid;
+
+	if(!(p > 0) || !(T > 0)){
+		*err = FPROPS_RANGE_ERROR;
+		return STATE_NAN(P);
+	}
+	/* widest plausible range of density, from the ideal gas value */
+	lo = log(0.1 * p / (D->R * T));
+	hi = log(2 * L->opt.rho_max);
+	if(T < D->T_c){
+		double rhof, rhog, psat;
+		psat = P->sat_fn(T, &rhof, &rhog, D, err);
+		if(*err){
+			*err = FPROPS_SAT_CVGC_ERROR;
+			return STATE_NAN(P);
+		}
+		if(p == psat){
+			*err = FPROPS_VALUE_UNDEFINED;
+			return STATE_NAN(P);
+		}
+		/* pick the branch on the correct side of the dome */
+		if(p > psat)lo = log(rhof);
+		else hi = log(rhog);
+	}
+	if(lut_pT_resid(lo, &d) * lut_pT_resid(hi, &d) > 0){
+		ERRMSG("Unable to bracket density for p = %f bar, T = %f K",p/1e5,T);
+		*err = FPROPS_RANGE_ERROR;
+		return STATE_NAN(P);
+	}
+	if(zeroin_solve(&lut_pT_resid, &d, lo, hi, 1e-13, &lnrho, &resid)){
+		*err = FPROPS_NUMERIC_ERROR;
+		return STATE_NAN(P);
+	}
+	return STATE_TRHO(P, T, exp(lnrho));
+}
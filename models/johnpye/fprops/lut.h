@@ -0,0 +1,102 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2024 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//** @file
+	Tabulated ('look-up table', LUT) property backend for FPROPS.
+
+	A LUT fluid wraps an existing PureFluid with VLE (Helmholtz or Peng-
+	Robinson) and replaces its property evaluation by bicubic Hermite
+	interpolation in two tables, prepared once:
+
+	 - properties p, u, h, s, cv, cp, w as functions of (T, ln rho), and
+	 - T and ln rho as functions of (ln p, h), for fprops_solve_ph.
+
+	Each table cell is checked against the wrapped EOS at interior points when
+	the table is built, separately for each tabulated function. Where a
+	function is not within the requested tolerance, or where a cell touches
+	the saturation dome or the critical point, states falling in the cell (and
+	states outside the tables) are evaluated with the wrapped EOS instead. Saturation properties always come from the
+	wrapped fluid.
+*/
+#ifndef FPROPS_LUT_H
+#define FPROPS_LUT_H
+
+#include "rundata.h"
+
+/** Table sizes and ranges for lut_prepare. Zero values select defaults. */
+typedef struct LutOptions_struct{
+	unsigned nT;   /**< number of temperature nodes (default 100) */
+	unsigned nrho; /**< number of density nodes (default 100) */
+	unsigned np;   /**< number of pressure nodes (default 100) */
+	unsigned nh;   /**< number of enthalpy nodes (default 100) */
+	double T_max;  /**< upper temperature of (T,rho) table (default 2 T_c) */
+	double rho_min, rho_max; /**< density range (default rhog(T_t) to 1.1 rhof(T_t)) */
+	double p_min, p_max; /**< pressure range of (p,h) table (default p_t to 10 p_c) */
+	double tol;    /**< relative tolerance of interpolated values (default 1e-6) */
+} LutOptions;
+
+/**
+	Tabulated data, with node values and derivatives of nf functions on a
+	uniform nx-by-ny grid.
+*/
+typedef struct LutTable_struct{
+	unsigned nx, ny;   /**< number of nodes in each direction */
+	unsigned nf;       /**< number of tabulated functions */
+	double x0, dx;     /**< first node and spacing, x direction */
+	double y0, dy;     /**< first node and spacing, y direction */
+	double *f;         /**< [nx][ny][nf][4] value and derivatives (x, y, xy) scaled to a unit cell */
+	unsigned char *ok; /**< [nx-1][ny-1] bit k set where function k can be interpolated */
+} LutTable;
+
+typedef struct LutRunData_struct{
+	PureFluid *base;   /**< the wrapped fluid, owned by the LUT fluid */
+	LutOptions opt;    /**< options actually used for the tables */
+	LutTable trho;     /**< p, u, h, s, cv, cp, w in terms of (T, ln rho) */
+	LutTable ph;       /**< T, ln rho in terms of (ln p, h) */
+} LutRunData;
+
+/**
+	Create a LUT fluid wrapping 'base', which must be a Helmholtz or
+	Peng-Robinson fluid. Ownership of 'base' passes to the new fluid (it is
+	destroyed by lut_destroy). The reference state should be set on 'base'
+	beforehand; it cannot be changed once the tables are built.
+
+	@param opt table options, or NULL for defaults.
+	@return new fluid, or NULL with err set on failure.
+*/
+PureFluid *lut_prepare(PureFluid *base, const LutOptions *opt, FpropsError *err);
+
+void lut_destroy(PureFluid *P);
+
+/**
+	Solve (p,h) for a LUT fluid: interpolated in the (p,h) table, else solved
+	with the wrapped EOS. The returned state belongs to P.
+*/
+FluidState2 lut_solve_ph(double p, double h, const PureFluid *P, FpropsError *err);
+
+/**
+	Solve (p,T) for a LUT fluid, from the tabulated p(T,rho). Saturated
+	(p,T) pairs are rejected as FPROPS_VALUE_UNDEFINED.
+*/
+FluidState2 lut_solve_pT(double p, double T, const PureFluid *P, FpropsError *err);
+
+/**
+	@return nonzero if the (p,h) state lies in a usable cell of the (p,h)
+	table, in which case it is single-phase and lut_solve_ph will return
+	without iteration.
+*/
+int lut_ph_tabulated(double p, double h, const PureFluid *P);
+
+#endif /* FPROPS_LUT_H */
@@ -80,6 +80,7 @@ PureFluid *pengrob_prepare(const EosData *E, const ReferenceState *ref){
 	MSG("Preparing PR fluid '%s'...",E->name);
 	PureFluid *P = FPROPS_NEW(PureFluid);
 	P->data = FPROPS_NEW(FluidData);
+	P->data->sat = NULL;
 
 	/* metadata */
 	// TODO should we copy this so that we can uncouple the filedata? */
@@ -218,18 +219,21 @@ PureFluid *pengrob_prepare(const EosData *E, const ReferenceState *ref){
 	FN(dpdrho_T); FN(alphap); FN(betap);
 	FN(sat);
 	P->setref_fn = refstate_set_for_phi0;
+	P->batch_fn = NULL;
 #undef FN
 #undef I
 #undef D
 #undef C
 	//P->sat_fn = &pengrob_sat_akasaka;
 
+	fprops_sat_cache_prepare(P);
 	return P;
 }
 
 
 void pengrob_destroy(PureFluid *P){
 	cp0_destroy(P->data->cp0);
+	fprops_sat_cache_destroy(P->data);
 	FPROPS_FREE(P->data->corr.pengrob);
 	FPROPS_FREE(P->data);
 	FPROPS_FREE(P);
@@ -564,9 +568,12 @@ double pengrob_sat(double T,double *rhof_ret, double *rhog_ret, const FluidData
 	double A, B;
 	double sqrt2 = sqrt(2);
 
-	double p = fprops_psat_T_acentric(T, data);
-	//double p = data->p_c / 2;
-	MSG("Initial guess: p = %f from acentric factor",p);
+	double p, rhof_guess, rhog_guess;
+	if(fprops_sat_guess(T, &p, &rhof_guess, &rhog_guess, data)){
+		p = fprops_psat_T_acentric(T, data);
+		//double p = data->p_c / 2;
+		MSG("Initial guess: p = %f from acentric factor",p);
+	}
 
 	int i = 0;
 	double vg, vf;
@@ -113,6 +113,53 @@ typedef struct{} PureFluid;
 // use SWIG's generalised exceptions
 %include <exception.i>
 
+%{
+typedef void FpropsBatchFn(const double *T, const double *rho, double *out, size_t n, const PureFluid *fluid, FpropsError *err);
+
+/* evaluate a batch function over equal-length sequences of T and rho, giving a list */
+PyObject *fprops_py_batch(FpropsBatchFn *fn, const PureFluid *P, PyObject *T, PyObject *rho, FpropsError *err){
+	Py_ssize_t i, n;
+	double *buf;
+	PyObject *res;
+	if(!PySequence_Check(T) || !PySequence_Check(rho)){
+		PyErr_SetString(PyExc_TypeError,"T and rho must be sequences");
+		return NULL;
+	}
+	n = PySequence_Length(T);
+	if(n != PySequence_Length(rho)){
+		PyErr_SetString(PyExc_ValueError,"T and rho must be of the same length");
+		return NULL;
+	}
+	buf = FPROPS_NEW_ARRAY(double,3*n+1);
+	for(i=0; i<n; ++i){
+		PyObject *o = PySequence_GetItem(T,i);
+		buf[i] = o ? PyFloat_AsDouble(o) : NAN;
+		Py_XDECREF(o);
+		o = PySequence_GetItem(rho,i);
+		buf[n+i] = o ? PyFloat_AsDouble(o) : NAN;
+		Py_XDECREF(o);
+	}
+	if(PyErr_Occurred()){
+		FPROPS_FREE(buf);
+		return NULL;
+	}
+	(*fn)(buf, buf+n, buf+2*n, n, P, err);
+	res = PyList_New(n);
+	for(i=0; i<n; ++i){
+		PyList_SET_ITEM(res, i, PyFloat_FromDouble(buf[2*n+i]));
+	}
+	FPROPS_FREE(buf);
+	return res;
+}
+%}
+
+// eg P.h_batch([300,400],[1000,900]): property at many (T,rho) states in one call
+%define BATCHMETHOD(VAR)
+	PyObject *VAR ## _batch(PyObject *T, PyObject *rho, FpropsError *err){
+		return fprops_py_batch(&fprops_ ## VAR ## _batch, $self, T, rho, err);
+	}
+%enddef
+
 %extend PureFluid{
 	// destructor: doesn't see to work
 	~PureFluid();
@@ -172,6 +219,16 @@ typedef struct{} PureFluid;
 		return fprops_region_px(p, x, $self,err);
 	}
 
+	BATCHMETHOD(p)
+	BATCHMETHOD(u)
+	BATCHMETHOD(h)
+	BATCHMETHOD(s)
+	BATCHMETHOD(a)
+	BATCHMETHOD(g)
+	BATCHMETHOD(cv)
+	BATCHMETHOD(cp)
+	BATCHMETHOD(w)
+
 
 	double psat_T_acentric(double T){
 		return fprops_psat_T_acentric(T, $self->data);
@@ -31,6 +31,9 @@ Data declarations as provided in input files are given in filedata.h
 
 typedef struct PureFluid_struct PureFluid;
 
+/* saturation curve cache, defined in sat.c */
+struct SatCache_struct;
+
 /** Power terms for phi0 (including polynomial) */
 typedef struct Phi0RunPowTerm_struct{
 	double a;
@@ -91,6 +94,7 @@ typedef union CorrelationUnion_union{
 	HelmholtzRunData *helm;
 	PengrobRunData *pengrob;
 	IncompRunData *incomp;
+	struct LutRunData_struct *lut;
 	/* maybe more later */
 } CorrelationUnion;
 
@@ -101,7 +105,6 @@ TODO FluidData (or PureFluid?) could/should be extended to include the following
 frequently-calculated items:
 	- fluid properties at triple point (rhoft, rhogt, pt...)
 	- fluid properties at critical point (hc, ...)
-	- accurate saturation curve data (interpolation/spline/something like that)
 	- solutions of iterative solver results, eg (p,h) pairs.
 
 This data would be held at this level unless it is correlation-specific in
@@ -129,6 +132,7 @@ typedef struct FluidData_struct{
 	double rhostar; /**< reference for reduced density */
 	Phi0RunData *cp0; /* data for ideal component of Helmholtz energy */
 	ReferenceState ref0;
+	struct SatCache_struct *sat; /**< saturation curve cache, built when the fluid is prepared (see sat.h), or NULL */
 	/* correlation-specific stuff here */
 	CorrelationUnion corr;
 } FluidData;
@@ -189,6 +193,27 @@ typedef double SatEvalFn(double T,double *rhof, double *rhog, const FluidData *d
 
 typedef int SetRefStateFn(PureFluid *data, const ReferenceState *ref);
 
+/** Properties that can be requested from a BatchEvalFn */
+typedef enum FpropsBatchProp_enum{
+	FPROPS_BATCH_P
+	,FPROPS_BATCH_U
+	,FPROPS_BATCH_H
+	,FPROPS_BATCH_S
+	,FPROPS_BATCH_A
+	,FPROPS_BATCH_G
+	,FPROPS_BATCH_CV
+	,FPROPS_BATCH_CP
+	,FPROPS_BATCH_W
+} FpropsBatchProp;
+
+/**
+	Evaluate one property at n (T,rho) states given as separate arrays,
+	writing the n values to 'out'. Phase equilibrium is not considered: each
+	state is evaluated directly from the EOS, as with PropEvalFn2.
+*/
+typedef void BatchEvalFn(FpropsBatchProp prop, size_t n, const double *T
+	, const double *rho, double *out, const FluidData *data, FpropsError *err);
+
 typedef enum PhaseBehaviour_enum{
 	FPROPS_SINGLEPHASE
 	,FPROPS_VLE
@@ -220,6 +245,7 @@ typedef struct PureFluid_struct{
 	PropEvalFn2 *dpdrho_T_fn; // this derivative is required for saturation properties by Akasaka method
 	SatEvalFn *sat_fn; // function to return {psat,rhof,rhog}(T) for this pure fluid;
 	SetRefStateFn *setref_fn; // function to set reference state for this pure fluid
+	BatchEvalFn *batch_fn; // evaluation of many states at once, or NULL if not provided
 
 	const ViscosityData *visc; // TODO should it be here? or inside FluidData?? probably yes, but needs review.
 	const ThermalConductivityData *thcond; // TODO should it be here? probably yes, but needs review.
@@ -43,8 +43,10 @@
 
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #define SQ(X) ((X)*(X))
+#define FSU_TRHO(T,RHO) (FluidStateUnion){.Trho={T, RHO}}
 
 #define TCRIT(DATA) (DATA->data->T_c)
 #define PCRIT(DATA) (DATA->data->p_c)
@@ -228,8 +230,203 @@ double fprops_rhog_T_chouaieb(double T, const FluidData *data){
 	return data->rho_c * exp(PPP * (pow(alpha,NNN) - exp(1-alpha)));
 }
 
+/*------------------------------------------------------------------------------
+  SATURATION CURVE CACHE
+*/
+
+/* number of intervals between cached nodes */
+#define SAT_CACHE_N 64
+
+/**
+	Saturation curve data for a fluid, held in FluidData::sat. Nodes
+	k = 0..SAT_CACHE_N are evenly spaced in u = sqrt(1 - T/T_c), from the
+	critical point (k = 0) down to T_lo (the triple point, where known), which
+	keeps rhof(u), rhog(u) and ln psat(u) smooth right up to the critical point.
+	Node values are converged solutions of the fluid's own SatEvalFn; between
+	nodes they are interpolated by local cubics to give starting values for the
+	iterative solvers. The cache is built by fprops_sat_cache_prepare and not
+	changed afterwards.
+*/
+typedef struct SatCache_struct{
+	double T_c;     /**< critical temperature */
+	double T_lo;    /**< temperature of node SAT_CACHE_N */
+	double du;      /**< node spacing in u */
+	int klo;        /**< nodes klo..SAT_CACHE_N are valid */
+	double p_lo;    /**< psat(T_lo), exactly as returned by the SatEvalFn */
+	unsigned long serial; /**< tags the memos below as belonging to this cache */
+	double lnp[SAT_CACHE_N + 1];
+	double rhof[SAT_CACHE_N + 1];
+	double rhog[SAT_CACHE_N + 1];
+} SatCache;
+
+/* serial number of the last cache built; 0 is never used */
+static unsigned long sat_cache_serial = 0;
+
+/**
+	Last result of fprops_sat_T (x = T, y = psat) or fprops_sat_p (x = p,
+	y = Tsat), since repeated calls with the same argument are common when
+	these are used inside an outer Newton iteration. Kept per thread, and
+	tagged with the serial number of the fluid's cache, which no other cache
+	gets even at the same address.
+*/
+typedef struct{
+	unsigned long serial;
+	double x, y, rhof, rhog;
+} SatMemo;
+
+static FPROPS_THREAD_LOCAL SatMemo sat_T_memo, sat_p_memo;
+
+static double sat_cache_T(const SatCache *C, int k){
+	double u = k * C->du;
+	if(k == SAT_CACHE_N)return C->T_lo;
+	return C->T_c * (1 - u*u);
+}
+
+/**
+	Interpolate cached node values f[] at x = u/du, using the cubic through the
+	four valid nodes nearest to x (or fewer, if fewer nodes are valid).
+	@param dfdx (output) derivative with respect to x, or NULL
+*/
+static double sat_cache_interp(const SatCache *C, const double *f, double x, double *dfdx){
+	int m = SAT_CACHE_N - C->klo + 1;
+	int s, i, j;
+	double val = 0, der = 0;
+	if(m > 4)m = 4;
+	s = (int)floor(x) - 1;
+	if(s > SAT_CACHE_N - m + 1)s = SAT_CACHE_N - m + 1;
+	if(s < C->klo)s = C->klo;
+	for(j = 0; j < m; ++j){
+		/* Lagrange basis polynomial for node s+j, and its derivative */
+		double L = 1, dL = 0;
+		for(i = 0; i < m; ++i){
+			if(i == j)continue;
+			double a = (x - (s + i)) / (j - i);
+			dL = dL * a + L / (j - i);
+			L *= a;
+		}
+		val += f[s + j] * L;
+		der += f[s + j] * dL;
+	}
+	if(dfdx)*dfdx = der;
+	return val;
+}
+
+int fprops_sat_guess(double T, double *psat, double *rhof, double *rhog, const FluidData *data){
+	const SatCache *C = data->sat;
+	double x, rf, rg;
+	if(C == NULL || C->klo > SAT_CACHE_N)return 1;
+	if(!(T < C->T_c) || T < C->T_lo - 1e-8)return 1;
+	x = sqrt(1 - T / C->T_c) / C->du;
+	/* a little extrapolation is allowed, for use while the cache is built */
+	if(x < C->klo - 1.5)return 1;
+	rf = sat_cache_interp(C, C->rhof, x, NULL);
+	rg = sat_cache_interp(C, C->rhog, x, NULL);
+	if(!(rf > rg) || !(rg > 0))return 1;
+	*psat = exp(sat_cache_interp(C, C->lnp, x, NULL));
+	*rhof = rf;
+	*rhog = rg;
+	return 0;
+}
+
+/**
+	Nodes are solved in order of increasing temperature, each starting from
+	an extrapolation of the nodes already solved (the SatEvalFn makes use of
+	fprops_sat_guess); if a node fails to solve, the cache covers only the
+	temperatures below it.
+*/
+void fprops_sat_cache_prepare(PureFluid *P){
+	FluidData *D = P->data;
+	SatCache *C;
+	int k;
+	if(D->sat)return;
+	switch(P->type){
+	case FPROPS_HELMHOLTZ:
+	case FPROPS_PENGROB:
+		break;
+	default:
+		return;
+	}
+	if(!(D->T_c > 0))return;
+
+	C = FPROPS_NEW(SatCache);
+	C->T_c = D->T_c;
+	C->T_lo = D->T_t;
+	if(C->T_lo == 0)C->T_lo = 0.2 * D->T_c;
+	C->du = sqrt(1 - C->T_lo / C->T_c) / SAT_CACHE_N;
+	C->klo = SAT_CACHE_N + 1;
+	C->serial = ++sat_cache_serial;
+	D->sat = C;
+
+	for(k = SAT_CACHE_N; k > 0; --k){
+		FpropsError e = FPROPS_NO_ERROR;
+		double T = sat_cache_T(C, k), rf, rg;
+		double p = P->sat_fn(T, &rf, &rg, D, &e);
+		if(e || !(p > 0) || !(rf > rg) || !(rg > 0)){
+			MSG("Saturation cache for '%s' is limited to T < %f",P->name,T);
+			break;
+		}
+		if(k == SAT_CACHE_N)C->p_lo = p;
+		C->lnp[k] = log(p);
+		C->rhof[k] = rf;
+		C->rhog[k] = rg;
+		C->klo = k;
+	}
+	if(k == 0){
+		C->lnp[0] = log(D->p_c);
+		C->rhof[0] = C->rhog[0] = D->rho_c;
+		C->klo = 0;
+	}
+	MSG("Cached %d saturation nodes for '%s'",SAT_CACHE_N + 1 - C->klo, P->name);
+}
+
+void fprops_sat_cache_destroy(FluidData *data){
+	if(data->sat){
+		FPROPS_FREE(data->sat);
+		data->sat = NULL;
+	}
+}
+
+/**
+	Estimate Tsat(p) by inverse interpolation of the cached ln psat.
+	@return 0 on success, nonzero if p is outside the cached range.
+*/
+static int sat_cache_T_p(const SatCache *C, double logp, double *T){
+	int lo = C->klo, hi = SAT_CACHE_N, k, i;
+	double x, u, f, dfdx;
+	if(hi - lo < 1)return 1;
+	/* ln psat decreases with k */
+	if(!(logp <= C->lnp[lo] && logp >= C->lnp[hi]))return 1;
+	while(hi - lo > 1){
+		k = (lo + hi) / 2;
+		if(C->lnp[k] >= logp)lo = k;
+		else hi = k;
+	}
+	x = lo + (C->lnp[lo] - logp) / (C->lnp[lo] - C->lnp[hi]);
+	for(i = 0; i < 3; ++i){
+		f = sat_cache_interp(C, C->lnp, x, &dfdx) - logp;
+		if(!(dfdx < 0))break;
+		x -= f / dfdx;
+		if(x < lo)x = lo;
+		if(x > hi)x = hi;
+	}
+	u = x * C->du;
+	*T = C->T_c * (1 - u*u);
+	if(*T < C->T_lo)*T = C->T_lo;
+	return 0;
+}
+
 void fprops_sat_T(double T, double *psat, double *rhof, double *rhog, const PureFluid *d, FpropsError *err){
+	const SatCache *C = d->data->sat;
+	if(C && sat_T_memo.serial == C->serial && T == sat_T_memo.x){
+		*psat = sat_T_memo.y;
+		*rhof = sat_T_memo.rhof;
+		*rhog = sat_T_memo.rhog;
+		return;
+	}
 	*psat = d->sat_fn(T,rhof,rhog,d->data,err);
+	if(C && !*err){
+		sat_T_memo = (SatMemo){C->serial, T, *psat, *rhof, *rhog};
+	}
 }
 
 /**
@@ -238,6 +435,14 @@ void fprops_sat_T(double T, double *psat, double *rhof, double *rhog, const Pure
 void fprops_triple_point(double *p_t_out, double *rhof_t_out, double *rhog_t_out, const PureFluid *d, FpropsError *err){
 	static const PureFluid *d_last = NULL;
 	static double p_t, rhof_t, rhog_t;
+	const SatCache *C = d->data->sat;
+	if(C && C->klo <= SAT_CACHE_N && C->T_lo == d->data->T_t){
+		/* first node of the saturation cache is the triple point */
+		*p_t_out = C->p_lo;
+		*rhof_t_out = C->rhof[SAT_CACHE_N];
+		*rhog_t_out = C->rhog[SAT_CACHE_N];
+		return;
+	}
 	if(d == d_last){
 		*p_t_out = p_t;
 		*rhof_t_out = rhof_t;
@@ -289,9 +494,47 @@ static double sat_p_resid(double rT, void *user_data){
 
 
 /**
-	Solve saturation conditions as a function of pressure. 
+	Solve psat(T) = p by Newton iteration in T, using the Clapeyron equation
+	for dpsat/dT and starting from the cached saturation curve. Each step is a
+	saturation solve at T, which itself starts from the cached curve.
+	@return 0 on success, nonzero if p is outside the cached range or the
+	iteration fails.
+*/
+static int sat_p_newton(double p, const SatCache *C, double *T_sat, double *rho_f, double *rho_g, const PureFluid *P){
+	double logp = log(p), T, dT;
+	int i;
+	if(sat_cache_T_p(C, logp, &T))return 1;
+	for(i = 0; i < 20; ++i){
+		FpropsError e = FPROPS_NO_ERROR;
+		double rf, rg, hf, hg, dlnpdT;
+		double p1 = P->sat_fn(T, &rf, &rg, P->data, &e);
+		if(e || !(p1 > 0))return 1;
+		hf = P->h_fn(FSU_TRHO(T,rf), P->data, &e);
+		hg = P->h_fn(FSU_TRHO(T,rg), P->data, &e);
+		/* Clapeyron: dp/dT = h_fg / (T v_fg) */
+		dlnpdT = (hg - hf) / (T * (1./rg - 1./rf) * p1);
+		if(e || !(dlnpdT > 0))return 1;
+		dT = -(log(p1) - logp) / dlnpdT;
+		MSG("iter %d: T = %f, p1 = %f, dT = %e", i, T, p1, dT);
+		if(fabs(dT) < 1e-10 * T){
+			*T_sat = T;
+			*rho_f = rf;
+			*rho_g = rg;
+			return 0;
+		}
+		if(T + dT > C->T_c)dT = 0.5 * (C->T_c - T);
+		if(T + dT < C->T_lo)dT = 0.5 * (C->T_lo - T);
+		T += dT;
+	}
+	return 1;
+}
+
+/**
+	Solve saturation conditions as a function of pressure.
 
-	Currently this is just a Brent solver. We've tried to improve it slightly
+	Where the saturation curve cache covers p, this is a Newton iteration
+	(sat_p_newton) from the interpolated Tsat(p). Otherwise, or if that fails,
+	it's a Brent solver. We've tried to improve it slightly
 	by solving for the residual of log(p)-log(p1) as a function of 1/T, which
 	should make the function a bit more linear.
 
@@ -328,7 +571,18 @@ void fprops_sat_p(double p, double *T_sat, double *rho_f, double *rho_g, const P
 		return;
 	}
 	/* FIXME what about checking triple point pressure? */
-	
+
+	const SatCache *C = P->data->sat;
+	if(C && sat_p_memo.serial == C->serial && p == sat_p_memo.x){
+		*T_sat = sat_p_memo.y;
+		*rho_f = sat_p_memo.rhof;
+		*rho_g = sat_p_memo.rhog;
+		return;
+	}
+	if(C && !sat_p_newton(p, C, T_sat, rho_f, rho_g, P)){
+		sat_p_memo = (SatMemo){C->serial, p, *T_sat, *rho_f, *rho_g};
+		return;
+	}
 
 	SatPResidData D = {
 		P, log(p), err, 0
@@ -359,7 +613,12 @@ void fprops_sat_p(double p, double *T_sat, double *rho_f, double *rho_g, const P
 	}
 	T = 1./rT;
 	fprops_sat_T(T, &p1, rho_f, rho_g, P, err);
-	if(!*err)*T_sat = T;
+	if(!*err){
+		*T_sat = T;
+		if(C){
+			sat_p_memo = (SatMemo){C->serial, p, T, *rho_f, *rho_g};
+		}
+	}
 	MSG("Got p1 = %f, p = %f in %d iterations", p1, p, D.neval);
 }
 
@@ -389,6 +648,27 @@ void fprops_sat_hf(double hf, double *Tsat_out, double *psat_out, double *rhof_o
 		return;
 	}
 
+	const SatCache *C = P->data->sat;
+	if(C && C->klo < SAT_CACHE_N){
+		/* start from the neighbouring nodes of the saturation cache that
+		bracket hf (which increases with T, so decreases with k) */
+		int lo = C->klo, hi = SAT_CACHE_N, k;
+		while(hi - lo > 1){
+			FpropsError e = FPROPS_NO_ERROR;
+			k = (lo + hi) / 2;
+			double hk = P->h_fn(FSU_TRHO(sat_cache_T(C,k),C->rhof[k]), P->data, &e);
+			if(e)break;
+			if(hk > hf){
+				lo = k;
+			}else{
+				hi = k;
+				T2 = sat_cache_T(C,k);
+				h2 = hk;
+			}
+		}
+		T1 = sat_cache_T(C,lo);
+	}
+
 	int i = 0;
 	while(i++ < 60){
 		assert(T1 >= P->data->T_t - 1e-4);
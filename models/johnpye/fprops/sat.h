@@ -17,5 +17,27 @@ void fprops_sat_hf(double hf, double *T_sat, double *p_sat, double *rho_f, doubl
 
 void fprops_triple_point(double *p_sat, double *rho_f, double *rho_g, const PureFluid *d, FpropsError *err);
 
+/**
+	Starting values for an iterative saturation solver at temperature T, from
+	the saturation curve cache of the fluid (see FluidData::sat and
+	fprops_sat_cache_prepare).
+
+	@return 0 on success, nonzero if no cached data is available at T, in
+	which case the outputs are not changed.
+*/
+int fprops_sat_guess(double T, double *p_sat, double *rho_f, double *rho_g, const FluidData *data);
+
+/**
+	Build the saturation curve cache of a fluid with VLE, by tabulating the
+	fluid's own SatEvalFn from the triple point to the critical point. Called
+	at the end of helmholtz_prepare and pengrob_prepare, once the fluid's
+	functions are set; the cache is read-only afterwards, so that a prepared
+	fluid can be used from several threads.
+*/
+void fprops_sat_cache_prepare(PureFluid *P);
+
+/** Free the saturation curve cache of a fluid, if any. */
+void fprops_sat_cache_destroy(FluidData *data);
+
 #endif
 
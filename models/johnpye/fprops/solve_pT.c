@@ -27,6 +27,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "derivs.h"
 #include "rundata.h"
 #include "zeroin.h"
+#include "lut.h"
 
 #include <stdio.h>
 #include <math.h>
@@ -85,6 +86,7 @@ int fprops_region_pT(double p, double T, const PureFluid *fluid, FpropsError *er
 	switch(fluid->type){
 	case FPROPS_HELMHOLTZ:
 	case FPROPS_PENGROB:
+	case FPROPS_LUT:
 		{
 			double p_c = fluid->data->p_c;
 			double T_c = fluid->data->T_c;
@@ -128,6 +130,8 @@ FluidState2 fprops_solve_pT(double p, double h, const PureFluid *fluid, FpropsEr
 	case FPROPS_HELMHOLTZ:
 	case FPROPS_PENGROB:
 		return fprops_solve_pT_Trho(p,h,fluid,err);
+	case FPROPS_LUT:
+		return lut_solve_pT(p,h,fluid,err);
 	case FPROPS_INCOMP:
 		return fprops_solve_pT_incomp(p,h,fluid,err);
 	default:
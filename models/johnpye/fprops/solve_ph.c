@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "derivs.h"
 #include "rundata.h"
 #include "zeroin.h"
+#include "lut.h"
 
 #include <stdio.h>
 #include <math.h>
@@ -84,6 +85,10 @@ int fprops_region_ph(double p, double h, const PureFluid *fluid, FpropsError *er
 	case FPROPS_HELMHOLTZ:
 	case FPROPS_PENGROB:
 		break; // all good, proceed
+	case FPROPS_LUT:
+		// tabulated states are single-phase
+		if(lut_ph_tabulated(p,h,fluid))return FPROPS_NON;
+		break;
 	case FPROPS_INCOMP:
 		// incompressible fluids are always non-saturated.
 		return FPROPS_NON;
@@ -135,6 +140,8 @@ FluidState2 fprops_solve_ph(double p, double h, const PureFluid *fluid, FpropsEr
 	case FPROPS_HELMHOLTZ:
 	case FPROPS_PENGROB:
 		return fprops_solve_ph_Trho(p,h,fluid,err);
+	case FPROPS_LUT:
+		return lut_solve_ph(p,h,fluid,err);
 	case FPROPS_INCOMP:
 		return fprops_solve_ph_incomp(p,h,fluid,err);
 	default:
@@ -144,6 +151,17 @@ FluidState2 fprops_solve_ph(double p, double h, const PureFluid *fluid, FpropsEr
 	}
 }
 
+/**
+	Last single-phase solution from fprops_solve_ph_Trho, used as the starting
+	point of the next iteration when that is for a nearby state of the same
+	fluid, on the same side of the saturation curve. Kept per thread, so that
+	threads solving different states don't disturb each other's starts.
+*/
+static FPROPS_THREAD_LOCAL struct{
+	const PureFluid *fluid;
+	double p, h, T, rho;
+} ph_last = {NULL, 0, 0, 0, 0};
+
 static FluidState2 fprops_solve_ph_Trho(double p, double h, const PureFluid *fluid, FpropsError *err){
 	double T = 0, rho = 0;
 	double Tsat, rhof, rhog, hf, hg;
@@ -240,6 +258,23 @@ static FluidState2 fprops_solve_ph_Trho(double p, double h, const PureFluid *flu
 
 		T1 = T;
 		rho1 = rho;
+
+		int warm = 0;
+		if(ph_last.fluid == fluid && fabs(log(p / ph_last.p)) < 0.5
+			&& fabs(h - ph_last.h) < 0.2 * fluid->data->R * ph_last.T
+		){
+			if(subcrit_pressure){
+				if(liquid_iteration)warm = (ph_last.rho >= rhof);
+				else warm = (ph_last.rho <= rhog);
+			}else{
+				warm = (ph_last.p >= p_c);
+			}
+			if(warm){
+				MSG("WARM START from previous solution: T = %f, rho = %f",ph_last.T,ph_last.rho);
+				T1 = ph_last.T;
+				rho1 = ph_last.rho;
+			}
+		}
 		assert(!isnan(T1));
 		assert(!isnan(rho1));
 
@@ -254,13 +289,16 @@ static FluidState2 fprops_solve_ph_Trho(double p, double h, const PureFluid *flu
 		}
 
 		/* try our own home-baked newton iteration */
-		int i = 0;
+		int i;
+newton:
+		i = 0;
 		*err = FPROPS_NO_ERROR;
 		double delta_T = 0;
 		double delta_rho = 0;
 		MSG("STARTING ITERATION");
 		MSG("rhof_t = %f",rhof_t);
 		while(i++ < 200){
+			if(warm && i > 50)break;
 			//FluidState2 S1 = fprops_set_Trho(T1,rho1,fluid,err);
 			//double p1 = fprops_p(S1,err);
 			double p1 = fluid->p_fn(FSU_TRHO(T1,rho1), fluid->data, err);
@@ -302,6 +340,11 @@ static FluidState2 fprops_solve_ph_Trho(double p, double h, const PureFluid *flu
 
 			if(fabs(p1 - p) < 1e-4 && fabs(h1 - h) < 1e-8){
 				MSG("Converged to T = %f, rho = %f, in homebaked Newton solver", T1, rho1);
+				ph_last.fluid = fluid;
+				ph_last.p = p;
+				ph_last.h = h;
+				ph_last.T = T1;
+				ph_last.rho = rho1;
 				return STATE_TRHO(fluid,T1,rho1);
 			}
 			/* calculate step, we're solving log(p1) in this code... */
@@ -391,6 +434,13 @@ static FluidState2 fprops_solve_ph_Trho(double p, double h, const PureFluid *flu
 			if(T1 < fluid->data->T_t)T1 = fluid->data->T_t;
 			rho1 = rho1 + delta_rho;
 		}
+		if(warm){
+			MSG("Warm start failed; retrying from the usual starting point");
+			warm = 0;
+			T1 = T;
+			rho1 = rho;
+			goto newton;
+		}
 #ifdef FPE_DEBUG
 	}else{
 		/* an FPE occurred */
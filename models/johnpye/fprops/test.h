@@ -72,6 +72,7 @@ int helm_check_p_c(const HelmholtzData *d);
 #define STATENAME1(STATE) \
 	((STATE.fluid->type == FPROPS_HELMHOLTZ\
 		||STATE.fluid->type == FPROPS_PENGROB\
+		||STATE.fluid->type == FPROPS_LUT\
 		||STATE.fluid->type == FPROPS_IDEAL\
 		||STATE.fluid->type == FPROPS_INCOMP\
 	) ? "T" : "???")
@@ -79,6 +80,7 @@ int helm_check_p_c(const HelmholtzData *d);
 #define STATENAME2(STATE) \
 	((STATE.fluid->type == FPROPS_HELMHOLTZ \
 		||STATE.fluid->type == FPROPS_PENGROB \
+		||STATE.fluid->type == FPROPS_LUT \
 		||STATE.fluid->type == FPROPS_IDEAL \
 	) ? "rho" \
 	: ((STATE.fluid->type == FPROPS_INCOMP) ? "p" : "???")) \
@@ -86,6 +88,7 @@ int helm_check_p_c(const HelmholtzData *d);
 #define STATEVAL1(STATE) \
 	((STATE.fluid->type == FPROPS_HELMHOLTZ\
 		||STATE.fluid->type == FPROPS_PENGROB\
+		||STATE.fluid->type == FPROPS_LUT\
 		||STATE.fluid->type == FPROPS_IDEAL\
 	) ? STATE.vals.Trho.T\
 	: (\
@@ -97,6 +100,7 @@ int helm_check_p_c(const HelmholtzData *d);
 #define STATEVAL2(STATE) \
 	((STATE.fluid->type == FPROPS_HELMHOLTZ\
 		||STATE.fluid->type == FPROPS_PENGROB\
+		||STATE.fluid->type == FPROPS_LUT\
 		||STATE.fluid->type == FPROPS_IDEAL\
 	) ? STATE.vals.Trho.rho\
 	: (\
@@ -136,6 +136,10 @@ static void integrator_ida_create(IntegratorSystem *integ) {
 			| VAR_FIXED;
 	enginedata->vfilter.matchvalue = VAR_SVAR | VAR_INCIDENT | VAR_ACTIVE | 0;
 	enginedata->pfree = NULL;
+	enginedata->jstart = NULL;
+	enginedata->jslot = NULL;
+	enginedata->jvmode = IDA_JV_DIRECTIONAL;
+	enginedata->jvdata = NULL;
 
 	enginedata->rfilter.matchbits = REL_EQUALITY | REL_INCLUDED | REL_ACTIVE;
 	enginedata->rfilter.matchvalue = REL_EQUALITY | REL_INCLUDED | REL_ACTIVE;
@@ -166,7 +170,10 @@ static void integrator_ida_free(void *enginedata) {
 		(d->pfree)(enginedata);
 	}
 
+	integrator_ida_jvdata_free(d);
 	ASC_FREE(d->rellist);
+	if(d->jstart)ASC_FREE(d->jstart);
+	if(d->jslot)ASC_FREE(d->jslot);
 
 #ifdef DESTROY_DEBUG
 	CONSOLE_DEBUG("Now destroying the enginedata");
@@ -203,6 +210,7 @@ enum ida_parameters {
 	IDA_PARAM_GSMODIFIED,
 	IDA_PARAM_MAXNCF,
 	IDA_PARAM_PREC,
+	IDA_PARAM_JVMODE,
 	IDA_PARAMS_SIZE
 };
 
@@ -294,7 +302,9 @@ static int integrator_ida_params_default(IntegratorSystem *integ) {
 		,(SlvParameterInitChar) { {"linsolver"
 				,"Linear solver",1
 				,"See IDA manual, section 5.5.3. Choose 'ASCEND' to use the linsolqr"
-				" direct linear solver bundled with ASCEND, 'DENSE' to use the dense"
+				" sparse direct linear solver bundled with ASCEND (the matrix pattern"
+				" is built once from the incidence graph and only refactored"
+				" numerically thereafter; best for large systems), 'DENSE' to use the dense"
 				" solver bundled with IDA, or one of the Krylov solvers SPGMR, SPBCG"
 				" or SPTFQMR (which still need preconditioners to be implemented"
 				" before they can be very useful."
@@ -342,6 +352,20 @@ static int integrator_ida_params_default(IntegratorSystem *integ) {
 			},"NONE"}, (char *[]) {"NONE","DIAG",NULL}
 	);
 
+	slv_param_char(p,IDA_PARAM_JVMODE
+		,(SlvParameterInitChar) { {"jvmode"
+				,"Jacobian-vector products",1
+				,"How J*v is computed for the Krylov solvers (SPGMR, SPBCG, SPTFQMR)"
+				" when autodiff is on. 'GRADIENT' evaluates the full gradient of every"
+				" relation for each product. 'DIRECTIONAL' uses one forward-mode"
+				" directional derivative sweep per relation. 'COLORED' recovers the"
+				" sparse Jacobian by finite differences with columns grouped by"
+				" graph colouring (one residual evaluation per colour), once per"
+				" Newton iteration, after which each product is a sparse"
+				" matrix-vector multiplication."
+			},"DIRECTIONAL"}, (char *[]) {"GRADIENT","DIRECTIONAL","COLORED",NULL}
+	);
+
 	asc_assert(p->num_parms == IDA_PARAMS_SIZE);
 
 	CONSOLE_DEBUG("Created %d params", p->num_parms);
@@ -365,6 +389,9 @@ int ida_load_rellist(IntegratorSystem *integ) {
 	n_active_rels = slv_count_solvers_rels(integ->system, &integrator_ida_rel);
 	rels = slv_get_solvers_rel_list(integ->system);
 
+	/* programs and patterns kept for J*v refer to the old relation list */
+	integrator_ida_jvdata_free(enginedata);
+
 	if (enginedata->rellist != NULL) {
 		ASC_FREE(enginedata->rellist);
 		enginedata->rellist = NULL;
@@ -555,7 +582,11 @@ int ida_set_optional_inputs(IntegratorSystem *integ, void *ida_mem) {
 	CONSOLE_DEBUG("ASSIGNING LINEAR SOLVER '%s'",linsolver);
 	if (strcmp(linsolver, "ASCEND") == 0) {
 		CONSOLE_DEBUG("ASCEND DIRECT SOLVER, size = %d",integ->n_y);
-		IDAASCEND(ida_mem, integ->n_y);
+		flag = IDAASCEND(ida_mem, integ->n_y);
+		if(flag != IDAASCEND_SUCCESS){
+			ERROR_REPORTER_HERE(ASC_PROG_ERR,"Unable to set up IDAASCEND linear solver (flag %d)",flag);
+			return 5;
+		}
 		IDAASCENDSetJacFn(ida_mem, &integrator_ida_sjex, (void *) integ);
 
 		enginedata->flagfntype = "IDAASCEND";
@@ -672,6 +703,15 @@ int ida_set_optional_inputs(IntegratorSystem *integ, void *ida_mem) {
 		/* assign the J*v function */
 		if (SLV_PARAM_BOOL(&(integ->params),IDA_PARAM_AUTODIFF)) {
 			CONSOLE_DEBUG("USING AUTODIFF");
+			pname = SLV_PARAM_CHAR(&(integ->params),IDA_PARAM_JVMODE);
+			if (strcmp(pname, "GRADIENT") == 0) {
+				enginedata->jvmode = IDA_JV_GRADIENT;
+			} else if (strcmp(pname, "COLORED") == 0) {
+				enginedata->jvmode = IDA_JV_COLORED;
+			} else {
+				enginedata->jvmode = IDA_JV_DIRECTIONAL;
+			}
+			CONSOLE_DEBUG("J*v MODE = %s",pname);
 #if SUNDIALS_VERSION_MAJOR==2 && SUNDIALS_VERSION_MINOR>=4
 			flag = IDASpilsSetJacTimesVecFn(ida_mem, &integrator_ida_jvex);
 #else
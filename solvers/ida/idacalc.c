@@ -33,6 +33,8 @@
 #include <setjmp.h>
 #include <fenv.h>
 #include <math.h>
+#include <float.h>
+#include <string.h>
 
 #ifdef ASC_WITH_MMIO
 # include <mmio.h>
@@ -42,21 +44,25 @@
 #include <ascend/utilities/error.h>
 #include <ascend/utilities/ascSignal.h>
 #include <ascend/general/panic.h>
+#include <ascend/general/mathmacros.h>
 #include <ascend/compiler/instance_enum.h>
 
 #include <ascend/system/slv_client.h>
 #include <ascend/system/relman.h>
+#include <ascend/system/relprog.h>
 #include <ascend/system/block.h>
 #include <ascend/system/slv_stdcalls.h>
 #include <ascend/system/jacobian.h>
 #include <ascend/system/bndman.h>
 
+#include <ascend/linear/mtx_frozen.h>
+
 #include <ascend/utilities/config.h>
 #include <ascend/integrator/integrator.h>
 
 
 /* #define FEX_DEBUG  */
-#define JEX_DEBUG
+/* #define JEX_DEBUG */
 /* #define DJEX_DEBUG */
 /* #define ROOT_DEBUG */
 
@@ -446,23 +452,10 @@ int integrator_ida_djex(long int Neq, realtype tt
 }
 
 /**
-	Function to evaluate the product J*v, in the form required for IDA (see IDASpilsSetJacTimesVecFn)
-
-	Given tt, yy, yp, rr and v, we need to evaluate and return Jv.
-
-	@param tt current value of the independent variable (time, t)
-	@param yy current value of the dependent variable vector, y(t).
-	@param yp current value of y'(t).
-	@param rr current value of the residual vector F(t, y, y').
-	@param v  the vector by which the Jacobian must be multiplied to the right.
-	@param Jv the output vector computed
-	@param c_j the scalar in the system Jacobian, proportional to the inverse of the step size ($ \alpha$ in Eq. (3.5) ).
-	@param jac_data pointer to our stuff (integ in this case, passed into IDA via IDASp*SetJacTimesVecFn.)
-	@param tmp1 @see tmp2
-	@param tmp2 (as well as tmp1) pointers to memory allocated for variables of type N_Vector for use here as temporary storage or work space.
-	@return 0 on success
+	J*v from the full gradient of each relation (relman_diff3), one row at a
+	time. See integrator_ida_jvex for the arguments.
 */
-int integrator_ida_jvex(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr
+static int integrator_ida_jvex_grad(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr
 		, N_Vector v, N_Vector Jv, realtype c_j
 		, void *jac_data, N_Vector tmp1, N_Vector tmp2
 ){
@@ -605,14 +598,551 @@ int integrator_ida_jvex(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr
 	return 0;
 }
 
-/* sparse jacobian evaluation for IDAASCEND sparse direct linear solver */
+/**
+	Column of the iteration matrix for a variable incident in a relation: a
+	state y_i and its derivative y'_i both go to column i. The independent
+	variable has no column (-1).
+*/
+static int integrator_ida_jcol(IntegratorSystem *integ, struct var_variable *v){
+	if(v == integ->x)return -1;
+	if(var_deriv(v))return integrator_ida_diffindex(integ,v);
+	return var_sindex(v);
+}
+
+/**
+	Fill Jac with the structural pattern of F_y + c_j F_y', row i being
+	relation i, taken from the relation incidences. Values are all nonzero
+	(so that a y and y' sharing a column can't cancel out) but meaningless.
+*/
+static void integrator_ida_fill_pattern(IntegratorSystem *integ, mtx_matrix_t Jac){
+	IntegratorIdaData *enginedata;
+	const struct var_variable **vlist;
+	struct var_variable *v;
+	int i, c, len, col;
+	mtx_coord_t C;
+
+	enginedata = integrator_ida_enginedata(integ);
+	mtx_clear(Jac);
+	for(i=0; i < enginedata->nrels; ++i){
+		len = rel_n_incidences(enginedata->rellist[i]);
+		vlist = rel_incidence_list(enginedata->rellist[i]);
+		for(c=0; c < len; ++c){
+			v = (struct var_variable *)vlist[c];
+			if(!var_apply_filter(v,&enginedata->vfilter))continue;
+			col = integrator_ida_jcol(integ,v);
+			if(col < 0)continue;
+			mtx_fill_org_value(Jac, mtx_coord(&C, i, col), 1.0);
+		}
+	}
+	mtx_assemble(Jac);
+}
+
+/**
+	Build the structural pattern of F_y + c_j F_y' in Jac from the relation
+	incidences, freeze it, and record for each filtered incidence of each
+	relation (in the order relman_diff3 returns them) the slot that its
+	derivative is to be added into (mtx_NONE for the independent variable).
+
+	@return 0 on success, nonzero if the pattern could not be frozen.
+*/
+static int integrator_ida_sjex_freeze(IntegratorSystem *integ, mtx_matrix_t Jac){
+	IntegratorIdaData *enginedata;
+	const struct var_variable **vlist;
+	struct var_variable *v;
+	int i, c, len, col, nnz;
+	int32 *slot;
+
+	enginedata = integrator_ida_enginedata(integ);
+
+	if(enginedata->jstart)ASC_FREE(enginedata->jstart);
+	if(enginedata->jslot)ASC_FREE(enginedata->jslot);
+	enginedata->jstart = ASC_NEW_ARRAY(int32,enginedata->nrels + 1);
+
+	nnz = 0;
+	for(i=0; i < enginedata->nrels; ++i){
+		enginedata->jstart[i] = nnz;
+		len = rel_n_incidences(enginedata->rellist[i]);
+		vlist = rel_incidence_list(enginedata->rellist[i]);
+		for(c=0; c < len; ++c){
+			if(var_apply_filter(vlist[c],&enginedata->vfilter))nnz++;
+		}
+	}
+	enginedata->jstart[enginedata->nrels] = nnz;
+	enginedata->jslot = ASC_NEW_ARRAY(int32,nnz > 0 ? nnz : 1);
+
+	integrator_ida_fill_pattern(integ,Jac);
+	if(mtx_freeze(Jac,mtx_ENTIRE_MATRIX))return 1;
+
+	for(i=0; i < enginedata->nrels; ++i){
+		slot = enginedata->jslot + enginedata->jstart[i];
+		len = rel_n_incidences(enginedata->rellist[i]);
+		vlist = rel_incidence_list(enginedata->rellist[i]);
+		for(c=0; c < len; ++c){
+			v = (struct var_variable *)vlist[c];
+			if(!var_apply_filter(v,&enginedata->vfilter))continue;
+			col = integrator_ida_jcol(integ,v);
+			*slot = (col < 0) ? mtx_NONE : mtx_frozen_slot(Jac, i, col);
+			if(col >= 0 && *slot == mtx_NONE){
+				mtx_thaw(Jac);
+				return 1;
+			}
+			slot++;
+		}
+	}
+
+	CONSOLE_DEBUG("Frozen IDA Jacobian pattern: %d rows, %d nonzeros"
+		,enginedata->nrels, mtx_frozen_nonzeros(Jac)
+	);
+	return 0;
+}
+
+/**
+	Sparse Jacobian evaluation for the IDAASCEND sparse direct linear solver.
+
+	The first call for a given matrix builds and freezes its pattern from
+	the incidence graph (see integrator_ida_sjex_freeze). Subsequent calls
+	only write the new values of F_y + c_j F_y' into the frozen slots, so
+	that the matrix pattern, and with it the orderings and pivot sequence
+	kept by linsolqr, stay the same from one Jacobian to the next.
+*/
 int integrator_ida_sjex(long int Neq, realtype tt
 		, N_Vector yy, N_Vector yp, N_Vector rr
 		, realtype c_j, void *jac_data, mtx_matrix_t Jac
 		, N_Vector tmp1, N_Vector tmp2, N_Vector tmp3
 ){
-	ERROR_REPORTER_HERE(ASC_PROG_ERR,"Not implemented");
-	return -1;
+	IntegratorSystem *integ;
+	IntegratorIdaData *enginedata;
+	char *relname;
+	struct rel_relation **relptr;
+	int i, j, nnz;
+	double *derivatives, *val;
+	struct var_variable **variables;
+	int32 *slot;
+	int count, status, is_error = 0;
+
+	integ = (IntegratorSystem *)jac_data;
+	enginedata = integrator_ida_enginedata(integ);
+
+	if(enginedata->nrels != Neq){
+		ERROR_REPORTER_HERE(ASC_PROG_ERR,"Number of relations (%d) does not"
+			" match the number of states (%ld)",enginedata->nrels,Neq
+		);
+		return -1;
+	}
+
+	if(!mtx_is_frozen(Jac) && integrator_ida_sjex_freeze(integ,Jac)){
+		ERROR_REPORTER_HERE(ASC_PROG_ERR,"Unable to freeze the Jacobian pattern");
+		return -1;
+	}
+
+	/* pass the values of everything back to the compiler */
+	integrator_set_t(integ, (double)tt);
+	integrator_set_y(integ, NV_DATA_S(yy));
+	integrator_set_ydot(integ, NV_DATA_S(yp));
+
+	/* perform bounds checking on all variables */
+	if(slv_check_bounds(integ->system, 0, -1, NULL)){
+		return 1;
+	}
+
+	variables = ASC_NEW_ARRAY(struct var_variable*, NV_LENGTH_S(yy) * 2);
+	derivatives = ASC_NEW_ARRAY(double, NV_LENGTH_S(yy) * 2);
+
+	val = mtx_frozen_values(Jac);
+	nnz = mtx_frozen_nonzeros(Jac);
+	for(j=0; j < nnz; ++j)val[j] = 0.0;
+
+	for(i=0, relptr = enginedata->rellist;
+			i< enginedata->nrels && relptr != NULL;
+			++i, ++relptr
+	){
+		status = relman_diff3(*relptr, &enginedata->vfilter, derivatives, variables, &count, enginedata->safeeval);
+		if(status){
+			relname = rel_make_name(integ->system, *relptr);
+			CONSOLE_DEBUG("ERROR calculating derivatives for relation '%s'",relname);
+			ASC_FREE(relname);
+			is_error = 1;
+			break;
+		}
+		asc_assert(count == enginedata->jstart[i+1] - enginedata->jstart[i]);
+
+		/* y and y' of the same state share a slot: add, don't assign */
+		slot = enginedata->jslot + enginedata->jstart[i];
+		for(j=0; j < count; ++j){
+			if(slot[j] == mtx_NONE)continue;
+			if(var_deriv(variables[j])){
+				val[slot[j]] += derivatives[j] * c_j;
+			}else{
+				val[slot[j]] += derivatives[j];
+			}
+		}
+	}
+
+	ASC_FREE(variables);
+	ASC_FREE(derivatives);
+
+	if(is_error){
+		return 1;
+	}
+	mtx_frozen_commit(Jac);
+	return 0;
+}
+
+/*--------------------------------------------------
+  JACOBIAN-VECTOR PRODUCTS FOR THE KRYLOV SOLVERS
+*/
+
+/**
+	Data kept between calls of integrator_ida_jvex in the DIRECTIONAL and
+	COLORED modes. Built on first use, and freed (so rebuilt) whenever the
+	relation list is reloaded.
+*/
+struct IntegratorIdaJvDataStruct{
+	/* DIRECTIONAL */
+	struct RelProg **progs;  /**< by relation; NULL where not compiled */
+	double *work;            /**< program work space plus one gradient */
+	double *dir;             /**< direction, in rel_incidence_list order */
+
+	/* COLORED */
+	mtx_matrix_t J;          /**< frozen pattern of F_y + c_j F_y' */
+	int32 n;                 /**< order of J */
+	const int32 *colptr;     /**< CSC pattern of J (arrays owned by J) */
+	const int32 *rowind;
+	real64 *val;             /**< last Jacobian, in CSC slot order */
+	int32 ncolors;
+	int32 *colorstart;       /**< columns of colour k are bycolor[colorstart[k]..] */
+	int32 *bycolor;
+	double *inc;             /**< increment of each column in its sweep */
+	N_Vector ftmp;           /**< residuals at the perturbed point */
+	int valid;               /**< val holds J at (t, c_j, ykey, ypkey) */
+	double t, c_j;
+	double *ykey, *ypkey;
+};
+
+static IntegratorIdaJvData *integrator_ida_jvdata(IntegratorSystem *integ){
+	IntegratorIdaData *enginedata = integrator_ida_enginedata(integ);
+	IntegratorIdaJvData *jv;
+	if(enginedata->jvdata == NULL){
+		jv = ASC_NEW_CLEAR(IntegratorIdaJvData);
+		enginedata->jvdata = jv;
+	}
+	return enginedata->jvdata;
+}
+
+void integrator_ida_jvdata_free(IntegratorIdaData *enginedata){
+	IntegratorIdaJvData *jv = enginedata->jvdata;
+	int i;
+	if(jv == NULL)return;
+	if(jv->progs){
+		for(i=0; i < enginedata->nrels; ++i)relprog_destroy(jv->progs[i]);
+		ASC_FREE(jv->progs);
+	}
+	if(jv->work)ASC_FREE(jv->work);
+	if(jv->dir)ASC_FREE(jv->dir);
+	if(jv->J)mtx_destroy(jv->J);
+	if(jv->colorstart)ASC_FREE(jv->colorstart);
+	if(jv->bycolor)ASC_FREE(jv->bycolor);
+	if(jv->inc)ASC_FREE(jv->inc);
+	if(jv->ftmp)N_VDestroy_Serial(jv->ftmp);
+	if(jv->ykey)ASC_FREE(jv->ykey);
+	if(jv->ypkey)ASC_FREE(jv->ypkey);
+	ASC_FREE(jv);
+	enginedata->jvdata = NULL;
+}
+
+/**
+	Compile the relations for the DIRECTIONAL mode, and size the work
+	arrays for the longest relation.
+*/
+static void integrator_ida_jv_progs(IntegratorSystem *integ, IntegratorIdaJvData *jv){
+	IntegratorIdaData *enginedata = integrator_ida_enginedata(integ);
+	int i, len, maxwork = 1, maxlen = 1, ncompiled = 0;
+
+	jv->progs = ASC_NEW_ARRAY(struct RelProg *,enginedata->nrels > 0 ? enginedata->nrels : 1);
+	for(i=0; i < enginedata->nrels; ++i){
+		jv->progs[i] = relprog_create(enginedata->rellist[i]);
+		len = rel_n_incidences(enginedata->rellist[i]);
+		maxlen = MAX(maxlen,len);
+		if(jv->progs[i]){
+			ncompiled++;
+			len += relprog_work_size(jv->progs[i]);
+		}
+		maxwork = MAX(maxwork,len);
+	}
+	jv->work = ASC_NEW_ARRAY(double,maxwork);
+	jv->dir = ASC_NEW_ARRAY(double,maxlen);
+	CONSOLE_DEBUG("Compiled %d of %d relations for J*v",ncompiled,enginedata->nrels);
+}
+
+/**
+	J*v with one forward-mode directional derivative sweep per relation,
+	along the direction (v, c_j v) in (y, y'). See integrator_ida_jvex.
+*/
+static int integrator_ida_jvex_dir(realtype tt, N_Vector yy, N_Vector yp
+		, N_Vector v, N_Vector Jv, realtype c_j, IntegratorSystem *integ
+){
+	IntegratorIdaData *enginedata = integrator_ida_enginedata(integ);
+	IntegratorIdaJvData *jv = integrator_ida_jvdata(integ);
+	const struct var_variable **vlist;
+	struct var_variable *var;
+	struct rel_relation *rel;
+	int i, c, len;
+	double Jv_i;
+	char *relname;
+
+	if(jv->progs == NULL)integrator_ida_jv_progs(integ,jv);
+
+	integrator_set_t(integ, (double)tt);
+	integrator_set_y(integ, NV_DATA_S(yy));
+	integrator_set_ydot(integ, NV_DATA_S(yp));
+
+	for(i=0; i < enginedata->nrels; ++i){
+		rel = enginedata->rellist[i];
+		len = rel_n_incidences(rel);
+		vlist = rel_incidence_list(rel);
+		for(c=0; c < len; ++c){
+			var = (struct var_variable *)vlist[c];
+			if(var == integ->x || !var_apply_filter(var,&enginedata->vfilter)){
+				jv->dir[c] = 0.0;
+			}else if(var_deriv(var)){
+				jv->dir[c] = c_j * NV_Ith_S(v,integrator_ida_diffindex(integ,var));
+			}else{
+				jv->dir[c] = NV_Ith_S(v,var_sindex(var));
+			}
+		}
+		if(relman_diff_dir(rel, jv->progs[i], jv->dir, &Jv_i
+				, enginedata->safeeval, jv->work)
+		){
+			relname = rel_make_name(integ->system, rel);
+			ERROR_REPORTER_HERE(ASC_PROG_ERR,"Calculation error in rel '%s'",relname);
+			ASC_FREE(relname);
+			return 1;
+		}
+		NV_Ith_S(Jv,i) = Jv_i;
+	}
+	return 0;
+}
+
+/**
+	Set up the COLORED mode: freeze the pattern of F_y + c_j F_y' and
+	colour its columns greedily so that no two columns of the same colour
+	share a row (Curtis-Powell-Reid). All the columns of one colour can
+	then be perturbed together in a single residual sweep.
+*/
+static int integrator_ida_jv_color(IntegratorSystem *integ, IntegratorIdaJvData *jv){
+	int32 *rowptr, *colind, *color, *mark, *fill;
+	int32 n, i, j, k, p, q, c;
+	real64 *val;
+
+	n = (int32)integ->n_y;
+	jv->J = mtx_create();
+	mtx_set_order(jv->J, n);
+	integrator_ida_fill_pattern(integ, jv->J);
+	if(mtx_freeze(jv->J, mtx_ENTIRE_MATRIX)
+		|| mtx_frozen_csc(jv->J, &jv->n, &jv->colptr, &jv->rowind, &val)
+	){
+		ERROR_REPORTER_HERE(ASC_PROG_ERR,"Unable to freeze the Jacobian pattern");
+		return 1;
+	}
+	jv->val = val;
+	asc_assert(jv->n == n);
+
+	/* the same pattern by rows */
+	rowptr = ASC_NEW_ARRAY_CLEAR(int32, n + 1);
+	colind = ASC_NEW_ARRAY(int32, jv->colptr[n] > 0 ? jv->colptr[n] : 1);
+	for(p=0; p < jv->colptr[n]; ++p)rowptr[jv->rowind[p] + 1]++;
+	for(i=0; i < n; ++i)rowptr[i+1] += rowptr[i];
+	fill = ASC_NEW_ARRAY(int32, n > 0 ? n : 1);
+	for(i=0; i < n; ++i)fill[i] = rowptr[i];
+	for(j=0; j < n; ++j){
+		for(p=jv->colptr[j]; p < jv->colptr[j+1]; ++p){
+			colind[fill[jv->rowind[p]]++] = j;
+		}
+	}
+
+	/* greedy colouring: mark[c]==j if colour c is taken by a neighbour of j */
+	color = ASC_NEW_ARRAY(int32, n > 0 ? n : 1);
+	mark = ASC_NEW_ARRAY(int32, n + 1);
+	for(k=0; k <= n; ++k)mark[k] = -1;
+	jv->ncolors = 0;
+	for(j=0; j < n; ++j){
+		color[j] = -1;
+		for(p=jv->colptr[j]; p < jv->colptr[j+1]; ++p){
+			i = jv->rowind[p];
+			for(q=rowptr[i]; q < rowptr[i+1]; ++q){
+				c = color[colind[q]];
+				if(colind[q] < j && c >= 0)mark[c] = j;
+			}
+		}
+		for(c=0; mark[c] == j; ++c);
+		color[j] = c;
+		if(c + 1 > jv->ncolors)jv->ncolors = c + 1;
+	}
+
+	/* columns grouped by colour */
+	jv->colorstart = ASC_NEW_ARRAY_CLEAR(int32, jv->ncolors + 1);
+	jv->bycolor = ASC_NEW_ARRAY(int32, n > 0 ? n : 1);
+	for(j=0; j < n; ++j)jv->colorstart[color[j] + 1]++;
+	for(c=0; c < jv->ncolors; ++c)jv->colorstart[c+1] += jv->colorstart[c];
+	for(c=0; c < jv->ncolors; ++c)fill[c] = jv->colorstart[c];
+	for(j=0; j < n; ++j)jv->bycolor[fill[color[j]]++] = j;
+
+	ASC_FREE(rowptr);
+	ASC_FREE(colind);
+	ASC_FREE(fill);
+	ASC_FREE(color);
+	ASC_FREE(mark);
+
+	jv->inc = ASC_NEW_ARRAY(double, n > 0 ? n : 1);
+	jv->ykey = ASC_NEW_ARRAY(double, n > 0 ? n : 1);
+	jv->ypkey = ASC_NEW_ARRAY(double, n > 0 ? n : 1);
+	jv->ftmp = N_VNew_Serial(n);
+	jv->valid = 0;
+
+	CONSOLE_DEBUG("J*v: %d columns in %d colours (%d nonzeros)"
+		,n, jv->ncolors, jv->colptr[n]
+	);
+	return 0;
+}
+
+/**
+	Recover F_y + c_j F_y' at (tt, yy, yp) by finite differences, with one
+	residual sweep per colour. Each column j is perturbed by inc_j in y_j
+	and c_j*inc_j in y'_j together, as IDA's own difference quotients do.
+	rr must be the residual at the unperturbed point.
+*/
+static int integrator_ida_jv_colored_eval(realtype tt, N_Vector yy, N_Vector yp
+		, N_Vector rr, realtype c_j, IntegratorSystem *integ
+		, IntegratorIdaJvData *jv, N_Vector ytmp, N_Vector yptmp
+){
+	int32 c, k, j, p, n = jv->n;
+	double *y, *ypd, *yt, *ypt, *f0, *f1, inc, nom, srur;
+	int status = 0;
+
+	srur = sqrt(DBL_EPSILON);
+	y = NV_DATA_S(yy);
+	ypd = NV_DATA_S(yp);
+	yt = NV_DATA_S(ytmp);
+	ypt = NV_DATA_S(yptmp);
+	f0 = NV_DATA_S(rr);
+	f1 = NV_DATA_S(jv->ftmp);
+
+	for(j=0; j < n; ++j){
+		yt[j] = y[j];
+		ypt[j] = ypd[j];
+	}
+	for(c=0; c < jv->ncolors && !status; ++c){
+		for(k=jv->colorstart[c]; k < jv->colorstart[c+1]; ++k){
+			j = jv->bycolor[k];
+			nom = fabs(var_nominal(integ->y[j]));
+			inc = srur * MAX(fabs(y[j]), nom > 0 ? nom : 1.0);
+			inc = (y[j] + inc) - y[j];
+			jv->inc[j] = inc;
+			yt[j] = y[j] + inc;
+			ypt[j] = ypd[j] + c_j * inc;
+		}
+		status = integrator_ida_fex(tt, ytmp, yptmp, jv->ftmp, (void *)integ);
+		for(k=jv->colorstart[c]; k < jv->colorstart[c+1]; ++k){
+			j = jv->bycolor[k];
+			if(!status){
+				for(p=jv->colptr[j]; p < jv->colptr[j+1]; ++p){
+					jv->val[p] = (f1[jv->rowind[p]] - f0[jv->rowind[p]]) / jv->inc[j];
+				}
+			}
+			yt[j] = y[j];
+			ypt[j] = ypd[j];
+		}
+	}
+
+	/* leave the model at the unperturbed point */
+	integrator_set_t(integ, (double)tt);
+	integrator_set_y(integ, y);
+	integrator_set_ydot(integ, ypd);
+	return status;
+}
+
+/**
+	J*v from a sparse Jacobian recovered by coloured finite differences
+	(see integrator_ida_jv_colored_eval). IDA calls this several times with
+	the same (t, y, y', c_j) during one linear solve, so the Jacobian is
+	only recomputed when one of those has changed; each product is then a
+	sparse matrix-vector multiplication. See integrator_ida_jvex.
+*/
+static int integrator_ida_jvex_colored(realtype tt, N_Vector yy, N_Vector yp
+		, N_Vector rr, N_Vector v, N_Vector Jv, realtype c_j
+		, IntegratorSystem *integ, N_Vector tmp1, N_Vector tmp2
+){
+	IntegratorIdaJvData *jv = integrator_ida_jvdata(integ);
+	int32 j, p, n;
+	double *vd, *Jvd, vj;
+	size_t sz;
+
+	if(jv->J == NULL && integrator_ida_jv_color(integ,jv))return -1;
+	n = jv->n;
+	sz = (size_t)n * sizeof(double);
+
+	if(!jv->valid || jv->t != tt || jv->c_j != c_j
+		|| memcmp(jv->ykey, NV_DATA_S(yy), sz)
+		|| memcmp(jv->ypkey, NV_DATA_S(yp), sz)
+	){
+		jv->valid = 0;
+		if(integrator_ida_jv_colored_eval(tt, yy, yp, rr, c_j, integ, jv, tmp1, tmp2)){
+			return 1;
+		}
+		jv->t = tt;
+		jv->c_j = c_j;
+		memcpy(jv->ykey, NV_DATA_S(yy), sz);
+		memcpy(jv->ypkey, NV_DATA_S(yp), sz);
+		jv->valid = 1;
+	}
+
+	vd = NV_DATA_S(v);
+	Jvd = NV_DATA_S(Jv);
+	for(j=0; j < n; ++j)Jvd[j] = 0.0;
+	for(j=0; j < n; ++j){
+		vj = vd[j];
+		if(vj == 0.0)continue;
+		for(p=jv->colptr[j]; p < jv->colptr[j+1]; ++p){
+			Jvd[jv->rowind[p]] += jv->val[p] * vj;
+		}
+	}
+	return 0;
+}
+
+/**
+	Function to evaluate the product J*v, in the form required for IDA (see IDASpilsSetJacTimesVecFn)
+
+	Given tt, yy, yp, rr and v, we need to evaluate and return Jv. How this
+	is done depends on the 'jvmode' parameter: from the full gradient of
+	each relation (GRADIENT), by one forward-mode sweep per relation
+	(DIRECTIONAL) or from a sparse Jacobian recovered by coloured finite
+	differences (COLORED).
+
+	@param tt current value of the independent variable (time, t)
+	@param yy current value of the dependent variable vector, y(t).
+	@param yp current value of y'(t).
+	@param rr current value of the residual vector F(t, y, y').
+	@param v  the vector by which the Jacobian must be multiplied to the right.
+	@param Jv the output vector computed
+	@param c_j the scalar in the system Jacobian, proportional to the inverse of the step size ($ \alpha$ in Eq. (3.5) ).
+	@param jac_data pointer to our stuff (integ in this case, passed into IDA via IDASp*SetJacTimesVecFn.)
+	@param tmp1 @see tmp2
+	@param tmp2 (as well as tmp1) pointers to memory allocated for variables of type N_Vector for use here as temporary storage or work space.
+	@return 0 on success
+*/
+int integrator_ida_jvex(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr
+		, N_Vector v, N_Vector Jv, realtype c_j
+		, void *jac_data, N_Vector tmp1, N_Vector tmp2
+){
+	IntegratorSystem *integ = (IntegratorSystem *)jac_data;
+	switch(integrator_ida_enginedata(integ)->jvmode){
+	case IDA_JV_DIRECTIONAL:
+		return integrator_ida_jvex_dir(tt, yy, yp, v, Jv, c_j, integ);
+	case IDA_JV_COLORED:
+		return integrator_ida_jvex_colored(tt, yy, yp, rr, v, Jv, c_j, integ, tmp1, tmp2);
+	default:
+		return integrator_ida_jvex_grad(tt, yy, yp, rr, v, Jv, c_j, jac_data, tmp1, tmp2);
+	}
 }
 
 /* root finding function */
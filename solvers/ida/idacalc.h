@@ -20,6 +20,7 @@
 */
 
 #include "ida.h"
+#include "idatypes.h"
 #include "idalinear.h"
 
 /* residual function forward declaration */
@@ -30,6 +31,12 @@ int integrator_ida_jvex(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr
 		, void *jac_data, N_Vector tmp1, N_Vector tmp2
 );
 
+/**
+	Free the data kept between calls of integrator_ida_jvex, eg when the
+	relation list changes. Safe to call if there is none.
+*/
+void integrator_ida_jvdata_free(IntegratorIdaData *enginedata);
+
 /* dense jacobian evaluation for IDADense dense direct linear solver */
 #if SUNDIALS_VERSION_MAJOR==2 && SUNDIALS_VERSION_MINOR>=4
 int integrator_ida_djex(int Neq, realtype tt, realtype c_j
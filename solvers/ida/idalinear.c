@@ -1,7 +1,30 @@
+/*	ASCEND modelling environment
+	Copyright (C) 2006-2011 Carnegie Mellon University
+
+	This program is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2, or (at your option)
+	any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*//**
+	@file
+	Sparse direct linear solver for IDA (IDAASCEND, see idalinear.h). The
+	iteration matrix is factored through linsolqr with SPK1 and sn_lu, with
+	pivot reuse on, so an unchanged pattern is refactored along the old
+	pivot sequence.
+*/
 #include "idalinear.h"
 
 #include <ascend/utilities/error.h>
 #include <ascend/general/ascMalloc.h>
+#include <ascend/linear/linsolqr.h>
 
 /** FIXME should the following be moved to ida.h? */
 #include <sundials/sundials_math.h>
@@ -17,6 +40,8 @@ typedef struct IntegratorIdaAscendMemStruct{
 	unsigned long          integ_nje;
 	unsigned long          integ_nre;
 	mtx_matrix_t           integ_sparse_jac_matrix;
+	linsolqr_system_t      integ_linsys; /* factors of integ_sparse_jac_matrix */
+	real64 *               integ_rhs;    /* rhs registered with integ_linsys */
 } IntegratorIdaAscendMem;
 
 /* readability replacements (see also ida_dense.c from SUNDIALS distro */
@@ -38,6 +63,8 @@ typedef struct IntegratorIdaAscendMemStruct{
 #define jacfn        (iamem->integ_jacfn)
 #define jacdata      (iamem->integ_jac_data)
 #define JJ           (iamem->integ_sparse_jac_matrix)
+#define LL           (iamem->integ_linsys)
+#define rhs          (iamem->integ_rhs)
 
 #define MSGD_IDAMEM_NULL "Integrator memory is NULL."
 #define MSGD_MEM_FAIL    "A memory request failed."
@@ -66,6 +93,7 @@ int integrator_ida_lfree(IDAMem ida_mem);
 int IDAASCEND(void *ida_mem, long _neq){
 	IDAMem IDA_mem;
 	IntegratorIdaAscendMem *iamem;
+	mtx_region_t R;
 
 	if(ida_mem == NULL){
 		IDAProcessError(NULL, IDAASCEND_MEM_NULL, "IDAASCEND", __FUNCTION__, MSGD_IDAMEM_NULL);
@@ -73,15 +101,15 @@ int IDAASCEND(void *ida_mem, long _neq){
 	}
 	IDA_mem = (IDAMem)ida_mem;
 
+	/* free linsolver memory with the previous lfree fn, if allocated */
+	if(lfree != NULL)lfree(IDA_mem);
+
 	iamem = ASC_NEW(IntegratorIdaAscendMem);
 	if(iamem == NULL){
 		return IDAASCEND_MEM_FAIL;
 	}
 	lmem = (void *)iamem;
 
-	/* free linsolver memory with the previous lfree fn, if allocated */
-	if(lfree != NULL)lfree(ida_mem);
-
 	/* set the internal-use linear solver function pointers for IDA */
 	linit  = &integrator_ida_linit;
 	lsetup = &integrator_ida_lsetup;
@@ -94,7 +122,26 @@ int IDAASCEND(void *ida_mem, long _neq){
 	lastflag = IDAASCEND_SUCCESS;
 	neq = _neq;
 
-	/* allocate memory required for Jacobian mtx_matrix_t ?? */
+	/*
+		The matrix is filled and frozen by the first call to jacfn; from then
+		on, the pattern is fixed, so SPK1 and the supernodal LU can keep their
+		orderings and pivot sequence and only refactor numerically.
+	*/
+	JJ = mtx_create();
+	mtx_set_order(JJ, neq);
+	LL = linsolqr_create();
+	rhs = ASC_NEW_ARRAY_CLEAR(real64, neq > 0 ? neq : 1);
+	if(JJ == NULL || LL == NULL || rhs == NULL){
+		lfree(IDA_mem);
+		return IDAASCEND_MEM_FAIL;
+	}
+	linsolqr_set_matrix(LL, JJ);
+	R.row.low = R.col.low = 0;
+	R.row.high = R.col.high = neq - 1;
+	linsolqr_set_region(LL, R);
+	linsolqr_prep(LL, linsolqr_fmethod_to_fclass(sn_lu));
+	linsolqr_set_pivot_reuse(LL, TRUE);
+	linsolqr_add_rhs(LL, rhs, FALSE);
 
 	return IDAASCEND_SUCCESS;
 }
@@ -156,6 +203,8 @@ char *IDAASCENDGetReturnFlagName(int flag){
 		FLAG(IDAASCEND_JACFN_UNDEF);
 		FLAG(IDAASCEND_JACFN_UNRECVR);
 		FLAG(IDAASCEND_JACFN_RECVR);
+		FLAG(IDAASCEND_SINGULAR);
+		FLAG(IDAASCEND_SOLVE_FAIL);
 		default:
 			sprintf(name,"Unknown flag value '%d'",flag);
 	}
@@ -175,9 +224,9 @@ int integrator_ida_linit(IDAMem IDA_mem){
 	CONSOLE_DEBUG("Initialising IDA linear solver");
 	nje = 0;
 	nre = 0;
-	jacfn = NULL;
+	lastflag = IDAASCEND_SUCCESS;
 
-	/* initialise anything else in the IntegratorIdaAscendMem that needs it */
+	/* jacfn has been set already, by IDAASCENDSetJacFn before IDASolve */
 
 	return 0;
 }
@@ -187,12 +236,11 @@ int integrator_ida_lsetup(IDAMem IDA_mem
 	, N_Vector tmp1, N_Vector tmp2, N_Vector tmp3
 ){
 	int retval;
+	mtx_region_t R;
 
   	IntegratorIdaAscendMem *iamem;
 	iamem = (IntegratorIdaAscendMem *)lmem;
 
-	CONSOLE_DEBUG("Setting up IDA linear problem");
-
 	if(jacfn==NULL){
 		lastflag = IDAASCEND_JACFN_UNDEF;
 		return -1; /* unrecoverable */
@@ -201,10 +249,7 @@ int integrator_ida_lsetup(IDAMem IDA_mem
 	/* Increment nje counter. */
 	nje++;
 
-	/* clear the jacobian matrix */
-	/* ... */
-
-	/* evaluate the jacobian */
+	/* evaluate the jacobian (values only, once the pattern is frozen) */
 	retval = jacfn(neq, tn, yyp, ypp, rrp, cj, jacdata, JJ, 
 		tmp1, tmp2, tmp3
 	);
@@ -218,11 +263,24 @@ int integrator_ida_lsetup(IDAMem IDA_mem
 		return +1;
 	}
 
-	/* do block decomposition, LU factorisation or whatever, return success or fail flag */
-	/* ... */
+	/* refactor; with pivot reuse, unchanged orderings are kept */
+	R.row.low = R.col.low = 0;
+	R.row.high = R.col.high = neq - 1;
+	linsolqr_matrix_was_changed(LL);
+	if(linsolqr_reorder(LL, &R, spk1) || linsolqr_factor(LL, sn_lu)){
+		lastflag = IDAASCEND_SINGULAR;
+		return +1;
+	}
+	if(linsolqr_rank(LL) < neq){
+		CONSOLE_DEBUG("Iteration matrix is singular (rank %d < %ld)"
+			,linsolqr_rank(LL), neq
+		);
+		lastflag = IDAASCEND_SINGULAR;
+		return +1; /* recoverable: IDA will try again with a smaller step */
+	}
 
-	ERROR_REPORTER_HERE(ASC_PROG_ERR,"Not implemented");
-	return(-1);
+	lastflag = IDAASCEND_SUCCESS;
+	return 0;
 }
 
 /**
@@ -236,36 +294,46 @@ int integrator_ida_lsolve(IDAMem IDA_mem
 	, N_Vector b, N_Vector weight
 	, N_Vector ycur, N_Vector ypcur, N_Vector rrcur
 ){
-#ifdef STILL_NEED_TO_IMPLEMENT_THIS_STUFF
 	realtype *bd;
-  
+	long i;
+
   	IntegratorIdaAscendMem *iamem;
 	iamem = (IntegratorIdaAscendMem *)lmem;
-  
+
 	/* retrieve the data array for the RHS vector, 'b' */
 	bd = N_VGetArrayPointer(b);
 
-	/* call the necessary linsolqr routine here */
-	/* ... */
-	/* For IDADENSE, it's: DenseGETRS(JJ, pivots, bd); */
+	/* rows of JJ are the relations, in the same order as the residuals */
+	for(i=0; i < neq; ++i)rhs[i] = bd[i];
+	linsolqr_rhs_was_changed(LL, rhs);
+	if(linsolqr_solve(LL, rhs) || linsolqr_copy_solution(LL, rhs, bd)){
+		lastflag = IDAASCEND_SOLVE_FAIL;
+		return +1;
+	}
 
-	/* not sure what this is doing yet */
-	/* For IDADENSE, it's: Scale the correction to account for change in cj. */
+	/* Scale the correction to account for change in cj (as IDADENSE does). */
 	if(cjratio != ONE){
 		N_VScale(TWO/(ONE + cjratio), b, b);
 	}
-#endif
 
-	ERROR_REPORTER_HERE(ASC_PROG_ERR,"Not implemented");
-	return -1;
+	lastflag = IDAASCEND_SUCCESS;
+	return 0;
 }
 
 int integrator_ida_lfree(IDAMem IDA_mem){
-	CONSOLE_DEBUG("Freeing IDA linear solver data");
+  	IntegratorIdaAscendMem *iamem;
 
-	/* free jacobian mtx_matrix_t data ?? */
+	CONSOLE_DEBUG("Freeing IDA linear solver data");
 
 	if(lmem!=NULL){
+		iamem = (IntegratorIdaAscendMem *)lmem;
+		if(LL != NULL){
+			if(rhs != NULL)linsolqr_remove_rhs(LL, rhs);
+			linsolqr_set_matrix(LL, NULL);
+			linsolqr_destroy(LL);
+		}
+		if(JJ != NULL)mtx_destroy(JJ);
+		if(rhs != NULL)ASC_FREE(rhs);
 		ASC_FREE(lmem);
 		lmem=NULL;
 	}
@@ -16,10 +16,13 @@
 *//** @file
 	This file presents a linear solver interface that can be utilised by the
 	IDA integrator from the SUNDIALS suite by LLNL. The linear solver uses the
-	ASCEND linsolqr routines internally, and takes advantage of the block
-	decomposition functionality available in ASCEND.
-
-	EXPERIMENTAL -- INCOMPLETE -- UNDER DEVELOPMENT
+	ASCEND linsolqr routines internally: the iteration matrix F_y + c_j F_y'
+	is kept as a sparse mtx_matrix_t whose pattern is built once, from the
+	relation incidences, and frozen (see mtx_frozen.h). Each new Jacobian
+	only writes new values into the frozen pattern, after which the matrix
+	is refactored with SPK1 and the supernodal LU (sn_lu) with pivot reuse,
+	so that the orderings and pivot sequence are recomputed only when the
+	old pivots no longer hold up numerically.
 
 	This file and idalinear.c are modelled fairly closely on ida_dense.c from
 	the SUNDIALS distribution, which maps out the expected use of ida_lmem
@@ -35,7 +38,12 @@
 #include <ascend/linear/mtx.h>
 
 /**
-	Function prototype for sparse jacobian evaluation as required by this linear solver
+	Function prototype for sparse jacobian evaluation as required by this linear solver.
+	Jac is owned by the linear solver and has order Neq. The function may
+	build and freeze the pattern of Jac on the first call, and must keep it
+	unchanged from then on, writing only values.
+
+	@return 0 on success, >0 on a recoverable error, <0 on an unrecoverable one.
 */
 typedef int IntegratorSparseJacFn(long int Neq, realtype tt
 		, N_Vector yy, N_Vector yp, N_Vector rr
@@ -46,6 +54,8 @@ typedef int IntegratorSparseJacFn(long int Neq, realtype tt
 #define IDAASCEND_SUCCESS 0
 
 #define IDAASCEND_JACFN_RECVR 1
+#define IDAASCEND_SINGULAR 2
+#define IDAASCEND_SOLVE_FAIL 3
 
 #define IDAASCEND_MEM_NULL -1
 #define IDAASCEND_LMEM_NULL -2
@@ -100,6 +100,8 @@ static void integrator_ida_pcreate_jacobian(IntegratorSystem *integ){
 	P = mtx_create();
 	mtx_set_order(P, integ->n_y);
 	linsolqr_set_matrix(precdata->L, P);
+	/* P is refilled with the same pattern at every setup: keep orderings */
+	linsolqr_set_pivot_reuse(precdata->L, TRUE);
 
 	enginedata->pfree = &integrator_ida_pfree_jacobian;
 	enginedata->precdata = precdata;
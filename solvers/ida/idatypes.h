@@ -27,6 +27,16 @@
 /* forward dec needed for IntegratorIdaPrecFreeFn */
 struct IntegratorIdaDataStruct;
 
+/** Data for the DIRECTIONAL and COLORED J*v modes, private to idacalc.c */
+typedef struct IntegratorIdaJvDataStruct IntegratorIdaJvData;
+
+/** How J*v is computed for the Krylov linear solvers (see integrator_ida_jvex) */
+enum ida_jvmode{
+	IDA_JV_GRADIENT,    /**< full gradient of each relation */
+	IDA_JV_DIRECTIONAL, /**< one forward-mode sweep per relation */
+	IDA_JV_COLORED      /**< sparse J from coloured finite differences */
+};
+
 /**
 	Function type for freeing of preconditioner data. FIXME should this be part
 	of the precdata, perhaps? @see idaprec.h
@@ -57,6 +67,13 @@ typedef struct IntegratorIdaDataStruct{
 	void *precdata;                  /**< For use by the preconditioner */
 	IntegratorIdaPrecFreeFn *pfree;	 /**< Store instructions here on how to free precdata */
 
+	/* Frozen Jacobian pattern for the IDAASCEND sparse linear solver */
+	int32 *jstart;                   /**< by relation: offset of its incidences in jslot */
+	int32 *jslot;                    /**< frozen mtx slot of each filtered incidence */
+
+	enum ida_jvmode jvmode;          /**< J*v method for the Krylov solvers */
+	IntegratorIdaJvData *jvdata;     /**< data kept between J*v calls */
+
 	/* Error flag look-up data */
 	IdaFlagFn *flagfn;
 	IdaFlagNameFn *flagnamefn;
@@ -139,6 +139,12 @@ struct IpoptSystemStruct{
 	Index nnzJ; /* number of non zeros in the jacobian of the constraints */
 	Index nnzH; /* number of non-zeros in the hessian of the objective */
 
+	/* sparse Hessian of the Lagrangian, see ipopt_hessian_structure */
+	Index *hrow, *hcol;           /* row and column of each non-zero, nnzH long */
+	Index *hmap;                  /* non-zero for each packed element of each relation's Hessian, or -1 */
+	Index *hstart;                /* start of each relation's part of hmap, objective first */
+	ltmatrix *hrel;               /* Hessian of a single relation */
+
 #if 0
 	Number* x_L;                  /* lower bounds on x */
 	Number* x_U;                  /* upper bounds on x */
@@ -164,6 +170,8 @@ static int ipopt_get_default_parameters(slv_system_t server, SlvClientToken asys
 static void ipopt_iteration_begins(IpoptSystem *sys);
 static void ipopt_iteration_ends(IpoptSystem *sys);
 
+static void ipopt_hessian_destroy(IpoptSystem *sys);
+
 /*------------------------------------------------------------------------------
   SYSTEM SETUP/DESTROY, STATUS AND SOLVER ELIGIBILITY
 */
@@ -253,6 +261,7 @@ static int32 ipopt_destroy(slv_system_t server, SlvClientToken asys){
 	UNUSED_PARAMETER(server);
 	sys = SYS(asys);
 	slv_destroy_parms(&(sys->p));
+	ipopt_hessian_destroy(sys);
 	if(sys->s.cost) ascfree(sys->s.cost);
 	ASC_FREE(sys);
 	ERROR_REPORTER_HERE(ASC_PROG_WARNING,"ipopt_destroy still needs debugging");
@@ -686,7 +695,7 @@ Bool ipopt_eval_grad_f(Index n, Number* x, Bool new_x, Number* grad_f, void *use
 	);
 
 
-	for(j=0; j<len; ++j){
+	for(j=0; j<count; ++j){ /* only the filtered incidences are returned */
 		//asc_assert(!isnan(derivatives[j]));
 		grad_f[variables[j]] = derivatives[j];
 		char *tmp = var_make_name(sys->slv, sys->vlist[variables[j]]);
@@ -820,6 +829,152 @@ Bool ipopt_eval_jac_g(Index n, Number* x, Bool new_x, Index m
 	return TRUE;
 }
 
+/*------------------------------------------------------------------------------
+  SPARSE HESSIAN OF THE LAGRANGIAN
+*/
+
+/*
+	The Lagrangian is obj_factor*f(x) + sum_i lambda[i]*g_i(x). Each relation
+	contributes second derivatives only among its own incident variables, so
+	the sparsity structure is the union of the (filtered) lower triangles of
+	the relations, mapped to rows and columns by variable sindex. It is
+	found once at presolve. For each relation, hmap then gives the non-zero
+	into which each element of its packed lower triangle (as returned by
+	relman_hess_lower) is accumulated.
+
+	Relation k of the Lagrangian is the objective for k==0, else constraint
+	rlist[k-1].
+*/
+#define LAGRANGIAN_REL(SYS,K) ((K)==0 ? (SYS)->obj : (SYS)->rlist[(K)-1])
+
+struct ipopt_hess_entry{
+	Index row, col;
+};
+
+static int ipopt_hess_entry_cmp(const void *a, const void *b){
+	const struct ipopt_hess_entry *ea = a, *eb = b;
+	if(ea->row != eb->row)return ea->row < eb->row ? -1 : 1;
+	if(ea->col != eb->col)return ea->col < eb->col ? -1 : 1;
+	return 0;
+}
+
+static void ipopt_hessian_destroy(IpoptSystem *sys){
+	if(sys->hrow)ASC_FREE(sys->hrow);
+	if(sys->hcol)ASC_FREE(sys->hcol);
+	if(sys->hmap)ASC_FREE(sys->hmap);
+	if(sys->hstart)ASC_FREE(sys->hstart);
+	if(sys->hrel)ltmatrix_destroy(sys->hrel);
+	sys->hrow = sys->hcol = sys->hmap = sys->hstart = NULL;
+	sys->hrel = NULL;
+	sys->nnzH = 0;
+}
+
+/**
+	Find the sparsity structure of the Hessian of the Lagrangian and the
+	map from each relation's Hessian into it. Sets sys->nnzH.
+	@return 0 on success
+*/
+static int ipopt_hessian_structure(IpoptSystem *sys){
+	struct ipopt_hess_entry *e, key, *found;
+	struct var_variable **vl;
+	struct rel_relation *rel;
+	unsigned long len, maxlen, total;
+	Index k, nrel, i, j, pos, ne, nnz;
+
+	ipopt_hessian_destroy(sys);
+	nrel = sys->m + 1;
+
+	maxlen = 0;
+	total = 0;
+	for(k = 0; k < nrel; ++k){
+		len = rel_n_incidences(LAGRANGIAN_REL(sys,k));
+		total += (len*(len+1))/2;
+		if(len > maxlen)maxlen = len;
+	}
+
+	sys->hstart = ASC_NEW_ARRAY(Index,nrel + 1);
+	sys->hmap = ASC_NEW_ARRAY(Index,total + 1);
+	e = ASC_NEW_ARRAY(struct ipopt_hess_entry,total + 1);
+	if(sys->hstart==NULL || sys->hmap==NULL || e==NULL){
+		if(e)ASC_FREE(e);
+		ipopt_hessian_destroy(sys);
+		ERROR_REPORTER_HERE(ASC_PROG_ERR,"Insufficient memory for Hessian structure");
+		return 1;
+	}
+
+	/* collect the filtered elements of each relation's lower triangle */
+	pos = 0;
+	ne = 0;
+	for(k = 0; k < nrel; ++k){
+		rel = LAGRANGIAN_REL(sys,k);
+		sys->hstart[k] = pos;
+		len = rel_n_incidences(rel);
+		vl = (struct var_variable **)rel_incidence_list(rel);
+		if(k > 0 && !rel_apply_filter(rel,&(sys->rfilt))){
+			for(i = 0; i < (Index)((len*(len+1))/2); ++i){
+				sys->hmap[pos++] = -1;
+			}
+			continue;
+		}
+		for(i = 0; i < (Index)len; ++i){
+			for(j = 0; j <= i; ++j){
+				if(var_apply_filter(vl[i],&(sys->vfilt))
+					&& var_apply_filter(vl[j],&(sys->vfilt))
+				){
+					e[ne].row = MAX(var_sindex(vl[i]),var_sindex(vl[j]));
+					e[ne].col = MIN(var_sindex(vl[i]),var_sindex(vl[j]));
+					asc_assert(e[ne].row < sys->n);
+					ne++;
+					sys->hmap[pos++] = 0;
+				}else{
+					sys->hmap[pos++] = -1;
+				}
+			}
+		}
+	}
+	sys->hstart[nrel] = pos;
+
+	/* merge elements which fall on the same (row,col) */
+	qsort(e,ne,sizeof(struct ipopt_hess_entry),&ipopt_hess_entry_cmp);
+	nnz = 0;
+	for(i = 0; i < ne; ++i){
+		if(nnz == 0 || ipopt_hess_entry_cmp(&e[nnz-1],&e[i])){
+			e[nnz++] = e[i];
+		}
+	}
+
+	sys->hrow = ASC_NEW_ARRAY(Index,nnz + 1);
+	sys->hcol = ASC_NEW_ARRAY(Index,nnz + 1);
+	for(i = 0; i < nnz; ++i){
+		sys->hrow[i] = e[i].row;
+		sys->hcol[i] = e[i].col;
+	}
+
+	/* point each retained element at its non-zero */
+	for(k = 0; k < nrel; ++k){
+		rel = LAGRANGIAN_REL(sys,k);
+		len = rel_n_incidences(rel);
+		vl = (struct var_variable **)rel_incidence_list(rel);
+		pos = sys->hstart[k];
+		for(i = 0; i < (Index)len; ++i){
+			for(j = 0; j <= i; ++j, ++pos){
+				if(sys->hmap[pos] < 0)continue;
+				key.row = MAX(var_sindex(vl[i]),var_sindex(vl[j]));
+				key.col = MIN(var_sindex(vl[i]),var_sindex(vl[j]));
+				found = bsearch(&key,e,nnz,sizeof(struct ipopt_hess_entry),&ipopt_hess_entry_cmp);
+				asc_assert(found!=NULL);
+				sys->hmap[pos] = (Index)(found - e);
+			}
+		}
+	}
+	ASC_FREE(e);
+
+	sys->hrel = ltmatrix_create(LTMATRIX_LOWER,maxlen > 0 ? maxlen : 1);
+	sys->nnzH = nnz;
+	CONSOLE_DEBUG("Hessian of the Lagrangian has %d non-zeros (%lu relation elements)",nnz,total);
+	return 0;
+}
+
 Bool ipopt_eval_h(Index n, Number* x, Bool new_x
 		, Number obj_factor, Index m, Number* lambda
 		, Bool new_lambda, Index nele_hess, Index* iRow
@@ -829,17 +984,12 @@ Bool ipopt_eval_h(Index n, Number* x, Bool new_x
 	IpoptSystem *sys;
 	sys = SYS(user_data);
 
-	int res,count;
-
-	struct var_variable **incidence_list;
-
-	ltmatrix *hess_matrix;
-
-	unsigned long i;
-
-	Index row;
-	Index col;
-	Index idx;
+	int res, safe;
+	struct rel_relation *rel;
+	const Index *map;
+	const double *h;
+	Number factor;
+	Index k, idx, nelem;
 
 	//CONSOLE_DEBUG("IN FUNCTION ipopt_eval_h");
 	//CONSOLE_DEBUG("nnzH = %d",sys->nnzH);
@@ -847,7 +997,9 @@ Bool ipopt_eval_h(Index n, Number* x, Bool new_x
 
 	asc_assert(sys!=NULL);
 	asc_assert(n==sys->n);
+	asc_assert(m==sys->m);
 	asc_assert(nele_hess==sys->nnzH);
+	asc_assert(sys->hmap!=NULL);
 
 	if(new_x){
 		res = ipopt_update_model(sys,x);
@@ -857,89 +1009,46 @@ Bool ipopt_eval_h(Index n, Number* x, Bool new_x
 	if(values == NULL){
 		asc_assert(iRow !=NULL && jCol != NULL);
 
-		CONSOLE_DEBUG("Determining sparsity structure of the hessian of the lagrangian");
-
-		/* identify the sparsity structure of the Hessian (note: only the lower-
-		left part is required by IPOPT , because the Hessian is symmetric) */
-		//CONSOLE_DEBUG("Analysing of Hessian matrix sparsity structure not implemented");
-		//CONSOLE_DEBUG("Dense Hessian Calculations being performed");
-
-		idx = 0;
-
-		for (row = 0; row < n; row++) {
-			for (col = 0; col <= row; col++) {
-				iRow[idx] = row;
-				jCol[idx] = col;
-				idx++;
-			}
+		/* only the lower-left part is required by IPOPT, because the Hessian
+		is symmetric. The structure was found in ipopt_hessian_structure. */
+		for(idx = 0; idx < nele_hess; ++idx){
+			iRow[idx] = sys->hrow[idx];
+			jCol[idx] = sys->hcol[idx];
 		}
-		asc_assert(idx == nele_hess);
-
-		CONSOLE_DEBUG("Done with sparsity calc, there are %d elements",idx);
 	}
 	else{
 		asc_assert(jCol==NULL && iRow==NULL);
 		asc_assert(lambda!=NULL);
 
-		/** Array of LT matrix */
-		hess_matrix = ltmatrix_create(LTMATRIX_LOWER,n);
-
-		//CONSOLE_DEBUG("Order of Hessian MATRIX [%d x %d]",n,n);
-
-		/** Correction for objective function **/
-		//CONSOLE_DEBUG("Correction for Objective Relation underway");
-		relman_hess(sys->obj,&(sys->vfilt),hess_matrix,&count,n,SLV_PARAM_BOOL(&(sys->p),ASCEND_PARAM_SAFEEVAL));
-
-		idx = 0;
-
-		for (row = 0; row < n; row++) {
-			for (col = 0; col <= row; col++) {
-				values[idx] = ltmatrix_get_element(hess_matrix,row,col) * (obj_factor);
-				idx++;
-			}
+		safe = SLV_PARAM_BOOL(&(sys->p),ASCEND_PARAM_SAFEEVAL);
+		for(idx = 0; idx < nele_hess; ++idx){
+			values[idx] = 0.0;
 		}
-		asc_assert(idx == nele_hess);
-
-
-		/** Correction for m-relations **/
-
 
-		for(i=0; i<m; i++){
-			/** @TODO Initialize the Hess Matrix Elements to zero */
-			ltmatrix_clear(hess_matrix);
-
-			incidence_list = (struct var_variable**) rel_incidence_list(sys->rlist[i]);
-			if(incidence_list!=NULL){
-				//CONSOLE_DEBUG("Correction for Constraint Relation [%lu] underway",i);
-				relman_hess(sys->rlist[i],&(sys->vfilt),hess_matrix,&count,n,SLV_PARAM_BOOL(&(sys->p),ASCEND_PARAM_SAFEEVAL));
-
-				idx=0;
+		h = sys->hrel->h;
+		for(k = 0; k <= m; ++k){
+			factor = (k==0) ? obj_factor : lambda[k-1];
+			map = sys->hmap + sys->hstart[k];
+			nelem = sys->hstart[k+1] - sys->hstart[k];
+			if(factor == 0.0 || nelem == 0)continue;
+
+			rel = LAGRANGIAN_REL(sys,k);
+			res = relman_hess_lower(rel,sys->hrel,safe);
+			if(res && !safe){
+				//CONSOLE_DEBUG("Hessian evaluation failed for relation %d",k);
+				return FALSE;
+			}
 
-				for (row = 0; row < n; row++) {
-					for (col = 0; col <= row; col++) {
-						values[idx] +=  ltmatrix_get_element(hess_matrix,row,col) * (lambda[i]);
-						idx++;
-					}
+			for(idx = 0; idx < nelem; ++idx){
+				if(map[idx] >= 0){
+					values[map[idx]] += factor * h[idx];
 				}
-				asc_assert(idx == nele_hess);
-
-			}
-			else{
-				ERROR_REPORTER_HERE(ASC_PROG_WARNING,"Unused Relation???");
-				ltmatrix_destroy(hess_matrix);
-				return FALSE; //I'm not sure about the action to take.
 			}
 		}
-
 		//CONSOLE_DEBUG("Hessian Matrix evaluation successful");
-
-		ltmatrix_destroy(hess_matrix);
-
-		/* evaluate the Hessian matrix */
-		//CONSOLE_DEBUG("Evaluation of Hessian matrix Completed");
 	}
 
-	return TRUE; /* fail: not yet implemented */
+	return TRUE;
 }
 
 /*------------------------------------------------------------------------------
@@ -1021,18 +1130,17 @@ static int ipopt_presolve(slv_system_t server, SlvClientToken asys){
 
 	//CONSOLE_DEBUG("got objective rel %p",sys->obj);
 
-	/* calculate nnz for hessian matrix @todo FIXME */
+	/* find the sparsity structure of the Hessian of the Lagrangian */
 
 	if(strcmp(SLV_PARAM_CHAR(&(sys->p),IPOPT_PARAM_HESS_APPROX),"exact")==0){
-		/** @todo fix rtot to be 'm' instead */
-		sys->nnzH = ((sys->n)*((sys->n)+1))/2; //dense Hessian count
+		if(ipopt_hessian_structure(sys)){
+			return -5;
+		}
 	}else{
-		//CONSOLE_DEBUG("Skipping relman_hessian_count as hessian method is not exact.");
-		//sys->nnzH = sys->n * sys->m;
+		//CONSOLE_DEBUG("Skipping Hessian structure as hessian method is not exact.");
+		ipopt_hessian_destroy(sys);
 	}
 
-	/* need to provide sparsity structure for hessian matrix? */
-
 #if 0
 	/** @SEE http://www.coin-or.org/Ipopt/documentation/node37.html */
 	ipopt_eval_h(number_of_variables, NULL/*x at which to evaluate*/, TRUE /* new x */
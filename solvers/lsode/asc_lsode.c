@@ -202,7 +202,16 @@ typedef struct IntegratorLsodeDataStruct{
 	struct var_variable **ydot_vars; /**< NULL-terminated list of derivative vars*/
 	struct rel_relation **rlist;     /**< NULL-terminated list of relevant rels
 	                                    to be differentiated */
-	DenseMatrix dydot_dy;               /**< change in derivatives wrt states */
+	DenseMatrix dydot_dy;               /**< change in derivatives wrt states;
+	                                    if banded, element (i,j) is stored at
+	                                    (i-j+mu,j), see LSODE_DYDOT_DY */
+
+	/* structure of dydot_dy, see integrator_lsode_structure */
+	int banded;                      /**< dydot_dy is a band matrix (miter 4 or 5) */
+	int ml, mu;                      /**< lower and upper bandwidth of dydot_dy */
+	int *jstart, *jrow;              /**< derivatives affected by each state, by column */
+	int ngroups;                     /**< number of groups of states */
+	int *gstart, *gstate;            /**< states in each group, see integrator_lsode_dydot_dy */
 
 	IntegratorLsodeLastCallType lastcall;  /* type of last call; func or grad */
 	IntegratorLsodeStatusCode   status;    /* solve status */
@@ -218,6 +227,10 @@ typedef struct IntegratorLsodeDataStruct{
 	@NOTE LSODE is not reentrant! @ENDNOTE
 */
 
+/** Element (I,J) of dydot_dy, which may be stored in band form */
+#define LSODE_DYDOT_DY(D,I,J) \
+	DENSEMATRIX_ELEM((D)->dydot_dy, (D)->banded ? (I)-(J)+(D)->mu : (I), (J))
+
 /** Macro to declare a local var and fetch the 'enginedata' stuff into it from l_lsode_blsys. */
 #define LSODEDATA_GET(N) \
 	IntegratorLsodeData *N; \
@@ -254,6 +267,7 @@ typedef void LsodeJacobianFn(int *, double *, double *, int *, int *, double *,
 */
 
 static int integrator_lsode_setup_diffs(IntegratorSystem *blsys);
+static void integrator_lsode_structure_free(IntegratorLsodeData *d);
 
 /**
 	void LSODE(&fex, &neq, y, &x, &xend, &itol, reltol, abtol, &itask,
@@ -296,6 +310,7 @@ static void integrator_lsode_create(IntegratorSystem *blsys){
 */
 static void integrator_lsode_free(void *enginedata){
 	IntegratorLsodeData d;
+	integrator_lsode_structure_free((IntegratorLsodeData *)enginedata);
 	d = *((IntegratorLsodeData *)enginedata);
 
 	if(d.input_indices)ASC_FREE(d.input_indices);
@@ -376,10 +391,13 @@ static int integrator_lsode_params_default(IntegratorSystem *blsys){
 			,"0=Functional iteration, 1=Modified Newton iteration with user-"
 			"supplied analytical Jacobian, 2=Modified Newton iteration with"
 			" internally-generated numerical Jacobian, 3=Modified Jacobi-Newton"
-			" iteration with internally generated numerical Jacobian. See "
+			" iteration with internally generated numerical Jacobian, 4=Modified"
+			" Newton iteration with user-supplied banded Jacobian, 5=Modified"
+			" Newton iteration with internally-generated banded Jacobian. For 4"
+			" and 5 the bandwidth is found from the structure of the system. See"
 			" 'Description and Use of LSODE', section 3.1. Note that not all"
 			" methods described there are available via ASCEND."
-		}, 1, 0, 3}
+		}, 1, 0, 5}
 	);
 
 	slv_param_int(p,LSODE_PARAM_MAXORD
@@ -647,6 +665,234 @@ static void lsode_free_mem(double *y, double *reltol, double *abtol, double *rwo
   }
 }
 
+/*------------------------------------------------------------------------------
+  STRUCTURE OF THE JACOBIAN
+*/
+
+static void integrator_lsode_structure_free(IntegratorLsodeData *d){
+	if(d->jstart)ASC_FREE(d->jstart);
+	if(d->jrow)ASC_FREE(d->jrow);
+	if(d->gstart)ASC_FREE(d->gstart);
+	if(d->gstate)ASC_FREE(d->gstate);
+	d->jstart = d->jrow = d->gstart = d->gstate = NULL;
+	d->ngroups = 0;
+}
+
+/**
+	Find which derivatives can be affected by each state, from the incidence
+	of the system and the output assignment of its last block partition.
+	A change in state y_j changes the residual of each relation in which it
+	appears, hence the variable assigned to that relation, hence the
+	relations in which that variable appears, and so on. This gives the
+	structure of dydot_dy without any numerical work, together with its
+	lower and upper bandwidth d->ml and d->mu.
+
+	The states are then divided into groups such that no two states in a
+	group affect the same derivative. The columns of dydot_dy for a whole
+	group are found with a single solve, see integrator_lsode_dydot_dy.
+	For a band matrix there are at most ml+mu+1 groups.
+
+	@return 0 on success, 1 if the system has no output assignment.
+*/
+static int integrator_lsode_structure(IntegratorSystem *blsys){
+	IntegratorLsodeData *d;
+	dof_t *dof;
+	struct var_variable **mvl;
+	struct rel_relation **rl;
+	int32 nmv, *outof, *stamp, *stack, *rstart, *rcol, *group, *forbid;
+	int n, i, j, k, p, q, g, sp, nr, nnz, cap;
+	double work;
+
+	d = (IntegratorLsodeData *)blsys->enginedata;
+	integrator_lsode_structure_free(d);
+
+	dof = slv_get_dofdata(blsys->system);
+	if(dof==NULL || dof->assign==NULL)return 1;
+	mvl = slv_get_master_var_list(blsys->system);
+	nmv = slv_get_num_master_vars(blsys->system);
+	n = (int)d->n_eqns;
+
+	outof = ASC_NEW_ARRAY(int32,nmv);
+	stamp = ASC_NEW_ARRAY(int32,nmv);
+	stack = ASC_NEW_ARRAY(int32,nmv);
+	for(k = 0; k < nmv; ++k){
+		outof[k] = -1;
+		stamp[k] = -1;
+	}
+	for(i = 0; i < n; ++i){
+		outof[var_mindex(d->ydot_vars[i])] = i;
+	}
+
+	/* derivatives reachable from each state */
+	cap = 4*n;
+	d->jstart = ASC_NEW_ARRAY(int,n+1);
+	d->jrow = ASC_NEW_ARRAY(int,cap);
+	d->ml = d->mu = 0;
+	nnz = 0;
+	for(j = 0; j < n; ++j){
+		d->jstart[j] = nnz;
+		sp = 0;
+		stack[sp++] = var_mindex(d->y_vars[j]);
+		stamp[stack[0]] = j;
+		while(sp > 0){
+			k = stack[--sp];
+			rl = var_incidence_list_to_modify(mvl[k]);
+			nr = var_n_incidences(mvl[k]);
+			for(p = 0; p < nr; ++p){
+				q = rel_mindex(rl[p]);
+				if(q >= dof->n_assign || dof->assign[q] < 0)continue;
+				q = dof->assign[q];
+				if(stamp[q] == j)continue;
+				stamp[q] = j;
+				stack[sp++] = q;
+				i = outof[q];
+				if(i < 0)continue;
+				if(nnz == cap){
+					cap *= 2;
+					d->jrow = (int *)ASC_REALLOC(d->jrow,cap*sizeof(int));
+				}
+				d->jrow[nnz++] = i;
+				if(i - j > d->ml)d->ml = i - j;
+				if(j - i > d->mu)d->mu = j - i;
+			}
+		}
+	}
+	d->jstart[n] = nnz;
+	ASC_FREE(outof);
+	ASC_FREE(stamp);
+	ASC_FREE(stack);
+
+	/* the same structure by rows */
+	rstart = ASC_NEW_ARRAY_CLEAR(int32,n+1);
+	rcol = ASC_NEW_ARRAY(int32,nnz+1);
+	for(p = 0; p < nnz; ++p){
+		rstart[d->jrow[p]+1]++;
+	}
+	work = 0;
+	for(i = 0; i < n; ++i){
+		work += (double)rstart[i+1]*rstart[i+1];
+		rstart[i+1] += rstart[i];
+	}
+	for(j = 0; j < n; ++j){
+		for(p = d->jstart[j]; p < d->jstart[j+1]; ++p){
+			rcol[rstart[d->jrow[p]]++] = j;
+		}
+	}
+	for(i = n; i > 0; --i){
+		rstart[i] = rstart[i-1];
+	}
+	rstart[0] = 0;
+
+	/* assign groups greedily, in order of states, unless that would cost
+	more than the solves it saves, in which case group by the band */
+	group = ASC_NEW_ARRAY(int32,n);
+	forbid = ASC_NEW_ARRAY(int32,n);
+	d->ngroups = 0;
+	if(work <= (double)n*n){
+		for(g = 0; g < n; ++g){
+			forbid[g] = -1;
+		}
+		for(j = 0; j < n; ++j){
+			for(p = d->jstart[j]; p < d->jstart[j+1]; ++p){
+				i = d->jrow[p];
+				for(q = rstart[i]; q < rstart[i+1] && rcol[q] < j; ++q){
+					forbid[group[rcol[q]]] = j;
+				}
+			}
+			for(g = 0; g < d->ngroups && forbid[g] == j; ++g);
+			group[j] = g;
+			if(g == d->ngroups)d->ngroups++;
+		}
+	}else{
+		d->ngroups = MIN(d->ml + d->mu + 1, n);
+		for(j = 0; j < n; ++j){
+			group[j] = j % d->ngroups;
+		}
+	}
+	ASC_FREE(rstart);
+	ASC_FREE(rcol);
+
+	/* list the states in each group */
+	d->gstart = ASC_NEW_ARRAY_CLEAR(int,d->ngroups+1);
+	d->gstate = ASC_NEW_ARRAY(int,n);
+	for(j = 0; j < n; ++j){
+		d->gstart[group[j]+1]++;
+	}
+	for(g = 0; g < d->ngroups; ++g){
+		d->gstart[g+1] += d->gstart[g];
+	}
+	for(g = 0; g < d->ngroups; ++g){
+		forbid[g] = d->gstart[g];
+	}
+	for(j = 0; j < n; ++j){
+		d->gstate[forbid[group[j]]++] = j;
+	}
+	ASC_FREE(group);
+	ASC_FREE(forbid);
+
+	CONSOLE_DEBUG("dydot_dy has %d non-zeros, ml = %d, mu = %d, %d groups of states"
+		,nnz,d->ml,d->mu,d->ngroups
+	);
+	return 0;
+}
+
+/**
+	Fill dydot_dy from the factored Jacobian of the system, with one solve
+	per group of states: the right-hand side is the sum of the columns of
+	the Jacobian for the states in the group, and since no two of those
+	states affect the same derivative, each derivative in the solution
+	belongs to exactly one of them.
+
+	@param rhs is the right-hand side already added to the linear system,
+	zero on entry and on exit.
+	@return 0 on success
+*/
+static int integrator_lsode_dydot_dy(slv_system_t sys, real64 *rhs
+		, IntegratorLsodeData *d
+){
+	linsolqr_system_t lqr_sys;
+	mtx_matrix_t mtx;
+	mtx_coord_t nz;
+	real64 value, *solution;
+	int g, k, j, p;
+
+	lqr_sys = slv_get_linsolqr_sys(sys);
+	mtx = slv_get_sys_mtx(sys);
+	solution = ASC_NEW_ARRAY_CLEAR(real64,mtx_capacity(mtx));
+	if(solution==NULL)return 1;
+
+	for(g = 0; g < d->ngroups; ++g){
+		for(k = d->gstart[g]; k < d->gstart[g+1]; ++k){
+			j = d->gstate[k];
+			nz.col = mtx_org_to_col(mtx,d->input_indices[j]);
+			nz.row = mtx_FIRST;
+			while(value = mtx_next_in_col(mtx,&nz,mtx_ALL_ROWS),
+				nz.row != mtx_LAST
+			){
+				rhs[mtx_row_to_org(mtx,nz.row)] += value;
+			}
+		}
+
+		linsolqr_rhs_was_changed(lqr_sys,rhs);
+		linsolqr_solve(lqr_sys,rhs);
+		linsolqr_copy_solution(lqr_sys,rhs,solution);
+
+		for(k = d->gstart[g]; k < d->gstart[g+1]; ++k){
+			j = d->gstate[k];
+			for(p = d->jstart[j]; p < d->jstart[j+1]; ++p){
+				LSODE_DYDOT_DY(d,d->jrow[p],j)
+					= -1.0*solution[d->output_indices[d->jrow[p]]];
+			}
+			mtx_zr_org_vec_using_col(mtx,mtx_org_to_col(mtx,d->input_indices[j])
+				,rhs,mtx_ALL_ROWS
+			);
+		}
+	}
+
+	ascfree(solution);
+	return 0;
+}
+
 /**
 	"Temporary" derivative evaluation routine (pre 1995!).
 
@@ -711,9 +957,13 @@ static int integrator_lsode_derivatives(IntegratorSystem *blsys
     FPRINTF(stderr,"Early termination due to failure in LUFactorJacobian\n");
     goto error;
   }
-  result = Compute_dy_dx_smart(blsys->system, scratch_vector, enginedata->dydot_dy,
-                               inputs_ndx_list, ninputs,
-                               outputs_ndx_list, noutputs);
+  if(enginedata->jstart){
+    result = integrator_lsode_dydot_dy(blsys->system, scratch_vector, enginedata);
+  }else{
+    result = Compute_dy_dx_smart(blsys->system, scratch_vector, enginedata->dydot_dy,
+                                 inputs_ndx_list, ninputs,
+                                 outputs_ndx_list, noutputs);
+  }
 
   linsolqr_remove_rhs(linsys,scratch_vector);
   if (result) {
@@ -852,8 +1102,6 @@ static void LSODE_JEX(int *neq ,double *t, double *y
 
   UNUSED_PARAMETER(t);
   UNUSED_PARAMETER(y);
-  UNUSED_PARAMETER(ml);
-  UNUSED_PARAMETER(mu);
 
   /* CONSOLE_DEBUG("Calling for a gradient evaluation"); */
 #ifdef TIMING_DEBUG
@@ -868,7 +1116,7 @@ static void LSODE_JEX(int *neq ,double *t, double *y
 
   nok = integrator_lsode_derivatives(l_lsode_blsys
 		, *neq
-		, *nrpd
+		, *neq
   );
 
   if(nok){
@@ -899,11 +1147,23 @@ static void LSODE_JEX(int *neq ,double *t, double *y
 	We will send in a column major ordering vector for pd.
   */
   asc_assert(*neq == DENSEMATRIX_NCOLS(lsodedata->dydot_dy));
-  asc_assert(*nrpd == DENSEMATRIX_NROWS(lsodedata->dydot_dy));
-  for (j=0;j<*neq;j++) { /* loop through columnns */
-    for (i=0;i<*nrpd;i++){ /* loop through rows */
+  if(lsodedata->banded){
+    /* df(i)/dy(j) goes in pd(i-j+mu+1,j), as stored in dydot_dy */
+    asc_assert(*ml == lsodedata->ml && *mu == lsodedata->mu);
+    asc_assert(*ml + *mu + 1 == DENSEMATRIX_NROWS(lsodedata->dydot_dy));
+    for (j=0;j<*neq;j++) {
+      for (i=0;i<=*ml+*mu;i++){
+        pd[i] = DENSEMATRIX_ELEM(lsodedata->dydot_dy,i,j);
+      }
+      pd += *nrpd;
+    }
+  }else{
+    asc_assert(*nrpd == DENSEMATRIX_NROWS(lsodedata->dydot_dy));
+    for (j=0;j<*neq;j++) { /* loop through columnns */
+      for (i=0;i<*nrpd;i++){ /* loop through rows */
 			/* CONSOLE_DEBUG("JAC[r=%d,c=%d]=%f",i,j,lsodedata.dydot_dy[i][j]); */
-      *pd++ = DENSEMATRIX_ELEM(lsodedata->dydot_dy,i,j);
+        *pd++ = DENSEMATRIX_ELEM(lsodedata->dydot_dy,i,j);
+      }
     }
   }
 
@@ -952,7 +1212,6 @@ static int integrator_lsode_solve(IntegratorSystem *blsys
 
 	d->input_indices = ASC_NEW_ARRAY_CLEAR(int, d->n_eqns);
 	d->output_indices = ASC_NEW_ARRAY_CLEAR(int, d->n_eqns);
-	d->dydot_dy = densematrix_create(d->n_eqns,d->n_eqns);
 
 	d->y_vars = ASC_NEW_ARRAY(struct var_variable *,d->n_eqns+1);
 	d->ydot_vars = ASC_NEW_ARRAY(struct var_variable *, d->n_eqns+1);
@@ -986,7 +1245,7 @@ static int integrator_lsode_solve(IntegratorSystem *blsys
 	method = SLV_PARAM_CHAR(&(blsys->params),LSODE_PARAM_METH);
 	miter = SLV_PARAM_INT(&(blsys->params),LSODE_PARAM_MITER);
 	maxord = SLV_PARAM_INT(&(blsys->params),LSODE_PARAM_MAXORD);
-	if(miter < 0 || miter > 3){
+	if(miter < 0 || miter > 5){
 		ERROR_REPORTER_HERE(ASC_USER_ERROR,"Unacceptable value '%d' of parameter 'miter'",miter);
 		return 5;
 	}
@@ -1011,6 +1270,27 @@ static int integrator_lsode_solve(IntegratorSystem *blsys
 
 	CONSOLE_DEBUG("MF = %d",mf);
 
+	/* find the structure of dydot_dy if we are to supply it, or if LSODE
+	needs its bandwidth */
+	d->banded = (miter == 4 || miter == 5);
+	if(miter == 1 || d->banded){
+		slv_presolve(blsys->system);
+		if(integrator_lsode_structure(blsys)){
+			ERROR_REPORTER_HERE(ASC_PROG_WARNING,"Unable to find the structure"
+				" of the Jacobian: a full Jacobian will be used.");
+			if(d->banded){
+				mf -= 3; /* the full-matrix equivalent of miter 4 or 5 */
+				d->banded = 0;
+			}
+		}
+	}
+	densematrix_destroy(d->dydot_dy);
+	if(d->banded){
+		d->dydot_dy = densematrix_create(d->ml + d->mu + 1,d->n_eqns);
+	}else{
+		d->dydot_dy = densematrix_create(d->n_eqns,d->n_eqns);
+	}
+
   nsamples = integrator_getnsamples(blsys);
   if (nsamples <2) {
   	ERROR_REPORTER_HERE(ASC_USER_ERROR,"Integration will not be performed. The system has no end sample time defined.");
@@ -1037,6 +1317,9 @@ static int integrator_lsode_solve(IntegratorSystem *blsys
 		case 13: case 23:
 			lrw = 22 + neq * (maxord + 1) + 4 * neq;
 			break;
+		case 14: case 15: case 24: case 25:
+			lrw = 22 + neq * (maxord + 1) + 3 * neq + (2 * d->ml + d->mu + 1) * neq;
+			break;
 		default:
 			ERROR_REPORTER_HERE(ASC_USER_ERROR,"Unknown size requirements for this value of 'mf'");
 			return 4;
@@ -1070,6 +1353,11 @@ static int integrator_lsode_solve(IntegratorSystem *blsys
   iwork[5] = integrator_get_maxsubsteps(blsys);
 	iwork[4] = maxord;
 	CONSOLE_DEBUG("MAXORD = %d",maxord);
+	if(d->banded){
+		iwork[0] = d->ml;
+		iwork[1] = d->mu;
+		CONSOLE_DEBUG("ML = %d, MU = %d",d->ml,d->mu);
+	}
 
   if(x[0] > integrator_getsample(blsys, 2)){
     ERROR_REPORTER_HERE(ASC_USER_ERROR,"Invalid initialisation time: exceeds second timestep value");
@@ -27,6 +27,10 @@
 
 #include <math.h>
 #include <stdarg.h>
+#include <string.h>
+#ifdef _OPENMP
+# include <omp.h>
+#endif
 
 #define ASC_BUILDING_INTERFACE
 
@@ -44,11 +48,16 @@
 #include <ascend/general/panic.h>
 #include <ascend/general/list.h>
 
+#include <ascend/compiler/safe.h>
+#include <ascend/compiler/relation_util.h>
+
 #include <ascend/linear/mtx_vector.h>
 
 #include <ascend/system/calc.h>
 #include <ascend/system/slv_stdcalls.h>
 #include <ascend/system/relman.h>
+#include <ascend/system/relprog.h>
+#include <ascend/system/relblock.h>
 #include <ascend/system/block.h>
 #include <ascend/solver/solver.h>
 
@@ -61,9 +70,36 @@
 /* #define PIVOT_DEBUG */
 /* #define LISTS_DEBUG *//* show lists of vars and rels before solving */
 
+#define PARALLEL_MIN_ROWS 64
+/**< Blocks with fewer rows than this are always assembled serially. */
+
+#define BLOCK_TASK_MAX_ROWS 50
+/**< Blocks with more rows than this are never given to block workers. */
+
+/* states of blocks in concurrent solving */
+#define BLOCK_UNTRIED 0
+#define BLOCK_CONVERGED 1   /* by a worker */
+#define BLOCK_NEW 2         /* converged by a worker in the current pass */
+#define BLOCK_FAILED 3      /* left to the serial iteration */
+
+#if defined(_OPENMP) && _OPENMP >= 200805
+# define BLOCK_TASKS 1 /* OpenMP 3.0 tasks are available */
+#else
+# define BLOCK_TASKS 0
+#endif
+
+#ifdef _OPENMP
+# define THREAD_NUM omp_get_thread_num()
+#else
+# define THREAD_NUM 0
+#endif
+
 #define QRSLV(s) ((qrslv_system_t)(s))
 #define SERVER (sys->slv)
 
+/* the compiled program of a relation, if any */
+#define RELPROG(sys,rel) ((sys)->progs ? (sys)->progs[rel_mindex(rel)] : NULL)
+
 #define SOLVER_QRSLV_EXT 33
 
 enum QRSLV_PARAMS{
@@ -111,6 +147,11 @@ enum QRSLV_PARAMS{
 	,ITSCALETOL
 	,FACTOR_OPTION
 	,MAX_MINOR
+	,COMPILED_EVAL
+	,ASSEMBLY_THREADS
+	,FROZEN_PATTERN
+	,PIVOT_REUSE
+	,BLOCK_THREADS
 	,qrslv_PA_SIZE
 };
 
@@ -179,6 +220,7 @@ struct jacobian_data {
   boolean                accurate;       /* ? Recalculate matrix */
   boolean                singular;       /* ? Can matrix be inverted */
   boolean                old_partition;  /* old value of partition flag */
+  boolean                frozen;         /* ? mtx frozen for this block */
 };
 
 struct hessian_data {
@@ -197,6 +239,43 @@ struct reduced_data {
   boolean          accurate;     /* Ready to re-compute ? */
 };
 
+/**
+	Scratch space of one worker solving independent blocks, sized for the
+	largest block that may be given to a worker.
+*/
+struct block_worker {
+  struct RelationEvalContext *ctx;     /* evaluation context */
+  real64                 *work;        /* scratch for relation programs */
+  real64                 *grad;        /* one gradient, in incidence order */
+  real64                 *a;           /* dense scaled block Jacobian */
+  real64                 *r;           /* block residuals */
+  real64                 *dx;          /* Newton step */
+  real64                 *x0;          /* values before the step */
+  real64                 *xstart;      /* values on entry to the block */
+};
+
+/**
+	Dependency graph of the diagonal blocks, for solving independent
+	blocks concurrently. Block k depends on an earlier block j if one of
+	the relations in k is incident on a variable assigned in j.
+*/
+struct block_sched {
+  int32                  nthreads;     /* number of workers */
+  int32                  nblocks;
+  int32                  *sstart;      /* successors of block k are */
+  int32                  *succ;        /*   succ[sstart[k]..sstart[k+1]-1] */
+  int32                  *pending;     /* unconverged predecessors */
+  int32                  *ready;       /* blocks to start a pass with */
+  int32                  *iters;       /* iterations taken by the workers */
+  char                   *eligible;    /* ? block may be given to a worker */
+  char                   *state;       /* BLOCK_ state of each block */
+  struct block_worker    *w;           /* one per worker */
+  /* settings for the pass, copied from the parameters */
+  int                    safe, convopt, bounds;
+  int32                  maxit, maxminor;
+  real64                 tol, singtol;
+};
+
 struct qrslv_system_structure {
 
   /* Problem definition */
@@ -252,6 +331,26 @@ struct qrslv_system_structure {
   real64                 phi;          /* Unconstrained minimizer */
   real64                 maxstep;      /* Maximum step size allowed */
   real64                 progress;     /* Steepest directional derivative */
+
+  /* Compiled relation programs */
+  struct RelProg         **progs;      /* by rel_mindex, NULL if none */
+  int32                  mtot;         /* number of master rels */
+  real64                 *progwork;    /* scratch for relman_*_prog */
+  struct RelBlock        *fused;       /* batched bintokens of this block */
+  real64                 *fresid;      /* by rlist index: batched residuals */
+  int32                  *fdone;       /* by rlist index: batch result ok */
+
+  /* Multi-threaded residual and Jacobian assembly */
+  int32                  nthreads;     /* number of workers, 0 if none */
+  struct RelationEvalContext **ctxs;   /* one per worker */
+  real64                 **twork;      /* scratch, one per worker */
+  int32                  *jstart;      /* by rel_mindex: offset in jstage */
+  real64                 *jstage;      /* gradients staged by the workers */
+  int32                  *jslot;       /* frozen J slot of each jstage entry */
+  int32                  *rstatus;     /* by rlist index: eval status */
+
+  /* Concurrent solution of independent blocks */
+  struct block_sched     *bsched;      /* NULL if blocks are solved in turn */
 };
 
 typedef struct qrslv_system_structure *qrslv_system_t;
@@ -517,6 +616,78 @@ static boolean calc_inequalities( qrslv_system_t sys){
   return (calc_ok && satisfied);
 }
 
+/**
+	Multi-threaded body of calc_residuals: rows are shared among the
+	workers, then any errors are reported serially in row order. External
+	(blackbox) relations share their cache, so they are left for the serial
+	pass.
+
+	@return FALSE if any residual could not be calculated
+*/
+static boolean calc_residuals_threaded( qrslv_system_t sys){
+  int32 row, low, high;
+  int safe, convopt;
+  real64 tol;
+  boolean calc_ok = TRUE;
+
+  low = sys->residuals.rng->low;
+  high = sys->residuals.rng->high;
+  safe = SLV_PARAM_BOOL(&(sys->p),SAFE_CALC);
+  tol = SLV_PARAM_REAL(&(sys->p),FEAS_TOL);
+  if(strcmp(SLV_PARAM_CHAR(&(sys->p),CONVOPT),"ABSOLUTE") == 0) {
+    convopt = 1;
+  }else if(strcmp(SLV_PARAM_CHAR(&(sys->p),CONVOPT),"RELNOM_SCALE") == 0) {
+    convopt = 2;
+  }else{
+    convopt = 0;
+  }
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(sys->nthreads) schedule(dynamic,16)
+#endif
+  for( row = low; row <= high; row++ ) {
+    int32 org, t;
+    struct rel_relation *rel;
+    t = THREAD_NUM;
+    org = mtx_row_to_org(sys->J.mtx,row);
+    rel = sys->rlist[org];
+    if(rel_extnodeinfo(rel) != NULL) continue;
+    sys->residuals.vec[row] = relman_eval_ctx(rel,RELPROG(sys,rel)
+      ,sys->ctxs[t],&(sys->rstatus[org]),safe,sys->twork[t]
+    );
+    if(convopt == 1) {
+      relman_calc_satisfied(rel,tol);
+    }else if(convopt == 2) {
+      relman_calc_satisfied_scaled(rel,tol);
+    }
+  }
+
+  for( row = low; row <= high; row++ ) {
+    int32 org = mtx_row_to_org(sys->J.mtx,row);
+    struct rel_relation *rel = sys->rlist[org];
+    if(rel_extnodeinfo(rel) != NULL) {
+      sys->residuals.vec[row] = relman_eval_ctx(rel,NULL
+        ,sys->ctxs[0],&(sys->rstatus[org]),safe,sys->twork[0]
+      );
+      if(convopt == 1) {
+        relman_calc_satisfied(rel,tol);
+      }else if(convopt == 2) {
+        relman_calc_satisfied_scaled(rel,tol);
+      }
+    }
+    if(sys->rstatus[org]){
+      if(safe){
+        safe_error_to_stderr((enum safe_err *)&(sys->rstatus[org]));
+      }
+      calc_ok = FALSE;
+#if DEBUG
+      CONSOLE_DEBUG("error calculating residual for row %d",row);
+#endif
+    }
+  }
+  return calc_ok;
+}
+
 /**
 	Calculates all of the residuals in the current block and computes
 	the residual norm for block status.
@@ -538,8 +709,18 @@ static boolean calc_residuals( qrslv_system_t sys){
   Asc_SignalHandlerPush(SIGFPE,SIG_IGN);
 #endif
 
+  if(sys->nthreads > 1
+      && sys->residuals.rng->high - row + 1 >= PARALLEL_MIN_ROWS
+  ){
+    calc_ok = calc_residuals_threaded(sys);
+    row = sys->residuals.rng->high + 1; /* skip the serial loop */
+  }else if(sys->fused != NULL) {
+    relblock_eval(sys->fused,sys->fresid,sys->fdone);
+  }
+
   for( ; row <= sys->residuals.rng->high; row++ ) {
-    rel = sys->rlist[mtx_row_to_org(sys->J.mtx,row)];
+    int32 org = mtx_row_to_org(sys->J.mtx,row);
+    rel = sys->rlist[org];
 #if DEBUG
     if(!rel) {
       int r;
@@ -550,7 +731,14 @@ static boolean calc_residuals( qrslv_system_t sys){
       );
     }
 #endif
-    sys->residuals.vec[row] = relman_eval(rel,&calc_ok_1,SLV_PARAM_BOOL(&(sys->p),SAFE_CALC));
+    if(sys->fused != NULL && sys->fdone[org]) {
+      sys->residuals.vec[row] = sys->fresid[org];
+      calc_ok_1 = 1;
+    }else{
+      sys->residuals.vec[row] = relman_eval_prog(rel,RELPROG(sys,rel)
+        ,&calc_ok_1,SLV_PARAM_BOOL(&(sys->p),SAFE_CALC),sys->progwork
+      );
+    }
     if(!calc_ok_1){
         calc_ok = FALSE;
 #if DEBUG
@@ -579,6 +767,182 @@ static boolean calc_residuals( qrslv_system_t sys){
 }
 
 
+/**
+	Multi-threaded body of calc_J: the workers write each relation's
+	gradient into its own slice of sys->jstage, then the slices are copied
+	into the (already cleared) Jacobian in row order, so the matrix is
+	filled identically whatever the number of threads. External relations
+	are differentiated in the serial pass, as in calc_residuals_threaded.
+*/
+static void calc_J_threaded( qrslv_system_t sys, const var_filter_t *vfilter){
+  int32 row, low, high;
+  int safe;
+
+  low = sys->J.reg.row.low;
+  high = sys->J.reg.row.high;
+  safe = SLV_PARAM_BOOL(&(sys->p),SAFE_CALC);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(sys->nthreads) schedule(dynamic,16)
+#endif
+  for( row = low; row <= high; row++ ) {
+    int32 org, t;
+    real64 resid;
+    struct rel_relation *rel;
+    t = THREAD_NUM;
+    org = mtx_row_to_org(sys->J.mtx,row);
+    rel = sys->rlist[org];
+    if(rel_extnodeinfo(rel) != NULL) continue;
+    sys->rstatus[org] = relman_grad_ctx(rel,RELPROG(sys,rel),sys->ctxs[t]
+      ,&resid,sys->jstage + sys->jstart[rel_mindex(rel)],safe,sys->twork[t]
+    );
+  }
+
+  for( row = low; row <= high; row++ ) {
+    int32 org = mtx_row_to_org(sys->J.mtx,row);
+    struct rel_relation *rel = sys->rlist[org];
+    real64 resid;
+    if(rel_extnodeinfo(rel) != NULL) {
+      sys->rstatus[org] = relman_grad_ctx(rel,NULL,sys->ctxs[0]
+        ,&resid,sys->jstage + sys->jstart[rel_mindex(rel)],safe,sys->twork[0]
+      );
+    }
+    if(safe){
+      safe_error_to_stderr((enum safe_err *)&(sys->rstatus[org]));
+    }else if(sys->rstatus[org]){
+      continue; /* as relman_diffs: unsafe failures are not mapped */
+    }
+    relman_map_grad(rel,vfilter,sys->J.mtx
+      ,sys->jstage + sys->jstart[rel_mindex(rel)]
+    );
+  }
+}
+
+/**
+	Freeze the pattern of the freshly filled current block of the Jacobian
+	and record, for every incidence of every relation in the block, the
+	slot its derivative goes to (or mtx_NONE if it is filtered out). Gives
+	up, leaving the matrix unfrozen, unless the incidences account for
+	every slot exactly.
+*/
+static void freeze_J( qrslv_system_t sys, const var_filter_t *vfilter){
+  int32 row, org, c, len, slot, nslots = 0;
+  const struct var_variable **vlist;
+  struct rel_relation *rel;
+
+  sys->J.frozen = FALSE;
+  if(mtx_freeze(sys->J.mtx,&(sys->J.reg))) return;
+  for( row = sys->J.reg.row.low; row <= sys->J.reg.row.high; row++ ) {
+    org = mtx_row_to_org(sys->J.mtx,row);
+    rel = sys->rlist[org];
+    len = rel_n_incidences(rel);
+    vlist = rel_incidence_list(rel);
+    for( c = 0; c < len; c++ ) {
+      slot = mtx_NONE;
+      if(var_apply_filter(vlist[c],vfilter)) {
+        slot = mtx_frozen_slot(sys->J.mtx,org,var_sindex(vlist[c]));
+        if(slot == mtx_NONE) {
+          mtx_thaw(sys->J.mtx);
+          return;
+        }
+        nslots++;
+      }
+      sys->jslot[sys->jstart[rel_mindex(rel)] + c] = slot;
+    }
+  }
+  if(nslots != mtx_frozen_nonzeros(sys->J.mtx)) {
+    mtx_thaw(sys->J.mtx);
+    return;
+  }
+  sys->J.frozen = TRUE;
+}
+
+/**
+	Refill the current block of a frozen Jacobian in place, using the
+	workers if there are several and the block is big enough. External
+	relations are left for the serial pass, as in calc_J_threaded, and so
+	are relations with binary tokens, which are differentiated there as
+	relman_diffs would.
+
+	@return FALSE if a gradient failed in unsafe mode, in which case the
+	row must be left out and the caller should rebuild the matrix instead.
+*/
+static boolean calc_J_frozen( qrslv_system_t sys){
+  int32 row, low, high;
+  int safe;
+  real64 *val;
+  boolean ok = TRUE;
+
+  low = sys->J.reg.row.low;
+  high = sys->J.reg.row.high;
+  safe = SLV_PARAM_BOOL(&(sys->p),SAFE_CALC);
+  val = mtx_frozen_values(sys->J.mtx);
+  if(sys->fused != NULL) {
+    relblock_resid_grad(sys->fused,sys->fresid,sys->fdone
+      ,sys->jstage,sys->jstart
+    );
+  }
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(sys->nthreads) schedule(dynamic,16) \
+  if(sys->nthreads > 1 && high - low + 1 >= PARALLEL_MIN_ROWS)
+#endif
+  for( row = low; row <= high; row++ ) {
+    int32 org, t, c, len, *slot;
+    real64 resid, *grad;
+    struct rel_relation *rel;
+    t = THREAD_NUM;
+    org = mtx_row_to_org(sys->J.mtx,row);
+    rel = sys->rlist[org];
+    grad = sys->jstage + sys->jstart[rel_mindex(rel)];
+    slot = sys->jslot + sys->jstart[rel_mindex(rel)];
+    if(sys->fused != NULL && sys->fdone[org]) {
+      sys->rstatus[org] = 0;
+    }else if(rel_extnodeinfo(rel) != NULL || relman_has_binary(rel)) {
+      continue;
+    }else{
+      sys->rstatus[org] = relman_grad_ctx(rel,RELPROG(sys,rel),sys->ctxs[t]
+        ,&resid,grad,safe,sys->twork[t]
+      );
+    }
+    len = rel_n_incidences(rel);
+    for( c = 0; c < len; c++ ) {
+      if(slot[c] != mtx_NONE) val[slot[c]] = grad[c];
+    }
+  }
+
+  for( row = low; row <= high; row++ ) {
+    int32 org, c, len, *slot;
+    real64 resid, *grad;
+    struct rel_relation *rel;
+    org = mtx_row_to_org(sys->J.mtx,row);
+    rel = sys->rlist[org];
+    if(!(sys->fused != NULL && sys->fdone[org])
+        && (rel_extnodeinfo(rel) != NULL || relman_has_binary(rel))
+    ){
+      grad = sys->jstage + sys->jstart[rel_mindex(rel)];
+      slot = sys->jslot + sys->jstart[rel_mindex(rel)];
+      sys->rstatus[org] = 0;
+      if(relman_grad_binary(rel,&resid,grad)) {
+        sys->rstatus[org] = relman_grad_ctx(rel,NULL,sys->ctxs[0]
+          ,&resid,grad,safe,sys->twork[0]
+        );
+      }
+      len = rel_n_incidences(rel);
+      for( c = 0; c < len; c++ ) {
+        if(slot[c] != mtx_NONE) val[slot[c]] = grad[c];
+      }
+    }
+    if(safe){
+      safe_error_to_stderr((enum safe_err *)&(sys->rstatus[org]));
+    }else if(sys->rstatus[org]){
+      ok = FALSE;
+    }
+  }
+  if(ok) mtx_frozen_commit(sys->J.mtx);
+  return ok;
+}
+
 /**
 	Calculates the current block of the jacobian.
 	It is initially unscaled.
@@ -595,11 +959,40 @@ static boolean calc_J( qrslv_system_t sys){
   vfilter.matchbits = (VAR_INBLOCK | VAR_ACTIVE);
   vfilter.matchvalue = (VAR_INBLOCK | VAR_ACTIVE);
   time0=tm_cpu_time();
-  mtx_clear_region(sys->J.mtx,&(sys->J.reg));
-  for( row = sys->J.reg.row.low; row <= sys->J.reg.row.high; row++ ) {
-    struct rel_relation *rel;
-    rel = sys->rlist[mtx_row_to_org(sys->J.mtx,row)];
-    relman_diffs(rel,&vfilter,sys->J.mtx,&resid,SLV_PARAM_BOOL(&(sys->p),SAFE_CALC));
+  if(!(sys->J.frozen && mtx_is_frozen(sys->J.mtx) && calc_J_frozen(sys))) {
+    mtx_clear_region(sys->J.mtx,&(sys->J.reg));
+    row = sys->J.reg.row.low;
+    if(sys->nthreads > 1
+        && sys->J.reg.row.high - row + 1 >= PARALLEL_MIN_ROWS
+    ){
+      calc_J_threaded(sys,&vfilter);
+      row = sys->J.reg.row.high + 1; /* skip the serial loop */
+    }else if(sys->fused != NULL) {
+      relblock_resid_grad(sys->fused,sys->fresid,sys->fdone
+        ,sys->jstage,sys->jstart
+      );
+    }
+    for( ; row <= sys->J.reg.row.high; row++ ) {
+      struct rel_relation *rel;
+      int32 org;
+      org = mtx_row_to_org(sys->J.mtx,row);
+      rel = sys->rlist[org];
+      if(sys->fused != NULL && sys->fdone[org]) {
+        relman_map_grad(rel,&vfilter,sys->J.mtx
+          ,sys->jstage + sys->jstart[rel_mindex(rel)]
+        );
+        continue;
+      }
+      relman_diffs_prog(rel,RELPROG(sys,rel)
+        ,&vfilter,sys->J.mtx,&resid,SLV_PARAM_BOOL(&(sys->p),SAFE_CALC)
+        ,sys->progwork
+      );
+    }
+    if(SLV_PARAM_BOOL(&(sys->p),FROZEN_PATTERN) && sys->jslot != NULL) {
+      freeze_J(sys,&vfilter);
+    }else{
+      sys->J.frozen = FALSE;
+    }
   }
   sys->s.block.jactime += (tm_cpu_time() - time0);
   sys->s.block.jacs++;
@@ -2432,6 +2825,47 @@ static boolean block_feasible( qrslv_system_t sys){
    return TRUE;
 }
 
+/**
+	Free the batched evaluation plan of the current block, if any.
+*/
+static void destroy_fused( qrslv_system_t sys){
+  relblock_destroy(sys->fused);
+  destroy_array(sys->fresid);
+  destroy_array(sys->fdone);
+  sys->fused = NULL;
+  sys->fresid = NULL;
+  sys->fdone = NULL;
+}
+
+/**
+	Group the relations of the current block that have compiled batch
+	functions (see relblock.h), so that calc_residuals and calc_J evaluate
+	each group with one call. Relations not in the plan, or whose batch
+	result is not finite, are evaluated as usual.
+*/
+static void create_fused( qrslv_system_t sys){
+  int32 row, n;
+  struct rel_relation **rels;
+
+  relblock_destroy(sys->fused);
+  sys->fused = NULL;
+  n = sys->J.reg.row.high - sys->J.reg.row.low + 1;
+  if(n < 2 || !SLV_PARAM_BOOL(&(sys->p),COMPILED_EVAL)) return;
+  rels = ASC_NEW_ARRAY(struct rel_relation *,n);
+  for( row = sys->J.reg.row.low; row <= sys->J.reg.row.high; row++ ) {
+    rels[row - sys->J.reg.row.low] = sys->rlist[mtx_row_to_org(sys->J.mtx,row)];
+  }
+  sys->fused = relblock_create(rels,n);
+  ascfree(rels);
+  if(sys->fused == NULL) return;
+  if(sys->fdone == NULL) {
+    sys->fresid = ASC_NEW_ARRAY(real64,sys->rtot);
+    sys->fdone = ASC_NEW_ARRAY(int32,sys->rtot);
+  }
+  /* results of the previous block must not be taken for this one's */
+  memset(sys->fdone,0,sys->rtot*sizeof(int32));
+}
+
 /**
 	Moves on to the next block, updating all of the solver information.
 	To move to the first block, set sys->s.block.current_block to -1 before
@@ -2482,6 +2916,7 @@ static void move_to_next_block( qrslv_system_t sys){
   if(sys->s.block.current_block < sys->s.block.number_of ) {
 
     /* Initialize next block */
+    sys->J.frozen = FALSE;
     if(OPTIMIZING(sys)){
       mtx_region(&(sys->J.reg), 0, sys->rank-1, 0, sys->vused-1 );
     }else{
@@ -2492,8 +2927,15 @@ static void move_to_next_block( qrslv_system_t sys){
     row = sys->J.reg.row.high - sys->J.reg.row.low + 1;
     col = sys->J.reg.col.high - sys->J.reg.col.low + 1;
     sys->s.block.current_size = MAX(row,col);
+    create_fused(sys);
 
     sys->s.block.iteration = 0;
+    if(sys->bsched != NULL
+        && sys->bsched->state[sys->s.block.current_block] == BLOCK_CONVERGED
+    ){
+      /* solved by a block worker */
+      sys->s.block.iteration = sys->bsched->iters[sys->s.block.current_block];
+    }
     sys->s.block.cpu_elapsed = 0.0;
     sys->s.block.functime = 0.0;
     sys->s.block.jactime = 0.0;
@@ -2701,12 +3143,316 @@ static void reorder_new_block(qrslv_system_t sys){
   }
 }
 
+/*------------------------------------------------------------------------------
+  CONCURRENT SOLUTION OF INDEPENDENT BLOCKS
+
+  When the 'blockthreads' parameter asks for several workers, each time the
+  solver moves on from a converged block, the blocks ahead of it whose
+  predecessors have all converged are handed to the workers as OpenMP tasks.
+  When a worker converges a block, the successors left with no unconverged
+  predecessor become tasks in turn. A block only reads the variables of the
+  blocks it depends on, which no longer change, and writes its own, so the
+  workers never touch the same data.
+
+  The workers use plain Newton steps on a dense copy of the block Jacobian,
+  cut back to respect bounds and halved until the residuals fall, and report
+  nothing. A block that a worker converges is then found converged by
+  move_to_next_block and passed over as usual; a block that it cannot
+  converge is put back as it was and solved in turn by the serial
+  iteration, which then also reports any trouble. mtx and linsolqr keep
+  shared state and so are not used by the workers.
+*/
+
+/**
+	Solve a*x = b in place by Gaussian elimination with partial pivoting;
+	a is n by n, by rows, and b is overwritten with x.
+
+	@return FALSE if a pivot is smaller than tol.
+*/
+static boolean block_task_lu_solve(real64 *a, real64 *b, int32 n
+		, real64 tol
+){
+  int32 i, j, k, p;
+  real64 t, piv;
+
+  for( k = 0; k < n; k++ ) {
+    p = k;
+    for( i = k + 1; i < n; i++ ) {
+      if(fabs(a[i*n + k]) > fabs(a[p*n + k])) p = i;
+    }
+    if(fabs(a[p*n + k]) <= tol) return FALSE;
+    if(p != k) {
+      for( j = 0; j < n; j++ ) {
+        t = a[k*n + j]; a[k*n + j] = a[p*n + j]; a[p*n + j] = t;
+      }
+      t = b[k]; b[k] = b[p]; b[p] = t;
+    }
+    piv = a[k*n + k];
+    for( i = k + 1; i < n; i++ ) {
+      t = a[i*n + k] / piv;
+      if(t == 0.0) continue;
+      for( j = k + 1; j < n; j++ ) {
+        a[i*n + j] -= t * a[k*n + j];
+      }
+      b[i] -= t * b[k];
+    }
+  }
+  for( k = n - 1; k >= 0; k-- ) {
+    t = b[k];
+    for( j = k + 1; j < n; j++ ) {
+      t -= a[k*n + j] * b[j];
+    }
+    b[k] = t / a[k*n + k];
+  }
+  return TRUE;
+}
+
+/**
+	Evaluate the residuals of the rows low..low+n-1 into r, and decide
+	whether they are satisfied as calc_residuals would.
+
+	@return FALSE if any residual could not be calculated.
+*/
+static boolean block_task_eval(qrslv_system_t sys, struct block_worker *w
+		, int32 low, int32 n, real64 *phi, boolean *satisfied
+){
+  struct block_sched *bs = sys->bsched;
+  struct rel_relation *rel;
+  int32 i, status;
+
+  *phi = 0.0;
+  *satisfied = TRUE;
+  for( i = 0; i < n; i++ ) {
+    rel = sys->rlist[low + i];
+    w->r[i] = relman_eval_ctx(rel,RELPROG(sys,rel),w->ctx,&status
+      ,bs->safe,w->work
+    );
+    if(status || !asc_finite(w->r[i])) return FALSE;
+    *phi += w->r[i] * w->r[i];
+    if(bs->convopt == 2) {
+      if(!relman_calc_satisfied_scaled(rel,bs->tol)) *satisfied = FALSE;
+    }else{
+      if(!relman_calc_satisfied(rel,bs->tol)) *satisfied = FALSE;
+    }
+  }
+  return TRUE;
+}
+
+/**
+	Solve block k by itself, on a worker thread.
+
+	@return TRUE if the block converged, else its variables are put back.
+*/
+static boolean block_task_solve(qrslv_system_t sys, int32 k
+		, struct block_worker *w
+){
+  struct block_sched *bs = sys->bsched;
+  const mtx_region_t *reg;
+  const struct var_variable **inc;
+  struct rel_relation *rel;
+  struct var_variable *var;
+  int32 n, low, i, j, c, len, it, minor;
+  real64 phi, newphi, alpha, resid, x, lo, up;
+  boolean sat;
+
+  reg = &((slv_get_solvers_blocks(SERVER))->block[k]);
+  low = reg->row.low;
+  n = reg->row.high - low + 1;
+  for( j = 0; j < n; j++ ) {
+    var = sys->vlist[low + j];
+    w->xstart[j] = var_value(var);
+    if(bs->bounds && (w->xstart[j] < var_lower_bound(var)
+        || w->xstart[j] > var_upper_bound(var))
+    ){
+      return FALSE; /* let move_to_next_block deal with it */
+    }
+  }
+  if(!block_task_eval(sys,w,low,n,&phi,&sat)) goto fail;
+
+  for( it = 0; !sat; it++ ) {
+    if(it >= bs->maxit) goto fail;
+
+    /* Jacobian, with the columns scaled by the variable nominals */
+    for( i = 0; i < n*n; i++ ) {
+      w->a[i] = 0.0;
+    }
+    for( i = 0; i < n; i++ ) {
+      rel = sys->rlist[low + i];
+      if(relman_grad_ctx(rel,RELPROG(sys,rel),w->ctx,&resid,w->grad
+          ,bs->safe,w->work)
+      ){
+        goto fail;
+      }
+      inc = rel_incidence_list(rel);
+      len = rel_n_incidences(rel);
+      for( c = 0; c < len; c++ ) {
+        j = var_sindex(inc[c]) - low;
+        if(j >= 0 && j < n) {
+          w->a[i*n + j] += w->grad[c] * var_nominal((struct var_variable *)inc[c]);
+        }
+      }
+      w->dx[i] = -w->r[i];
+    }
+    if(!block_task_lu_solve(w->a,w->dx,n,bs->singtol)) goto fail;
+
+    /* the largest step up to Newton's that stays within bounds */
+    alpha = 1.0;
+    for( j = 0; j < n; j++ ) {
+      var = sys->vlist[low + j];
+      w->dx[j] *= var_nominal(var);
+      w->x0[j] = var_value(var);
+      if(!asc_finite(w->dx[j])) goto fail;
+      if(bs->bounds) {
+        if(w->x0[j] + alpha*w->dx[j] < (lo = var_lower_bound(var))) {
+          alpha = (lo - w->x0[j]) / w->dx[j];
+        }
+        if(w->x0[j] + alpha*w->dx[j] > (up = var_upper_bound(var))) {
+          alpha = (up - w->x0[j]) / w->dx[j];
+        }
+      }
+    }
+    if(alpha <= 0.0) goto fail;
+
+    /* halve the step until the residuals fall */
+    for( minor = 0; ; minor++ ) {
+      if(minor > bs->maxminor) goto fail;
+      for( j = 0; j < n; j++ ) {
+        var = sys->vlist[low + j];
+        x = w->x0[j] + alpha*w->dx[j];
+        if(bs->bounds) {
+          x = MAX(x,var_lower_bound(var));
+          x = MIN(x,var_upper_bound(var));
+        }
+        var_set_value(var,x);
+      }
+      if(block_task_eval(sys,w,low,n,&newphi,&sat)
+          && (sat || newphi < phi)
+      ){
+        break;
+      }
+      alpha *= 0.5;
+    }
+    phi = newphi;
+  }
+  bs->iters[k] = it;
+  return TRUE;
+
+fail:
+  for( j = 0; j < n; j++ ) {
+    var_set_value(sys->vlist[low + j],w->xstart[j]);
+  }
+  return FALSE;
+}
+
+/**
+	Task body: solve block k and, if it converges, start the successors
+	which have no unconverged predecessor left.
+*/
+static void block_task_run(qrslv_system_t sys, int32 k){
+  struct block_sched *bs = sys->bsched;
+  int32 c, s, left;
+
+  if(!block_task_solve(sys,k,&(bs->w[THREAD_NUM]))) {
+    bs->state[k] = BLOCK_FAILED;
+    return;
+  }
+  bs->state[k] = BLOCK_NEW;
+  for( c = bs->sstart[k]; c < bs->sstart[k+1]; c++ ) {
+    s = bs->succ[c];
+#if BLOCK_TASKS
+#pragma omp critical(qrslv_block_sched)
+#endif
+    left = --(bs->pending[s]);
+    if(left == 0 && bs->eligible[s] && bs->state[s] == BLOCK_UNTRIED) {
+#if BLOCK_TASKS
+#pragma omp task firstprivate(s)
+#endif
+      block_task_run(sys,s);
+    }
+  }
+}
+
+/**
+	Solve, on the workers, every block after the current one that does not
+	depend on an unconverged block, in dependency order.
+*/
+static void solve_ready_blocks(qrslv_system_t sys){
+  struct block_sched *bs = sys->bsched;
+  int32 first, j, k, c, nready;
+
+  if(bs == NULL || OPTIMIZING(sys)) return;
+  first = sys->s.block.current_block + 1;
+  if(first <= 0) {
+    /* a new solve: forget the blocks tried earlier */
+    for( k = 0; k < bs->nblocks; k++ ) {
+      bs->state[k] = BLOCK_UNTRIED;
+      bs->iters[k] = 0;
+    }
+    first = 0;
+  }
+
+  for( k = first; k < bs->nblocks; k++ ) {
+    bs->pending[k] = 0;
+  }
+  for( j = first; j < bs->nblocks; j++ ) {
+    if(bs->state[j] == BLOCK_CONVERGED) continue;
+    for( c = bs->sstart[j]; c < bs->sstart[j+1]; c++ ) {
+      bs->pending[bs->succ[c]]++;
+    }
+  }
+  nready = 0;
+  for( k = first; k < bs->nblocks; k++ ) {
+    if(bs->pending[k] == 0 && bs->eligible[k]
+        && bs->state[k] == BLOCK_UNTRIED
+    ){
+      bs->ready[nready++] = k;
+    }
+  }
+  if(nready == 0) return;
+
+  bs->safe = SLV_PARAM_BOOL(&(sys->p),SAFE_CALC);
+  bs->convopt = (strcmp(SLV_PARAM_CHAR(&(sys->p),CONVOPT),"RELNOM_SCALE") == 0)
+    ? 2 : 1;
+  bs->bounds = !(sys->p.ignore_bounds);
+  bs->tol = SLV_PARAM_REAL(&(sys->p),FEAS_TOL);
+  bs->singtol = SLV_PARAM_REAL(&(sys->p),SING_TOL);
+  bs->maxit = SLV_PARAM_INT(&(sys->p),ITER_LIMIT);
+  bs->maxminor = SLV_PARAM_INT(&(sys->p),MAX_MINOR);
+
+#ifdef ASC_SIGNAL_TRAPS
+  Asc_SignalHandlerPush(SIGFPE,SIG_IGN);
+#endif
+#if BLOCK_TASKS
+#pragma omp parallel num_threads(bs->nthreads)
+#pragma omp single
+#endif
+  {
+    for( c = 0; c < nready; c++ ) {
+      k = bs->ready[c];
+#if BLOCK_TASKS
+#pragma omp task firstprivate(k)
+#endif
+      block_task_run(sys,k);
+    }
+  }
+#ifdef ASC_SIGNAL_TRAPS
+  Asc_SignalHandlerPop(SIGFPE,SIG_IGN);
+#endif
+  for( k = first; k < bs->nblocks; k++ ) {
+    if(bs->state[k] == BLOCK_NEW) {
+      bs->state[k] = BLOCK_CONVERGED;
+      sys->s.iteration += bs->iters[k];
+    }
+  }
+}
+
 /**
 	Moves to next unconverged block, assuming that the current block has
 	converged (or is -1, to start).
 */
 static void find_next_unconverged_block( qrslv_system_t sys){
 
+   solve_ready_blocks(sys);
    do{
      move_to_next_block(sys);
 #if DEBUG
@@ -2830,7 +3576,7 @@ int32 qrslv_get_default_parameters(slv_system_t server, SlvClientToken asys
   }
 
   parameters->num_parms = 0;
-  asc_assert(qrslv_PA_SIZE==44);
+  asc_assert(qrslv_PA_SIZE==49);
   /* begin defining parameters */
 
   slv_param_bool(parameters,IGNORE_BOUNDS
@@ -3141,7 +3887,8 @@ int32 qrslv_get_default_parameters(slv_system_t server, SlvClientToken asys
   	}, "Fastest-SPK1/MR-RANKI"}, (char *[]){
 		"SPK1/RANKI","SPK1/RANKI+ROW",
 		"Fast-SPK1/RANKI","Fast-SPK1/RANKI+ROW",
-		"Fastest-SPK1/MR-RANKI","CondQR","CPQR",NULL
+		"Fastest-SPK1/MR-RANKI","CondQR","CPQR",
+		"SPK1/Supernodal-LU",NULL
   	}   /*,"GAUSS","GAUSS_EASY"  currently only works for ken */
   );
 
@@ -3152,6 +3899,63 @@ int32 qrslv_get_default_parameters(slv_system_t server, SlvClientToken asys
   	}, 30, 5, 100}
   );
 
+  slv_param_bool(parameters,COMPILED_EVAL
+  	,(SlvParameterInitBool){{"compiledeval"
+  		,"compiled relation evaluation",2
+  		,"If TRUE, token relations are translated at presolve into flat"
+		" register programs that are used for residual and Jacobian"
+		" evaluation. In each block, relations that are instances of the"
+		" same equation and have compiled bintoken batch functions are"
+		" also evaluated together, with one call per group."
+		" Relations that cannot be compiled, or that give floating-point"
+		" errors, use the normal evaluation routines."
+  	}, 1}
+  );
+
+  slv_param_int(parameters,ASSEMBLY_THREADS
+  	,(SlvParameterInitInt){{"assemblythreads"
+  		,"threads for function/Jacobian assembly",2
+  		,"Number of threads used to evaluate residuals and the Jacobian"
+		" of large blocks. 1 means serial evaluation; 0 means use as many"
+		" threads as OpenMP allows. Results do not depend on this setting."
+		" Ignored if ASCEND was built without OpenMP."
+  	}, 1, 0, 1024}
+  );
+
+  slv_param_bool(parameters,FROZEN_PATTERN
+  	,(SlvParameterInitBool){{"frozenpattern"
+  		,"refill Jacobian in place",2
+  		,"If TRUE, after the first Jacobian of each block the sparsity"
+		" pattern is frozen and later Jacobians of the block are written"
+		" straight into the existing matrix elements instead of clearing"
+		" and rebuilding the matrix."
+  	}, 1}
+  );
+
+  slv_param_bool(parameters,PIVOT_REUSE
+  	,(SlvParameterInitBool){{"pivotreuse"
+  		,"reuse pivot sequence",2
+  		,"If TRUE, the linear solver keeps the pivot sequence and fill"
+		" pattern of each block and, while the block's Jacobian pattern is"
+		" unchanged, only recomputes the numeric factors. A full pivot"
+		" search is done again whenever an old pivot becomes too small."
+		" Used by the SPK1/Supernodal-LU factorization."
+  	}, 1}
+  );
+
+  slv_param_int(parameters,BLOCK_THREADS
+  	,(SlvParameterInitInt){{"blockthreads"
+  		,"threads for independent blocks",2
+  		,"Number of threads used to solve diagonal blocks whose"
+		" predecessors have converged. Blocks of up to 50 equations are"
+		" given to the workers as soon as the blocks they depend on have"
+		" converged, and solved by Newton's method; larger blocks, and any"
+		" that a worker cannot converge, are solved in turn as usual."
+		" 1 means serial; 0 means use as many threads as OpenMP allows."
+		" Ignored if ASCEND was built without OpenMP."
+  	}, 1, 0, 1024}
+  );
+
   asc_assert(parameters->num_parms==qrslv_PA_SIZE);
 
   return 1;
@@ -3249,6 +4053,267 @@ static void destroy_matrices( qrslv_system_t sys)
    }
 }
 
+/**
+	Free the compiled relation programs, if any.
+*/
+static void destroy_progs( qrslv_system_t sys){
+  int32 ind;
+  if(sys->progs != NULL){
+    for( ind = 0; ind < sys->mtot; ++ind ) {
+      relprog_destroy(sys->progs[ind]);
+    }
+    ascfree(sys->progs);
+    sys->progs = NULL;
+  }
+  destroy_array(sys->progwork);
+  sys->progwork = NULL;
+  destroy_fused(sys);
+}
+
+/**
+	Compile the token relations in rlist to relation programs, and size
+	the shared scratch space for the largest of them. The programs are
+	kept by master index, as block reordering permutes rlist.
+*/
+static void create_progs( qrslv_system_t sys){
+  int32 ind, worklen = 0, len;
+  struct RelProg *prog;
+  if(sys->rtot <= 0) return;
+  sys->mtot = slv_get_num_master_rels(SERVER);
+  sys->progs = ASC_NEW_ARRAY_CLEAR(struct RelProg *,sys->mtot);
+  for( ind = 0; ind < sys->rtot; ++ind ) {
+    prog = relprog_create(sys->rlist[ind]);
+    sys->progs[rel_mindex(sys->rlist[ind])] = prog;
+    if(prog != NULL) {
+      len = relprog_work_size(prog) + relprog_num_vars(prog);
+      worklen = MAX(worklen,len);
+    }
+  }
+  sys->progwork = ASC_NEW_ARRAY_OR_NULL(real64,worklen);
+}
+
+/**
+	Free the per-worker evaluation contexts and staging buffers, if any.
+*/
+static void destroy_assembly( qrslv_system_t sys){
+  int32 t;
+  for( t = 0; t < sys->nthreads; ++t ) {
+    RelationEvalContextDestroy(sys->ctxs[t]);
+    destroy_array(sys->twork[t]);
+  }
+  destroy_array(sys->ctxs);
+  destroy_array(sys->twork);
+  destroy_array(sys->jstart);
+  destroy_array(sys->jstage);
+  destroy_array(sys->jslot);
+  destroy_array(sys->rstatus);
+  sys->ctxs = NULL;
+  sys->twork = NULL;
+  sys->jstart = NULL;
+  sys->jstage = NULL;
+  sys->jslot = NULL;
+  sys->rstatus = NULL;
+  sys->nthreads = 0;
+  sys->J.frozen = FALSE; /* jslot is gone */
+}
+
+/**
+	Set up multi-threaded assembly if the ASSEMBLY_THREADS parameter asks
+	for more than one worker, or the frozen-pattern Jacobian refill or the
+	batched evaluation of compiled bintokens (which use the same buffers,
+	with one worker if serial). Must follow
+	create_progs, since the worker scratch is sized for the programs.
+
+	Each worker has its own evaluation context and scratch; each relation
+	has its own slice of jstage for its gradient and its own rstatus entry.
+	The workers therefore never write to shared memory, and the results are
+	copied into the Jacobian in row order afterwards.
+*/
+static void create_assembly( qrslv_system_t sys){
+  int32 ind, t, nthreads, len, worklen = 0, nnz = 0;
+  struct rel_relation **mlist;
+  struct RelProg *prog;
+#ifdef _OPENMP
+  nthreads = SLV_PARAM_INT(&(sys->p),ASSEMBLY_THREADS);
+  if(nthreads <= 0) nthreads = omp_get_max_threads();
+#else
+  nthreads = 1;
+#endif
+  if(nthreads < 1) nthreads = 1;
+  if(sys->rtot <= 0
+      || (nthreads == 1 && !SLV_PARAM_BOOL(&(sys->p),FROZEN_PATTERN)
+        && !SLV_PARAM_BOOL(&(sys->p),COMPILED_EVAL))
+  ){
+    return;
+  }
+
+  /* by master index, as block reordering permutes rlist */
+  mlist = slv_get_master_rel_list(SERVER);
+  sys->mtot = slv_get_num_master_rels(SERVER);
+  sys->jstart = ASC_NEW_ARRAY(int32,sys->mtot + 1);
+  for( ind = 0; ind < sys->mtot; ++ind ) {
+    sys->jstart[ind] = nnz;
+    nnz += rel_n_incidences(mlist[ind]);
+  }
+  sys->jstart[sys->mtot] = nnz;
+  for( ind = 0; ind < sys->rtot; ++ind ) {
+    prog = RELPROG(sys,sys->rlist[ind]);
+    if(prog != NULL) {
+      len = relprog_work_size(prog);
+      worklen = MAX(worklen,len);
+    }
+  }
+  sys->jstage = ASC_NEW_ARRAY_OR_NULL(real64,nnz);
+  sys->jslot = ASC_NEW_ARRAY_OR_NULL(int32,nnz);
+  sys->rstatus = ASC_NEW_ARRAY_CLEAR(int32,sys->rtot);
+  sys->ctxs = ASC_NEW_ARRAY(struct RelationEvalContext *,nthreads);
+  sys->twork = ASC_NEW_ARRAY(real64 *,nthreads);
+  for( t = 0; t < nthreads; ++t ) {
+    sys->ctxs[t] = RelationEvalContextCreate();
+    sys->twork[t] = ASC_NEW_ARRAY_OR_NULL(real64,worklen);
+  }
+  sys->nthreads = nthreads;
+}
+
+/**
+	Free the block dependency graph and workers, if any.
+*/
+static void destroy_block_sched( qrslv_system_t sys){
+  struct block_sched *bs = sys->bsched;
+  int32 t;
+  if(bs == NULL) return;
+  for( t = 0; t < bs->nthreads; ++t ) {
+    RelationEvalContextDestroy(bs->w[t].ctx);
+    destroy_array(bs->w[t].work);
+    destroy_array(bs->w[t].grad);
+    destroy_array(bs->w[t].a);
+  }
+  destroy_array(bs->w);
+  destroy_array(bs->sstart);
+  destroy_array(bs->succ);
+  destroy_array(bs->pending);
+  destroy_array(bs->eligible);
+  ascfree(bs);
+  sys->bsched = NULL;
+}
+
+/**
+	Build the block dependency graph and the workers for concurrent
+	block solving, if the BLOCK_THREADS parameter asks for more than one
+	worker. Must follow the partitioning and create_progs.
+*/
+static void create_block_sched( qrslv_system_t sys){
+  const mtx_block_t *b;
+  struct block_sched *bs;
+  const struct var_variable **inc;
+  struct rel_relation *rel;
+  struct RelProg *prog;
+  int32 nthreads, nb, k, j, r, c, p, len, t, nedge;
+  int32 maxrows = 0, maxinc = 0, worklen = 0;
+  int32 *blockof, *mark;
+
+#if BLOCK_TASKS
+  nthreads = SLV_PARAM_INT(&(sys->p),BLOCK_THREADS);
+  if(nthreads <= 0) nthreads = omp_get_max_threads();
+#else
+  nthreads = 1;
+#endif
+  b = slv_get_solvers_blocks(SERVER);
+  nb = b->nblocks;
+  if(nthreads <= 1 || OPTIMIZING(sys) || sys->rank <= 0 || nb < 2
+      || !SLV_PARAM_BOOL(&(sys->p),PARTITION)
+  ){
+    return;
+  }
+
+  bs = ASC_NEW_CLEAR(struct block_sched);
+  bs->nblocks = nb;
+  bs->sstart = ASC_NEW_ARRAY_CLEAR(int32,nb + 1);
+  bs->pending = ASC_NEW_ARRAY(int32,3*nb);
+  bs->ready = bs->pending + nb;
+  bs->iters = bs->ready + nb;
+  bs->eligible = ASC_NEW_ARRAY_CLEAR(char,2*nb);
+  bs->state = bs->eligible + nb;
+  blockof = ASC_NEW_ARRAY(int32,sys->rank + nb);
+  mark = blockof + sys->rank;
+  for( k = 0; k < nb; k++ ) {
+    mark[k] = -1;
+    for( c = b->block[k].col.low; c <= b->block[k].col.high; c++ ) {
+      blockof[c] = k;
+    }
+  }
+
+  /* count the edges j -> k, then fill them in, in order of k */
+  for( nedge = 0, k = 0; k < nb; k++ ) {
+    bs->eligible[k] = (b->block[k].row.high - b->block[k].row.low + 1
+      <= BLOCK_TASK_MAX_ROWS);
+    for( r = b->block[k].row.low; r <= b->block[k].row.high; r++ ) {
+      rel = sys->rlist[r];
+      if(rel_extnodeinfo(rel) != NULL) {
+        bs->eligible[k] = 0; /* external code may not be reentrant */
+      }
+      inc = rel_incidence_list(rel);
+      len = rel_n_incidences(rel);
+      maxinc = MAX(maxinc,len);
+      for( c = 0; c < len; c++ ) {
+        p = var_sindex(inc[c]);
+        if(p < 0 || p >= b->block[k].col.low) continue;
+        j = blockof[p];
+        if(mark[j] != k) {
+          mark[j] = k;
+          bs->sstart[j + 1]++;
+          nedge++;
+        }
+      }
+      prog = RELPROG(sys,rel);
+      if(prog != NULL) worklen = MAX(worklen,relprog_work_size(prog));
+    }
+    if(bs->eligible[k]) {
+      maxrows = MAX(maxrows,b->block[k].row.high - b->block[k].row.low + 1);
+    }
+  }
+  for( k = 0; k < nb; k++ ) {
+    bs->sstart[k + 1] += bs->sstart[k];
+    bs->pending[k] = bs->sstart[k]; /* next free slot of each list */
+    mark[k] = -1;
+  }
+  bs->succ = ASC_NEW_ARRAY_OR_NULL(int32,nedge);
+  for( k = 0; k < nb; k++ ) {
+    for( r = b->block[k].row.low; r <= b->block[k].row.high; r++ ) {
+      inc = rel_incidence_list(sys->rlist[r]);
+      len = rel_n_incidences(sys->rlist[r]);
+      for( c = 0; c < len; c++ ) {
+        p = var_sindex(inc[c]);
+        if(p < 0 || p >= b->block[k].col.low) continue;
+        j = blockof[p];
+        if(mark[j] != k) {
+          mark[j] = k;
+          bs->succ[bs->pending[j]++] = k;
+        }
+      }
+    }
+  }
+  ascfree(blockof);
+  sys->bsched = bs;
+  if(maxrows == 0) {
+    destroy_block_sched(sys); /* nothing for the workers to do */
+    return;
+  }
+
+  bs->w = ASC_NEW_ARRAY_CLEAR(struct block_worker,nthreads);
+  for( t = 0; t < nthreads; ++t ) {
+    bs->w[t].ctx = RelationEvalContextCreate();
+    bs->w[t].work = ASC_NEW_ARRAY_OR_NULL(real64,worklen);
+    bs->w[t].grad = ASC_NEW_ARRAY_OR_NULL(real64,maxinc);
+    bs->w[t].a = ASC_NEW_ARRAY(real64,maxrows*(maxrows + 4));
+    bs->w[t].r = bs->w[t].a + maxrows*maxrows;
+    bs->w[t].dx = bs->w[t].r + maxrows;
+    bs->w[t].x0 = bs->w[t].dx + maxrows;
+    bs->w[t].xstart = bs->w[t].x0 + maxrows;
+  }
+  bs->nthreads = nthreads;
+}
+
 static void destroy_vectors( qrslv_system_t sys)
 {
    destroy_array(sys->nominals.vec);
@@ -3396,6 +4461,8 @@ static void set_factor_options (qrslv_system_t sys)
     sys->J.fm = ranki_jz2;
   }else if(strcmp(SLV_PARAM_CHAR(&(sys->p),FACTOR_OPTION),"Fastest-SPK1/MR-RANKI") == 0) {
     sys->J.fm = ranki_ba2;
+  }else if(strcmp(SLV_PARAM_CHAR(&(sys->p),FACTOR_OPTION),"SPK1/Supernodal-LU") == 0) {
+    sys->J.fm = sn_lu;
 /*  }else if(strcmp(SLV_PARAM_CHAR(&(sys->p),FACTOR_OPTION),"GAUSS") == 0) {
     sys->J.fm = gauss_ba2;
   }else if(strcmp(SLV_PARAM_CHAR(&(sys->p),FACTOR_OPTION),"GAUSS_EASY") == 0) {
@@ -3414,6 +4481,7 @@ static void set_factor_options (qrslv_system_t sys)
   /* KHACK NOTE: looks like drop tol never set on interface */
   linsolqr_set_drop_tolerance(sys->J.sys, sys->p.tolerance.drop);
   linsolqr_set_pivot_tolerance(sys->J.sys, SLV_PARAM_REAL(&(sys->p),PIVOT_TOL));
+  linsolqr_set_pivot_reuse(sys->J.sys, SLV_PARAM_BOOL(&(sys->p),PIVOT_REUSE));
   /* this next one is fishy, but we don't use qr so not panicking */
   linsolqr_set_condition_tolerance(sys->J.sys, SLV_PARAM_REAL(&(sys->p),PIVOT_TOL));
 }
@@ -3587,6 +4655,8 @@ static void qrslv_update_linsolqr(qrslv_system_t sys){
     sys->J.fm = ranki_jz2;
   }else if(strcmp(SLV_PARAM_CHAR(&(sys->p),FACTOR_OPTION),"Fastest-SPK1/MR-RANKI") == 0) {
     sys->J.fm = ranki_ba2;
+  }else if(strcmp(SLV_PARAM_CHAR(&(sys->p),FACTOR_OPTION),"SPK1/Supernodal-LU") == 0) {
+    sys->J.fm = sn_lu;
 /*  }else if(strcmp(SLV_PARAM_CHAR(&(sys->p),FACTOR_OPTION),"GAUSS_EASY") == 0) {
     sys->J.fm = gauss_easy;
   }else if(strcmp(SLV_PARAM_CHAR(&(sys->p),FACTOR_OPTION),"NGSLV-2-LEVEL") == 0) {
@@ -3594,9 +4664,13 @@ static void qrslv_update_linsolqr(qrslv_system_t sys){
   }else{
     sys->J.fm = ranki_ba2;
   }
+  if(linsolqr_fclass(sys->J.sys) != linsolqr_fmethod_to_fclass(sys->J.fm)) {
+    linsolqr_prep(sys->J.sys,linsolqr_fmethod_to_fclass(sys->J.fm));
+  }
   linsolqr_set_pivot_zero(sys->J.sys, SLV_PARAM_REAL(&(sys->p),SING_TOL));
   linsolqr_set_drop_tolerance(sys->J.sys, sys->p.tolerance.drop);
   linsolqr_set_pivot_tolerance(sys->J.sys, SLV_PARAM_REAL(&(sys->p),PIVOT_TOL));
+  linsolqr_set_pivot_reuse(sys->J.sys, SLV_PARAM_BOOL(&(sys->p),PIVOT_REUSE));
   /* this next one is fishy, but we don't use qr so not panicking */
   linsolqr_set_condition_tolerance(sys->J.sys, SLV_PARAM_REAL(&(sys->p),PIVOT_TOL));
 }
@@ -3657,12 +4731,29 @@ static int qrslv_presolve(slv_system_t server, SlvClientToken asys){
     sys->J.old_partition = SLV_PARAM_BOOL(&(sys->p),PARTITION);
     destroy_matrices(sys);
     destroy_vectors(sys);
+    destroy_progs(sys);
     create_matrices(server,sys);
     create_vectors(sys);
+    if(SLV_PARAM_BOOL(&(sys->p),COMPILED_EVAL)) {
+      create_progs(sys);
+    }
+    destroy_assembly(sys);
+    create_assembly(sys);
+    destroy_block_sched(sys);
+    create_block_sched(sys);
 
     sys->s.block.current_reordered_block = -2;
   }else{
     qrslv_update_linsolqr(sys);
+    if(!SLV_PARAM_BOOL(&(sys->p),COMPILED_EVAL)) {
+      destroy_progs(sys);
+    }else if(sys->progs == NULL) {
+      create_progs(sys);
+    }
+    destroy_assembly(sys);
+    create_assembly(sys);
+    destroy_block_sched(sys);
+    create_block_sched(sys);
   }
 
   /* Reset status */
@@ -4225,6 +5316,9 @@ static int qrslv_destroy(slv_system_t server, SlvClientToken asys){
   slv_destroy_parms(&(sys->p));
   destroy_matrices(sys);
   destroy_vectors(sys);
+  destroy_progs(sys);
+  destroy_assembly(sys);
+  destroy_block_sched(sys);
   sys->integrity = DESTROYED;
   if(sys->s.cost) ascfree(sys->s.cost);
   ascfree( (POINTER)asys );
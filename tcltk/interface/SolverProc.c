@@ -2219,7 +2219,7 @@ int Asc_SolvImportQlfdid(ClientData cdata, Tcl_Interp *interp
       g_compiler_counter = 1; /* initialize compiler counter */
     }
     if (g_solvinst_cur == solvinst_pot && g_compiler_counter == 0
-        && g_solvinst_cur != NULL) {
+        && g_solvinst_cur != NULL && !system_refresh(g_solvsys_cur)) {
       prevs = slv_get_selected_solver(g_solvsys_cur);
       CONSOLE_DEBUG("...");
       slv_select_solver(g_solvsys_cur,prevs);
@@ -2242,6 +2242,7 @@ int Asc_SolvImportQlfdid(ClientData cdata, Tcl_Interp *interp
 
     /* create system */
     if( g_solvsys_cur == NULL ) {
+      g_compiler_counter = 0; /* system_build records it; see system_refresh */
       g_solvsys_cur = system_build(g_solvinst_cur);
       if( g_solvsys_cur == NULL ) {
         FPRINTF(ASCERR,"system_build returned NULL.\n");
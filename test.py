@@ -24,6 +24,7 @@ import os, sys
 from pathlib import Path
 import math
 import atexit
+import gc
 
 import platform
 if platform.system() != "Windows":
@@ -249,6 +250,24 @@ class TestSolver(AscendSelfTester):
 		M.solve(ascpy.Solver('QRSlv'),ascpy.SolverReporter())
 		self.assertAlmostEqual( float(M.z), 4.61043629206)
 
+	def testrebuild(self):
+		self.L.load('test/relinclude.a4c')
+		T = self.L.findType('relinclude')
+		M = T.getSimulation('sim',True)
+		M.eq1.setIncluded(True)
+		M.eq2.setIncluded(False)
+		M.eq3.setIncluded(False)
+		M.setSolver(ascpy.Solver('QRSlv'))
+		M.setParameter('iterationlimit',7)
+		# the compiler has run since M was built: M must not refresh
+		M2 = T.getSimulation('sim2',True)
+		self.assertRaises(RuntimeError,M.build)
+		M.rebuild()
+		self.assertEqual(M.getSolver().getName(),'QRSlv')
+		self.assertEqual(M.getParameterValue('iterationlimit'),7)
+		M.solve(ascpy.Solver('QRSlv'),ascpy.SolverReporter())
+		self.assertAlmostEqual( float(M.z), 2.0)
+
 
 class TestBinTokens(AscendSelfTester):
 
@@ -260,6 +279,43 @@ class TestBinTokens(AscendSelfTester):
 		M.build()
 		M.solve(ascpy.Solver('QRSlv'),ascpy.SolverReporter())
 
+class TestInstanceValues(Ascend):
+
+	def testarray(self):
+		self.L.load('test/bintok/batch.a4c')
+		M = self.L.findType('batch').getSimulation('sim',True)
+		V = ascpy.InstanceValues(M.x)
+		self.assertEqual(len(V),12)
+		b = V.buffer()
+		self.assertAlmostEqual(b[3],0.1)
+		b[3] = 2.5
+		V.scatter()
+		self.assertAlmostEqual(float(M.x[3]),2.5)
+		M.x[4].setRealValue(1.5)
+		V.gather()
+		self.assertAlmostEqual(b[4],1.5)
+
+	def testnames(self):
+		self.L.load('test/bintok/batch.a4c')
+		M = self.L.findType('batch').getSimulation('sim',True)
+		V = ascpy.InstanceValues(M,["x[1]","x[2]"])
+		V.setValues([3.0,4.0])
+		self.assertAlmostEqual(float(M.x[1]),3.0)
+		self.assertAlmostEqual(float(M.x[2]),4.0)
+		self.assertRaises(RuntimeError,ascpy.InstanceValues,M,["nosuch"])
+
+	def testbufferowner(self):
+		self.L.load('test/bintok/batch.a4c')
+		M = self.L.findType('batch').getSimulation('sim',True)
+		b = ascpy.InstanceValues(M.x).buffer()
+		gc.collect()
+		self.assertAlmostEqual(b[3],0.1)
+
+	def testconstant(self):
+		self.L.load('test/chemakzo.a4c')
+		M = self.L.findType('chemakzo').getSimulation('sim',True)
+		self.assertRaises(RuntimeError,ascpy.InstanceValues,M,["k1"])
+
 class TestLRSlv(AscendSelfTester):
 	def testonerel(self):
 		self._run('onerel',"LRSlv","test/lrslv/onerel.a4c")
@@ -467,6 +523,31 @@ class TestLSODE(Ascend):
 		assert abs(M.R - 832) < 1.0
 		assert abs(M.F - 21.36) < 0.1
 
+	def testmiter(self):
+		self.L.load('test/lsode/mol.a4c')
+		T = self.L.findType('mol')
+		final = {}
+		for miter in [2,4,5]:
+			M = T.getSimulation('sim%d' % miter,True)
+			M.setSolver(ascpy.Solver('QRSlv'))
+			I = ascpy.Integrator(M)
+			I.setEngine('LSODE')
+			I.setParameter('miter',miter)
+			I.setParameter('rtolvect',False)
+			I.setParameter('rtol',1e-8)
+			I.setParameter('atolvect',False)
+			I.setParameter('atol',1e-8)
+			I.setReporter(ascpy.IntegratorReporterConsole(I))
+			I.setLinearTimesteps(ascpy.Units(), 0, 0.5, 10)
+			I.analyse()
+			I.solve()
+			final[miter] = [float(M.u[i]) for i in range(1,21)]
+		# banded Jacobians (analytic and finite difference) must give the
+		# same solution as the full finite-difference one
+		for miter in [4,5]:
+			for i in range(20):
+				self.assertAlmostEqual(final[miter][i],final[2][i],5)
+
 	def testwritegraph(self):
 		self.L.load('johnpye/lotka.a4c')
 		M = self.L.findType('lotka').getSimulation('sim',1)